@@ -960,6 +960,23 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="",
         min=8, max=8192,
     )
+    use_half_tile_passes: BoolProperty(
+        name="Half Float Tile Files",
+        description="Store data and shader AOV passes as half float in the temporary tile files written to disk while rendering in tiles, halving their disk usage. Render buffers in memory stay float, so memory usage is unchanged. Combined, light and ID passes are always stored as float",
+        default=False,
+    )
+
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Load image textures in tiles on demand while rendering on the CPU, instead of loading them fully up front. Tiled and mipmapped files (.tx or tiled OpenEXR) are read most efficiently",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory in megabytes used for image texture tiles, least recently used tiles are freed when the limit is reached",
+        default=4096,
+        min=64,
+    )
 
     # Various fine-tuning debug flags
 
@@ -975,6 +992,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_bvh_layouts,
         default='EMBREE',
     )
+    debug_use_cpu_wavefront: BoolProperty(
+        name="Wavefront",
+        description="Render batches of paths one kernel at a time, grouping paths that execute the same kernel, "
+        "instead of rendering each path from start to end",
+        default=False,
+    )
 
     debug_use_cuda_adaptive_compile: BoolProperty(name="Adaptive Compile", default=False)
 
@@ -833,6 +833,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
   params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
   params.use_bvh_compact_structure = RNA_boolean_get(&cscene, "debug_use_compact_bvh");
   params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
+  /* With persistent data the scene is kept for the next frame of an animation render, so the
+   * BVH of deforming geometry can be refit instead of rebuilt. */
+  params.use_bvh_refit = background && b_scene.render().use_persistent_data();
   params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
 
   PointerRNA csscene = RNA_pointer_get(&b_scene.ptr, "cycles_curves");
@@ -854,6 +857,9 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene,
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = get_boolean(cscene, "use_texture_cache");
+  params.texture_cache_size = get_int(cscene, "texture_cache_size");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
@@ -956,9 +962,11 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
   if (background) {
     params.use_auto_tile = RNA_boolean_get(&cscene, "use_auto_tile");
     params.tile_size = max(get_int(cscene, "tile_size"), 8);
+    params.use_half_tile_passes = RNA_boolean_get(&cscene, "use_half_tile_passes");
   }
   else {
     params.use_auto_tile = false;
+    params.use_half_tile_passes = false;
   }
 
   return params;
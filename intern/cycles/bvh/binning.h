@@ -17,12 +17,13 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
+/* Object binner. Finds the split with the best SAH heuristic
  * by testing for each dimension multiple partitionings for regular spaced
  * partition locations. A partitioning for a partition location is computed,
  * by putting primitives whose centroid is on the left and right of the split
  * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+ * blocks occupied by the primitives in the partitions. Large ranges are binned
+ * multi-threaded. */
 
 class BVHObjectBinning : public BVHRange {
  public:
@@ -59,6 +60,24 @@ class BVHObjectBinning : public BVHRange {
   enum { MAX_BINS = 32 };
   enum { LOG_BLOCK_SIZE = 2 };
 
+  /* Ranges with at least this many primitives are binned by multiple threads, each taking
+   * blocks of this many primitives. These are the top levels of the tree, where the recursive
+   * build has not created enough tasks yet to keep all threads busy. */
+  enum { PARALLEL_BINNING_MIN_SIZE = 65536 };
+  enum { PARALLEL_BINNING_BLOCK_SIZE = 8192 };
+
+  /* Number of primitives and bounds of every bin, in every dimension. */
+  struct Bins {
+    BoundBox bounds[MAX_BINS][4];
+    int4 count[MAX_BINS];
+
+    void clear(size_t num_bins);
+    void merge(const Bins &other, size_t num_bins);
+  };
+
+  /* Add primitives in the range from begin to end to the bins. */
+  void bin_primitives(const BVHReference *prims, size_t begin, size_t end, Bins &bins) const;
+
   /* computes the bin numbers for each dimension for a box. */
   __forceinline int4 get_bin(const BoundBox &box) const
   {
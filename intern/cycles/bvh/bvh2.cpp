@@ -21,6 +21,9 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Rebuild a refitted BVH once its SAH cost is this much higher than when it was built. */
+#define BVH2_MAX_REFIT_SAH_RATIO 1.5f
+
 BVHStackEntry::BVHStackEntry(const BVHNode *n, int i) : node(n), idx(i) {}
 
 int BVHStackEntry::encodeIdx() const
@@ -31,7 +34,7 @@ int BVHStackEntry::encodeIdx() const
 BVH2::BVH2(const BVHParams &params_,
            const vector<Geometry *> &geometry_,
            const vector<Object *> &objects_)
-    : BVH(params_, geometry_, objects_)
+    : BVH(params_, geometry_, objects_), build_sah_cost(0.0f), refit_sah_cost(0.0f)
 {
 }
 
@@ -70,6 +73,8 @@ void BVH2::build(Progress &progress, Stats *)
     return;
   }
 
+  build_sah_cost = refit_sah_cost = root->computeSubtreeSAHCost(params);
+
   /* pack triangles */
   progress.set_substatus("Packing BVH triangles and strands");
   pack_primitives();
@@ -100,6 +105,11 @@ void BVH2::refit(Progress &progress)
   refit_nodes();
 }
 
+bool BVH2::need_rebuild_after_refit() const
+{
+  return refit_sah_cost > build_sah_cost * BVH2_MAX_REFIT_SAH_RATIO;
+}
+
 BVHNode *BVH2::widen_children_nodes(const BVHNode *root)
 {
   return const_cast<BVHNode *>(root);
@@ -309,10 +319,16 @@ void BVH2::refit_nodes()
 
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
-  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
+  float sah_cost = 0.0f;
+  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility, sah_cost);
+
+  /* Same as BVHNode::computeSubtreeSAHCost(), with the area of each node relative to the root. */
+  refit_sah_cost = sah_cost / bbox.safe_area();
 }
 
-void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
+/* Refit the subtree at the node, adding the cost of its nodes weighted by their area to the
+ * SAH cost. */
+void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost)
 {
   if (leaf) {
     /* refit leaf node */
@@ -330,6 +346,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     leaf_data[0].z = __uint_as_float(visibility);
     leaf_data[0].w = __uint_as_float(data[0].w);
     memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4) * BVH_NODE_LEAF_SIZE);
+
+    sah_cost += bbox.safe_area() * params.primitive_cost(c1 - c0);
   }
   else {
     assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
@@ -342,8 +360,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     BoundBox bbox0 = BoundBox::empty, bbox1 = BoundBox::empty;
     uint visibility0 = 0, visibility1 = 0;
 
-    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0);
-    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1);
+    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0, sah_cost);
+    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1, sah_cost);
 
     if (is_unaligned) {
       Transform aligned_space = transform_identity();
@@ -357,6 +375,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     bbox.grow(bbox0);
     bbox.grow(bbox1);
     visibility = visibility0 | visibility1;
+
+    sah_cost += bbox.safe_area() * params.node_cost(2);
   }
 }
 
@@ -38,6 +38,10 @@ class BVH2 : public BVH {
   void build(Progress &progress, Stats *stats);
   void refit(Progress &progress);
 
+  /* Check if the BVH degraded so much by refitting that building it again is worth it, by
+   * comparing the SAH cost of the refitted and the built tree. */
+  bool need_rebuild_after_refit() const;
+
   PackedBVH pack;
 
  protected:
@@ -82,7 +86,7 @@ class BVH2 : public BVH {
 
   /* refit */
   void refit_nodes();
-  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility);
+  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost);
 
   /* Refit range of primitives. */
   void refit_primitives(int start, int end, BoundBox &bbox, uint &visibility);
@@ -93,6 +97,10 @@ class BVH2 : public BVH {
 
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
+
+  /* SAH cost of the tree as built and after the last refit. */
+  float build_sah_cost;
+  float refit_sah_cost;
 };
 
 CCL_NAMESPACE_END
@@ -77,6 +77,11 @@ static void rtc_error_func(void *, enum RTCError, const char *str)
   VLOG_WARNING << str;
 }
 
+/* Refitting lowers the quality of the BVH as the geometry deforms further away from the shape it
+ * was built for. Embree does not expose the cost of its trees, so after this many refits the
+ * geometry BVHs are built with full quality again. */
+#  define BVH_EMBREE_MAX_REFITS 8
+
 static double progress_start_time = 0.0;
 
 static bool rtc_progress_func(void *user_ptr, const double n)
@@ -94,13 +99,34 @@ static bool rtc_progress_func(void *user_ptr, const double n)
   return !progress->get_cancel();
 }
 
+/* Identifies how an object is added to the scene: not at all, as instance or with its geometry,
+ * along with the number of motion steps. Refitting only updates the data of the existing Embree
+ * geometries, so it's not possible when this changes. */
+static int embree_object_layout(const BVHParams &params, const Object *ob)
+{
+  const Geometry *geom = ob->get_geometry();
+  if (params.top_level) {
+    if (!ob->is_traceable()) {
+      return 0;
+    }
+    if (geom->is_instanced()) {
+      const int num_motion_steps = ob->use_motion() ? ob->get_motion().size() : 1;
+      return (num_motion_steps << 2) | 1;
+    }
+  }
+
+  const int num_motion_steps = geom->has_motion_blur() ? geom->get_motion_steps() : 1;
+  return (num_motion_steps << 2) | 2;
+}
+
 BVHEmbree::BVHEmbree(const BVHParams &params_,
                      const vector<Geometry *> &geometry_,
                      const vector<Object *> &objects_)
     : BVH(params_, geometry_, objects_),
       scene(NULL),
       rtc_device(NULL),
-      build_quality(RTC_BUILD_QUALITY_REFIT)
+      build_quality(RTC_BUILD_QUALITY_REFIT),
+      num_refits(0)
 {
   SIMD_SET_FLUSH_TO_ZERO;
 }
@@ -133,9 +159,12 @@ void BVHEmbree::build(Progress &progress,
 
   const bool dynamic = params.bvh_type == BVH_TYPE_DYNAMIC;
   const bool compact = params.use_compact_structure;
+  /* A dynamic scene builds a separate BVH for each geometry, which can then be refit
+   * individually. The build quality stays high since these are used for final renders. */
+  const bool two_level = dynamic || params.use_refit;
 
   scene = rtcNewScene(rtc_device);
-  const RTCSceneFlags scene_flags = (dynamic ? RTC_SCENE_FLAG_DYNAMIC : RTC_SCENE_FLAG_NONE) |
+  const RTCSceneFlags scene_flags = (two_level ? RTC_SCENE_FLAG_DYNAMIC : RTC_SCENE_FLAG_NONE) |
                                     (compact ? RTC_SCENE_FLAG_COMPACT : RTC_SCENE_FLAG_NONE) |
                                     RTC_SCENE_FLAG_ROBUST
 #  if EMBREE_MAJOR_VERSION >= 4
@@ -148,8 +177,13 @@ void BVHEmbree::build(Progress &progress,
                                                         RTC_BUILD_QUALITY_MEDIUM);
   rtcSetSceneBuildQuality(scene, build_quality);
 
+  object_layout.clear();
+  object_layout.reserve(objects.size());
+  num_refits = 0;
+
   int i = 0;
   foreach (Object *ob, objects) {
+    object_layout.push_back({ob->get_geometry(), embree_object_layout(params, ob)});
     if (params.top_level) {
       if (!ob->is_traceable()) {
         ++i;
@@ -203,17 +237,32 @@ void BVHEmbree::add_object(Object *ob, int i)
 }
 
 void BVHEmbree::add_instance(Object *ob, int i)
+{
+  const size_t num_object_motion_steps = ob->use_motion() ? ob->get_motion().size() : 1;
+  const size_t num_motion_steps = min(num_object_motion_steps, (size_t)RTC_MAX_TIME_STEP_COUNT);
+  assert(num_object_motion_steps <= RTC_MAX_TIME_STEP_COUNT);
+
+  RTCGeometry geom_id = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_INSTANCE);
+  rtcSetGeometryTimeStepCount(geom_id, num_motion_steps);
+  set_instance(geom_id, ob);
+#  if EMBREE_MAJOR_VERSION >= 4
+  rtcSetGeometryEnableFilterFunctionFromArguments(geom_id, true);
+#  endif
+
+  rtcCommitGeometry(geom_id);
+  rtcAttachGeometryByID(scene, geom_id, i * 2);
+  rtcReleaseGeometry(geom_id);
+}
+
+void BVHEmbree::set_instance(RTCGeometry geom_id, const Object *ob)
 {
   BVHEmbree *instance_bvh = (BVHEmbree *)(ob->get_geometry()->bvh);
   assert(instance_bvh != NULL);
 
   const size_t num_object_motion_steps = ob->use_motion() ? ob->get_motion().size() : 1;
   const size_t num_motion_steps = min(num_object_motion_steps, (size_t)RTC_MAX_TIME_STEP_COUNT);
-  assert(num_object_motion_steps <= RTC_MAX_TIME_STEP_COUNT);
 
-  RTCGeometry geom_id = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_INSTANCE);
   rtcSetGeometryInstancedScene(geom_id, instance_bvh->scene);
-  rtcSetGeometryTimeStepCount(geom_id, num_motion_steps);
 
   if (ob->use_motion()) {
     array<DecomposedTransform> decomp(ob->get_motion().size());
@@ -239,13 +288,6 @@ void BVHEmbree::add_instance(Object *ob, int i)
 
   rtcSetGeometryUserData(geom_id, (void *)instance_bvh->scene);
   rtcSetGeometryMask(geom_id, ob->visibility_for_tracing());
-#  if EMBREE_MAJOR_VERSION >= 4
-  rtcSetGeometryEnableFilterFunctionFromArguments(geom_id, true);
-#  endif
-
-  rtcCommitGeometry(geom_id);
-  rtcAttachGeometryByID(scene, geom_id, i * 2);
-  rtcReleaseGeometry(geom_id);
 }
 
 void BVHEmbree::add_triangles(const Object *ob, const Mesh *mesh, int i)
@@ -635,22 +677,62 @@ void BVHEmbree::add_curves(const Object *ob, const Hair *hair, int i)
   rtcReleaseGeometry(geom_id);
 }
 
+bool BVHEmbree::can_refit() const
+{
+  if (scene == NULL || objects.size() != object_layout.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    const Object *ob = objects[i];
+    if (object_layout[i].first != ob->get_geometry() ||
+        object_layout[i].second != embree_object_layout(params, ob))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void BVHEmbree::refit(Progress &progress)
 {
   progress.set_substatus("Refitting BVH nodes");
 
+  /* When refitting is requested for the scene, let Embree refit the BVH of each geometry rather
+   * than building it again, except every few updates to restore the quality of the BVH. */
+  enum RTCBuildQuality geom_quality = build_quality;
+  if (params.use_refit) {
+    if (++num_refits < BVH_EMBREE_MAX_REFITS) {
+      geom_quality = RTC_BUILD_QUALITY_REFIT;
+    }
+    else {
+      num_refits = 0;
+    }
+  }
+
   /* Update all vertex buffers, then tell Embree to rebuild/-fit the BVHs. */
   unsigned geom_id = 0;
   foreach (Object *ob, objects) {
-    if (!params.top_level || (ob->is_traceable() && !ob->get_geometry()->is_instanced())) {
+    if (params.top_level && ob->is_traceable() && ob->get_geometry()->is_instanced()) {
+      /* The transform, visibility and instanced scene may have changed. */
+      RTCGeometry geom = rtcGetGeometry(scene, geom_id);
+      set_instance(geom, ob);
+      rtcCommitGeometry(geom);
+    }
+    else if (!params.top_level || ob->is_traceable()) {
       Geometry *geom = ob->get_geometry();
 
       if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
         Mesh *mesh = static_cast<Mesh *>(geom);
         if (mesh->num_triangles() > 0) {
           RTCGeometry geom = rtcGetGeometry(scene, geom_id);
-          set_tri_vertex_buffer(geom, mesh, true);
+          /* Vertex arrays are replaced rather than modified in place when syncing, so the
+           * shared buffers are set again instead of only being tagged as updated. */
+          set_tri_vertex_buffer(geom, mesh, false);
           rtcSetGeometryUserData(geom, (void *)mesh->prim_offset);
+          rtcSetGeometryMask(geom, ob->visibility_for_tracing());
+          rtcSetGeometryBuildQuality(geom, geom_quality);
           rtcCommitGeometry(geom);
         }
       }
@@ -660,6 +742,8 @@ void BVHEmbree::refit(Progress &progress)
           RTCGeometry geom = rtcGetGeometry(scene, geom_id + 1);
           set_curve_vertex_buffer(geom, hair, true);
           rtcSetGeometryUserData(geom, (void *)hair->curve_segment_offset);
+          rtcSetGeometryMask(geom, ob->visibility_for_tracing());
+          rtcSetGeometryBuildQuality(geom, geom_quality);
           rtcCommitGeometry(geom);
         }
       }
@@ -668,6 +752,9 @@ void BVHEmbree::refit(Progress &progress)
         if (pointcloud->num_points() > 0) {
           RTCGeometry geom = rtcGetGeometry(scene, geom_id);
           set_point_vertex_buffer(geom, pointcloud, true);
+          rtcSetGeometryUserData(geom, (void *)pointcloud->prim_offset);
+          rtcSetGeometryMask(geom, ob->visibility_for_tracing());
+          rtcSetGeometryBuildQuality(geom, geom_quality);
           rtcCommitGeometry(geom);
         }
       }
@@ -675,6 +762,7 @@ void BVHEmbree::refit(Progress &progress)
     geom_id += 2;
   }
 
+  rtcSetSceneProgressMonitorFunction(scene, rtc_progress_func, &progress);
   rtcCommitScene(scene);
 }
 
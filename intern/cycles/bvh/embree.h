@@ -36,6 +36,10 @@ class BVHEmbree : public BVH {
              const bool isSyclEmbreeDevice = false);
   void refit(Progress &progress);
 
+  /* Check if the objects are still stored in the same way as when the scene was built, so that
+   * the existing Embree geometries can be updated by refit(). */
+  bool can_refit() const;
+
   RTCScene scene;
 
  protected:
@@ -52,6 +56,7 @@ class BVHEmbree : public BVH {
   void add_triangles(const Object *ob, const Mesh *mesh, int i);
 
  private:
+  void set_instance(RTCGeometry geom_id, const Object *ob);
   void set_tri_vertex_buffer(RTCGeometry geom_id, const Mesh *mesh, const bool update);
   void set_curve_vertex_buffer(RTCGeometry geom_id, const Hair *hair, const bool update);
   void set_point_vertex_buffer(RTCGeometry geom_id,
@@ -61,6 +66,12 @@ class BVHEmbree : public BVH {
   RTCDevice rtc_device;
   bool rtc_device_is_sycl;
   enum RTCBuildQuality build_quality;
+
+  /* Geometry of each object and how it was added to the scene on the last build, see
+   * embree_object_layout(). */
+  vector<std::pair<const Geometry *, int>> object_layout;
+  /* Number of refits since the geometry BVHs were last built with full quality. */
+  int num_refits;
 };
 
 CCL_NAMESPACE_END
@@ -105,6 +105,10 @@ class BVHParams {
   /* Same as in SceneParams. */
   int bvh_type;
 
+  /* Refit the BVH of topology-stable geometry on updates instead of rebuilding it, rebuilding
+   * only when the quality of the refitted BVH degraded too much. */
+  bool use_refit;
+
   /* These are needed for Embree. */
   int curve_subdivisions;
 
@@ -141,6 +145,7 @@ class BVHParams {
     num_motion_point_steps = 0;
 
     bvh_type = 0;
+    use_refit = false;
 
     curve_subdivisions = 4;
   }
@@ -16,9 +16,33 @@
 #include "scene/pointcloud.h"
 
 #include "util/algorithm.h"
+#include "util/tbb.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Ranges with at least this many references are chopped into spatial bins by multiple threads,
+ * each taking blocks of references of the given size. */
+static const int BVH_SPATIAL_PARALLEL_THRESHOLD = 65536;
+static const int BVH_SPATIAL_PARALLEL_BLOCK_SIZE = 8192;
+
+/* Spatial bins of all dimensions, for chopping references by multiple threads. */
+struct BVHSpatialBins {
+  BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+};
+
+static void bvh_spatial_bins_clear(BVHSpatialBin (*bins)[BVHParams::NUM_SPATIAL_BINS])
+{
+  for (int dim = 0; dim < 3; dim++) {
+    for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+      BVHSpatialBin &bin = bins[dim][i];
+
+      bin.bounds = BoundBox::empty;
+      bin.enter = 0;
+      bin.exit = 0;
+    }
+  }
+}
+
 /* Object Split */
 
 BVHObjectSplit::BVHObjectSplit(BVHBuild *builder,
@@ -150,44 +174,78 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild &builder,
   float3 binSize = (range_bounds.max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
   float3 invBinSize = 1.0f / binSize;
 
-  for (int dim = 0; dim < 3; dim++) {
-    for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-      BVHSpatialBin &bin = storage_->bins[dim][i];
-
-      bin.bounds = BoundBox::empty;
-      bin.enter = 0;
-      bin.exit = 0;
-    }
-  }
-
   /* chop references into bins. */
-  for (unsigned int refIdx = range.start(); refIdx < range.end(); refIdx++) {
-    const BVHReference &ref = references_->at(refIdx);
-    BoundBox prim_bounds = get_prim_bounds(ref);
-    float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
-    float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
-    int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
-    int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
-
-    firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
-    lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
-
-    for (int dim = 0; dim < 3; dim++) {
-      BVHReference currRef(
-          get_prim_bounds(ref), ref.prim_index(), ref.prim_object(), ref.prim_type());
-
-      for (int i = firstBin[dim]; i < lastBin[dim]; i++) {
-        BVHReference leftRef, rightRef;
-
-        split_reference(
-            builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
-        storage_->bins[dim][i].bounds.grow(leftRef.bounds());
-        currRef = rightRef;
+  auto chop_references = [&](const size_t begin,
+                             const size_t end,
+                             BVHSpatialBin(*bins)[BVHParams::NUM_SPATIAL_BINS]) {
+    for (size_t refIdx = begin; refIdx < end; refIdx++) {
+      const BVHReference &ref = references_->at(refIdx);
+      BoundBox prim_bounds = get_prim_bounds(ref);
+      float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
+      float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
+      int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
+      int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
+
+      firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
+      lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
+
+      for (int dim = 0; dim < 3; dim++) {
+        BVHReference currRef(
+            get_prim_bounds(ref), ref.prim_index(), ref.prim_object(), ref.prim_type());
+
+        for (int i = firstBin[dim]; i < lastBin[dim]; i++) {
+          BVHReference leftRef, rightRef;
+
+          split_reference(builder,
+                          leftRef,
+                          rightRef,
+                          currRef,
+                          dim,
+                          origin[dim] + binSize[dim] * (float)(i + 1));
+          bins[dim][i].bounds.grow(leftRef.bounds());
+          currRef = rightRef;
+        }
+
+        bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
+        bins[dim][firstBin[dim]].enter++;
+        bins[dim][lastBin[dim]].exit++;
       }
+    }
+  };
 
-      storage_->bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
-      storage_->bins[dim][firstBin[dim]].enter++;
-      storage_->bins[dim][lastBin[dim]].exit++;
+  if (range.size() < BVH_SPATIAL_PARALLEL_THRESHOLD) {
+    bvh_spatial_bins_clear(storage_->bins);
+    chop_references(range.start(), range.end(), storage_->bins);
+  }
+  else {
+    /* Chop blocks of references in parallel and merge the bins of all threads. Merging only
+     * grows bounds and adds counts, so the result is the same as chopping single threaded. */
+    enumerable_thread_specific<BVHSpatialBins> thread_bins([]() {
+      BVHSpatialBins local_bins;
+      bvh_spatial_bins_clear(local_bins.bins);
+      return local_bins;
+    });
+
+    parallel_for(
+        blocked_range<size_t>(range.start(), range.end(), BVH_SPATIAL_PARALLEL_BLOCK_SIZE),
+        [&](const blocked_range<size_t> &r) {
+          chop_references(r.begin(), r.end(), thread_bins.local().bins);
+        });
+
+    /* The storage is local to this thread, but while waiting for the loop above, the thread may
+     * have worked on other build tasks that use the same storage. So only start using it now. */
+    bvh_spatial_bins_clear(storage_->bins);
+    for (const BVHSpatialBins &local_bins : thread_bins) {
+      for (int dim = 0; dim < 3; dim++) {
+        for (int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+          BVHSpatialBin &bin = storage_->bins[dim][i];
+          const BVHSpatialBin &local_bin = local_bins.bins[dim][i];
+
+          bin.bounds.grow(local_bin.bounds);
+          bin.enter += local_bin.enter;
+          bin.exit += local_bin.exit;
+        }
+      }
     }
   }
 
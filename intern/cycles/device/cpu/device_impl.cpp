@@ -271,7 +271,7 @@ void CPUDevice::build_bvh(BVH *bvh, Progress &progress, bool refit)
       bvh->params.bvh_layout == BVH_LAYOUT_MULTI_EMBREEGPU_EMBREE)
   {
     BVHEmbree *const bvh_embree = static_cast<BVHEmbree *>(bvh);
-    if (refit) {
+    if (refit && bvh_embree->can_refit()) {
       bvh_embree->refit(progress);
     }
     else {
@@ -326,6 +326,11 @@ void *CPUDevice::get_cpu_osl_memory()
 #endif
 }
 
+void CPUDevice::set_cpu_image_cache_lookup(ImageCacheLookupFunction lookup)
+{
+  kernel_globals.image_cache_lookup = lookup;
+}
+
 bool CPUDevice::load_kernels(const uint /*kernel_features*/)
 {
   return true;
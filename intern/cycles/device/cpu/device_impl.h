@@ -88,6 +88,7 @@ class CPUDevice : public Device {
   virtual void get_cpu_kernel_thread_globals(
       vector<CPUKernelThreadGlobals> &kernel_thread_globals) override;
   virtual void *get_cpu_osl_memory() override;
+  virtual void set_cpu_image_cache_lookup(ImageCacheLookupFunction lookup) override;
 
  protected:
   virtual bool load_kernels(uint /*kernel_features*/) override;
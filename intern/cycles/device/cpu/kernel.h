@@ -43,6 +43,12 @@ class CPUKernels {
   IntegratorShadeFunction integrator_shade_dedicated_light;
   IntegratorShadeFunction integrator_megakernel;
 
+  /* Execute only the next kernel queued for the path, returning false when the path is done. */
+  using IntegratorStepFunction = CPUKernelFunction<bool (*)(
+      const KernelGlobalsCPU *kg, IntegratorStateCPU *state, ccl_global float *render_buffer)>;
+
+  IntegratorStepFunction integrator_megakernel_step;
+
   /* Shader evaluation. */
 
   using ShaderEvalFunction = CPUKernelFunction<void (*)(
@@ -56,6 +56,11 @@ void Device::build_bvh(BVH *bvh, Progress &progress, bool refit)
   BVH2 *const bvh2 = static_cast<BVH2 *>(bvh);
   if (refit) {
     bvh2->refit(progress);
+
+    if (bvh->params.use_refit && bvh2->need_rebuild_after_refit()) {
+      VLOG_WORK << "Rebuilding BVH, quality degraded too much from refitting.";
+      bvh2->build(progress, &stats);
+    }
   }
   else {
     bvh2->build(progress, &stats);
@@ -491,6 +496,11 @@ void *Device::get_cpu_osl_memory()
   return nullptr;
 }
 
+void Device::set_cpu_image_cache_lookup(ImageCacheLookupFunction /*lookup*/)
+{
+  LOG(FATAL) << "Device does not support CPU kernels.";
+}
+
 GPUDevice::~GPUDevice() noexcept(false) {}
 
 bool GPUDevice::load_texture_info()
@@ -217,6 +217,8 @@ class Device {
       vector<CPUKernelThreadGlobals> & /*kernel_thread_globals*/);
   /* Get OpenShadingLanguage memory buffer. */
   virtual void *get_cpu_osl_memory();
+  /* Set the function used by kernels to look up pixels of images in the image cache. */
+  virtual void set_cpu_image_cache_lookup(ImageCacheLookupFunction /*lookup*/);
 
   /* Acceleration structure building. */
   virtual void build_bvh(BVH *bvh, Progress &progress, bool refit);
@@ -16,7 +16,9 @@
 #include "scene/scene.h"
 #include "session/buffers.h"
 
+#include "util/algorithm.h"
 #include "util/atomic.h"
+#include "util/debug.h"
 #include "util/log.h"
 #include "util/tbb.h"
 
@@ -74,31 +76,74 @@ void PathTraceWorkCPU::render_samples(RenderStatistics &statistics,
   }
 
   tbb::task_arena local_arena = local_tbb_arena_create(device_);
-  local_arena.execute([&]() {
-    parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
-      if (is_cancel_requested()) {
-        return;
+  if (use_wavefront()) {
+    const int states_num = wavefront_batch_size * 2;
+    wavefront_thread_states_.resize(kernel_thread_globals_.size());
+    for (unique_ptr<IntegratorStateCPU[]> &states : wavefront_thread_states_) {
+      if (!states) {
+        states.reset(new IntegratorStateCPU[states_num]);
       }
+    }
 
-      const int y = work_index / image_width;
-      const int x = work_index - y * image_width;
+    const int64_t tiles_x = divide_up(image_width, wavefront_tile_size);
+    const int64_t tiles_y = divide_up(image_height, wavefront_tile_size);
+    local_arena.execute([&]() {
+      parallel_for(int64_t(0), tiles_x * tiles_y, [&](int64_t work_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
 
-      KernelWorkTile work_tile;
-      work_tile.x = effective_buffer_params_.full_x + x;
-      work_tile.y = effective_buffer_params_.full_y + y;
-      work_tile.w = 1;
-      work_tile.h = 1;
-      work_tile.start_sample = start_sample;
-      work_tile.sample_offset = sample_offset;
-      work_tile.num_samples = 1;
-      work_tile.offset = effective_buffer_params_.offset;
-      work_tile.stride = effective_buffer_params_.stride;
+        const int64_t tile_y = work_index / tiles_x;
+        const int64_t tile_x = work_index - tile_y * tiles_x;
+        const int x = tile_x * wavefront_tile_size;
+        const int y = tile_y * wavefront_tile_size;
+
+        KernelWorkTile work_tile;
+        work_tile.x = effective_buffer_params_.full_x + x;
+        work_tile.y = effective_buffer_params_.full_y + y;
+        work_tile.w = min(wavefront_tile_size, int(image_width - x));
+        work_tile.h = min(wavefront_tile_size, int(image_height - y));
+        work_tile.start_sample = start_sample;
+        work_tile.sample_offset = sample_offset;
+        work_tile.num_samples = 1;
+        work_tile.offset = effective_buffer_params_.offset;
+        work_tile.stride = effective_buffer_params_.stride;
+
+        const int thread_index = tbb::this_task_arena::current_thread_index();
+        CPUKernelThreadGlobals *kernel_globals = &kernel_thread_globals_[thread_index];
+        IntegratorStateCPU *states = wavefront_thread_states_[thread_index].get();
+
+        render_samples_wavefront(kernel_globals, states, work_tile, samples_num);
+      });
+    });
+  }
+  else {
+    local_arena.execute([&]() {
+      parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
+
+        const int y = work_index / image_width;
+        const int x = work_index - y * image_width;
 
-      CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+        KernelWorkTile work_tile;
+        work_tile.x = effective_buffer_params_.full_x + x;
+        work_tile.y = effective_buffer_params_.full_y + y;
+        work_tile.w = 1;
+        work_tile.h = 1;
+        work_tile.start_sample = start_sample;
+        work_tile.sample_offset = sample_offset;
+        work_tile.num_samples = 1;
+        work_tile.offset = effective_buffer_params_.offset;
+        work_tile.stride = effective_buffer_params_.stride;
 
-      render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+        CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+
+        render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+      });
     });
-  });
+  }
   if (device_->profiler.active()) {
     for (CPUKernelThreadGlobals &kernel_globals : kernel_thread_globals_) {
       kernel_globals.stop_profiling();
@@ -164,6 +209,124 @@ void PathTraceWorkCPU::render_samples_full_pipeline(KernelGlobalsCPU *kernel_glo
   }
 }
 
+bool PathTraceWorkCPU::use_wavefront() const
+{
+  if (!DebugFlags().cpu.wavefront) {
+    return false;
+  }
+  /* The path guiding data is stored per thread and only supports a single path at a time. */
+  if (device_scene_->data.integrator.use_guiding) {
+    return false;
+  }
+  return true;
+}
+
+/* Key used to group paths executing the same kernel. Shading kernels are additionally grouped
+ * by the shader of the hit, like the GPU shader sorting, so that consecutive paths execute the
+ * same shader nodes. Zero means the path is finished. */
+static inline uint64_t wavefront_path_sort_key(const IntegratorStateCPU &state)
+{
+  /* Same order of execution as in #integrator_megakernel_step. */
+  if (state.shadow.shadow_path.queued_kernel) {
+    return uint64_t(state.shadow.shadow_path.queued_kernel) << 32;
+  }
+  if (state.ao.shadow_path.queued_kernel) {
+    return uint64_t(state.ao.shadow_path.queued_kernel) << 32;
+  }
+  const uint32_t queued_kernel = state.path.queued_kernel;
+  if (queued_kernel == 0) {
+    return 0;
+  }
+  return (uint64_t(queued_kernel) << 32) | state.path.shader_sort_key;
+}
+
+void PathTraceWorkCPU::render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                                IntegratorStateCPU *states,
+                                                const KernelWorkTile &work_tile,
+                                                const int samples_num)
+{
+  const bool has_bake = device_scene_->data.bake.use;
+
+  /* The shadow catcher split continues the path in the state following the main path. */
+  const int states_per_pixel = device_scene_->data.integrator.has_shadow_catcher ? 2 : 1;
+  const int pixels_num = work_tile.w * work_tile.h;
+  const int states_num = pixels_num * states_per_pixel;
+
+  float *render_buffer = buffers_->buffer.data();
+
+  for (int i = 0; i < states_num; ++i) {
+    path_state_init_queues(&states[i]);
+  }
+
+  /* Pixels which don't need any more samples, e.g. because of adaptive sampling. */
+  bool pixel_done[wavefront_batch_size] = {false};
+  std::pair<uint64_t, int> active_paths[wavefront_batch_size * 2];
+
+  for (int sample = 0; sample < samples_num; ++sample) {
+    if (is_cancel_requested()) {
+      break;
+    }
+
+    /* Start a new path for every pixel. */
+    for (int pixel = 0; pixel < pixels_num; ++pixel) {
+      if (pixel_done[pixel]) {
+        continue;
+      }
+
+      KernelWorkTile pixel_work_tile = work_tile;
+      pixel_work_tile.x = work_tile.x + pixel % work_tile.w;
+      pixel_work_tile.y = work_tile.y + pixel / work_tile.w;
+      pixel_work_tile.w = 1;
+      pixel_work_tile.h = 1;
+      pixel_work_tile.start_sample = work_tile.start_sample + sample;
+
+      IntegratorStateCPU *state = &states[pixel * states_per_pixel];
+      bool path_started;
+      if (has_bake) {
+        path_started = kernels_.integrator_init_from_bake(
+            kernel_globals, state, &pixel_work_tile, render_buffer);
+      }
+      else {
+        path_started = kernels_.integrator_init_from_camera(
+            kernel_globals, state, &pixel_work_tile, render_buffer);
+      }
+      if (!path_started) {
+        pixel_done[pixel] = true;
+      }
+    }
+
+    /* Advance all paths by one kernel until they are finished. Every path executes its kernels in
+     * the same order as with the megakernel, so the result is the same. Like with the megakernel,
+     * a shadow catcher path only continues once the main path of its pixel is finished, because
+     * both accumulate into the same pixel and the order of the additions affects the result. */
+    while (true) {
+      int active_paths_num = 0;
+      uint64_t main_path_key = 0;
+      for (int i = 0; i < states_num; ++i) {
+        const uint64_t key = wavefront_path_sort_key(states[i]);
+        const bool is_shadow_catcher_path = (states_per_pixel == 2) && (i % 2 == 1);
+        if (!is_shadow_catcher_path) {
+          main_path_key = key;
+        }
+        else if (main_path_key != 0) {
+          continue;
+        }
+        if (key != 0) {
+          active_paths[active_paths_num++] = {key, i};
+        }
+      }
+      if (active_paths_num == 0) {
+        break;
+      }
+      sort(active_paths, active_paths + active_paths_num);
+      for (int i = 0; i < active_paths_num; ++i) {
+        kernels_.integrator_megakernel_step(
+            kernel_globals, &states[active_paths[i].second], render_buffer);
+      }
+    }
+  }
+}
+
 void PathTraceWorkCPU::copy_to_display(PathTraceDisplay *display,
                                        PassMode pass_mode,
                                        int num_samples)
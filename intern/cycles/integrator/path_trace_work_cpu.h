@@ -11,6 +11,7 @@
 
 #include "integrator/path_trace_work.h"
 
+#include "util/unique_ptr.h"
 #include "util/vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -74,6 +75,20 @@ class PathTraceWorkCPU : public PathTraceWork {
                                     const KernelWorkTile &work_tile,
                                     const int samples_num);
 
+  /* Render the pixels of the work tile as one batch of paths, which are advanced one kernel at a
+   * time. Paths which execute the same kernel are grouped, similar to the GPU wavefront. */
+  void render_samples_wavefront(KernelGlobalsCPU *kernel_globals,
+                                IntegratorStateCPU *states,
+                                const KernelWorkTile &work_tile,
+                                const int samples_num);
+
+  /* Whether to use the wavefront scheduling instead of the megakernel. */
+  bool use_wavefront() const;
+
+  /* Width and height of the pixel tiles rendered as one batch by the wavefront scheduling. */
+  static constexpr int wavefront_tile_size = 8;
+  static constexpr int wavefront_batch_size = wavefront_tile_size * wavefront_tile_size;
+
   /* CPU kernels. */
   const CPUKernels &kernels_;
 
@@ -83,6 +98,11 @@ class PathTraceWorkCPU : public PathTraceWork {
    * accessing it, but some "localization" is required to decouple from kernel globals stored
    * on the device level. */
   vector<CPUKernelThreadGlobals> kernel_thread_globals_;
+
+  /* Path states of the batch of every thread for the wavefront scheduling, allocated on demand.
+   * The states are big because of the shadow intersections, so they are not zero initialized to
+   * avoid touching memory which might never be used. */
+  vector<unique_ptr<IntegratorStateCPU[]>> wavefront_thread_states_;
 };
 
 CCL_NAMESPACE_END
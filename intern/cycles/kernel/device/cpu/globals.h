@@ -52,6 +52,10 @@ typedef struct KernelGlobalsCPU {
   int osl_thread_index = 0;
 #endif
 
+  /* Lookup in the image cache, which is implemented outside of the kernel so that it does not
+   * depend on OpenImageIO. Set by the device when images are stored in the cache. */
+  ImageCacheLookupFunction image_cache_lookup = nullptr;
+
 #ifdef __PATH_GUIDING__
   /* Pointers to global data structures. */
   openpgl::cpp::SampleStorage *opgl_sample_data_storage = nullptr;
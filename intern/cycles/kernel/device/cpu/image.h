@@ -811,6 +811,15 @@ template<typename TexT, typename OutT> struct NanoVDBInterpolator {
 
 #undef SET_CUBIC_SPLINE_WEIGHTS
 
+ccl_device_noinline float4 kernel_tex_image_cache_interp(
+    KernelGlobals kg, const TextureInfo &info, float x, float y, const float2 dx, const float2 dy)
+{
+  kernel_assert(kg->image_cache_lookup);
+  float result[4];
+  kg->image_cache_lookup(info.cache_handle, x, y, dx.x, dx.y, dy.x, dy.y, result);
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, float y)
 {
   const TextureInfo &info = kernel_data_fetch(texture_info, id);
@@ -819,6 +828,11 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, flo
     return zero_float4();
   }
 
+  if (info.cache_handle) {
+    /* Without differentials the most detailed mip level is used. */
+    return kernel_tex_image_cache_interp(kg, info, x, y, zero_float2(), zero_float2());
+  }
+
   switch (info.data_type) {
     case IMAGE_DATA_TYPE_HALF: {
       const float f = TextureInterpolator<half, float>::interp(info, x, y);
@@ -851,6 +865,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals kg, int id, float x, flo
   }
 }
 
+/* Texture lookup with the differentials of the coordinates along the screen x and y axis, which
+ * are used to select the mip level for images in the image cache. */
+ccl_device float4 kernel_tex_image_interp_with_differentials(
+    KernelGlobals kg, int id, float x, float y, const float2 dx, const float2 dy)
+{
+  const TextureInfo &info = kernel_data_fetch(texture_info, id);
+
+  if (info.cache_handle) {
+    return kernel_tex_image_cache_interp(kg, info, x, y, dx, dy);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals kg,
                                              int id,
                                              float3 P,
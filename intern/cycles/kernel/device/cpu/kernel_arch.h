@@ -38,6 +38,10 @@ KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_volume);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(shade_dedicated_light);
 KERNEL_INTEGRATOR_SHADE_FUNCTION(megakernel);
 
+bool KERNEL_FUNCTION_FULL_NAME(integrator_megakernel_step)(const KernelGlobalsCPU *ccl_restrict kg,
+                                                           IntegratorStateCPU *state,
+                                                           ccl_global float *render_buffer);
+
 #undef KERNEL_INTEGRATOR_FUNCTION
 #undef KERNEL_INTEGRATOR_INIT_FUNCTION
 #undef KERNEL_INTEGRATOR_SHADE_FUNCTION
@@ -113,6 +113,13 @@ DEFINE_INTEGRATOR_SHADE_KERNEL(megakernel)
 DEFINE_INTEGRATOR_SHADOW_KERNEL(intersect_shadow)
 DEFINE_INTEGRATOR_SHADOW_SHADE_KERNEL(shade_shadow)
 
+bool KERNEL_FUNCTION_FULL_NAME(integrator_megakernel_step)(const KernelGlobalsCPU *kg,
+                                                           IntegratorStateCPU *state,
+                                                           ccl_global float *render_buffer)
+{
+  return KERNEL_INVOKE(megakernel_step, kg, state, render_buffer);
+}
+
 /* --------------------------------------------------------------------
  * Shader evaluation.
  */
@@ -4,6 +4,7 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh2.h"
+#include "bvh/embree.h"
 
 #include "device/device.h"
 
@@ -30,6 +31,7 @@
 #include "util/log.h"
 #include "util/progress.h"
 #include "util/task.h"
+#include "util/time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -91,6 +93,7 @@ void Geometry::compute_bvh(Device *device,
       bparams.num_motion_curve_steps = params->num_bvh_time_steps;
       bparams.num_motion_point_steps = params->num_bvh_time_steps;
       bparams.bvh_type = params->bvh_type;
+      bparams.use_refit = params->use_bvh_refit;
       bparams.curve_subdivisions = params->curve_subdivisions();
 
       delete bvh;
@@ -122,20 +125,39 @@ void GeometryManager::device_update_bvh(Device *device,
   bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
   bparams.num_motion_point_steps = scene->params.num_bvh_time_steps;
   bparams.bvh_type = scene->params.bvh_type;
+  bparams.use_refit = scene->params.use_bvh_refit;
   bparams.curve_subdivisions = scene->params.curve_subdivisions();
 
   VLOG_INFO << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
-  const bool can_refit = scene->bvh != nullptr &&
-                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
-                          bparams.bvh_layout == BVHLayout::BVH_LAYOUT_METAL);
+  bool can_refit = scene->bvh != nullptr &&
+                   (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
+                    bparams.bvh_layout == BVHLayout::BVH_LAYOUT_METAL);
+#ifdef WITH_EMBREE
+  /* The scene BVH is freed when geometry is added or removed, so the topology is unchanged when
+   * it still exists. The top level BVH2 can't be refit since its data is moved to the device. */
+  if (scene->bvh != nullptr && bparams.use_refit &&
+      bparams.bvh_layout == BVHLayout::BVH_LAYOUT_EMBREE)
+  {
+    can_refit = static_cast<BVHEmbree *>(scene->bvh)->can_refit();
+  }
+#endif
 
   BVH *bvh = scene->bvh;
   if (!scene->bvh) {
     bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
   }
 
-  device->build_bvh(bvh, progress, can_refit);
+  {
+    scoped_callback_timer timer([scene, can_refit](double time) {
+      if (scene->update_stats) {
+        scene->update_stats->geometry.times.add_entry(
+            {can_refit ? "device_update_bvh (refit)" : "device_update_bvh (build)", time});
+      }
+      VLOG_INFO << "Scene BVH " << (can_refit ? "refit" : "build") << " time " << time << "s.";
+    });
+    device->build_bvh(bvh, progress, can_refit);
+  }
 
   if (progress.get_cancel()) {
     return;
@@ -5,6 +5,7 @@
 #include "scene/image.h"
 #include "device/device.h"
 #include "scene/colorspace.h"
+#include "scene/image_cache.h"
 #include "scene/image_oiio.h"
 #include "scene/image_vdb.h"
 #include "scene/scene.h"
@@ -326,6 +327,9 @@ ImageManager::ImageManager(const DeviceInfo &info)
 
   /* Set image limits */
   features.has_nanovdb = info.has_nanovdb;
+
+  /* The kernel can only look up pixels through the image cache on the CPU. */
+  device_supports_image_cache = (info.type == DEVICE_CPU);
 }
 
 ImageManager::~ImageManager()
@@ -488,6 +492,7 @@ size_t ImageManager::add_image_slot(ImageLoader *loader,
   img->builtin = builtin;
   img->users = 1;
   img->mem = NULL;
+  img->cache_handle = 0;
 
   images[slot] = img;
 
@@ -713,6 +718,19 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
     delete img->mem;
     img->mem = NULL;
   }
+  if (img->cache_handle) {
+    image_cache->remove_image(img->cache_handle);
+    img->cache_handle = 0;
+  }
+
+  /* Look up pixels through the image cache instead of loading them, if possible. */
+  if (image_cache && ImageCache::supports_image(img)) {
+    img->cache_handle = image_cache->add_image(img);
+    if (img->cache_handle) {
+      type = IMAGE_DATA_TYPE_FLOAT4;
+      img->mem_name = string_printf("tex_image_cached_%03d", (int)slot);
+    }
+  }
 
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
@@ -720,7 +738,19 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (img->cache_handle) {
+    /* Placeholder for the device, the kernel uses the cache handle instead. */
+    thread_scoped_lock device_lock(device_mutex);
+    float *pixels = (float *)img->mem->alloc(1, 1);
+
+    pixels[0] = TEX_IMAGE_MISSING_R;
+    pixels[1] = TEX_IMAGE_MISSING_G;
+    pixels[2] = TEX_IMAGE_MISSING_B;
+    pixels[3] = TEX_IMAGE_MISSING_A;
+
+    img->mem->info.cache_handle = img->cache_handle;
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -848,6 +878,10 @@ void ImageManager::device_free_image(Device *, size_t slot)
     delete img->mem;
   }
 
+  if (img->cache_handle) {
+    image_cache->remove_image(img->cache_handle);
+  }
+
   delete img->loader;
   delete img;
   images[slot] = NULL;
@@ -865,6 +899,14 @@ void ImageManager::device_update(Device *device, Scene *scene, Progress &progres
     }
   });
 
+  if (scene->params.use_texture_cache && device_supports_image_cache) {
+    if (!image_cache) {
+      image_cache = make_unique<ImageCache>(scene->params.texture_cache_size);
+    }
+    image_cache->set_max_memory(scene->params.texture_cache_size);
+    device->set_cpu_image_cache_lookup(ImageCache::lookup);
+  }
+
   TaskPool pool;
   for (size_t slot = 0; slot < images.size(); slot++) {
     Image *img = images[slot];
@@ -946,6 +988,10 @@ void ImageManager::collect_statistics(RenderStats *stats)
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (image_cache) {
+    image_cache->collect_statistics(&stats->image.cache);
+  }
 }
 
 void ImageManager::tag_update()
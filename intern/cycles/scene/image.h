@@ -19,6 +19,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceInfo;
+class ImageCache;
 class ImageHandle;
 class ImageKey;
 class ImageMetaData;
@@ -208,6 +209,9 @@ class ImageManager {
     string mem_name;
     device_texture *mem;
 
+    /* Handle in the image cache when the pixels are not loaded into memory. */
+    uint64_t cache_handle;
+
     int users;
     thread_mutex mutex;
   };
@@ -224,6 +228,9 @@ class ImageManager {
   vector<Image *> images;
   void *osl_texture_system;
 
+  bool device_supports_image_cache;
+  unique_ptr<ImageCache> image_cache;
+
   size_t add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(size_t slot);
   void remove_image_user(size_t slot);
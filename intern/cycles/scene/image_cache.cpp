@@ -0,0 +1,280 @@
+/* SPDX-FileCopyrightText: 2011-2022 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "scene/image_cache.h"
+#include "scene/colorspace.h"
+#include "scene/stats.h"
+
+#include "util/log.h"
+#include "util/texture.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+using OIIO::TextureOpt;
+using OIIO::TextureSystem;
+
+/* Image as registered in the texture system, the kernel gets a pointer to this. */
+struct ImageCacheEntry {
+  TextureSystem *texture_system;
+  TextureSystem::TextureHandle *handle;
+  ustring filepath;
+  /* Processor to convert to scene linear, null when no conversion is needed. */
+  ColorSpaceProcessor *processor;
+  int channels;
+  bool associate_alpha;
+  bool ignore_alpha;
+  TextureOpt::InterpMode interpolation;
+  TextureOpt::MipMode mipmode;
+  TextureOpt::Wrap wrap;
+};
+
+static TextureOpt::Wrap image_cache_wrap(const ExtensionType extension)
+{
+  switch (extension) {
+    case EXTENSION_REPEAT:
+      return TextureOpt::WrapPeriodic;
+    case EXTENSION_EXTEND:
+      return TextureOpt::WrapClamp;
+    case EXTENSION_MIRROR:
+      return TextureOpt::WrapMirror;
+    case EXTENSION_CLIP:
+    case EXTENSION_NUM_TYPES:
+      break;
+  }
+  return TextureOpt::WrapBlack;
+}
+
+static TextureOpt::InterpMode image_cache_interpolation(const InterpolationType interpolation)
+{
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      return TextureOpt::InterpClosest;
+    case INTERPOLATION_CUBIC:
+      return TextureOpt::InterpBicubic;
+    case INTERPOLATION_SMART:
+      return TextureOpt::InterpSmartBicubic;
+    case INTERPOLATION_NONE:
+    case INTERPOLATION_LINEAR:
+    case INTERPOLATION_NUM_TYPES:
+      break;
+  }
+  return TextureOpt::InterpBilinear;
+}
+
+ImageCache::ImageCache(const int max_memory_mb) : max_memory_mb(max_memory_mb)
+{
+  /* Not shared with OSL, so that the memory limit only applies to the images of this scene. */
+  TextureSystem *ts = TextureSystem::create(false);
+
+  /* Untiled images are tiled and mip-mapped in memory, so they benefit from filtered lookups
+   * too. For the best performance files should be converted to tiled .tx or OpenEXR files. */
+  ts->attribute("automip", 1);
+  ts->attribute("autotile", 64);
+  ts->attribute("max_memory_MB", float(max_memory_mb));
+  /* Alpha is associated in the lookup, matching the images that are fully loaded. */
+  ts->attribute("unassociatedalpha", 1);
+
+  texture_system = ts;
+}
+
+ImageCache::~ImageCache()
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+  ts->invalidate_all(true);
+  TextureSystem::destroy(ts);
+}
+
+void ImageCache::set_max_memory(const int max_memory_mb_)
+{
+  if (max_memory_mb == max_memory_mb_) {
+    return;
+  }
+
+  max_memory_mb = max_memory_mb_;
+  ((TextureSystem *)texture_system)->attribute("max_memory_MB", float(max_memory_mb));
+}
+
+bool ImageCache::supports_image(const ImageManager::Image *img)
+{
+  if (img->loader->osl_filepath().empty() || img->params.animated) {
+    return false;
+  }
+
+  const ImageMetaData &metadata = img->metadata;
+  if (metadata.channels <= 0 || metadata.depth > 1) {
+    return false;
+  }
+
+  /* The alpha channel of these is stored unmodified, which the texture system doesn't support
+   * for files with unassociated alpha. */
+  return !(ColorSpaceManager::colorspace_is_data(img->params.colorspace) ||
+           img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
+}
+
+uint64_t ImageCache::add_image(const ImageManager::Image *img)
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+  const ustring filepath = img->loader->osl_filepath();
+
+  TextureSystem::TextureHandle *handle = ts->get_texture_handle(filepath);
+  if (handle == nullptr || !ts->good(handle)) {
+    return 0;
+  }
+
+  OIIO::ImageSpec spec;
+  if (!ts->get_imagespec(handle, nullptr, 0, spec)) {
+    return 0;
+  }
+
+  /* Formats where the image loader applies conversions that the texture system doesn't. */
+  ustring format;
+  ts->get_texture_info(handle, nullptr, 0, ustring("fileformat"), OIIO::TypeString, &format);
+  if ((format == "jpeg" && spec.nchannels == 4) || format == "targa" || format == "dds" ||
+      format == "psd")
+  {
+    VLOG_WORK << "Not using texture cache for " << img->loader->name() << ", unsupported "
+              << format << " file.";
+    return 0;
+  }
+
+  const ImageMetaData &metadata = img->metadata;
+  ImageCacheEntry *entry = new ImageCacheEntry();
+  entry->texture_system = ts;
+  entry->handle = handle;
+  entry->filepath = filepath;
+  entry->processor = nullptr;
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    entry->processor = ColorSpaceManager::get_processor(metadata.colorspace);
+  }
+  entry->channels = min(metadata.channels, 4);
+  entry->ignore_alpha = (img->params.alpha_type == IMAGE_ALPHA_IGNORE);
+  entry->associate_alpha = !entry->ignore_alpha && entry->channels == 4 &&
+                           spec.get_int_attribute("oiio:UnassociatedAlpha", 0);
+  entry->interpolation = image_cache_interpolation(img->params.interpolation);
+  /* Closest interpolation is typically used for pixel art, don't blur it with mip-maps. */
+  entry->mipmode = (img->params.interpolation == INTERPOLATION_CLOSEST) ?
+                       TextureOpt::MipModeNoMIP :
+                       TextureOpt::MipModeTrilinear;
+  entry->wrap = image_cache_wrap(img->params.extension);
+
+  VLOG_WORK << "Using texture cache for " << img->loader->name() << " ("
+            << ((spec.tile_width) ? "tiled" : "untiled") << " " << format << " file).";
+
+  return (uint64_t)entry;
+}
+
+void ImageCache::remove_image(const uint64_t handle)
+{
+  ImageCacheEntry *entry = (ImageCacheEntry *)handle;
+  if (entry == nullptr) {
+    return;
+  }
+
+  /* Release the tiles, the file might be modified before it's used again. */
+  entry->texture_system->invalidate(entry->filepath);
+  delete entry;
+}
+
+void ImageCache::collect_statistics(ImageCacheStats *stats)
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+
+  int64_t texture_queries = 0, tile_lookups = 0, tile_misses = 0;
+  int64_t bytes_read = 0, memory_used = 0;
+  float io_time = 0.0f;
+  ts->getattribute("stat:texture_queries", OIIO::TypeInt64, &texture_queries);
+  ts->getattribute("stat:find_tile_calls", OIIO::TypeInt64, &tile_lookups);
+  ts->getattribute("stat:find_tile_cache_misses", OIIO::TypeInt64, &tile_misses);
+  ts->getattribute("stat:bytes_read", OIIO::TypeInt64, &bytes_read);
+  ts->getattribute("stat:cache_memory_used", OIIO::TypeInt64, &memory_used);
+  ts->getattribute("stat:fileio_time", OIIO::TypeFloat, &io_time);
+
+  stats->used = (texture_queries > 0);
+  stats->texture_queries = texture_queries;
+  stats->tile_lookups = tile_lookups;
+  stats->tile_misses = tile_misses;
+  stats->bytes_read = bytes_read;
+  stats->memory_used = memory_used;
+  stats->io_time = io_time;
+}
+
+/* Coordinates follow the kernel convention with the origin at the bottom of the image,
+ * derivatives are the change of the coordinates along the screen x and y axis. */
+
+void ImageCache::lookup(const uint64_t cache_handle,
+                        const float x,
+                        const float y,
+                        const float dxdx,
+                        const float dydx,
+                        const float dxdy,
+                        const float dydy,
+                        float *result)
+{
+  const ImageCacheEntry *entry = (const ImageCacheEntry *)cache_handle;
+
+  TextureOpt options;
+  options.interpmode = entry->interpolation;
+  options.mipmode = entry->mipmode;
+  options.swrap = entry->wrap;
+  options.twrap = entry->wrap;
+
+  /* The texture system uses the same pixel centers as the kernel but has its origin at the
+   * top of the image. The per-thread info is found by the texture system itself. */
+  float pixel[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  if (!entry->texture_system->texture(entry->handle,
+                                      nullptr,
+                                      options,
+                                      x,
+                                      1.0f - y,
+                                      dxdx,
+                                      -dydx,
+                                      dxdy,
+                                      -dydy,
+                                      entry->channels,
+                                      pixel))
+  {
+    result[0] = TEX_IMAGE_MISSING_R;
+    result[1] = TEX_IMAGE_MISSING_G;
+    result[2] = TEX_IMAGE_MISSING_B;
+    result[3] = TEX_IMAGE_MISSING_A;
+    return;
+  }
+
+  /* Same conversion to RGBA as for images that are fully loaded. */
+  switch (entry->channels) {
+    case 1:
+      pixel[1] = pixel[2] = pixel[0];
+      pixel[3] = 1.0f;
+      break;
+    case 2:
+      pixel[3] = pixel[1];
+      pixel[1] = pixel[2] = pixel[0];
+      break;
+    case 3:
+      pixel[3] = 1.0f;
+      break;
+  }
+
+  if (entry->ignore_alpha) {
+    pixel[3] = 1.0f;
+  }
+  else if (entry->associate_alpha) {
+    pixel[0] *= pixel[3];
+    pixel[1] *= pixel[3];
+    pixel[2] *= pixel[3];
+  }
+
+  if (entry->processor) {
+    ColorSpaceManager::to_scene_linear(entry->processor, pixel, 4);
+  }
+
+  result[0] = pixel[0];
+  result[1] = pixel[1];
+  result[2] = pixel[2];
+  result[3] = pixel[3];
+}
+
+CCL_NAMESPACE_END
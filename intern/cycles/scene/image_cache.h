@@ -0,0 +1,58 @@
+/* SPDX-FileCopyrightText: 2011-2022 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include "scene/image.h"
+
+CCL_NAMESPACE_BEGIN
+
+class ImageCacheStats;
+
+/* Image Cache
+ *
+ * Out-of-core storage of image textures for CPU rendering. Instead of loading the full image
+ * into memory, tiles of the image are read on demand from the file and kept in a cache with a
+ * fixed memory limit, evicting least recently used tiles. Tiled and mip-mapped files (like .tx
+ * or tiled OpenEXR files) are read most efficiently, other images are tiled and mip-mapped in
+ * memory when they are first accessed.
+ *
+ * The kernel looks up pixels with the handle stored in #TextureInfo.cache_handle, through
+ * #ImageCache::lookup which the device stores in the kernel globals. */
+class ImageCache {
+ public:
+  explicit ImageCache(const int max_memory_mb);
+  ~ImageCache();
+
+  void set_max_memory(const int max_memory_mb);
+
+  /* Check if the image can be looked up through the cache, it has to be a 2D image file with
+   * pixels that don't need any processing beyond color space conversion. */
+  static bool supports_image(const ImageManager::Image *img);
+
+  /* Returns the handle of the image to be stored in #TextureInfo.cache_handle. */
+  uint64_t add_image(const ImageManager::Image *img);
+  void remove_image(const uint64_t handle);
+
+  void collect_statistics(ImageCacheStats *stats);
+
+  /* Kernel lookup of an image by its handle, passed to the device as #ImageCacheLookupFunction. */
+  static void lookup(uint64_t cache_handle,
+                     float x,
+                     float y,
+                     float dxdx,
+                     float dydx,
+                     float dxdy,
+                     float dydy,
+                     float *result);
+
+ protected:
+  void *texture_system;
+  int max_memory_mb;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __IMAGE_CACHE_H__ */
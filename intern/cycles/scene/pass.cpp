@@ -172,6 +172,7 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
       break;
     case PASS_MIST:
       pass_info.num_components = 1;
+      pass_info.use_half_storage = true;
       break;
     case PASS_POSITION:
       pass_info.num_components = 3;
@@ -179,12 +180,15 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
       break;
     case PASS_NORMAL:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
     case PASS_ROUGHNESS:
       pass_info.num_components = 1;
+      pass_info.use_half_storage = true;
       break;
     case PASS_UV:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
     case PASS_MOTION:
       pass_info.num_components = 4;
@@ -206,12 +210,14 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
       break;
     case PASS_AO:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
 
     case PASS_DIFFUSE_COLOR:
     case PASS_GLOSSY_COLOR:
     case PASS_TRANSMISSION_COLOR:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
     case PASS_DIFFUSE:
       pass_info.num_components = 3;
@@ -281,9 +287,11 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
 
     case PASS_DENOISING_NORMAL:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
     case PASS_DENOISING_ALBEDO:
       pass_info.num_components = 3;
+      pass_info.use_half_storage = true;
       break;
     case PASS_DENOISING_DEPTH:
       pass_info.num_components = 1;
@@ -322,9 +330,11 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
 
     case PASS_AOV_COLOR:
       pass_info.num_components = 4;
+      pass_info.use_half_storage = true;
       break;
     case PASS_AOV_VALUE:
       pass_info.num_components = 1;
+      pass_info.use_half_storage = true;
       break;
 
     case PASS_BAKE_PRIMITIVE:
@@ -44,6 +44,11 @@ struct PassInfo {
 
   /* Pass supports denoising. */
   bool support_denoise = false;
+
+  /* Pass values are data in a limited range, which can be stored as half float outside of the
+   * render buffers without visible loss of precision. Light passes are accumulated with a high
+   * dynamic range, and ID or sample count passes need exact values. */
+  bool use_half_storage = false;
 };
 
 class Pass : public Node {
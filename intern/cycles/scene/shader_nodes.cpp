@@ -393,6 +393,15 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
       flags |= NODE_IMAGE_ALPHA_UNASSOCIATE;
     }
   }
+  if (compiler.scene->params.use_texture_cache && projection == NODE_IMAGE_PROJ_FLAT &&
+      tex_mapping.skip() && vector_in->link &&
+      vector_in->link->parent->type == TextureCoordinateNode::get_node_type() &&
+      vector_in->link == vector_in->link->parent->output("UV") &&
+      !((TextureCoordinateNode *)vector_in->link->parent)->get_from_dupli())
+  {
+    /* The image cache selects mip levels based on the differentials of the default UV map. */
+    flags |= NODE_IMAGE_UV_DIFFERENTIALS;
+  }
 
   if (projection != NODE_IMAGE_PROJ_BOX) {
     /* If there only is one image (a very common case), we encode it as a negative value. */
@@ -212,6 +212,38 @@ string MeshStats::full_report(int indent_level)
 
 /* Image statistics. */
 
+ImageCacheStats::ImageCacheStats()
+    : used(false),
+      texture_queries(0),
+      tile_lookups(0),
+      tile_misses(0),
+      bytes_read(0),
+      memory_used(0),
+      io_time(0.0)
+{
+}
+
+string ImageCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const double hit_rate = (tile_lookups) ? 1.0 - double(tile_misses) / double(tile_lookups) :
+                                           1.0;
+  string result = "";
+  result += string_printf("%sTexture queries: %s\n",
+                          indent.c_str(),
+                          string_human_readable_number(texture_queries).c_str());
+  result += string_printf("%sTile hit rate: %.2f%% (%s misses)\n",
+                          indent.c_str(),
+                          hit_rate * 100.0,
+                          string_human_readable_number(tile_misses).c_str());
+  result += string_printf("%sMemory: %s, read from disk: %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str(),
+                          string_human_readable_size(bytes_read).c_str());
+  result += string_printf("%sI/O time: %fs\n", indent.c_str(), io_time);
+  return result;
+}
+
 ImageStats::ImageStats() {}
 
 string ImageStats::full_report(int indent_level)
@@ -219,6 +251,9 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (cache.used) {
+    result += indent + "Texture cache:\n" + cache.full_report(indent_level + 1);
+  }
   return result;
 }
 
@@ -150,6 +150,25 @@ class MeshStats {
   NamedSizeStats geometry;
 };
 
+/* Statistics about the texture cache used for out-of-core image textures. */
+class ImageCacheStats {
+ public:
+  ImageCacheStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Whether any image was rendered through the cache. */
+  bool used;
+
+  uint64_t texture_queries;
+  uint64_t tile_lookups;
+  uint64_t tile_misses;
+  size_t bytes_read;
+  size_t memory_used;
+  double io_time;
+};
+
 /* Statistics about images held in memory. */
 class ImageStats {
  public:
@@ -159,6 +178,7 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  ImageCacheStats cache;
 };
 
 /* Render process statistics. */
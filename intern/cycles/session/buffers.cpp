@@ -101,6 +101,7 @@ NODE_DEFINE(BufferParams)
   SOCKET_FLOAT(exposure, "Exposure", 1.0f);
   SOCKET_BOOLEAN(use_approximate_shadow_catcher, "Use Approximate Shadow Catcher", false);
   SOCKET_BOOLEAN(use_transparent_background, "Transparent Background", false);
+  SOCKET_BOOLEAN(use_half_tile_passes, "Use Half Tile Passes", false);
 
   /* Notes:
    *  - Skip passes since they do not follow typical container socket definition.
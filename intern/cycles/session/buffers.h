@@ -101,6 +101,7 @@ class BufferParams : public Node {
   float exposure = 1.0f;
   bool use_approximate_shadow_catcher = false;
   bool use_transparent_background = false;
+  bool use_half_tile_passes = false;
 
   BufferParams();
 
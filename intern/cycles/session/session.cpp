@@ -517,6 +517,7 @@ void Session::do_delayed_reset()
   buffer_params_.use_approximate_shadow_catcher =
       scene->film->get_use_approximate_shadow_catcher();
   buffer_params_.use_transparent_background = scene->background->get_transparent();
+  buffer_params_.use_half_tile_passes = params.use_half_tile_passes;
 
   /* Tile and work scheduling. */
   tile_manager_.reset_scheduling(buffer_params_, get_effective_tile_size());
@@ -524,7 +525,9 @@ void Session::do_delayed_reset()
 
   /* Passes. */
   /* When multiple tiles are used SAMPLE_COUNT pass is used to keep track of possible partial
-   * tile results. It is safe to use generic update function here which checks for changes since
+   * tile results. The half float channels of the tile files are also stored relative to it, so
+   * it is needed for #use_half_tile_passes even when adaptive sampling is off.
+   * It is safe to use generic update function here which checks for changes since
    * changes in tile settings re-creates session, which ensures film is fully updated on tile
    * changes. */
   scene->film->update_passes(scene, tile_manager_.has_multiple_tiles());
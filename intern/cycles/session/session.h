@@ -55,6 +55,9 @@ class SessionParams {
   bool use_auto_tile;
   int tile_size;
 
+  /* Store passes which don't need full precision as half float in tile files. */
+  bool use_half_tile_passes;
+
   bool use_resolution_divider;
 
   ShadingSystem shadingsystem;
@@ -78,6 +81,7 @@ class SessionParams {
 
     use_auto_tile = true;
     tile_size = 2048;
+    use_half_tile_passes = false;
 
     use_resolution_divider = true;
 
@@ -92,7 +96,8 @@ class SessionParams {
              background == params.background && experimental == params.experimental &&
              pixel_size == params.pixel_size && threads == params.threads &&
              use_profiling == params.use_profiling && shadingsystem == params.shadingsystem &&
-             use_auto_tile == params.use_auto_tile && tile_size == params.tile_size);
+             use_auto_tile == params.use_auto_tile && tile_size == params.tile_size &&
+             use_half_tile_passes == params.use_half_tile_passes);
   }
 };
 
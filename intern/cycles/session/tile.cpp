@@ -71,6 +71,65 @@ static std::vector<std::string> exr_channel_names_for_passes(const BufferParams
   return channel_names;
 }
 
+/* Channels of the passes which are stored as half float in the tile file. The channel indices
+ * match the offsets of the pass components in the render buffers. */
+static vector<int> tile_half_channels(const BufferParams &buffer_params)
+{
+  vector<int> half_channels;
+  if (!buffer_params.use_half_tile_passes) {
+    return half_channels;
+  }
+
+  /* Values are stored relative to the number of samples of the pixel, see
+   * #tile_half_channels_num_samples. Tile files are only written when rendering with multiple
+   * tiles, and the session always adds the sample count pass in that case. */
+  DCHECK_NE(buffer_params.get_pass_offset(PASS_SAMPLE_COUNT), PASS_UNUSED);
+  if (buffer_params.get_pass_offset(PASS_SAMPLE_COUNT) == PASS_UNUSED) {
+    return half_channels;
+  }
+
+  for (const BufferPass &pass : buffer_params.passes) {
+    if (pass.offset == PASS_UNUSED) {
+      continue;
+    }
+
+    const PassInfo pass_info = pass.get_info();
+    if (!pass_info.use_half_storage) {
+      continue;
+    }
+
+    for (int i = 0; i < pass_info.num_components; ++i) {
+      half_channels.push_back(pass.offset + i);
+    }
+  }
+
+  return half_channels;
+}
+
+/* Number of samples the values of half float channels of the pixel are divided by. The render
+ * buffers contain the sum of all samples, which easily exceeds the half float range. Storing the
+ * sum divided by the number of samples keeps values in the range of the pass itself.
+ *
+ * The number of samples is taken from the sample count pass, which holds the samples actually
+ * rendered for the pixel, also with adaptive sampling or a cancelled render. It is stored as
+ * float in the file, so reading the file restores the values with the same number. */
+static float tile_half_channels_num_samples(const float *pixel, const int pass_sample_count)
+{
+  const uint num_samples = __float_as_uint(pixel[pass_sample_count]);
+  return (num_samples > 0) ? float(num_samples) : 1.0f;
+}
+
+/* Round to the nearest value representable as half float. Used to measure the precision loss of
+ * half float channels, the actual conversion happens when OpenImageIO writes the file. */
+static float round_to_half(const float value)
+{
+  int exponent;
+  frexpf(value, &exponent);
+  /* 11 significant bits for normalized values, fixed step for denormals. */
+  const float step = ldexpf(1.0f, max(exponent, -13) - 11);
+  return roundf(value / step) * step;
+}
+
 inline string node_socket_attribute_name(const SocketType &socket, const string &attr_name_prefix)
 {
   return attr_name_prefix + string(socket.name);
@@ -288,6 +347,15 @@ static bool configure_image_spec_from_buffer(ImageSpec *image_spec,
 
   image_spec->channelnames = std::move(channel_names);
 
+  /* Per-channel formats are only needed when some of the passes are stored as half float. */
+  const vector<int> half_channels = tile_half_channels(buffer_params);
+  if (!half_channels.empty()) {
+    image_spec->channelformats.assign(num_channels, TypeDesc::FLOAT);
+    for (const int channel : half_channels) {
+      image_spec->channelformats[channel] = TypeDesc::HALF;
+    }
+  }
+
   if (!buffer_params_to_image_spec_atttributes(image_spec, buffer_params)) {
     return false;
   }
@@ -360,6 +428,7 @@ void TileManager::update(const BufferParams &params, const Scene *scene)
     /* TODO(sergey): Proper Error handling, so that if configuration has failed we don't attempt to
      * write to a partially configured file. */
     configure_image_spec_from_buffer(&write_state_.image_spec, buffer_params_, tile_size_);
+    write_state_.half_channels = tile_half_channels(buffer_params_);
 
     const DenoiseParams denoise_params = scene->integrator->get_denoise_params();
     const AdaptiveSampling adaptive_sampling = scene->integrator->get_adaptive_sampling();
@@ -378,6 +447,7 @@ void TileManager::update(const BufferParams &params, const Scene *scene)
   }
   else {
     write_state_.image_spec = ImageSpec();
+    write_state_.half_channels.clear();
     overscan_ = 0;
   }
 }
@@ -468,6 +538,11 @@ bool TileManager::open_tile_output()
 
   write_state_.num_tiles_written = 0;
 
+  write_state_.num_half_values = 0;
+  write_state_.num_half_values_clamped = 0;
+  write_state_.half_max_error = 0.0f;
+  write_state_.half_max_relative_error = 0.0f;
+
   VLOG_WORK << "Opened tile file " << write_state_.filename;
 
   return true;
@@ -519,10 +594,12 @@ bool TileManager::write_tile(const RenderBuffers &tile_buffers)
   /* If there is an overscan used for the tile copy pixels into single continuous block of memory
    * without any "gaps".
    * This is a workaround for bug in OIIO (https://github.com/OpenImageIO/oiio/pull/3176).
-   * Our task reference: #93008. */
+   * Our task reference: #93008.
+   *
+   * Channels stored as half float are modified before writing, so those need a copy as well. */
   if (tile_params.window_x || tile_params.window_y ||
       tile_params.window_width != tile_params.width ||
-      tile_params.window_height != tile_params.height)
+      tile_params.window_height != tile_params.height || !write_state_.half_channels.empty())
   {
     pixel_storage.resize(pass_stride * tile_params.window_width * tile_params.window_height);
     float *pixels_continuous = pixel_storage.data();
@@ -539,6 +616,11 @@ bool TileManager::write_tile(const RenderBuffers &tile_buffers)
     pixels = pixel_storage.data();
   }
 
+  if (!write_state_.half_channels.empty()) {
+    convert_half_channels(pixel_storage.data(),
+                          int64_t(tile_params.window_width) * tile_params.window_height);
+  }
+
   VLOG_WORK << "Write tile at " << tile_x << ", " << tile_y;
 
   /* The image tile sizes in the OpenEXR file are different from the size of our big tiles. The
@@ -576,6 +658,49 @@ bool TileManager::write_tile(const RenderBuffers &tile_buffers)
   return true;
 }
 
+void TileManager::convert_half_channels(float *pixels, const int64_t num_pixels)
+{
+  const int64_t pass_stride = buffer_params_.pass_stride;
+  const int pass_sample_count = buffer_params_.get_pass_offset(PASS_SAMPLE_COUNT);
+
+  int64_t num_values_clamped = 0;
+  float max_error = 0.0f;
+  float max_relative_error = 0.0f;
+
+  /* Largest finite half float value, values out of range would be stored as infinity. */
+  const float half_max = 65504.0f;
+  /* Smallest normalized half float value. Below it the precision of half floats is a fixed step
+   * instead of a number of significant bits, so the relative error is not meaningful. */
+  const float half_min_normal = 6.103515625e-05f;
+
+  for (int64_t i = 0; i < num_pixels; ++i) {
+    float *pixel = pixels + i * pass_stride;
+    const float num_samples = tile_half_channels_num_samples(pixel, pass_sample_count);
+    for (const int channel : write_state_.half_channels) {
+      const float value = pixel[channel] / num_samples;
+      if (isfinite_safe(value) && fabsf(value) > half_max) {
+        pixel[channel] = copysignf(half_max, value);
+        ++num_values_clamped;
+        continue;
+      }
+      if (isfinite_safe(value)) {
+        const float error = fabsf(value - round_to_half(value));
+        max_error = max(max_error, error);
+        if (fabsf(value) >= half_min_normal) {
+          max_relative_error = max(max_relative_error, error / fabsf(value));
+        }
+      }
+      pixel[channel] = value;
+    }
+  }
+
+  write_state_.num_half_values += num_pixels * write_state_.half_channels.size();
+  write_state_.num_half_values_clamped += num_values_clamped;
+  write_state_.half_max_error = max(write_state_.half_max_error, max_error);
+  write_state_.half_max_relative_error = max(write_state_.half_max_relative_error,
+                                             max_relative_error);
+}
+
 void TileManager::finish_write_tiles()
 {
   if (!write_state_.tile_out) {
@@ -618,6 +743,19 @@ void TileManager::finish_write_tiles()
   VLOG_WORK << "Tile file size is "
             << string_human_readable_number(path_file_size(write_state_.filename)) << " bytes.";
 
+  if (!write_state_.half_channels.empty()) {
+    const size_t num_half_bytes_saved = size_t(buffer_params_.width) * buffer_params_.height *
+                                        write_state_.half_channels.size() *
+                                        (sizeof(float) - sizeof(half));
+    VLOG_WORK << "Stored " << write_state_.half_channels.size() << " of "
+              << buffer_params_.pass_stride << " channels as half float, saving "
+              << string_human_readable_size(num_half_bytes_saved)
+              << " of uncompressed pixels. Maximum rounding error " << write_state_.half_max_error
+              << " absolute, " << write_state_.half_max_relative_error << " relative, "
+              << write_state_.num_half_values_clamped << " of "
+              << write_state_.num_half_values << " values out of half float range.";
+  }
+
   /* Advance the counter upon explicit finish of the file.
    * Makes it possible to re-use tile manager for another scene, and avoids unnecessary increments
    * of the tile-file-within-session index. */
@@ -654,6 +792,22 @@ bool TileManager::read_full_buffer_from_disk(const string_view filename,
     return false;
   }
 
+  /* Restore the sum of samples in channels which were stored as half float. */
+  const vector<int> half_channels = tile_half_channels(buffer_params);
+  if (!half_channels.empty()) {
+    const int pass_sample_count = buffer_params.get_pass_offset(PASS_SAMPLE_COUNT);
+    const int64_t num_pixels = int64_t(buffer_params.width) * buffer_params.height;
+    float *pixels = buffers->buffer.data();
+
+    for (int64_t i = 0; i < num_pixels; ++i) {
+      float *pixel = pixels + i * buffer_params.pass_stride;
+      const float num_samples = tile_half_channels_num_samples(pixel, pass_sample_count);
+      for (const int channel : half_channels) {
+        pixel[channel] *= num_samples;
+      }
+    }
+  }
+
   if (!in->close()) {
     LOG(ERROR) << "Error closing tile file " << in->geterror();
     return false;
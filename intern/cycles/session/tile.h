@@ -124,6 +124,10 @@ class TileManager {
   bool open_tile_output();
   bool close_tile_output();
 
+  /* Prepare channels which are stored as half float for writing, and gather statistics about the
+   * precision loss. The pixels are continuous, without overscan. */
+  void convert_half_channels(float *pixels, const int64_t num_pixels);
+
   string temp_dir_;
 
   /* Part of an on-disk tile file name which avoids conflicts between several Cycles instances or
@@ -172,6 +176,16 @@ class TileManager {
     unique_ptr<ImageOutput> tile_out;
 
     int num_tiles_written = 0;
+
+    /* Channels which are stored as half float, empty when all channels are stored as float. */
+    vector<int> half_channels;
+
+    /* Statistics about the conversion of channels to half float, reported when the file is
+     * finished. The errors are measured on the pass values averaged over the samples. */
+    int64_t num_half_values = 0;
+    int64_t num_half_values_clamped = 0;
+    float half_max_error = 0.0f;
+    float half_max_relative_error = 0.0f;
   } write_state_;
 };
 
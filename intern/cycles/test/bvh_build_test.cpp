@@ -0,0 +1,154 @@
+/* SPDX-FileCopyrightText: 2011-2022 Blender Foundation
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "bvh/build.h"
+#include "bvh/node.h"
+#include "bvh/params.h"
+
+#include "scene/mesh.h"
+#include "scene/object.h"
+
+#include "util/array.h"
+#include "util/hash.h"
+#include "util/progress.h"
+#include "util/task.h"
+#include "util/time.h"
+
+/* Print build times and statistics of the test builds. */
+#define DO_PERF_TESTS 0
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Enough triangles for the top levels of the tree to be binned multi-threaded. */
+const int num_test_triangles = 200000;
+
+/* Small triangles scattered in a unit cube, with some clustering so that splits are not
+ * trivial to find. */
+void fill_test_mesh(Mesh &mesh, const int num_triangles)
+{
+  mesh.reserve_mesh(num_triangles * 3, num_triangles);
+
+  for (int i = 0; i < num_triangles; i++) {
+    const float cluster = (float)(i % 16) / 16.0f;
+    const float3 center = make_float3(hash_uint2_to_float(i, 0) * 0.5f + cluster * 0.5f,
+                                      hash_uint2_to_float(i, 1),
+                                      hash_uint2_to_float(i, 2) * cluster);
+    for (int v = 0; v < 3; v++) {
+      const float3 offset = make_float3(hash_uint2_to_float(i, 3 + v * 3),
+                                        hash_uint2_to_float(i, 4 + v * 3),
+                                        hash_uint2_to_float(i, 5 + v * 3));
+      mesh.add_vertex(center + (offset - make_float3(0.5f)) * 0.01f);
+    }
+    mesh.add_triangle(i * 3, i * 3 + 1, i * 3 + 2, 0, false);
+  }
+}
+
+struct BuildResult {
+  float sah_cost;
+  int num_nodes;
+  int num_triangles;
+  BoundBox bounds;
+};
+
+/* Build the BVH of the mesh and compute statistics of the tree. */
+BuildResult build_test_bvh(Mesh &mesh, const bool use_spatial_split)
+{
+  Object object;
+  object.set_geometry(&mesh);
+  vector<Object *> objects;
+  objects.push_back(&object);
+
+  BVHParams params;
+  params.use_spatial_split = use_spatial_split;
+
+  array<int> prim_type;
+  array<int> prim_index;
+  array<int> prim_object;
+  array<float2> prim_time;
+  Progress progress;
+
+  BVHBuild bvh_build(objects, prim_type, prim_index, prim_object, prim_time, params, progress);
+
+#if DO_PERF_TESTS
+  const double start_time = time_dt();
+#endif
+  BVHNode *root = bvh_build.run();
+
+  BuildResult result;
+  result.sah_cost = root->computeSubtreeSAHCost(params);
+  result.num_nodes = root->getSubtreeSize(BVH_STAT_NODE_COUNT);
+  result.num_triangles = root->getSubtreeSize(BVH_STAT_TRIANGLE_COUNT);
+  result.bounds = root->bounds;
+
+#if DO_PERF_TESTS
+  printf("BVH build (%s, %d threads): %d triangles, %.3f s, SAH cost %.3f, %d nodes\n",
+         (use_spatial_split) ? "spatial split" : "binning",
+         TaskScheduler::max_concurrency(),
+         (int)mesh.num_triangles(),
+         time_dt() - start_time,
+         result.sah_cost,
+         result.num_nodes);
+#endif
+
+  root->deleteSubtree();
+  return result;
+}
+
+void test_build_deterministic(const bool use_spatial_split)
+{
+  Mesh mesh;
+  fill_test_mesh(mesh, num_test_triangles);
+  mesh.compute_bounds();
+
+  /* Reference build without any parallel binning. */
+  TaskScheduler::init(1);
+  const BuildResult result_single = build_test_bvh(mesh, use_spatial_split);
+  TaskScheduler::exit();
+
+  /* Binning large ranges in parallel must give the same tree as the single threaded build, on
+   * every build. */
+  TaskScheduler::init(0);
+  const BuildResult result_a = build_test_bvh(mesh, use_spatial_split);
+  const BuildResult result_b = build_test_bvh(mesh, use_spatial_split);
+  TaskScheduler::exit();
+
+  EXPECT_EQ(result_a.sah_cost, result_single.sah_cost);
+  EXPECT_EQ(result_a.num_nodes, result_single.num_nodes);
+  EXPECT_EQ(result_a.num_triangles, result_single.num_triangles);
+
+  EXPECT_EQ(result_a.sah_cost, result_b.sah_cost);
+  EXPECT_EQ(result_a.num_nodes, result_b.num_nodes);
+  EXPECT_EQ(result_a.num_triangles, result_b.num_triangles);
+
+  /* Spatial splits may reference triangles more than once. */
+  if (use_spatial_split) {
+    EXPECT_GE(result_a.num_triangles, num_test_triangles);
+  }
+  else {
+    EXPECT_EQ(result_a.num_triangles, num_test_triangles);
+  }
+
+  for (int dim = 0; dim < 3; dim++) {
+    EXPECT_LE(result_a.bounds.min[dim], mesh.bounds.min[dim]);
+    EXPECT_GE(result_a.bounds.max[dim], mesh.bounds.max[dim]);
+  }
+}
+
+}  // namespace
+
+TEST(bvh_build, binning)
+{
+  test_build_deterministic(false);
+}
+
+TEST(bvh_build, spatial_split)
+{
+  test_build_deterministic(true);
+}
+
+CCL_NAMESPACE_END
@@ -4,8 +4,18 @@
 
 #include "testing/testing.h"
 
+#include <OpenImageIO/filesystem.h>
+
+#include "device/device.h"
 #include "integrator/tile.h"
+#include "scene/colorspace.h"
+#include "scene/scene.h"
+#include "session/buffers.h"
+#include "session/tile.h"
+#include "util/image.h"
 #include "util/math.h"
+#include "util/path.h"
+#include "util/stats.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -36,4 +46,146 @@ TEST(tile_calculate_best_size, Extreme)
             TileSize(1, 1, 1024));
 }
 
+namespace {
+
+/* Value of a pass component averaged over the samples of a pixel. */
+float tile_file_test_value(const int x, const int y, const int component)
+{
+  return sinf(float(x * 3 + y * 5 + component) * 0.1f);
+}
+
+/* Number of samples of a pixel, varying per pixel like with adaptive sampling. */
+int tile_file_test_num_samples(const int x, const int y)
+{
+  return 1 + (x * 7 + y * 3) % 500;
+}
+
+BufferPass tile_file_test_pass(const PassType type, const char *name)
+{
+  BufferPass pass;
+  pass.type = type;
+  pass.mode = PassMode::NOISY;
+  pass.name = ustring(name);
+  return pass;
+}
+
+}  // namespace
+
+TEST(tile_manager, HalfChannelsRoundTrip)
+{
+  ColorSpaceManager::init_fallback_config();
+
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  unique_ptr<Device> device(Device::create(device_info, stats, profiler));
+  SceneParams scene_params;
+  Scene scene(scene_params, device.get());
+
+  /* Two tiles, with the normal pass stored as half float. */
+  BufferParams params;
+  params.width = params.window_width = params.full_width = 256;
+  params.height = params.window_height = params.full_height = 128;
+  params.passes.push_back(tile_file_test_pass(PASS_COMBINED, "Combined"));
+  params.passes.push_back(tile_file_test_pass(PASS_NORMAL, "Normal"));
+  params.passes.push_back(tile_file_test_pass(PASS_SAMPLE_COUNT, "Sample Count"));
+  params.passes[0].offset = 0;
+  params.passes[1].offset = 4;
+  params.passes[2].offset = 7;
+  params.update_passes();
+  /* More samples than rendered in any pixel, the values are scaled by the sample count pass. */
+  params.samples = 1000;
+  params.use_half_tile_passes = true;
+
+  const int pass_combined = params.get_pass_offset(PASS_COMBINED);
+  const int pass_normal = params.get_pass_offset(PASS_NORMAL);
+  const int pass_sample_count = params.get_pass_offset(PASS_SAMPLE_COUNT);
+  ASSERT_EQ(params.pass_stride, 8);
+
+  TileManager tile_manager;
+  tile_manager.set_temp_dir(OIIO::Filesystem::temp_directory_path());
+
+  string filename;
+  tile_manager.full_buffer_written_cb = [&](string_view written_filename) {
+    filename = written_filename;
+  };
+
+  tile_manager.reset_scheduling(params, make_int2(128, 128));
+  tile_manager.update(params, &scene);
+  ASSERT_EQ(tile_manager.get_num_tiles(), 2);
+
+  while (tile_manager.next()) {
+    const Tile &tile = tile_manager.get_current_tile();
+
+    BufferParams tile_params = params;
+    tile_params.width = tile_params.window_width = tile.width;
+    tile_params.height = tile_params.window_height = tile.height;
+    tile_params.full_x = tile.x;
+    tile_params.full_y = tile.y;
+    tile_params.update_offset_stride();
+
+    RenderBuffers tile_buffers(device.get());
+    tile_buffers.reset(tile_params);
+
+    for (int y = 0; y < tile.height; y++) {
+      for (int x = 0; x < tile.width; x++) {
+        float *pixel = tile_buffers.buffer.data() +
+                       (int64_t(y) * tile.width + x) * params.pass_stride;
+        const int num_samples = tile_file_test_num_samples(tile.x + x, tile.y + y);
+        for (int i = 0; i < 4; i++) {
+          pixel[pass_combined + i] = 1000.5f * num_samples;
+        }
+        for (int i = 0; i < 3; i++) {
+          pixel[pass_normal + i] = tile_file_test_value(tile.x + x, tile.y + y, i) * num_samples;
+        }
+        pixel[pass_sample_count] = __uint_as_float(num_samples);
+      }
+    }
+
+    ASSERT_TRUE(tile_manager.write_tile(tile_buffers));
+  }
+
+  tile_manager.finish_write_tiles();
+  ASSERT_FALSE(filename.empty());
+
+  /* The normal pass is stored as half float, other passes as float. */
+  {
+    unique_ptr<ImageInput> in(ImageInput::open(filename));
+    ASSERT_TRUE(in);
+    const ImageSpec &spec = in->spec();
+    for (int channel = 0; channel < params.pass_stride; channel++) {
+      const bool is_half = (channel >= pass_normal && channel < pass_normal + 3);
+      EXPECT_EQ(spec.channelformat(channel), is_half ? TypeDesc::HALF : TypeDesc::FLOAT);
+    }
+    in->close();
+  }
+
+  RenderBuffers buffers(device.get());
+  DenoiseParams denoise_params;
+  ASSERT_TRUE(tile_manager.read_full_buffer_from_disk(filename, &buffers, &denoise_params));
+  ASSERT_EQ(buffers.params.width, params.width);
+  ASSERT_EQ(buffers.params.height, params.height);
+  ASSERT_EQ(buffers.params.pass_stride, params.pass_stride);
+
+  for (int y = 0; y < params.height; y++) {
+    for (int x = 0; x < params.width; x++) {
+      const float *pixel = buffers.buffer.data() +
+                           (int64_t(y) * params.width + x) * params.pass_stride;
+      const int num_samples = tile_file_test_num_samples(x, y);
+
+      EXPECT_EQ(pixel[pass_combined], 1000.5f * num_samples);
+      EXPECT_EQ(__float_as_uint(pixel[pass_sample_count]), uint(num_samples));
+
+      /* Half floats have 11 significant bits, and a fixed step of 2^-24 for denormals. */
+      for (int i = 0; i < 3; i++) {
+        const float expected = tile_file_test_value(x, y, i) * num_samples;
+        const float tolerance = fabsf(expected) * 1e-3f + num_samples * 6e-8f;
+        EXPECT_NEAR(pixel[pass_normal + i], expected, tolerance);
+      }
+    }
+  }
+
+  path_remove(filename);
+}
+
 CCL_NAMESPACE_END
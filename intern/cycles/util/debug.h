@@ -46,6 +46,10 @@ class DebugFlags {
      * CPUs and GPUs can be selected here instead.
      */
     BVHLayout bvh_layout = BVH_LAYOUT_AUTO;
+
+    /* Render batches of paths kernel by kernel, like the GPU devices do, instead of rendering
+     * every path from start to end with the megakernel. */
+    bool wavefront = false;
   };
 
   /* Descriptor of CUDA feature-set to be used. */
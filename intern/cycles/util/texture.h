@@ -75,6 +75,8 @@ typedef enum ExtensionType {
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
+  /* Image in the CPU texture cache, pixels are looked up through the cache instead of data. */
+  uint64_t cache_handle;
   /* Data Type */
   uint data_type;
   /* Interpolation and extension type. */
@@ -86,6 +88,20 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+#ifndef __KERNEL_GPU__
+/* Look up pixels of an image in the out-of-core image cache on the CPU, see
+ * #TextureInfo.cache_handle. Results are written to a float array since the layout of float4
+ * depends on the instruction set the kernel is compiled for. */
+typedef void (*ImageCacheLookupFunction)(uint64_t cache_handle,
+                                         float x,
+                                         float y,
+                                         float dxdx,
+                                         float dydx,
+                                         float dxdy,
+                                         float dydy,
+                                         float *result);
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
@@ -696,6 +696,9 @@ class USERPREF_PT_system_memory(SystemPanel, CenterAlignMixIn, Panel):
         col.prop(edit, "undo_steps", text="Undo Steps")
         col.prop(edit, "undo_memory_limit", text="Undo Memory Limit")
         col.prop(edit, "use_global_undo")
+        sub = col.column()
+        sub.active = edit.use_global_undo
+        sub.prop(edit, "use_global_undo_compression", text="Compress")
 
         layout.separator()
 
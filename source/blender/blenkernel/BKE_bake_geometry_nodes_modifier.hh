@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "BLI_set.hh"
 #include "BLI_sub_frame.hh"
 
 #include "BKE_bake_items.hh"
@@ -14,6 +15,7 @@ struct NodesModifierData;
 struct Main;
 struct Object;
 struct Scene;
+struct TaskPool;
 
 namespace blender::bke::bake {
 
@@ -48,6 +50,44 @@ struct PrevCache {
   SubFrame frame;
 };
 
+struct NodeBakeCache;
+
+/**
+ * Loads baked frames from disk in a background thread before they are needed, so that playback
+ * does not have to wait for the disk.
+ */
+class FramePrefetcher : NonCopyable, NonMovable {
+ private:
+  std::mutex mutex_;
+  TaskPool *task_pool_ = nullptr;
+  /** Indices of the frames that are currently loaded in the background. */
+  Set<int> loading_frames_;
+  /** States of prefetched frames. The state is empty if the frame could not be loaded. */
+  Map<int, BakeState> loaded_frames_;
+
+ public:
+  FramePrefetcher();
+  ~FramePrefetcher();
+
+  /** Start loading the frame with the given index in #NodeBakeCache::frames in the background. */
+  void prefetch(const NodeBakeCache &bake_cache, int frame_index);
+
+  /**
+   * Get the state of the frame if it has been prefetched, waiting for it if it is still loading.
+   * \return None if the frame has not been prefetched.
+   */
+  std::optional<BakeState> take(int frame_index);
+
+  /**
+   * Free prefetched frames that are not in the given range, e.g. because playback jumped to
+   * another frame. Otherwise they would stay in memory until the cache is reset.
+   */
+  void discard_frames_outside(IndexRange frames);
+
+ private:
+  static void prefetch_task(TaskPool *pool, void *taskdata);
+};
+
 /**
  * Baked data that corresponds to either a Simulation Output or Bake node.
  */
@@ -59,12 +99,23 @@ struct NodeBakeCache {
   std::optional<std::string> blobs_dir;
   /** Used to avoid reading blobs multiple times for different frames. */
   std::unique_ptr<BlobReadSharing> blob_sharing;
+  /**
+   * Loads the frames that follow the last loaded frame. Declared after #blob_sharing because it
+   * has to be destructed first.
+   */
+  std::unique_ptr<FramePrefetcher> prefetcher;
   /** Used to avoid checking if a bake exists many times. */
   bool failed_finding_bake = false;
 
   /** Range spanning from the first to the last baked frame. */
   IndexRange frame_range() const;
 
+  /**
+   * Load the baked state of the frame from disk if that has not happened yet. The frames after
+   * it are loaded in the background, so that they are ready when playback reaches them.
+   */
+  void ensure_frame_loaded(int frame_index);
+
   void reset();
 };
 
@@ -41,6 +41,15 @@ class BlobReader {
    */
   [[nodiscard]] virtual bool read_as_stream(const BlobSlice &slice,
                                             FunctionRef<bool(std::istream &)> fn) const;
+
+  /**
+   * Provide access to the data of the given slice without copying it, e.g. because the blob is
+   * memory-mapped. The data stays valid as long as the returned sharing info has users. Like all
+   * implicitly shared data, it may only be modified when it has a single user.
+   * \return None if the data is not available this way, #read has to be used instead then.
+   */
+  [[nodiscard]] virtual std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BlobSlice &slice) const;
 };
 
 /**
@@ -62,6 +71,15 @@ class BlobWriter {
    */
   virtual BlobSlice write_as_stream(StringRef file_extension,
                                     FunctionRef<void(std::ostream &)> fn);
+
+  /**
+   * Whether large blobs should be compressed before they are written. Compressed blobs take less
+   * space on disk, but they have to be decompressed into a separate buffer when they are read.
+   */
+  virtual bool use_compression() const
+  {
+    return false;
+  }
 };
 
 /**
@@ -89,11 +107,17 @@ class BlobWriteSharing : NonCopyable, NonMovable {
    */
   Map<const ImplicitSharingInfo *, StoredByRuntimeValue> stored_by_runtime_;
 
+  struct StoredByContentValue {
+    BlobSlice slice;
+    /** The blob contains the data compressed with zstd. */
+    bool compressed;
+  };
+
   /**
    * Remembers where data was stored based on the hash of the data. This allows us to skip writing
    * the same array again if it has the same hash.
    */
-  Map<uint64_t, BlobSlice> slice_by_content_hash_;
+  Map<uint64_t, StoredByContentValue> stored_by_content_hash_;
 
  public:
   ~BlobWriteSharing();
@@ -145,17 +169,46 @@ class BlobReadSharing : NonCopyable, NonMovable {
 };
 
 /**
- * A specific #BlobReader that reads from disk.
+ * A specific #BlobReader that reads from disk. Blob files are memory-mapped, so that their data
+ * can be used without copying it into separate buffers.
  */
 class DiskBlobReader : public BlobReader {
  private:
   const std::string blobs_dir_;
+  /** When false, #read_mapped never provides data and everything is copied with #read. */
+  const bool use_mapping_;
   mutable std::mutex mutex_;
   mutable Map<std::string, std::unique_ptr<fstream>> open_input_streams_;
+  /**
+   * Keeps a user of every blob file that has been mapped by this reader. Null when the file could
+   * not be mapped.
+   */
+  mutable Map<std::string, const ImplicitSharingInfo *> mapped_files_;
 
  public:
-  DiskBlobReader(std::string blobs_dir);
+  DiskBlobReader(std::string blobs_dir, bool use_mapping = true);
+  ~DiskBlobReader();
+
   [[nodiscard]] bool read(const BlobSlice &slice, void *r_data) const override;
+  [[nodiscard]] std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BlobSlice &slice) const override;
+
+  /**
+   * Load the data of all files that have been mapped so far into memory, so that accessing it
+   * later does not have to wait for the disk. Used when loading data in the background.
+   */
+  void load_mapped_pages() const;
+
+  /**
+   * True when reading from one of the mapped files failed, e.g. because it was truncated or the
+   * disk had an error. The affected memory is filled with zeros then, so data read through the
+   * mapping should not be used. Reading again with a reader that does not use mapping reports
+   * the error properly.
+   */
+  bool any_mapped_io_error() const;
+
+ private:
+  const ImplicitSharingInfo *ensure_mapped_file(const std::string &blob_path) const;
 };
 
 /**
@@ -172,16 +225,29 @@ class DiskBlobWriter : public BlobWriter {
   std::fstream blob_stream_;
   /** Current position in the file. */
   int64_t current_offset_ = 0;
+  /** Number of bytes written to all files, including independent files. */
+  int64_t written_size_ = 0;
   /** Used to generate file names for bake data that is stored in independent files. */
   int independent_file_count_ = 0;
+  bool use_compression_ = false;
 
  public:
-  DiskBlobWriter(std::string blob_dir, std::string base_name);
+  DiskBlobWriter(std::string blob_dir, std::string base_name, bool use_compression = false);
 
   BlobSlice write(const void *data, int64_t size) override;
 
   BlobSlice write_as_stream(StringRef file_extension,
                             FunctionRef<void(std::ostream &)> fn) override;
+
+  bool use_compression() const override
+  {
+    return use_compression_;
+  }
+
+  int64_t written_size() const
+  {
+    return written_size_;
+  }
 };
 
 void serialize_bake(const BakeState &bake_state,
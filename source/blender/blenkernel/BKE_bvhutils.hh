@@ -17,7 +17,6 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_span.hh"
 
-struct BVHCache;
 struct BVHTree;
 struct MFace;
 struct Mesh;
@@ -166,16 +165,3 @@ void BKE_bvhtree_from_pointcloud_get(const PointCloud &pointcloud,
                                      BVHTreeFromPointCloud &r_data);
 
 void free_bvhtree_from_pointcloud(BVHTreeFromPointCloud *data);
-
-/**
- * BVHCache
- */
-
-/* Using local coordinates */
-
-bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree);
-BVHCache *bvhcache_init();
-/**
- * Frees a BVH-cache.
- */
-void bvhcache_free(BVHCache *bvh_cache);
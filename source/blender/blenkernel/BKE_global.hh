@@ -234,6 +234,14 @@ enum {
 
   G_DEBUG_GHOST = (1 << 23),  /* Debug GHOST module. */
   G_DEBUG_WINTAB = (1 << 24), /* Debug Wintab. */
+
+  G_DEBUG_BLENDFILE_NO_THREADS = (1 << 25), /* Single threaded blend-file reading & writing. */
+
+  G_DEBUG_DEPSGRAPH_PRIORITY = (1 << 26),                 /* depsgraph critical path scheduling */
+  G_DEBUG_DEPSGRAPH_RELATIONS_CACHE = (1 << 27),          /* reuse relations of unchanged IDs */
+  G_DEBUG_DEPSGRAPH_RELATIONS_CACHE_VALIDATE = (1 << 28), /* compare reused relations to rebuild */
+  G_DEBUG_GEOMETRY_NODES_TRACE = (1 << 29),               /* geometry nodes evaluation timeline */
+  G_DEBUG_FIELD_NO_FUSION = (1 << 30),                    /* no fusion of field operations */
 };
 
 #define G_DEBUG_ALL \
@@ -48,6 +48,14 @@ enum {
    * data-blocks.
    */
   IDTYPE_FLAGS_NO_MEMFILE_UNDO = 1 << 5,
+  /**
+   * Indicates that `blend_write` of the given IDType may be called for different IDs from
+   * multiple threads at once when writing a file (never for undo steps).
+   *
+   * \note The callback must only modify the temporary copy of the ID it is given, and not
+   * access other IDs or global data.
+   */
+  IDTYPE_FLAGS_BLEND_WRITE_THREADSAFE = 1 << 6,
 };
 
 struct IDCacheKey {
@@ -22,7 +22,7 @@
 #include "DNA_customdata_types.h"
 
 struct BMEditMesh;
-struct BVHCache;
+struct BVHTree;
 struct Mesh;
 class ShrinkwrapBoundaryData;
 struct SubdivCCG;
@@ -94,6 +94,12 @@ struct LooseEdgeCache : public LooseGeomCache {};
  */
 struct LooseVertCache : public LooseGeomCache {};
 
+/** Frees a BVH tree stored in a mesh cache. Defined in `bvhutils.cc`. */
+struct BVHTreeDeleter {
+  void operator()(BVHTree *tree);
+};
+using BVHTreePointer = std::unique_ptr<BVHTree, BVHTreeDeleter>;
+
 struct MeshRuntime {
   /**
    * "Evaluated" mesh owned by this mesh. Used for objects which don't have effective modifiers, so
@@ -140,8 +146,18 @@ struct MeshRuntime {
   /** Cache for triangle to original face index map, accessed with #Mesh::corner_tri_faces(). */
   SharedCache<Array<int>> corner_tri_faces_cache;
 
-  /** Cache for BVH trees generated for the mesh. Defined in 'BKE_bvhutil.c' */
-  BVHCache *bvh_cache = nullptr;
+  /**
+   * Caches for BVH trees generated for the mesh, accessed with #BKE_bvhtree_from_mesh_get. Like
+   * the bounds, they are shared between meshes with unchanged positions and topology. The tree may
+   * be null when the mesh has no elements of the corresponding type.
+   */
+  SharedCache<BVHTreePointer> bvh_cache_verts;
+  SharedCache<BVHTreePointer> bvh_cache_edges;
+  SharedCache<BVHTreePointer> bvh_cache_faces;
+  SharedCache<BVHTreePointer> bvh_cache_corner_tris;
+  SharedCache<BVHTreePointer> bvh_cache_corner_tris_no_hidden;
+  SharedCache<BVHTreePointer> bvh_cache_loose_verts;
+  SharedCache<BVHTreePointer> bvh_cache_loose_edges;
 
   /** Needed in case we need to lazily initialize the mesh. */
   CustomData_MeshMasks cd_mask_extra = {};
@@ -17,6 +17,7 @@ struct OpenSubdiv_Converter;
 struct OpenSubdiv_Evaluator;
 struct OpenSubdiv_TopologyRefiner;
 struct Subdiv;
+struct SubdivForeachPlan;
 
 enum eSubdivVtxBoundaryInterpolation {
   /* Do not interpolate boundaries. */
@@ -78,6 +79,8 @@ enum eSubdivStatsValue {
   SUBDIV_STATS_SUBDIV_TO_CCG,
   SUBDIV_STATS_SUBDIV_TO_CCG_ELEMENTS,
   SUBDIV_STATS_TOPOLOGY_COMPARE,
+  SUBDIV_STATS_TOPOLOGY_HASH,
+  SUBDIV_STATS_FOREACH_PLAN,
 
   NUM_SUBDIV_STATS_VALUES,
 };
@@ -103,6 +106,12 @@ struct SubdivStats {
       double subdiv_to_ccg_elements_time;
       /* Time spent on CCG elements evaluation/initialization. */
       double topology_compare_time;
+      /* Time spent on hashing the topology of the coarse mesh, which allows to skip the topology
+       * comparison when the topology did not change. */
+      double topology_hash_time;
+      /* Time spent on calculating the number of elements and their offsets in the subdivided
+       * mesh. Stays zero when the traversal plan of a previous evaluation is reused. */
+      double foreach_plan_time;
     };
     double values_[NUM_SUBDIV_STATS_VALUES];
   };
@@ -180,6 +189,13 @@ struct Subdiv {
      * In total this array has a size of `num base faces + 1`.
      */
     int *face_ptex_offset;
+    /* Hash of the coarse mesh topology this descriptor was created for, see
+     * #BKE_subdiv_update_from_mesh. Only valid when `has_topology_hash` is set. */
+    uint64_t topology_hash;
+    bool has_topology_hash;
+    /* Element counts and offsets of the subdivided mesh for the last used resolution, which
+     * allows to skip their calculation when only the coarse positions change. */
+    SubdivForeachPlan *foreach_plan;
   } cache_;
 };
 
@@ -232,6 +248,8 @@ Subdiv *BKE_subdiv_new_from_mesh(const SubdivSettings *settings, const Mesh *mes
 
 /* Similar to above, but will not re-create descriptor if it was created for the
  * same settings and topology.
+ * When updating from a mesh, a hash of its topology is compared first, so that deforming meshes
+ * keep the existing topology refiner and evaluator without a full topology comparison.
  * If settings or topology did change, the existing descriptor is freed and a
  * new one is created from scratch.
  *
@@ -13,6 +13,7 @@
 struct Mesh;
 struct Subdiv;
 struct SubdivForeachContext;
+struct SubdivForeachPlan;
 struct SubdivToMeshSettings;
 
 using SubdivForeachTopologyInformationCb = bool (*)(const SubdivForeachContext *context,
@@ -156,3 +157,7 @@ bool BKE_subdiv_foreach_subdiv_geometry(Subdiv *subdiv,
                                         const SubdivForeachContext *context,
                                         const SubdivToMeshSettings *mesh_settings,
                                         const Mesh *coarse_mesh);
+
+/* Free the element counts and offsets cached in the subdivision surface descriptor by the
+ * traversal above. */
+void BKE_subdiv_foreach_plan_free(SubdivForeachPlan *plan);
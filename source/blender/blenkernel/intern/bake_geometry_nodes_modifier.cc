@@ -15,6 +15,7 @@
 #include "BLI_fileops.hh"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #include "MOD_nodes.hh"
 
@@ -48,6 +49,163 @@ IndexRange NodeBakeCache::frame_range() const
   return IndexRange::from_begin_end_inclusive(start_frame, end_frame);
 }
 
+/** Number of frames that are loaded in the background ahead of the frame that is played back. */
+static constexpr int prefetch_frames_num = 2;
+
+/**
+ * Load the baked state of a frame from disk. The state is empty if loading failed.
+ * \param load_pages: Also load the data of memory-mapped blob files into memory, so that the
+ *   first access does not have to wait for the disk.
+ */
+static BakeState load_baked_frame(const std::string &blobs_dir,
+                                  const std::string &meta_path,
+                                  const BlobReadSharing &blob_sharing,
+                                  const bool load_pages)
+{
+  {
+    DiskBlobReader blob_reader{blobs_dir};
+    fstream meta_file{meta_path};
+    std::optional<BakeState> bake_state = deserialize_bake(meta_file, blob_reader, blob_sharing);
+    if (!bake_state.has_value()) {
+      return {};
+    }
+    if (load_pages) {
+      blob_reader.load_mapped_pages();
+    }
+    if (!blob_reader.any_mapped_io_error()) {
+      return std::move(*bake_state);
+    }
+  }
+  /* Some of the mapped data could not be read and was replaced by zeros. Read the frame again
+   * without mapping, so that errors are detected. Don't use the shared data either, because it
+   * may reference the data that failed to load. */
+  DiskBlobReader blob_reader{blobs_dir, false};
+  BlobReadSharing local_blob_sharing;
+  fstream meta_file{meta_path};
+  std::optional<BakeState> bake_state = deserialize_bake(
+      meta_file, blob_reader, local_blob_sharing);
+  if (!bake_state.has_value()) {
+    return {};
+  }
+  return std::move(*bake_state);
+}
+
+struct PrefetchTaskData {
+  int frame_index;
+  std::string blobs_dir;
+  std::string meta_path;
+  const BlobReadSharing *blob_sharing;
+};
+
+static void prefetch_task_data_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  MEM_delete(static_cast<PrefetchTaskData *>(taskdata));
+}
+
+FramePrefetcher::FramePrefetcher()
+{
+  task_pool_ = BLI_task_pool_create_background(this, TASK_PRIORITY_LOW);
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+  BLI_task_pool_cancel(task_pool_);
+  BLI_task_pool_free(task_pool_);
+}
+
+void FramePrefetcher::prefetch(const NodeBakeCache &bake_cache, const int frame_index)
+{
+  const FrameCache &frame_cache = *bake_cache.frames[frame_index];
+  if (!frame_cache.state.items_by_id.is_empty()) {
+    return;
+  }
+  if (!bake_cache.blobs_dir || !frame_cache.meta_path) {
+    return;
+  }
+  {
+    std::lock_guard lock{mutex_};
+    if (loading_frames_.contains(frame_index) || loaded_frames_.contains(frame_index)) {
+      return;
+    }
+    loading_frames_.add_new(frame_index);
+  }
+  PrefetchTaskData *task_data = MEM_new<PrefetchTaskData>(__func__);
+  task_data->frame_index = frame_index;
+  task_data->blobs_dir = *bake_cache.blobs_dir;
+  task_data->meta_path = *frame_cache.meta_path;
+  task_data->blob_sharing = bake_cache.blob_sharing.get();
+  BLI_task_pool_push(task_pool_, prefetch_task, task_data, true, prefetch_task_data_free);
+}
+
+void FramePrefetcher::prefetch_task(TaskPool *__restrict pool, void *taskdata)
+{
+  FramePrefetcher &prefetcher = *static_cast<FramePrefetcher *>(BLI_task_pool_user_data(pool));
+  const PrefetchTaskData &task_data = *static_cast<const PrefetchTaskData *>(taskdata);
+  BakeState state = load_baked_frame(
+      task_data.blobs_dir, task_data.meta_path, *task_data.blob_sharing, true);
+
+  std::lock_guard lock{prefetcher.mutex_};
+  prefetcher.loading_frames_.remove(task_data.frame_index);
+  prefetcher.loaded_frames_.add(task_data.frame_index, std::move(state));
+}
+
+std::optional<BakeState> FramePrefetcher::take(const int frame_index)
+{
+  std::unique_lock lock{mutex_};
+  if (loading_frames_.contains(frame_index)) {
+    /* The frame is needed now, so rather wait for it than loading it a second time. */
+    lock.unlock();
+    BLI_task_pool_work_and_wait(task_pool_);
+    lock.lock();
+  }
+  return loaded_frames_.pop_try(frame_index);
+}
+
+void FramePrefetcher::discard_frames_outside(const IndexRange frames)
+{
+  Vector<BakeState> discarded_states;
+  {
+    std::lock_guard lock{mutex_};
+    loaded_frames_.remove_if([&](auto item) {
+      if (frames.contains(item.key)) {
+        return false;
+      }
+      discarded_states.append(std::move(item.value));
+      return true;
+    });
+  }
+  /* The states are freed here, without holding the lock. */
+}
+
+void NodeBakeCache::ensure_frame_loaded(const int frame_index)
+{
+  FrameCache &frame_cache = *this->frames[frame_index];
+  if (!frame_cache.state.items_by_id.is_empty()) {
+    return;
+  }
+  if (!this->blobs_dir) {
+    return;
+  }
+  if (!frame_cache.meta_path) {
+    return;
+  }
+  if (!this->prefetcher) {
+    this->prefetcher = std::make_unique<FramePrefetcher>();
+  }
+  if (std::optional<BakeState> prefetched_state = this->prefetcher->take(frame_index)) {
+    frame_cache.state = std::move(*prefetched_state);
+  }
+  else {
+    frame_cache.state = load_baked_frame(
+        *this->blobs_dir, *frame_cache.meta_path, *this->blob_sharing, false);
+  }
+  const IndexRange next_frames = IndexRange(frame_index + 1, prefetch_frames_num);
+  this->prefetcher->discard_frames_outside(next_frames);
+  for (const int i : next_frames.intersect(this->frames.index_range())) {
+    this->prefetcher->prefetch(*this, i);
+  }
+}
+
 SimulationNodeCache *ModifierCache::get_simulation_node_cache(const int id)
 {
   std::unique_ptr<SimulationNodeCache> *ptr = this->simulation_cache_by_id.lookup_ptr(id);
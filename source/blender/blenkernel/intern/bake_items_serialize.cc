@@ -14,7 +14,9 @@
 
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
 #include "BLI_math_matrix_types.hh"
+#include "BLI_mmap.h"
 #include "BLI_path_util.h"
 
 #include "DNA_material_types.h"
@@ -23,9 +25,17 @@
 #include "RNA_access.hh"
 #include "RNA_enum_types.hh"
 
+#include <fcntl.h> /* For open flags (O_BINARY, O_RDONLY). */
 #include <fmt/format.h>
 #include <sstream>
 #include <xxhash.h>
+#include <zstd.h>
+
+#ifndef WIN32
+#  include <unistd.h> /* For close. */
+#else
+#  include <io.h> /* For close. */
+#endif
 
 #ifdef WITH_OPENVDB
 #  include <openvdb/io/Stream.h>
@@ -84,7 +94,64 @@ bool BlobReader::read_as_stream(const BlobSlice &slice, FunctionRef<bool(std::is
   return true;
 }
 
-DiskBlobReader::DiskBlobReader(std::string blobs_dir) : blobs_dir_(std::move(blobs_dir)) {}
+std::optional<ImplicitSharingInfoAndData> BlobReader::read_mapped(
+    const BlobSlice & /*slice*/) const
+{
+  return std::nullopt;
+}
+
+/** Frees a memory-mapped blob file when no data in it is used anymore. */
+class MappedBlobFileSharingInfo : public ImplicitSharingInfo {
+ public:
+  BLI_mmap_file *file;
+
+  MappedBlobFileSharingInfo(BLI_mmap_file *file) : file(file) {}
+
+ private:
+  void delete_self_with_data() override
+  {
+    BLI_mmap_free(file);
+    MEM_delete(this);
+  }
+};
+
+/**
+ * Owns a slice of a memory-mapped blob file. Every slice has its own sharing info so that its
+ * data is mutable when it has a single user, independent of other slices in the same file. This
+ * is possible because files are mapped copy-on-write, changes never end up in the file on disk.
+ */
+class MappedBlobSliceSharingInfo : public ImplicitSharingInfo {
+ private:
+  const ImplicitSharingInfo *file_sharing_info_;
+
+ public:
+  MappedBlobSliceSharingInfo(const ImplicitSharingInfo &file_sharing_info)
+      : file_sharing_info_(&file_sharing_info)
+  {
+    file_sharing_info_->add_user();
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    file_sharing_info_->remove_user_and_delete_if_last();
+    MEM_delete(this);
+  }
+};
+
+DiskBlobReader::DiskBlobReader(std::string blobs_dir, const bool use_mapping)
+    : blobs_dir_(std::move(blobs_dir)), use_mapping_(use_mapping)
+{
+}
+
+DiskBlobReader::~DiskBlobReader()
+{
+  for (const ImplicitSharingInfo *sharing_info : mapped_files_.values()) {
+    if (sharing_info) {
+      sharing_info->remove_user_and_delete_if_last();
+    }
+  }
+}
 
 [[nodiscard]] bool DiskBlobReader::read(const BlobSlice &slice, void *r_data) const
 {
@@ -107,24 +174,133 @@ DiskBlobReader::DiskBlobReader(std::string blobs_dir) : blobs_dir_(std::move(blo
   return true;
 }
 
-DiskBlobWriter::DiskBlobWriter(std::string blob_dir, std::string base_name)
-    : blob_dir_(std::move(blob_dir)), base_name_(std::move(base_name))
+const ImplicitSharingInfo *DiskBlobReader::ensure_mapped_file(const std::string &blob_path) const
+{
+  return mapped_files_.lookup_or_add_cb(blob_path, [&]() -> const ImplicitSharingInfo * {
+    const int file = BLI_open(blob_path.c_str(), O_BINARY | O_RDONLY, 0);
+    if (file == -1) {
+      return nullptr;
+    }
+    /* The mapping stays valid after the file is closed. */
+    BLI_mmap_file *mmap_file = BLI_mmap_open_copy_on_write(file);
+    close(file);
+    if (mmap_file == nullptr) {
+      return nullptr;
+    }
+    return MEM_new<MappedBlobFileSharingInfo>(__func__, mmap_file);
+  });
+}
+
+std::optional<ImplicitSharingInfoAndData> DiskBlobReader::read_mapped(
+    const BlobSlice &slice) const
+{
+  if (!use_mapping_ || slice.range.is_empty()) {
+    return std::nullopt;
+  }
+
+  char blob_path[FILE_MAX];
+  BLI_path_join(blob_path, sizeof(blob_path), blobs_dir_.c_str(), slice.name.c_str());
+
+  std::lock_guard lock{mutex_};
+  const ImplicitSharingInfo *file_sharing_info = this->ensure_mapped_file(blob_path);
+  if (file_sharing_info == nullptr) {
+    return std::nullopt;
+  }
+  BLI_mmap_file *mmap_file = static_cast<const MappedBlobFileSharingInfo *>(file_sharing_info)
+                                 ->file;
+  if (slice.range.one_after_last() > int64_t(BLI_mmap_get_length(mmap_file))) {
+    return std::nullopt;
+  }
+  const void *data = POINTER_OFFSET(BLI_mmap_get_pointer(mmap_file), slice.range.start());
+  return ImplicitSharingInfoAndData{
+      MEM_new<MappedBlobSliceSharingInfo>(__func__, *file_sharing_info), data};
+}
+
+void DiskBlobReader::load_mapped_pages() const
+{
+  std::lock_guard lock{mutex_};
+  for (const ImplicitSharingInfo *sharing_info : mapped_files_.values()) {
+    if (sharing_info == nullptr) {
+      continue;
+    }
+    BLI_mmap_file *mmap_file = static_cast<const MappedBlobFileSharingInfo *>(sharing_info)->file;
+    const char *memory = static_cast<const char *>(BLI_mmap_get_pointer(mmap_file));
+    const int64_t size = BLI_mmap_get_length(mmap_file);
+    /* Touching a single byte of every page is enough to make the system load it. */
+    const int64_t page_size = 4096;
+    char accumulated = 0;
+    for (int64_t offset = 0; offset < size; offset += page_size) {
+      accumulated ^= *static_cast<const volatile char *>(memory + offset);
+    }
+    UNUSED_VARS(accumulated);
+  }
+}
+
+bool DiskBlobReader::any_mapped_io_error() const
+{
+  std::lock_guard lock{mutex_};
+  for (const ImplicitSharingInfo *sharing_info : mapped_files_.values()) {
+    if (sharing_info == nullptr) {
+      continue;
+    }
+    if (BLI_mmap_any_io_error(static_cast<const MappedBlobFileSharingInfo *>(sharing_info)->file))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+DiskBlobWriter::DiskBlobWriter(std::string blob_dir,
+                               std::string base_name,
+                               const bool use_compression)
+    : blob_dir_(std::move(blob_dir)),
+      base_name_(std::move(base_name)),
+      use_compression_(use_compression)
 {
   blob_name_ = base_name_ + ".blob";
 }
 
+/**
+ * Blobs start at aligned offsets in the file, so that memory-mapped data is properly aligned for
+ * all types stored in it.
+ */
+static constexpr int64_t blob_alignment = 64;
+
+/**
+ * Remove an existing file before writing a new one with the same name. Overwriting it in place
+ * would change the data of memory-mapped files from a previous bake that may still be in use.
+ * A new file is created instead, while existing mappings keep referencing the old one.
+ */
+static void prepare_new_blob_file(const char *path)
+{
+  BLI_file_ensure_parent_dir_exists(path);
+  if (BLI_exists(path)) {
+    BLI_delete(path, false, false);
+  }
+}
+
 BlobSlice DiskBlobWriter::write(const void *data, const int64_t size)
 {
   if (!blob_stream_.is_open()) {
     char blob_path[FILE_MAX];
     BLI_path_join(blob_path, sizeof(blob_path), blob_dir_.c_str(), blob_name_.c_str());
-    BLI_file_ensure_parent_dir_exists(blob_path);
+    prepare_new_blob_file(blob_path);
     blob_stream_.open(blob_path, std::ios::out | std::ios::binary);
   }
 
+  const int64_t padding = (blob_alignment - current_offset_ % blob_alignment) % blob_alignment;
+  if (padding > 0) {
+    const char zeros[blob_alignment] = {0};
+    blob_stream_.write(zeros, padding);
+    current_offset_ += padding;
+    written_size_ += padding;
+  }
+
   const int64_t old_offset = current_offset_;
   blob_stream_.write(static_cast<const char *>(data), size);
   current_offset_ += size;
+  written_size_ += size;
   return {blob_name_, {old_offset, size}};
 }
 
@@ -138,10 +314,11 @@ BlobSlice DiskBlobWriter::write_as_stream(const StringRef file_extension,
 
   char path[FILE_MAX];
   BLI_path_join(path, sizeof(path), blob_dir_.c_str(), file_name.c_str());
-  BLI_file_ensure_parent_dir_exists(path);
+  prepare_new_blob_file(path);
   std::fstream stream{path, std::ios::out | std::ios::binary};
   fn(stream);
   const int64_t written_bytes_num = stream.tellg();
+  written_size_ += written_bytes_num;
   return {file_name, {0, written_bytes_num}};
 }
 
@@ -189,13 +366,33 @@ DictionaryValuePtr BlobWriteSharing::write_implicitly_shared(
       });
 }
 
+/** Smaller blobs are never compressed, because the gain is negligible. */
+static constexpr int64_t min_compressed_blob_size = 64 * 1024;
+/** A fast compression level, because the bake is written for every frame. */
+static constexpr int blob_compression_level = 3;
+
 std::shared_ptr<io::serialize::DictionaryValue> BlobWriteSharing::write_deduplicated(
     BlobWriter &writer, const void *data, const int64_t size_in_bytes)
 {
   const uint64_t content_hash = XXH3_64bits(data, size_in_bytes);
-  const BlobSlice slice = slice_by_content_hash_.lookup_or_add_cb(
-      content_hash, [&]() { return writer.write(data, size_in_bytes); });
-  return slice.serialize();
+  const StoredByContentValue &stored = stored_by_content_hash_.lookup_or_add_cb(
+      content_hash, [&]() -> StoredByContentValue {
+        if (writer.use_compression() && size_in_bytes >= min_compressed_blob_size) {
+          const size_t bound = ZSTD_compressBound(size_in_bytes);
+          Array<char> compressed_data(bound, NoInitialization());
+          const size_t compressed_size = ZSTD_compress(
+              compressed_data.data(), bound, data, size_in_bytes, blob_compression_level);
+          if (!ZSTD_isError(compressed_size) && int64_t(compressed_size) < size_in_bytes) {
+            return {writer.write(compressed_data.data(), compressed_size), true};
+          }
+        }
+        return {writer.write(data, size_in_bytes), false};
+      });
+  DictionaryValuePtr io_data = stored.slice.serialize();
+  if (stored.compressed) {
+    io_data->append_str("compression", "zstd");
+  }
+  return io_data;
 }
 
 std::optional<ImplicitSharingInfoAndData> BlobReadSharing::read_shared(
@@ -282,22 +479,55 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_data_with_endian(
 }
 
 /**
- * Read data of an into an array and optionally perform an endian switch if necessary.
+ * Read the data of a blob into the buffer, decompressing it if it was compressed when written.
  */
-[[nodiscard]] static bool read_blob_raw_data_with_endian(const BlobReader &blob_reader,
-                                                         const DictionaryValue &io_data,
-                                                         const int64_t element_size,
-                                                         const int64_t elements_num,
-                                                         void *r_data)
+[[nodiscard]] static bool read_blob_data(const BlobReader &blob_reader,
+                                         const DictionaryValue &io_data,
+                                         const int64_t size_in_bytes,
+                                         void *r_data)
 {
   const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
   if (!slice) {
     return false;
   }
-  if (slice->range.size() != element_size * elements_num) {
+  const StringRefNull compression = io_data.lookup_str("compression").value_or("none");
+  if (compression == "none") {
+    if (slice->range.size() != size_in_bytes) {
+      return false;
+    }
+    return blob_reader.read(*slice, r_data);
+  }
+  if (compression != "zstd") {
     return false;
   }
-  if (!blob_reader.read(*slice, r_data)) {
+  auto decompress = [&](const void *compressed_data) {
+    const size_t decompressed_size = ZSTD_decompress(
+        r_data, size_in_bytes, compressed_data, slice->range.size());
+    return !ZSTD_isError(decompressed_size) && int64_t(decompressed_size) == size_in_bytes;
+  };
+  /* Decompress directly from the mapped file if possible to avoid an additional copy. */
+  if (const std::optional<ImplicitSharingInfoAndData> mapped = blob_reader.read_mapped(*slice)) {
+    const bool success = decompress(mapped->data);
+    mapped->sharing_info->remove_user_and_delete_if_last();
+    return success;
+  }
+  Array<char> compressed_data(slice->range.size(), NoInitialization());
+  if (!blob_reader.read(*slice, compressed_data.data())) {
+    return false;
+  }
+  return decompress(compressed_data.data());
+}
+
+/**
+ * Read data of an into an array and optionally perform an endian switch if necessary.
+ */
+[[nodiscard]] static bool read_blob_raw_data_with_endian(const BlobReader &blob_reader,
+                                                         const DictionaryValue &io_data,
+                                                         const int64_t element_size,
+                                                         const int64_t elements_num,
+                                                         void *r_data)
+{
+  if (!read_blob_data(blob_reader, io_data, element_size * elements_num, r_data)) {
     return false;
   }
   const StringRefNull stored_endian = io_data.lookup_str("endian").value_or("little");
@@ -338,14 +568,7 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_bytes(BlobWriter &blob_wr
                                               const int64_t bytes_num,
                                               void *r_data)
 {
-  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
-  if (!slice) {
-    return false;
-  }
-  if (slice->range.size() != bytes_num) {
-    return false;
-  }
-  return blob_reader.read(*slice, r_data);
+  return read_blob_data(blob_reader, io_data, bytes_num, r_data);
 }
 
 static std::shared_ptr<DictionaryValue> write_blob_simple_gspan(BlobWriter &blob_writer,
@@ -403,6 +626,41 @@ static std::shared_ptr<DictionaryValue> write_blob_shared_simple_gspan(
       sharing_info, [&]() { return write_blob_simple_gspan(blob_writer, blob_sharing, data); });
 }
 
+/**
+ * Use the stored data directly without copying it, if it is stored in the same format that is used
+ * at run-time.
+ */
+static std::optional<ImplicitSharingInfoAndData> read_blob_mapped_simple_gspan(
+    const DictionaryValue &io_data,
+    const BlobReader &blob_reader,
+    const CPPType &cpp_type,
+    const int size)
+{
+  if (io_data.lookup_str("compression").value_or("none") != "none") {
+    return std::nullopt;
+  }
+  if (io_data.lookup_str("endian").value_or("little") != get_endian_io_name(ENDIAN_ORDER)) {
+    return std::nullopt;
+  }
+  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
+  if (!slice) {
+    return std::nullopt;
+  }
+  if (slice->range.size() != size * cpp_type.size()) {
+    return std::nullopt;
+  }
+  std::optional<ImplicitSharingInfoAndData> mapped_data = blob_reader.read_mapped(*slice);
+  if (!mapped_data) {
+    return std::nullopt;
+  }
+  if (uintptr_t(mapped_data->data) % cpp_type.alignment() != 0) {
+    /* Blobs written by older versions are not aligned. */
+    mapped_data->sharing_info->remove_user_and_delete_if_last();
+    return std::nullopt;
+  }
+  return mapped_data;
+}
+
 [[nodiscard]] static const void *read_blob_shared_simple_gspan(
     const DictionaryValue &io_data,
     const BlobReader &blob_reader,
@@ -414,6 +672,11 @@ static std::shared_ptr<DictionaryValue> write_blob_shared_simple_gspan(
   const char *func = __func__;
   const std::optional<ImplicitSharingInfoAndData> sharing_info_and_data = blob_sharing.read_shared(
       io_data, [&]() -> std::optional<ImplicitSharingInfoAndData> {
+        if (std::optional<ImplicitSharingInfoAndData> mapped_data = read_blob_mapped_simple_gspan(
+                io_data, blob_reader, cpp_type, size))
+        {
+          return mapped_data;
+        }
         void *data_mem = MEM_mallocN_aligned(size * cpp_type.size(), cpp_type.alignment(), func);
         if (!read_blob_simple_gspan(blob_reader, io_data, {cpp_type, data_mem, size})) {
           MEM_freeN(data_mem);
@@ -0,0 +1,197 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <sstream>
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_path_util.h"
+#include "BLI_tempfile.h"
+
+#include "DNA_mesh_types.h"
+
+#include "BKE_bake_items.hh"
+#include "BKE_bake_items_serialize.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_mesh.hh"
+
+#include "CLG_log.h"
+
+namespace blender::bke::bake::tests {
+
+class BakeItemsSerializeTest : public testing::Test {
+ public:
+  std::string blobs_dir;
+
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    blobs_dir = std::string(temp_dir) + SEP_STR + "blender_bake_items_serialize_test";
+    if (!BLI_exists(blobs_dir.c_str())) {
+      BLI_dir_create_recursive(blobs_dir.c_str());
+    }
+  }
+
+  void TearDown() override
+  {
+    if (BLI_exists(blobs_dir.c_str())) {
+      BLI_delete(blobs_dir.c_str(), true, true);
+    }
+  }
+
+  /** Write the blobs of the state to a file on disk. \return The serialized meta data. */
+  std::string write(const BakeState &state, const bool use_compression)
+  {
+    std::stringstream meta_stream;
+    /* The blob file is closed when the writer is destructed. */
+    DiskBlobWriter blob_writer{blobs_dir, "frame", use_compression};
+    BlobWriteSharing blob_sharing;
+    serialize_bake(state, blob_writer, blob_sharing, meta_stream);
+    return meta_stream.str();
+  }
+
+  /** Read the state back through a #DiskBlobReader, which memory-maps the blob file. */
+  std::optional<BakeState> read(const std::string &meta_data)
+  {
+    std::stringstream meta_stream{meta_data};
+    DiskBlobReader blob_reader{blobs_dir};
+    BlobReadSharing blob_sharing;
+    return deserialize_bake(meta_stream, blob_reader, blob_sharing);
+  }
+};
+
+/** Large enough to be compressed, see `min_compressed_blob_size`. */
+static constexpr int verts_num = 100'000;
+
+static BakeState create_mesh_bake_state()
+{
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, 0);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(i % 10, 0.0f, 1.0f);
+  }
+  BakeState state;
+  state.items_by_id.add_new(1, std::make_unique<GeometryBakeItem>(GeometrySet::from_mesh(mesh)));
+  return state;
+}
+
+static GeometrySet &get_geometry(const BakeState &state)
+{
+  return dynamic_cast<GeometryBakeItem &>(*state.items_by_id.lookup(1)).geometry;
+}
+
+static void expect_positions_equal(const BakeState &expected, const BakeState &actual)
+{
+  ASSERT_TRUE(actual.items_by_id.contains(1));
+  const Mesh *expected_mesh = get_geometry(expected).get_mesh();
+  const Mesh *actual_mesh = get_geometry(actual).get_mesh();
+  ASSERT_NE(actual_mesh, nullptr);
+  ASSERT_EQ(actual_mesh->verts_num, expected_mesh->verts_num);
+  EXPECT_EQ_ARRAY(expected_mesh->vert_positions().data(),
+                  actual_mesh->vert_positions().data(),
+                  expected_mesh->verts_num);
+}
+
+TEST_F(BakeItemsSerializeTest, MappedRoundTrip)
+{
+  const BakeState state = create_mesh_bake_state();
+  const std::string meta_data = this->write(state, false);
+  std::optional<BakeState> read_state = this->read(meta_data);
+  ASSERT_TRUE(read_state.has_value());
+  expect_positions_equal(state, *read_state);
+
+  /* The positions use the memory-mapped file directly. Since it is mapped copy-on-write, they can
+   * still be modified in place without changing the file on disk. */
+  Mesh *mesh = get_geometry(*read_state).get_mesh_for_write();
+  const float3 *positions_data = mesh->vert_positions().data();
+  mesh->vert_positions_for_write().fill(float3(0.0f));
+  EXPECT_EQ(mesh->vert_positions().data(), positions_data);
+
+  std::optional<BakeState> read_state_again = this->read(meta_data);
+  ASSERT_TRUE(read_state_again.has_value());
+  expect_positions_equal(state, *read_state_again);
+}
+
+TEST_F(BakeItemsSerializeTest, CompressedRoundTrip)
+{
+  const BakeState state = create_mesh_bake_state();
+  std::optional<BakeState> read_state = this->read(this->write(state, true));
+  ASSERT_TRUE(read_state.has_value());
+  expect_positions_equal(state, *read_state);
+}
+
+TEST_F(BakeItemsSerializeTest, CompressedBlobIsSmaller)
+{
+  Array<int> values(verts_num);
+  for (const int i : values.index_range()) {
+    values[i] = i % 10;
+  }
+  const int64_t size_in_bytes = values.as_span().size_in_bytes();
+
+  std::shared_ptr<io::serialize::DictionaryValue> io_data;
+  {
+    DiskBlobWriter blob_writer{blobs_dir, "blob", true};
+    BlobWriteSharing blob_sharing;
+    io_data = blob_sharing.write_deduplicated(blob_writer, values.data(), size_in_bytes);
+  }
+  EXPECT_EQ(io_data->lookup_str("compression").value_or("none"), "zstd");
+  const std::optional<BlobSlice> slice = BlobSlice::deserialize(*io_data);
+  ASSERT_TRUE(slice.has_value());
+  EXPECT_LT(slice->range.size(), size_in_bytes);
+
+  /* The compressed data can be accessed through the mapping, it's decompressed from there. */
+  DiskBlobReader blob_reader{blobs_dir};
+  const std::optional<ImplicitSharingInfoAndData> mapped = blob_reader.read_mapped(*slice);
+  ASSERT_TRUE(mapped.has_value());
+  mapped->sharing_info->remove_user_and_delete_if_last();
+}
+
+TEST_F(BakeItemsSerializeTest, RewriteKeepsMappedData)
+{
+  const Array<int> old_values(verts_num, 1);
+  const Array<int> new_values(verts_num, 2);
+  const int64_t size_in_bytes = old_values.as_span().size_in_bytes();
+
+  BlobSlice slice;
+  {
+    DiskBlobWriter blob_writer{blobs_dir, "blob", false};
+    slice = blob_writer.write(old_values.data(), size_in_bytes);
+  }
+  DiskBlobReader blob_reader{blobs_dir};
+  const std::optional<ImplicitSharingInfoAndData> mapped = blob_reader.read_mapped(slice);
+  ASSERT_TRUE(mapped.has_value());
+
+  /* Baking again writes a new file, the data that is still in use does not change. */
+  {
+    DiskBlobWriter blob_writer{blobs_dir, "blob", false};
+    blob_writer.write(new_values.data(), size_in_bytes);
+  }
+  EXPECT_EQ_ARRAY(static_cast<const int *>(mapped->data), old_values.data(), verts_num);
+  EXPECT_FALSE(blob_reader.any_mapped_io_error());
+  mapped->sharing_info->remove_user_and_delete_if_last();
+
+  Array<int> read_values(verts_num);
+  DiskBlobReader new_blob_reader{blobs_dir, false};
+  EXPECT_FALSE(new_blob_reader.read_mapped(slice).has_value());
+  EXPECT_TRUE(new_blob_reader.read(slice, read_values.data()));
+  EXPECT_EQ_ARRAY(read_values.data(), new_values.data(), verts_num);
+}
+
+}  // namespace blender::bke::bake::tests
@@ -10,7 +10,8 @@
 #include "DNA_pointcloud_types.h"
 
 #include "BLI_math_geom.h"
-#include "BLI_task.h"
+#include "BLI_offset_indices.hh"
+#include "BLI_task.hh"
 
 #include "BKE_attribute.hh"
 #include "BKE_bvhutils.hh"
@@ -20,146 +21,51 @@
 using blender::BitSpan;
 using blender::BitVector;
 using blender::float3;
+using blender::GrainSize;
+using blender::IndexMask;
+using blender::IndexMaskMemory;
 using blender::IndexRange;
 using blender::int3;
 using blender::Span;
 using blender::VArray;
 
 /* -------------------------------------------------------------------- */
-/** \name BVHCache
+/** \name BVH Tree Building Utilities
  * \{ */
 
-struct BVHCacheItem {
-  bool is_filled;
-  BVHTree *tree;
-};
-
-struct BVHCache {
-  BVHCacheItem items[BVHTREE_MAX_ITEM];
-  ThreadMutex mutex;
-};
-
-/**
- * Queries a bvhcache for the cache bvhtree of the request type
- *
- * When the `r_locked` is filled and the tree could not be found the caches mutex will be
- * locked. This mutex can be unlocked by calling `bvhcache_unlock`.
- *
- * When `r_locked` is used the `mesh_eval_mutex` must contain the `MeshRuntime.eval_mutex`.
- */
-static bool bvhcache_find(BVHCache **bvh_cache_p,
-                          BVHCacheType type,
-                          BVHTree **r_tree,
-                          bool *r_locked,
-                          std::mutex *mesh_eval_mutex)
+void blender::bke::BVHTreeDeleter::operator()(BVHTree *tree)
 {
-  bool do_lock = r_locked;
-  if (r_locked) {
-    *r_locked = false;
-  }
-  if (*bvh_cache_p == nullptr) {
-    if (!do_lock) {
-      /* Cache does not exist and no lock is requested. */
-      return false;
-    }
-    /* Lazy initialization of the bvh_cache using the `mesh_eval_mutex`. */
-    std::lock_guard lock{*mesh_eval_mutex};
-    if (*bvh_cache_p == nullptr) {
-      *bvh_cache_p = bvhcache_init();
-    }
-  }
-  BVHCache *bvh_cache = *bvh_cache_p;
-
-  if (bvh_cache->items[type].is_filled) {
-    *r_tree = bvh_cache->items[type].tree;
-    return true;
-  }
-  if (do_lock) {
-    BLI_mutex_lock(&bvh_cache->mutex);
-    bool in_cache = bvhcache_find(bvh_cache_p, type, r_tree, nullptr, nullptr);
-    if (in_cache) {
-      BLI_mutex_unlock(&bvh_cache->mutex);
-      return in_cache;
-    }
-    *r_locked = true;
-  }
-  return false;
+  BLI_bvhtree_free(tree);
 }
 
-static void bvhcache_unlock(BVHCache *bvh_cache, bool lock_started)
+static void bvhtree_balance(BVHTree *tree)
 {
-  if (lock_started) {
-    BLI_mutex_unlock(&bvh_cache->mutex);
-  }
-}
-
-bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree)
-{
-  if (bvh_cache == nullptr) {
-    return false;
-  }
-
-  for (int i = 0; i < BVHTREE_MAX_ITEM; i++) {
-    if (bvh_cache->items[i].tree == tree) {
-      return true;
-    }
+  if (tree) {
+    BLI_bvhtree_balance(tree);
   }
-  return false;
 }
 
-BVHCache *bvhcache_init()
+/** Elements that are inserted into a tree, either all of them or the ones with a set bit. */
+static IndexMask bvhtree_elements_mask(const int64_t elems_num,
+                                       const BitSpan elems_mask,
+                                       IndexMaskMemory &memory)
 {
-  BVHCache *cache = MEM_cnew<BVHCache>(__func__);
-  BLI_mutex_init(&cache->mutex);
-  return cache;
-}
-/**
- * Inserts a BVHTree of the given type under the cache
- * After that the caller no longer needs to worry when to free the BVHTree
- * as that will be done when the cache is freed.
- *
- * A call to this assumes that there was no previous cached tree of the given type
- * \warning The #BVHTree can be nullptr.
- */
-static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType type)
-{
-  BVHCacheItem *item = &bvh_cache->items[type];
-  BLI_assert(!item->is_filled);
-  item->tree = tree;
-  item->is_filled = true;
-}
-
-void bvhcache_free(BVHCache *bvh_cache)
-{
-  for (int index = 0; index < BVHTREE_MAX_ITEM; index++) {
-    BVHCacheItem *item = &bvh_cache->items[index];
-    BLI_bvhtree_free(item->tree);
-    item->tree = nullptr;
+  if (elems_mask.is_empty()) {
+    return IndexMask(elems_num);
   }
-  BLI_mutex_end(&bvh_cache->mutex);
-  MEM_freeN(bvh_cache);
+  return IndexMask::from_bits(elems_mask.take_front(elems_num), memory);
 }
 
 /**
- * BVH-tree balancing inside a mutex lock must be run in isolation. Balancing
- * is multithreaded, and we do not want the current thread to start another task
- * that may involve acquiring the same mutex lock that it is waiting for.
+ * Computing the bounds of the leaves is a significant part of building a tree, so it is done in
+ * parallel. Every element of the mask gets the leaf at its position in the mask, which gives the
+ * same tree as inserting the elements one after another.
  */
-static void bvhtree_balance_isolated(void *userdata)
+template<typename Fn>
+static void bvhtree_insert_leaves(BVHTree *tree, const IndexMask &mask, const Fn &insert_fn)
 {
-  BLI_bvhtree_balance((BVHTree *)userdata);
-}
-
-static void bvhtree_balance(BVHTree *tree, const bool isolate)
-{
-  if (tree) {
-    if (isolate) {
-      BLI_task_isolate(bvhtree_balance_isolated, tree);
-    }
-    else {
-      BLI_bvhtree_balance(tree);
-    }
-  }
+  BLI_bvhtree_leaves_num_set(tree, int(mask.size()));
+  mask.foreach_index(GrainSize(1024), insert_fn);
 }
 
 /** \} */
@@ -570,12 +476,11 @@ static BVHTree *bvhtree_from_mesh_verts_create_tree(float epsilon,
     return nullptr;
   }
 
-  for (const int i : positions.index_range()) {
-    if (!verts_mask.is_empty() && !verts_mask[i]) {
-      continue;
-    }
-    BLI_bvhtree_insert(tree, i, positions[i], 1);
-  }
+  IndexMaskMemory memory;
+  const IndexMask mask = bvhtree_elements_mask(positions.size(), verts_mask, memory);
+  bvhtree_insert_leaves(tree, mask, [&](const int i, const int leaf) {
+    BLI_bvhtree_insert_leaf(tree, leaf, i, positions[i], 1);
+  });
   BLI_assert(BLI_bvhtree_get_len(tree) == verts_num_active);
 
   return tree;
@@ -592,7 +497,7 @@ BVHTree *bvhtree_from_mesh_verts_ex(BVHTreeFromMesh *data,
   BVHTree *tree = bvhtree_from_mesh_verts_create_tree(
       epsilon, tree_type, axis, vert_positions, verts_mask, verts_num_active);
 
-  bvhtree_balance(tree, false);
+  bvhtree_balance(tree);
 
   if (data) {
     /* Setup BVHTreeFromMesh */
@@ -621,16 +526,16 @@ static BVHTree *bvhtree_from_mesh_edges_create_tree(const Span<float3> positions
     return nullptr;
   }
 
-  for (const int i : edges.index_range()) {
-    if (!edges_mask.is_empty() && !edges_mask[i]) {
-      continue;
-    }
+  IndexMaskMemory memory;
+  const IndexMask mask = bvhtree_elements_mask(edges.size(), edges_mask, memory);
+  bvhtree_insert_leaves(tree, mask, [&](const int i, const int leaf) {
     float co[2][3];
     copy_v3_v3(co[0], positions[edges[i][0]]);
     copy_v3_v3(co[1], positions[edges[i][1]]);
 
-    BLI_bvhtree_insert(tree, i, co[0], 2);
-  }
+    BLI_bvhtree_insert_leaf(tree, leaf, i, co[0], 2);
+  });
+  BLI_assert(BLI_bvhtree_get_len(tree) == edges_num_active);
 
   return tree;
 }
@@ -647,7 +552,7 @@ BVHTree *bvhtree_from_mesh_edges_ex(BVHTreeFromMesh *data,
   BVHTree *tree = bvhtree_from_mesh_edges_create_tree(
       vert_positions, edges, edges_mask, edges_num_active, epsilon, tree_type, axis);
 
-  bvhtree_balance(tree, false);
+  bvhtree_balance(tree);
 
   if (data) {
     /* Setup BVHTreeFromMesh */
@@ -726,18 +631,16 @@ static BVHTree *bvhtree_from_mesh_corner_tris_create_tree(float epsilon,
     return nullptr;
   }
 
-  for (const int i : corner_tris.index_range()) {
+  IndexMaskMemory memory;
+  const IndexMask mask = bvhtree_elements_mask(corner_tris.size(), corner_tris_mask, memory);
+  bvhtree_insert_leaves(tree, mask, [&](const int i, const int leaf) {
     float co[3][3];
-    if (!corner_tris_mask.is_empty() && !corner_tris_mask[i]) {
-      continue;
-    }
-
     copy_v3_v3(co[0], positions[corner_verts[corner_tris[i][0]]]);
     copy_v3_v3(co[1], positions[corner_verts[corner_tris[i][1]]]);
     copy_v3_v3(co[2], positions[corner_verts[corner_tris[i][2]]]);
 
-    BLI_bvhtree_insert(tree, i, co[0], 3);
-  }
+    BLI_bvhtree_insert_leaf(tree, leaf, i, co[0], 3);
+  });
 
   BLI_assert(BLI_bvhtree_get_len(tree) == corner_tris_num_active);
 
@@ -763,7 +666,7 @@ BVHTree *bvhtree_from_mesh_corner_tris_ex(BVHTreeFromMesh *data,
                                                             corner_tris_mask,
                                                             corner_tris_num_active);
 
-  bvhtree_balance(tree, false);
+  bvhtree_balance(tree);
 
   if (data) {
     /* Setup BVHTreeFromMesh */
@@ -812,112 +715,130 @@ static BitVector<> corner_tris_no_hidden_map_get(const blender::OffsetIndices<in
   return corner_tris_mask;
 }
 
-BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
-                                   const Mesh *mesh,
-                                   const BVHCacheType bvh_cache_type,
-                                   const int tree_type)
+static blender::SharedCache<blender::bke::BVHTreePointer> &bvh_cache_get(
+    blender::bke::MeshRuntime &runtime, const BVHCacheType bvh_cache_type)
 {
-  using namespace blender;
-  using namespace blender::bke;
-  BVHCache **bvh_cache_p = (BVHCache **)&mesh->runtime->bvh_cache;
-
-  Span<int3> corner_tris;
-  if (ELEM(bvh_cache_type, BVHTREE_FROM_CORNER_TRIS, BVHTREE_FROM_CORNER_TRIS_NO_HIDDEN)) {
-    corner_tris = mesh->corner_tris();
-  }
-
-  const Span<float3> positions = mesh->vert_positions();
-  const Span<int2> edges = mesh->edges();
-  const Span<int> corner_verts = mesh->corner_verts();
-
-  /* Setup BVHTreeFromMesh */
-  bvhtree_from_mesh_setup_data(nullptr,
-                               bvh_cache_type,
-                               positions,
-                               edges,
-                               corner_verts,
-                               corner_tris,
-                               (const MFace *)CustomData_get_layer(&mesh->fdata_legacy, CD_MFACE),
-                               data);
-
-  bool lock_started = false;
-  data->cached = bvhcache_find(
-      bvh_cache_p, bvh_cache_type, &data->tree, &lock_started, &mesh->runtime->eval_mutex);
-
-  if (data->cached) {
-    BLI_assert(lock_started == false);
-
-    /* NOTE: #data->tree can be nullptr. */
-    return data->tree;
+  switch (bvh_cache_type) {
+    case BVHTREE_FROM_VERTS:
+      return runtime.bvh_cache_verts;
+    case BVHTREE_FROM_EDGES:
+      return runtime.bvh_cache_edges;
+    case BVHTREE_FROM_FACES:
+      return runtime.bvh_cache_faces;
+    case BVHTREE_FROM_CORNER_TRIS:
+      return runtime.bvh_cache_corner_tris;
+    case BVHTREE_FROM_CORNER_TRIS_NO_HIDDEN:
+      return runtime.bvh_cache_corner_tris_no_hidden;
+    case BVHTREE_FROM_LOOSEVERTS:
+      return runtime.bvh_cache_loose_verts;
+    case BVHTREE_FROM_LOOSEEDGES:
+      return runtime.bvh_cache_loose_edges;
+    case BVHTREE_MAX_ITEM:
+      break;
   }
+  BLI_assert_unreachable();
+  return runtime.bvh_cache_verts;
+}
 
-  /* Create BVHTree. */
+static BVHTree *bvhtree_from_mesh_create_tree(const Mesh &mesh,
+                                              const BVHCacheType bvh_cache_type,
+                                              const int tree_type)
+{
+  using namespace blender;
+  using namespace blender::bke;
+  const Span<float3> positions = mesh.vert_positions();
+  const Span<int2> edges = mesh.edges();
+  const Span<int> corner_verts = mesh.corner_verts();
 
   switch (bvh_cache_type) {
     case BVHTREE_FROM_LOOSEVERTS: {
-      const LooseVertCache &loose_verts = mesh->loose_verts();
-      data->tree = bvhtree_from_mesh_verts_create_tree(
+      const LooseVertCache &loose_verts = mesh.loose_verts();
+      return bvhtree_from_mesh_verts_create_tree(
           0.0f, tree_type, 6, positions, loose_verts.is_loose_bits, loose_verts.count);
-      break;
     }
     case BVHTREE_FROM_VERTS: {
-      data->tree = bvhtree_from_mesh_verts_create_tree(0.0f, tree_type, 6, positions, {}, -1);
-      break;
+      return bvhtree_from_mesh_verts_create_tree(0.0f, tree_type, 6, positions, {}, -1);
     }
     case BVHTREE_FROM_LOOSEEDGES: {
-      const LooseEdgeCache &loose_edges = mesh->loose_edges();
-      data->tree = bvhtree_from_mesh_edges_create_tree(
+      const LooseEdgeCache &loose_edges = mesh.loose_edges();
+      return bvhtree_from_mesh_edges_create_tree(
           positions, edges, loose_edges.is_loose_bits, loose_edges.count, 0.0f, tree_type, 6);
-      break;
     }
     case BVHTREE_FROM_EDGES: {
-      data->tree = bvhtree_from_mesh_edges_create_tree(
-          positions, edges, {}, -1, 0.0f, tree_type, 6);
-      break;
+      return bvhtree_from_mesh_edges_create_tree(positions, edges, {}, -1, 0.0f, tree_type, 6);
     }
     case BVHTREE_FROM_FACES: {
-      BLI_assert(!(mesh->totface_legacy == 0 && mesh->faces_num != 0));
-      data->tree = bvhtree_from_mesh_faces_create_tree(
+      BLI_assert(!(mesh.totface_legacy == 0 && mesh.faces_num != 0));
+      return bvhtree_from_mesh_faces_create_tree(
           0.0f,
           tree_type,
           6,
           positions,
-          (const MFace *)CustomData_get_layer(&mesh->fdata_legacy, CD_MFACE),
-          mesh->totface_legacy,
+          (const MFace *)CustomData_get_layer(&mesh.fdata_legacy, CD_MFACE),
+          mesh.totface_legacy,
           {},
           -1);
-      break;
     }
     case BVHTREE_FROM_CORNER_TRIS_NO_HIDDEN: {
-      AttributeAccessor attributes = mesh->attributes();
+      const Span<int3> corner_tris = mesh.corner_tris();
+      AttributeAccessor attributes = mesh.attributes();
       int mask_bits_act_len = -1;
       const BitVector<> mask = corner_tris_no_hidden_map_get(
-          mesh->faces(),
+          mesh.faces(),
           *attributes.lookup_or_default(".hide_poly", AttrDomain::Face, false),
           corner_tris.size(),
           &mask_bits_act_len);
-      data->tree = bvhtree_from_mesh_corner_tris_create_tree(
+      return bvhtree_from_mesh_corner_tris_create_tree(
           0.0f, tree_type, 6, positions, corner_verts, corner_tris, mask, mask_bits_act_len);
-      break;
     }
     case BVHTREE_FROM_CORNER_TRIS: {
-      data->tree = bvhtree_from_mesh_corner_tris_create_tree(
+      const Span<int3> corner_tris = mesh.corner_tris();
+      return bvhtree_from_mesh_corner_tris_create_tree(
           0.0f, tree_type, 6, positions, corner_verts, corner_tris, {}, -1);
-      break;
     }
     case BVHTREE_MAX_ITEM:
       BLI_assert_unreachable();
       break;
   }
+  return nullptr;
+}
+
+BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
+                                   const Mesh *mesh,
+                                   const BVHCacheType bvh_cache_type,
+                                   const int tree_type)
+{
+  using namespace blender;
+  using namespace blender::bke;
+
+  Span<int3> corner_tris;
+  if (ELEM(bvh_cache_type, BVHTREE_FROM_CORNER_TRIS, BVHTREE_FROM_CORNER_TRIS_NO_HIDDEN)) {
+    corner_tris = mesh->corner_tris();
+  }
 
-  bvhtree_balance(data->tree, lock_started);
+  /* Setup BVHTreeFromMesh */
+  bvhtree_from_mesh_setup_data(nullptr,
+                               bvh_cache_type,
+                               mesh->vert_positions(),
+                               mesh->edges(),
+                               mesh->corner_verts(),
+                               corner_tris,
+                               (const MFace *)CustomData_get_layer(&mesh->fdata_legacy, CD_MFACE),
+                               data);
 
-  /* Save on cache for later use */
-  // printf("BVHTree built and saved on cache\n");
-  BLI_assert(data->cached == false);
+  /* The tree is shared with copies of the mesh that have the same positions and topology, so it
+   * is only built once for e.g. all evaluated copies or realized instances of a mesh. The cache
+   * computes the tree in an isolated task, so the multi-threaded building can't deadlock. */
+  SharedCache<BVHTreePointer> &bvh_cache = bvh_cache_get(*mesh->runtime, bvh_cache_type);
+  bvh_cache.ensure([&](BVHTreePointer &r_tree) {
+    BVHTree *tree = bvhtree_from_mesh_create_tree(*mesh, bvh_cache_type, tree_type);
+    bvhtree_balance(tree);
+    r_tree.reset(tree);
+  });
+
+  /* NOTE: #data->tree can be nullptr. */
+  data->tree = bvh_cache.data().get();
   data->cached = true;
-  bvhcache_insert(*bvh_cache_p, data->tree, bvh_cache_type);
-  bvhcache_unlock(*bvh_cache_p, lock_started);
 
 #ifndef NDEBUG
   if (data->tree != nullptr) {
@@ -959,9 +880,12 @@ void BKE_bvhtree_from_mesh_tris_init(const Mesh &mesh,
                                nullptr,
                                &r_data);
 
-  int tris_num = 0;
-  faces_mask.foreach_index(
-      [&](const int i) { tris_num += mesh::face_triangles_num(faces[i].size()); });
+  /* The first leaf of the triangles of every selected face. */
+  Array<int> leaf_offsets(faces_mask.size() + 1);
+  faces_mask.foreach_index(GrainSize(4096), [&](const int face_i, const int pos) {
+    leaf_offsets[pos] = mesh::face_triangles_num(faces[face_i].size());
+  });
+  const int tris_num = offset_indices::accumulate_counts_to_offsets(leaf_offsets).total_size();
 
   int active_num = -1;
   BVHTree *tree = bvhtree_new_common(0.0f, 2, 6, tris_num, active_num);
@@ -970,15 +894,17 @@ void BKE_bvhtree_from_mesh_tris_init(const Mesh &mesh,
     return;
   }
 
-  faces_mask.foreach_index([&](const int face_i) {
+  BLI_bvhtree_leaves_num_set(tree, tris_num);
+  faces_mask.foreach_index(GrainSize(512), [&](const int face_i, const int pos) {
     const IndexRange triangles_range = mesh::face_triangles_range(faces, face_i);
-    for (const int tri_i : triangles_range) {
+    for (const int i : triangles_range.index_range()) {
+      const int tri_i = triangles_range[i];
       float co[3][3];
       copy_v3_v3(co[0], positions[corner_verts[corner_tris[tri_i][0]]]);
       copy_v3_v3(co[1], positions[corner_verts[corner_tris[tri_i][1]]]);
       copy_v3_v3(co[2], positions[corner_verts[corner_tris[tri_i][2]]]);
 
-      BLI_bvhtree_insert(tree, tri_i, co[0], 3);
+      BLI_bvhtree_insert_leaf(tree, leaf_offsets[pos] + i, tri_i, co[0], 3);
     }
   });
 
@@ -1010,12 +936,12 @@ void BKE_bvhtree_from_mesh_edges_init(const Mesh &mesh,
     return;
   }
 
-  edges_mask.foreach_index([&](const int edge_i) {
+  bvhtree_insert_leaves(tree, edges_mask, [&](const int edge_i, const int leaf) {
     const int2 &edge = edges[edge_i];
     float co[2][3];
     copy_v3_v3(co[0], positions[edge[0]]);
     copy_v3_v3(co[1], positions[edge[1]]);
-    BLI_bvhtree_insert(tree, edge_i, co[0], 2);
+    BLI_bvhtree_insert_leaf(tree, leaf, edge_i, co[0], 2);
   });
 
   BLI_bvhtree_balance(tree);
@@ -1045,9 +971,8 @@ void BKE_bvhtree_from_mesh_verts_init(const Mesh &mesh,
     return;
   }
 
-  verts_mask.foreach_index([&](const int vert_i) {
-    const float3 &position = positions[vert_i];
-    BLI_bvhtree_insert(tree, vert_i, position, 1);
+  bvhtree_insert_leaves(tree, verts_mask, [&](const int vert_i, const int leaf) {
+    BLI_bvhtree_insert_leaf(tree, leaf, vert_i, positions[vert_i], 1);
   });
 
   BLI_bvhtree_balance(tree);
@@ -1086,7 +1011,9 @@ void BKE_bvhtree_from_pointcloud_get(const PointCloud &pointcloud,
   }
 
   const Span<float3> positions = pointcloud.positions();
-  points_mask.foreach_index([&](const int i) { BLI_bvhtree_insert(tree, i, positions[i], 1); });
+  bvhtree_insert_leaves(tree, points_mask, [&](const int i, const int leaf) {
+    BLI_bvhtree_insert_leaf(tree, leaf, i, positions[i], 1);
+  });
 
   BLI_bvhtree_balance(tree);
 
@@ -13,7 +13,6 @@
 #include "BLI_task.hh"
 
 #include "BKE_bake_data_block_id.hh"
-#include "BKE_bvhutils.hh"
 #include "BKE_customdata.hh"
 #include "BKE_editmesh_cache.hh"
 #include "BKE_lib_id.hh"
@@ -44,10 +43,13 @@ static void free_mesh_eval(MeshRuntime &mesh_runtime)
 
 static void free_bvh_cache(MeshRuntime &mesh_runtime)
 {
-  if (mesh_runtime.bvh_cache) {
-    bvhcache_free(mesh_runtime.bvh_cache);
-    mesh_runtime.bvh_cache = nullptr;
-  }
+  mesh_runtime.bvh_cache_verts.tag_dirty();
+  mesh_runtime.bvh_cache_edges.tag_dirty();
+  mesh_runtime.bvh_cache_faces.tag_dirty();
+  mesh_runtime.bvh_cache_corner_tris.tag_dirty();
+  mesh_runtime.bvh_cache_corner_tris_no_hidden.tag_dirty();
+  mesh_runtime.bvh_cache_loose_verts.tag_dirty();
+  mesh_runtime.bvh_cache_loose_edges.tag_dirty();
 }
 
 static void free_batch_cache(MeshRuntime &mesh_runtime)
@@ -63,7 +65,6 @@ MeshRuntime::MeshRuntime() = default;
 MeshRuntime::~MeshRuntime()
 {
   free_mesh_eval(*this);
-  free_bvh_cache(*this);
   free_batch_cache(*this);
 }
 
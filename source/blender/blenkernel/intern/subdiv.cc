@@ -13,6 +13,10 @@
 
 #include "BLI_utildefines.h"
 
+#include "BKE_attribute.hh"
+#include "BKE_customdata.hh"
+#include "BKE_mesh.hh"
+#include "BKE_subdiv_foreach.hh"
 #include "BKE_subdiv_modifier.hh"
 
 #include "MEM_guardedalloc.h"
@@ -24,6 +28,8 @@
 #include "opensubdiv_evaluator_capi.hh"
 #include "opensubdiv_topology_refiner_capi.hh"
 
+#include <xxhash.h>
+
 /* --------------------------------------------------------------------
  * Module.
  */
@@ -167,14 +173,70 @@ Subdiv *BKE_subdiv_update_from_converter(Subdiv *subdiv,
   return BKE_subdiv_new_from_converter(settings, converter);
 }
 
+template<typename T> static uint64_t hash_span(const blender::Span<T> span, const uint64_t seed)
+{
+  return XXH3_64bits_withSeed(span.data(), span.size_in_bytes(), seed);
+}
+
+/* Hash all the data which the mesh converter passes to OpenSubdiv, except for the vertex
+ * positions. This is much cheaper than creating the converter and comparing it against the
+ * topology refiner. */
+static uint64_t subdiv_topology_hash_from_mesh(const SubdivSettings *settings, const Mesh *mesh)
+{
+  using namespace blender;
+  uint64_t hash = XXH3_64bits_withSeed(&mesh->verts_num, sizeof(mesh->verts_num), 0);
+  hash = hash_span(mesh->edges(), hash);
+  hash = hash_span(mesh->face_offsets(), hash);
+  hash = hash_span(mesh->corner_verts(), hash);
+  hash = hash_span(mesh->corner_edges(), hash);
+  if (settings->use_creases) {
+    const bke::AttributeAccessor attributes = mesh->attributes();
+    const VArraySpan vert_creases = *attributes.lookup<float>("crease_vert",
+                                                              bke::AttrDomain::Point);
+    const VArraySpan edge_creases = *attributes.lookup<float>("crease_edge",
+                                                              bke::AttrDomain::Edge);
+    hash = hash_span(vert_creases, hash + 1);
+    hash = hash_span(edge_creases, hash + 1);
+  }
+  /* The face-varying topology is created from the UV maps. */
+  const int uv_maps_num = CustomData_number_of_layers(&mesh->corner_data, CD_PROP_FLOAT2);
+  for (const int i : IndexRange(uv_maps_num)) {
+    const float2 *uv_map = static_cast<const float2 *>(
+        CustomData_get_layer_n(&mesh->corner_data, CD_PROP_FLOAT2, i));
+    hash = hash_span(Span(uv_map, mesh->corners_num), hash);
+  }
+  return hash;
+}
+
 Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
                                     const SubdivSettings *settings,
                                     const Mesh *mesh)
 {
+  SubdivStats stats;
+  BKE_subdiv_stats_init(&stats);
+  BKE_subdiv_stats_begin(&stats, SUBDIV_STATS_TOPOLOGY_HASH);
+  const uint64_t topology_hash = subdiv_topology_hash_from_mesh(settings, mesh);
+  BKE_subdiv_stats_end(&stats, SUBDIV_STATS_TOPOLOGY_HASH);
+  if (subdiv != nullptr && subdiv->topology_refiner != nullptr &&
+      subdiv->cache_.has_topology_hash && subdiv->cache_.topology_hash == topology_hash &&
+      BKE_subdiv_settings_equal(&subdiv->settings, settings))
+  {
+    /* Only the vertex positions changed, e.g. with deformation. The topology refiner, the
+     * evaluator with its patch tables and the cached traversal data stay valid, so only the limit
+     * surface has to be evaluated again. */
+    BKE_subdiv_stats_reset(&subdiv->stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+    subdiv->stats.topology_hash_time = stats.topology_hash_time;
+    return subdiv;
+  }
   OpenSubdiv_Converter converter;
   BKE_subdiv_converter_init_for_mesh(&converter, settings, mesh);
   subdiv = BKE_subdiv_update_from_converter(subdiv, settings, &converter);
   BKE_subdiv_converter_free(&converter);
+  if (subdiv != nullptr) {
+    subdiv->cache_.topology_hash = topology_hash;
+    subdiv->cache_.has_topology_hash = true;
+    subdiv->stats.topology_hash_time = stats.topology_hash_time;
+  }
   return subdiv;
 }
 
@@ -198,6 +260,9 @@ void BKE_subdiv_free(Subdiv *subdiv)
   if (subdiv->cache_.face_ptex_offset != nullptr) {
     MEM_freeN(subdiv->cache_.face_ptex_offset);
   }
+  if (subdiv->cache_.foreach_plan != nullptr) {
+    BKE_subdiv_foreach_plan_free(subdiv->cache_.foreach_plan);
+  }
   MEM_freeN(subdiv);
 }
 
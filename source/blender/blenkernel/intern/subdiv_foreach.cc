@@ -111,6 +111,33 @@ struct SubdivForeachTaskContext {
   BLI_bitmap *coarse_edges_used_map;
 };
 
+/**
+ * Counters and offsets of the subdivided mesh. They only depend on the coarse topology and the
+ * resolution, so they are cached in the #Subdiv and reused as long as only the coarse vertex
+ * positions change, like for deforming meshes.
+ */
+struct SubdivForeachPlan {
+  int resolution;
+  int coarse_verts_num;
+  int coarse_edges_num;
+  int coarse_faces_num;
+
+  int num_subdiv_vertices;
+  int num_subdiv_edges;
+  int num_subdiv_loops;
+  int num_subdiv_faces;
+
+  int vertices_corner_offset;
+  int vertices_edge_offset;
+  int vertices_inner_offset;
+  int edge_boundary_offset;
+  int edge_inner_offset;
+
+  int *subdiv_vertex_offset;
+  int *subdiv_edge_offset;
+  int *subdiv_face_offset;
+};
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -243,12 +270,19 @@ static void subdiv_foreach_ctx_init_offsets(SubdivForeachTaskContext *ctx)
   }
 }
 
-static void subdiv_foreach_ctx_init(Subdiv *subdiv, SubdivForeachTaskContext *ctx)
+static bool subdiv_foreach_plan_matches(const SubdivForeachPlan *plan,
+                                        const SubdivForeachTaskContext *ctx)
+{
+  const Mesh *coarse_mesh = ctx->coarse_mesh;
+  return plan->resolution == ctx->settings->resolution &&
+         plan->coarse_verts_num == coarse_mesh->verts_num &&
+         plan->coarse_edges_num == coarse_mesh->edges_num &&
+         plan->coarse_faces_num == coarse_mesh->faces_num;
+}
+
+static SubdivForeachPlan *subdiv_foreach_plan_create(SubdivForeachTaskContext *ctx)
 {
   const Mesh *coarse_mesh = ctx->coarse_mesh;
-  /* Allocate maps and offsets. */
-  ctx->coarse_vertices_used_map = BLI_BITMAP_NEW(coarse_mesh->verts_num, "vertices used map");
-  ctx->coarse_edges_used_map = BLI_BITMAP_NEW(coarse_mesh->edges_num, "edges used map");
   ctx->subdiv_vertex_offset = static_cast<int *>(MEM_malloc_arrayN(
       coarse_mesh->faces_num, sizeof(*ctx->subdiv_vertex_offset), "vertex_offset"));
   ctx->subdiv_edge_offset = static_cast<int *>(MEM_malloc_arrayN(
@@ -259,6 +293,65 @@ static void subdiv_foreach_ctx_init(Subdiv *subdiv, SubdivForeachTaskContext *ct
   subdiv_foreach_ctx_init_offsets(ctx);
   /* Calculate number of geometry in the result subdivision mesh. */
   subdiv_foreach_ctx_count(ctx);
+
+  SubdivForeachPlan *plan = MEM_new<SubdivForeachPlan>(__func__);
+  plan->resolution = ctx->settings->resolution;
+  plan->coarse_verts_num = coarse_mesh->verts_num;
+  plan->coarse_edges_num = coarse_mesh->edges_num;
+  plan->coarse_faces_num = coarse_mesh->faces_num;
+  plan->num_subdiv_vertices = ctx->num_subdiv_vertices;
+  plan->num_subdiv_edges = ctx->num_subdiv_edges;
+  plan->num_subdiv_loops = ctx->num_subdiv_loops;
+  plan->num_subdiv_faces = ctx->num_subdiv_faces;
+  plan->vertices_corner_offset = ctx->vertices_corner_offset;
+  plan->vertices_edge_offset = ctx->vertices_edge_offset;
+  plan->vertices_inner_offset = ctx->vertices_inner_offset;
+  plan->edge_boundary_offset = ctx->edge_boundary_offset;
+  plan->edge_inner_offset = ctx->edge_inner_offset;
+  plan->subdiv_vertex_offset = ctx->subdiv_vertex_offset;
+  plan->subdiv_edge_offset = ctx->subdiv_edge_offset;
+  plan->subdiv_face_offset = ctx->subdiv_face_offset;
+  return plan;
+}
+
+static void subdiv_foreach_ctx_init_from_plan(SubdivForeachTaskContext *ctx,
+                                              const SubdivForeachPlan *plan)
+{
+  ctx->num_subdiv_vertices = plan->num_subdiv_vertices;
+  ctx->num_subdiv_edges = plan->num_subdiv_edges;
+  ctx->num_subdiv_loops = plan->num_subdiv_loops;
+  ctx->num_subdiv_faces = plan->num_subdiv_faces;
+  ctx->vertices_corner_offset = plan->vertices_corner_offset;
+  ctx->vertices_edge_offset = plan->vertices_edge_offset;
+  ctx->vertices_inner_offset = plan->vertices_inner_offset;
+  ctx->edge_boundary_offset = plan->edge_boundary_offset;
+  ctx->edge_inner_offset = plan->edge_inner_offset;
+  ctx->subdiv_vertex_offset = plan->subdiv_vertex_offset;
+  ctx->subdiv_edge_offset = plan->subdiv_edge_offset;
+  ctx->subdiv_face_offset = plan->subdiv_face_offset;
+}
+
+static void subdiv_foreach_ctx_init(Subdiv *subdiv, SubdivForeachTaskContext *ctx)
+{
+  const Mesh *coarse_mesh = ctx->coarse_mesh;
+  /* Allocate maps. */
+  ctx->coarse_vertices_used_map = BLI_BITMAP_NEW(coarse_mesh->verts_num, "vertices used map");
+  ctx->coarse_edges_used_map = BLI_BITMAP_NEW(coarse_mesh->edges_num, "edges used map");
+  /* Counters and offsets are owned by the subdiv, and are only calculated when the topology or
+   * the resolution changed since the last traversal. */
+  SubdivForeachPlan *plan = subdiv->cache_.foreach_plan;
+  if (plan != nullptr && subdiv_foreach_plan_matches(plan, ctx)) {
+    subdiv_foreach_ctx_init_from_plan(ctx, plan);
+    BKE_subdiv_stats_reset(&subdiv->stats, SUBDIV_STATS_FOREACH_PLAN);
+  }
+  else {
+    BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_FOREACH_PLAN);
+    if (plan != nullptr) {
+      BKE_subdiv_foreach_plan_free(plan);
+    }
+    subdiv->cache_.foreach_plan = subdiv_foreach_plan_create(ctx);
+    BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_FOREACH_PLAN);
+  }
   ctx->face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
 }
 
@@ -266,9 +359,14 @@ static void subdiv_foreach_ctx_free(SubdivForeachTaskContext *ctx)
 {
   MEM_freeN(ctx->coarse_vertices_used_map);
   MEM_freeN(ctx->coarse_edges_used_map);
-  MEM_freeN(ctx->subdiv_vertex_offset);
-  MEM_freeN(ctx->subdiv_edge_offset);
-  MEM_freeN(ctx->subdiv_face_offset);
+}
+
+void BKE_subdiv_foreach_plan_free(SubdivForeachPlan *plan)
+{
+  MEM_freeN(plan->subdiv_vertex_offset);
+  MEM_freeN(plan->subdiv_edge_offset);
+  MEM_freeN(plan->subdiv_face_offset);
+  MEM_delete(plan);
 }
 
 /** \} */
@@ -57,6 +57,19 @@ FileReader *BLI_filereader_new_mmap(int filedes) ATTR_WARN_UNUSED_RESULT;
 /** Create #FileReader from a region of memory. */
 FileReader *BLI_filereader_new_memory(const void *data, size_t len) ATTR_WARN_UNUSED_RESULT
     ATTR_NONNULL();
+/**
+ * Access the data of a #FileReader created by #BLI_filereader_new_memory or
+ * #BLI_filereader_new_mmap without copying it.
+ *
+ * \return A pointer to `size` bytes starting at `offset`, or NULL when the reader is not
+ * memory-backed, the range is out of bounds or a previous IO error occurred.
+ * For memory-mapped files, #BLI_filereader_memory_is_valid has to be checked after the
+ * returned memory has been read, since IO errors are only detected when accessing it.
+ */
+const void *BLI_filereader_memory_data(FileReader *reader, off64_t offset, size_t size)
+    ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+/** Returns false when accessing the data of a memory-backed #FileReader caused an IO error. */
+bool BLI_filereader_memory_is_valid(FileReader *reader) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
 /** Create #FileReader from applying `Zstd` decompression on an underlying file. */
 FileReader *BLI_filereader_new_zstd(FileReader *base) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 /** Create #FileReader from applying `Gzip` decompression on an underlying file. */
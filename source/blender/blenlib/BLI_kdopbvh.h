@@ -139,6 +139,14 @@ void BLI_bvhtree_free(BVHTree *tree);
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
 
+/**
+ * Construct from multiple threads: first set the number of leaves, then insert every leaf at its
+ * own position (in any order and from any thread), then call balance.
+ */
+void BLI_bvhtree_leaves_num_set(BVHTree *tree, int leaf_num);
+void BLI_bvhtree_insert_leaf(
+    BVHTree *tree, int leaf_index, int index, const float co[3], int numpoints);
+
 /**
  * Update: first update points/nodes, then call update_tree to refit the bounding volumes.
  * \note call before #BLI_bvhtree_update_tree().
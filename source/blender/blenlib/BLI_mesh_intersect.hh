@@ -50,6 +50,11 @@ struct Vert {
   double3 co;
   int id = NO_INDEX;
   int orig = NO_INDEX;
+  /**
+   * True when `co` is exactly equal to `co_exact`. That is always the case for input vertices,
+   * but usually not for constructed ones like intersection points, whose `co` is rounded.
+   */
+  bool co_is_exact = false;
 
   Vert() = default;
   Vert(const mpq3 &mco, const double3 &dco, int id, int orig);
@@ -370,6 +375,13 @@ struct BoundingBox {
  */
 bool bbs_might_intersect(const BoundingBox &bb_a, const BoundingBox &bb_b);
 
+/**
+ * Exact sign of the orientation of the four vertices, like #orient3d on their exact coordinates.
+ * The determinant is evaluated with doubles first and exact arithmetic is only used when the
+ * floating point error bound does not allow deciding the sign, which is rare.
+ */
+int orient3d_with_filter(const Vert *a, const Vert *b, const Vert *c, const Vert *d);
+
 /**
  * This is the main routine for calculating the self_intersection of a triangle mesh.
  *
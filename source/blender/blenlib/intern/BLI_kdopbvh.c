@@ -1003,6 +1003,33 @@ void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoin
   bvhtree_node_inflate(tree, node, tree->epsilon);
 }
 
+void BLI_bvhtree_leaves_num_set(BVHTree *tree, int leaf_num)
+{
+  BLI_assert(tree->branch_num <= 0);
+  BLI_assert(tree->leaf_num == 0);
+  BLI_assert((size_t)leaf_num <= MEM_allocN_len(tree->nodes) / sizeof(*(tree->nodes)));
+
+  tree->leaf_num = leaf_num;
+}
+
+void BLI_bvhtree_insert_leaf(
+    BVHTree *tree, int leaf_index, int index, const float co[3], int numpoints)
+{
+  BVHNode *node = NULL;
+
+  BLI_assert(tree->branch_num <= 0);
+  BLI_assert(leaf_index >= 0 && leaf_index < tree->leaf_num);
+
+  /* Only the node at the given position is written, so different leaves can be inserted from
+   * different threads. */
+  node = tree->nodes[leaf_index] = &(tree->nodearray[leaf_index]);
+
+  create_kdop_hull(tree, node, co, numpoints, 0);
+  node->index = index;
+
+  bvhtree_node_inflate(tree, node, tree->epsilon);
+}
+
 bool BLI_bvhtree_update_node(
     BVHTree *tree, int index, const float co[3], const float co_moving[3], int numpoints)
 {
@@ -8,9 +8,11 @@
 
 #include "BLI_mmap.h"
 #include "BLI_fileops.h"
-#include "BLI_listbase.h"
+#include "BLI_threads.h"
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include <string.h>
 
 #ifndef WIN32
@@ -32,6 +34,8 @@ struct BLI_mmap_file {
 
   /* Platform-specific handle for the mapping. */
   void *handle;
+  /* The mapped memory may be written to, see #BLI_mmap_open_copy_on_write. */
+  bool copy_on_write;
 
   /* Flag to indicate IO errors. Needs to be volatile since it's being set from
    * within the signal handler, which is not part of the normal execution flow. */
@@ -41,9 +45,8 @@ struct BLI_mmap_file {
 #ifndef WIN32
 /* When using memory-mapped files, any IO errors will result in a SIGBUS signal.
  * Therefore, we need to catch that signal and stop reading the file in question.
- * To do so, we keep a list of all current FileDatas that use memory-mapped files,
- * and if a SIGBUS is caught, we check if the failed address is inside one of the
- * mapped regions.
+ * To do so, we keep a table of all currently memory-mapped files, and if a SIGBUS
+ * is caught, we check if the failed address is inside one of the mapped regions.
  * If it is, we set a flag to indicate a failed read and remap the memory in
  * question to a zero-backed region in order to avoid additional signals.
  * The code that actually reads the memory area has to check whether the flag was
@@ -52,11 +55,22 @@ struct BLI_mmap_file {
  * handler if one was configured and abort the process otherwise.
  */
 
+/* Maximum number of files that can be mapped at the same time. Opening more files fails, callers
+ * are expected to fall back to reading the file then. */
+#  define MMAP_FILES_MAX 4096
+
 static struct error_handler_data {
-  ListBase open_mmaps;
+  /* Files may be opened and freed from different threads (e.g. when baked geometry that
+   * references mapped memory is freed) while the signal handler runs on another thread. The
+   * handler cannot lock, so it reads this fixed-size table with atomic loads. Empty slots are
+   * null. */
+  BLI_mmap_file *open_mmaps[MMAP_FILES_MAX];
   char configured;
   void (*next_handler)(int, siginfo_t *, void *);
-} error_handler = {0};
+} error_handler = {{0}};
+
+/* Synchronizes threads that change the table of open files, not used by the signal handler. */
+static ThreadMutex error_handler_mutex = BLI_MUTEX_INITIALIZER;
 
 static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
 {
@@ -65,16 +79,20 @@ static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
 
   char *error_addr = (char *)siginfo->si_addr;
   /* Find the file that this error belongs to. */
-  LISTBASE_FOREACH (LinkData *, link, &error_handler.open_mmaps) {
-    BLI_mmap_file *file = link->data;
+  for (int i = 0; i < MMAP_FILES_MAX; i++) {
+    BLI_mmap_file *file = atomic_load_ptr((void *const *)&error_handler.open_mmaps[i]);
+    if (file == NULL) {
+      continue;
+    }
 
     /* Is the address where the error occurred in this file's mapped range? */
     if (error_addr >= file->memory && error_addr < file->memory + file->length) {
       file->io_error = true;
 
       /* Replace the mapped memory with zeroes. */
+      const int prot = file->copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
       const void *mapped_memory = mmap(
-          file->memory, file->length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+          file->memory, file->length, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
       if (mapped_memory == MAP_FAILED) {
         fprintf(stderr, "SIGBUS handler: Error replacing mapped file with zeros\n");
       }
@@ -96,6 +114,7 @@ static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
 /* Ensures that the error handler is set up and ready. */
 static bool sigbus_handler_setup(void)
 {
+  BLI_mutex_lock(&error_handler_mutex);
   if (!error_handler.configured) {
     struct sigaction newact = {0}, oldact = {0};
 
@@ -103,6 +122,7 @@ static bool sigbus_handler_setup(void)
     newact.sa_flags = SA_SIGINFO;
 
     if (sigaction(SIGBUS, &newact, &oldact)) {
+      BLI_mutex_unlock(&error_handler_mutex);
       return false;
     }
 
@@ -111,25 +131,42 @@ static bool sigbus_handler_setup(void)
     error_handler.next_handler = oldact.sa_sigaction;
     error_handler.configured = 1;
   }
+  BLI_mutex_unlock(&error_handler_mutex);
 
   return true;
 }
 
-/* Adds a file to the list that the error handler checks. */
-static void sigbus_handler_add(BLI_mmap_file *file)
+/* Adds a file to the table that the error handler checks. Fails when the table is full. */
+static bool sigbus_handler_add(BLI_mmap_file *file)
 {
-  BLI_addtail(&error_handler.open_mmaps, BLI_genericNodeN(file));
+  bool added = false;
+  BLI_mutex_lock(&error_handler_mutex);
+  for (int i = 0; i < MMAP_FILES_MAX; i++) {
+    if (error_handler.open_mmaps[i] == NULL) {
+      atomic_store_ptr((void **)&error_handler.open_mmaps[i], file);
+      added = true;
+      break;
+    }
+  }
+  BLI_mutex_unlock(&error_handler_mutex);
+  return added;
 }
 
-/* Removes a file from the list that the error handler checks. */
+/* Removes a file from the table that the error handler checks. */
 static void sigbus_handler_remove(BLI_mmap_file *file)
 {
-  LinkData *link = BLI_findptr(&error_handler.open_mmaps, file, offsetof(LinkData, data));
-  BLI_freelinkN(&error_handler.open_mmaps, link);
+  BLI_mutex_lock(&error_handler_mutex);
+  for (int i = 0; i < MMAP_FILES_MAX; i++) {
+    if (error_handler.open_mmaps[i] == file) {
+      atomic_store_ptr((void **)&error_handler.open_mmaps[i], NULL);
+      break;
+    }
+  }
+  BLI_mutex_unlock(&error_handler_mutex);
 }
 #endif
 
-BLI_mmap_file *BLI_mmap_open(int fd)
+static BLI_mmap_file *mmap_open(int fd, const bool copy_on_write)
 {
   void *memory, *handle = NULL;
   const size_t length = BLI_lseek(fd, 0, SEEK_END);
@@ -144,7 +181,8 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   }
 
   /* Map the given file to memory. */
-  memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  const int prot = copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  memory = mmap(NULL, length, prot, MAP_PRIVATE, fd, 0);
   if (memory == MAP_FAILED) {
     return NULL;
   }
@@ -154,11 +192,12 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   /* Memory mapping on Windows is a two-step process - first we create a mapping,
    * then we create a view into that mapping.
    * In our case, one view that spans the entire file is enough. */
-  handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  handle = CreateFileMapping(
+      file_handle, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
   if (handle == NULL) {
     return NULL;
   }
-  memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+  memory = MapViewOfFile(handle, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
   if (memory == NULL) {
     CloseHandle(handle);
     return NULL;
@@ -170,15 +209,30 @@ BLI_mmap_file *BLI_mmap_open(int fd)
   file->memory = memory;
   file->handle = handle;
   file->length = length;
+  file->copy_on_write = copy_on_write;
 
 #ifndef WIN32
   /* Register the file with the error handler. */
-  sigbus_handler_add(file);
+  if (!sigbus_handler_add(file)) {
+    munmap(memory, length);
+    MEM_freeN(file);
+    return NULL;
+  }
 #endif
 
   return file;
 }
 
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+  return mmap_open(fd, false);
+}
+
+BLI_mmap_file *BLI_mmap_open_copy_on_write(int fd)
+{
+  return mmap_open(fd, true);
+}
+
 bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
 {
   /* If a previous read has already failed or we try to read past the end,
@@ -218,11 +272,17 @@ size_t BLI_mmap_get_length(const BLI_mmap_file *file)
   return file->length;
 }
 
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
 void BLI_mmap_free(BLI_mmap_file *file)
 {
 #ifndef WIN32
-  munmap((void *)file->memory, file->length);
+  /* Unregister first, the address range may be reused by another mapping after unmapping. */
   sigbus_handler_remove(file);
+  munmap((void *)file->memory, file->length);
 #else
   UnmapViewOfFile(file->memory);
   CloseHandle(file->handle);
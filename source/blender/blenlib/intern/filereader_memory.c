@@ -128,3 +128,35 @@ FileReader *BLI_filereader_new_mmap(int filedes)
 
   return (FileReader *)mem;
 }
+
+const void *BLI_filereader_memory_data(FileReader *reader, off64_t offset, size_t size)
+{
+  if (!ELEM(reader->close, memory_close_raw, memory_close_mmap)) {
+    return NULL;
+  }
+  MemoryReader *mem = (MemoryReader *)reader;
+
+  if (offset < 0 || (size_t)offset + size > mem->length) {
+    return NULL;
+  }
+  if (mem->mmap) {
+#ifdef WIN32
+    /* IO errors are only handled by the structured exception handling in #BLI_mmap_read. */
+    return NULL;
+#else
+    if (BLI_mmap_any_io_error(mem->mmap)) {
+      return NULL;
+    }
+    return (const char *)BLI_mmap_get_pointer(mem->mmap) + offset;
+#endif
+  }
+  return mem->data + offset;
+}
+
+bool BLI_filereader_memory_is_valid(FileReader *reader)
+{
+  if (reader->close == memory_close_mmap) {
+    return !BLI_mmap_any_io_error(((MemoryReader *)reader)->mmap);
+  }
+  return true;
+}
@@ -11,9 +11,31 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
 
 #include "MEM_guardedalloc.h"
 
+/**
+ * Upper bound for the number of decompressed frames kept in memory (and decompressed ahead in
+ * parallel when reading sequentially). Frames are written with a size of 1 MB by `writefile.cc`.
+ */
+#define ZSTD_FRAME_CACHE_MAX 16
+
+typedef struct ZstdFrameCache {
+  /** Index of the frame stored in this entry, -1 when unused. */
+  int frame;
+  char *content;
+  size_t content_size;
+
+  /** Compressed input, only used while decompressing. */
+  char *compressed;
+  size_t compressed_size;
+
+  /** Every entry has its own context, so multiple frames can be decompressed in parallel. */
+  ZSTD_DCtx *ctx;
+  bool success;
+} ZstdFrameCache;
+
 typedef struct {
   FileReader reader;
 
@@ -28,8 +50,14 @@ typedef struct {
     size_t *compressed_ofs;
     size_t *uncompressed_ofs;
 
-    char *cached_content;
-    int cached_frame;
+    /** Ring of decompressed frames, see #zstd_ensure_cache. */
+    ZstdFrameCache *cache;
+    int cache_len;
+    int cache_next;
+    /** Number of frames to decompress at once when reading sequentially. */
+    int readahead_len;
+    /** Last accessed frame, used to detect sequential reading. */
+    int last_frame;
   } seek;
 } ZstdReader;
 
@@ -125,7 +153,18 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
     return false;
   }
 
-  zstd->seek.cached_frame = -1;
+  /* With a single thread, decompressing ahead doesn't help, but keep two frames around
+   * so that reading a block which spans a frame boundary doesn't decompress frames twice. */
+  const int threads_num = BLI_task_scheduler_num_threads();
+  zstd->seek.readahead_len = clamp_i(threads_num, 1, ZSTD_FRAME_CACHE_MAX);
+  zstd->seek.cache_len = max_ii(zstd->seek.readahead_len, 2);
+  zstd->seek.cache = MEM_calloc_arrayN(
+      zstd->seek.cache_len, sizeof(ZstdFrameCache), "ZstdFrameCache");
+  for (int i = 0; i < zstd->seek.cache_len; i++) {
+    zstd->seek.cache[i].frame = -1;
+  }
+  zstd->seek.cache_next = 0;
+  zstd->seek.last_frame = -1;
 
   return true;
 }
@@ -153,42 +192,140 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
-/* Ensure that the currently loaded frame is the correct one. */
+static ZstdFrameCache *zstd_cache_lookup(ZstdReader *zstd, int frame)
+{
+  for (int i = 0; i < zstd->seek.cache_len; i++) {
+    if (zstd->seek.cache[i].frame == frame) {
+      return &zstd->seek.cache[i];
+    }
+  }
+  return NULL;
+}
+
+/* Read the compressed data of the frame, this has to happen serially since it uses the base. */
+static bool zstd_cache_read_compressed(ZstdReader *zstd, ZstdFrameCache *entry, int frame)
+{
+  const size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] -
+                                 zstd->seek.compressed_ofs[frame];
+  const size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                                   zstd->seek.uncompressed_ofs[frame];
+
+  /* Buffers are reused between frames, they all have the same size except for the last one. */
+  if (entry->compressed_size < compressed_size) {
+    MEM_SAFE_FREE(entry->compressed);
+    entry->compressed = MEM_mallocN(compressed_size, __func__);
+    entry->compressed_size = compressed_size;
+  }
+  if (entry->content_size < uncompressed_size) {
+    MEM_SAFE_FREE(entry->content);
+    entry->content = MEM_mallocN(uncompressed_size, __func__);
+    entry->content_size = uncompressed_size;
+  }
+  if (entry->ctx == NULL) {
+    entry->ctx = ZSTD_createDCtx();
+  }
+
+  entry->frame = frame;
+  entry->success = false;
+
+  return zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) >= 0 &&
+         zstd->base->read(zstd->base, entry->compressed, compressed_size) >= compressed_size;
+}
+
+static void zstd_cache_decompress(const ZstdReader *zstd, ZstdFrameCache *entry)
+{
+  const int frame = entry->frame;
+  const size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] -
+                                 zstd->seek.compressed_ofs[frame];
+  const size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                                   zstd->seek.uncompressed_ofs[frame];
+
+  size_t res = ZSTD_decompressDCtx(
+      entry->ctx, entry->content, uncompressed_size, entry->compressed, compressed_size);
+  entry->success = !ZSTD_isError(res) && res >= uncompressed_size;
+}
+
+static void zstd_cache_decompress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const ZstdReader *zstd = BLI_task_pool_user_data(pool);
+  zstd_cache_decompress(zstd, (ZstdFrameCache *)taskdata);
+}
+
+/* Take the next entry of the ring, without evicting frames in the `[keep_start, keep_end)`
+ * range that are about to be used. */
+static ZstdFrameCache *zstd_cache_next_free(ZstdReader *zstd, int keep_start, int keep_end)
+{
+  for (int i = 0; i < zstd->seek.cache_len; i++) {
+    ZstdFrameCache *entry = &zstd->seek.cache[zstd->seek.cache_next];
+    zstd->seek.cache_next = (zstd->seek.cache_next + 1) % zstd->seek.cache_len;
+    if (entry->frame < keep_start || entry->frame >= keep_end) {
+      return entry;
+    }
+  }
+  BLI_assert_unreachable();
+  return NULL;
+}
+
+/**
+ * Ensure that the given frame is decompressed and return its content.
+ *
+ * When reading sequentially, the following frames are decompressed in parallel along with it,
+ * random access (e.g. when linking from a library) only decompresses the requested frame.
+ */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
-  if (zstd->seek.cached_frame == frame) {
+  const bool is_sequential = frame == zstd->seek.last_frame + 1;
+  zstd->seek.last_frame = frame;
+
+  ZstdFrameCache *entry = zstd_cache_lookup(zstd, frame);
+  if (entry) {
     /* Cached frame matches, so just return it. */
-    return zstd->seek.cached_content;
+    return entry->content;
   }
 
-  /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
-  MEM_SAFE_FREE(zstd->seek.cached_content);
+  const int batch_start = frame;
+  const int batch_end = is_sequential ?
+                            min_ii(frame + zstd->seek.readahead_len, zstd->seek.frames_num) :
+                            frame + 1;
 
-  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
-  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
-                             zstd->seek.uncompressed_ofs[frame];
+  ZstdFrameCache *batch[ZSTD_FRAME_CACHE_MAX];
+  int batch_len = 0;
+  for (int i = batch_start; i < batch_end; i++) {
+    if (zstd_cache_lookup(zstd, i)) {
+      continue;
+    }
+    ZstdFrameCache *new_entry = zstd_cache_next_free(zstd, batch_start, batch_end);
+    if (!zstd_cache_read_compressed(zstd, new_entry, i)) {
+      new_entry->frame = -1;
+      if (i == frame) {
+        return NULL;
+      }
+      /* Failing to read ahead is not an error yet, the frame may never be needed. */
+      break;
+    }
+    batch[batch_len++] = new_entry;
+  }
 
-  char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
-  char *compressed_data = MEM_mallocN(compressed_size, __func__);
-  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
-      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
-  {
-    MEM_freeN(compressed_data);
-    MEM_freeN(uncompressed_data);
-    return NULL;
+  if (batch_len > 1) {
+    TaskPool *pool = BLI_task_pool_create(zstd, TASK_PRIORITY_HIGH);
+    for (int i = 0; i < batch_len; i++) {
+      BLI_task_pool_push(pool, zstd_cache_decompress_task, batch[i], false, NULL);
+    }
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    zstd_cache_decompress(zstd, batch[0]);
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
-  MEM_freeN(compressed_data);
-  if (ZSTD_isError(res) || res < uncompressed_size) {
-    MEM_freeN(uncompressed_data);
-    return NULL;
+  for (int i = 0; i < batch_len; i++) {
+    if (!batch[i]->success) {
+      batch[i]->frame = -1;
+    }
   }
 
-  zstd->seek.cached_frame = frame;
-  zstd->seek.cached_content = uncompressed_data;
-  return uncompressed_data;
+  entry = zstd_cache_lookup(zstd, frame);
+  return entry ? entry->content : NULL;
 }
 
 static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
@@ -281,10 +418,16 @@ static void zstd_close(FileReader *reader)
   if (zstd->reader.seek) {
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
-    /* When an error has occurred this may be NULL, see: #99744. */
-    if (zstd->seek.cached_content) {
-      MEM_freeN(zstd->seek.cached_content);
+    for (int i = 0; i < zstd->seek.cache_len; i++) {
+      ZstdFrameCache *entry = &zstd->seek.cache[i];
+      /* Buffers may be NULL when the entry was never used, see: #99744. */
+      MEM_SAFE_FREE(entry->content);
+      MEM_SAFE_FREE(entry->compressed);
+      if (entry->ctx) {
+        ZSTD_freeDCtx(entry->ctx);
+      }
     }
+    MEM_freeN(zstd->seek.cache);
   }
   else {
     MEM_freeN((void *)zstd->in_buf.src);
@@ -22,6 +22,7 @@
 #  include "BLI_hash.hh"
 #  include "BLI_kdopbvh.h"
 #  include "BLI_map.hh"
+#  include "BLI_math_boolean.hh"
 #  include "BLI_math_geom.h"
 #  include "BLI_math_matrix.h"
 #  include "BLI_math_mpq.hh"
@@ -56,7 +57,11 @@ static void dump_perfdata();
 static constexpr bool intersect_use_threading = true;
 
 Vert::Vert(const mpq3 &mco, const double3 &dco, int id, int orig)
-    : co_exact(mco), co(dco), id(id), orig(orig)
+    : co_exact(mco),
+      co(dco),
+      id(id),
+      orig(orig),
+      co_is_exact(mco[0] == dco[0] && mco[1] == dco[1] && mco[2] == dco[2])
 {
 }
 
@@ -1123,6 +1128,56 @@ static int filter_plane_side(const double3 &p,
   return 0;
 }
 
+/**
+ * Index of the determinant calculated by #orient3d_with_filter: the coordinate differences have
+ * index 2, the 2x2 minors index 6 and the sum of the three products index 11.
+ */
+constexpr int index_orient3d = 11;
+
+/**
+ * Only used for sorting triangles around edges in the boolean (`sort_tris_class`), which is
+ * where exact orientation tests were evaluated most often without a filter before. The other
+ * exact sign computations are left alone:
+ * - The exact plane side tests in #intersect_tri_tri only run after #filter_plane_side could not
+ *   decide, so the points are nearly co-planar and filtering again would practically never
+ *   succeed.
+ * - #tti_above only runs for triangle pairs that are known to intersect, whose exact
+ *   intersection points are computed right after, which costs much more than the sign tests.
+ * - `find_ambient_cell` compares slopes and squared distances instead of orientations, and only
+ *   runs once per patch component.
+ * - The `orient3d` in the ray-cast winding number code already works on doubles.
+ */
+int orient3d_with_filter(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
+{
+  if (!(a->co_is_exact && b->co_is_exact && c->co_is_exact && d->co_is_exact)) {
+    /* The error bound only covers the error of the determinant computation, not the rounding of
+     * the coordinates themselves. */
+    return orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+  }
+  const double3 ad = a->co - d->co;
+  const double3 bd = b->co - d->co;
+  const double3 cd = c->co - d->co;
+  /* Same expression as the exact #orient3d, so that the signs agree. */
+  const double det = ad[2] * (bd[0] * cd[1] - cd[0] * bd[1]) +
+                     bd[2] * (cd[0] * ad[1] - ad[0] * cd[1]) +
+                     cd[2] * (ad[0] * bd[1] - bd[0] * ad[1]);
+  const double3 abs_ad = math::abs(ad);
+  const double3 abs_bd = math::abs(bd);
+  const double3 abs_cd = math::abs(cd);
+  const double supremum = abs_ad[2] * (abs_bd[0] * abs_cd[1] + abs_cd[0] * abs_bd[1]) +
+                          abs_bd[2] * (abs_cd[0] * abs_ad[1] + abs_ad[0] * abs_cd[1]) +
+                          abs_cd[2] * (abs_ad[0] * abs_bd[1] + abs_bd[0] * abs_ad[1]);
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (det > err_bound) {
+    return 1;
+  }
+  if (det < -err_bound) {
+    return -1;
+  }
+  /* Too close to decide with doubles, which includes the case of exactly coplanar points. */
+  return orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+}
+
 /*
  * #intersect_tri_tri and helper functions.
  * This code uses the algorithm of Guigue and Devillers, as described
@@ -4,6 +4,7 @@
 
 #include "testing/testing.h"
 
+#include <array>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -12,11 +13,17 @@
 
 #include "BLI_array.hh"
 #include "BLI_map.hh"
+#include "BLI_math_boolean.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_math_vector_mpq_types.hh"
 #include "BLI_mesh_boolean.hh"
+#include "BLI_rand.hh"
+#include "BLI_task.h"
+#include "BLI_time.h"
 #include "BLI_vector.hh"
 
+#define DO_PERF_TESTS 0
+
 #ifdef WITH_GMP
 namespace blender::meshintersect::tests {
 
@@ -610,9 +617,7 @@ TEST(boolean_polymesh, CubeCube)
   }
 }
 
-TEST(boolean_polymesh, CubeCone)
-{
-  const char *spec = R"(14 12
+static const char *cube_cone_spec = R"(14 12
   -1 -1 -1
   -1 -1 1
   -1 1 -1
@@ -640,7 +645,9 @@ TEST(boolean_polymesh, CubeCone)
   13 11 8
   8 9 10 12 13)";
 
-  IMeshBuilder mb(spec);
+TEST(boolean_polymesh, CubeCone)
+{
+  IMeshBuilder mb(cube_cone_spec);
   IMesh out = boolean_mesh(
       mb.imesh, BoolOpType::Union, 1, all_shape_zero, true, false, nullptr, &mb.arena);
   out.populate_vert();
@@ -957,5 +964,136 @@ TEST(boolean_polymesh, CubePlane)
   }
 }
 
+static double3 random_point(RandomNumberGenerator &rng)
+{
+  return double3(rng.get_double(), rng.get_double(), rng.get_double()) * 2.0 - 1.0;
+}
+
+/**
+ * Sets of four vertices for orientation tests. The fourth vertex of the set is either random,
+ * exactly on the plane of the first three, or very close to that plane. The last two cases are
+ * where the floating point filter can't decide.
+ */
+static Vector<std::array<const Vert *, 4>> make_orient3d_cases(const int cases_num,
+                                                               IMeshArena &arena)
+{
+  RandomNumberGenerator rng(0);
+  Vector<std::array<const Vert *, 4>> cases;
+  int vert_id = 0;
+  for (const int i : IndexRange(cases_num)) {
+    const mpq3 a(random_point(rng));
+    const mpq3 b(random_point(rng));
+    const mpq3 c(random_point(rng));
+    mpq3 d;
+    switch (i % 3) {
+      case 0:
+        d = mpq3(random_point(rng));
+        break;
+      case 1:
+        d = a + (b - a) * mpq_class(1, 3) + (c - a) * mpq_class(2, 7);
+        break;
+      case 2:
+        d = a + (b - a) * mpq_class(1, 3) + (c - a) * mpq_class(2, 7) +
+            mpq3(0, 0, mpq_class(1, 1000000000000));
+        break;
+    }
+    cases.append({arena.add_or_find_vert(a, vert_id++),
+                  arena.add_or_find_vert(b, vert_id++),
+                  arena.add_or_find_vert(c, vert_id++),
+                  arena.add_or_find_vert(d, vert_id++)});
+  }
+  return cases;
+}
+
+TEST(boolean_trimesh, Orient3dWithFilter)
+{
+  IMeshArena arena;
+  for (const std::array<const Vert *, 4> &verts : make_orient3d_cases(300, arena)) {
+    const int exact = orient3d(
+        verts[0]->co_exact, verts[1]->co_exact, verts[2]->co_exact, verts[3]->co_exact);
+    EXPECT_EQ(orient3d_with_filter(verts[0], verts[1], verts[2], verts[3]), exact);
+  }
+}
+
+/**
+ * Constructed vertices, like intersection points, only have rounded double coordinates. Far away
+ * from the origin that rounding is larger than the distance of the fourth vertex to the plane,
+ * so the sign can only be found with the exact coordinates.
+ */
+TEST(boolean_trimesh, Orient3dWithFilterConstructedOffset)
+{
+  IMeshArena arena;
+  RandomNumberGenerator rng(0);
+  const double3 offset(1000000.0, -2000000.0, 3000000.0);
+  int vert_id = 0;
+  for (const int i : IndexRange(300)) {
+    const Vert *a = arena.add_or_find_vert(offset + random_point(rng), vert_id++);
+    const Vert *b = arena.add_or_find_vert(offset + random_point(rng), vert_id++);
+    const Vert *c = arena.add_or_find_vert(offset + random_point(rng), vert_id++);
+    EXPECT_TRUE(a->co_is_exact && b->co_is_exact && c->co_is_exact);
+    const mpq3 normal = math::cross(b->co_exact - a->co_exact, c->co_exact - a->co_exact);
+    const mpq_class distance((i % 2 == 0 ? 1 : -1), 10000000000000);
+    const mpq3 d_exact = a->co_exact + (b->co_exact - a->co_exact) * mpq_class(1, 3) +
+                         (c->co_exact - a->co_exact) * mpq_class(2, 7) + normal * distance;
+    const Vert *d = arena.add_or_find_vert(d_exact, vert_id++);
+    EXPECT_FALSE(d->co_is_exact);
+    const int exact = orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+    EXPECT_NE(exact, 0);
+    EXPECT_EQ(orient3d_with_filter(a, b, c, d), exact);
+    EXPECT_EQ(orient3d_with_filter(d, c, b, a),
+              orient3d(d->co_exact, c->co_exact, b->co_exact, a->co_exact));
+
+    /* The rounded position is an input vertex itself, so the filter can be used for it. */
+    const Vert *d_rounded = arena.add_or_find_vert(d->co, vert_id++);
+    EXPECT_TRUE(d_rounded->co_is_exact);
+    EXPECT_EQ(orient3d_with_filter(a, b, c, d_rounded),
+              orient3d(a->co_exact, b->co_exact, c->co_exact, d_rounded->co_exact));
+  }
+}
+
+#  if DO_PERF_TESTS
+
+/* The cell finding of the boolean sorts the triangles around every edge shared by patches, which
+ * used exact orientation tests for every pair of triangles before #orient3d_with_filter. */
+
+TEST(boolean_perf, Orient3dWithFilter)
+{
+  IMeshArena arena;
+  const Vector<std::array<const Vert *, 4>> cases = make_orient3d_cases(300000, arena);
+  int exact_sum = 0;
+  const double time_exact_start = BLI_time_now_seconds();
+  for (const std::array<const Vert *, 4> &verts : cases) {
+    exact_sum += orient3d(
+        verts[0]->co_exact, verts[1]->co_exact, verts[2]->co_exact, verts[3]->co_exact);
+  }
+  const double time_filter_start = BLI_time_now_seconds();
+  int filter_sum = 0;
+  for (const std::array<const Vert *, 4> &verts : cases) {
+    filter_sum += orient3d_with_filter(verts[0], verts[1], verts[2], verts[3]);
+  }
+  const double time_end = BLI_time_now_seconds();
+  EXPECT_EQ(exact_sum, filter_sum);
+  std::cout << "Exact orient3d time: " << time_filter_start - time_exact_start << "\n";
+  std::cout << "Filtered orient3d time: " << time_end - time_filter_start << "\n";
+}
+
+TEST(boolean_perf, CubeCone)
+{
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  const int iterations = 200;
+  double time_total = 0.0;
+  for ([[maybe_unused]] const int i : IndexRange(iterations)) {
+    IMeshBuilder mb(cube_cone_spec);
+    const double time_start = BLI_time_now_seconds();
+    IMesh out = boolean_mesh(
+        mb.imesh, BoolOpType::Union, 1, all_shape_zero, true, false, nullptr, &mb.arena);
+    time_total += BLI_time_now_seconds() - time_start;
+  }
+  std::cout << "Average boolean time: " << time_total / iterations << "\n";
+  BLI_task_scheduler_exit();
+}
+
+#  endif
+
 }  // namespace blender::meshintersect::tests
 #endif
@@ -17,6 +17,7 @@ namespace blender {
 class ImplicitSharingInfo;
 }
 struct GHash;
+struct MemFileChunkBuffer;
 struct Main;
 struct Scene;
 
@@ -31,10 +32,15 @@ struct MemFileSharedStorage {
 
 struct MemFileChunk {
   void *next, *prev;
-  const char *buf;
+  /** Reference counted content, access it with #BLO_memfile_chunk_read. */
+  MemFileChunkBuffer *buffer;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /**
+   * When true, this chunk has the same content as the matching chunk of the previous step.
+   * Chunk buffers are reference counted and shared between all steps with the same content,
+   * so this doesn't imply anything about ownership.
+   */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -47,6 +53,7 @@ struct MemFileChunk {
 
 struct MemFile {
   ListBase chunks;
+  /** Size of the chunk buffers allocated for this memfile, not shared with previous ones. */
   size_t size;
   /**
    * Some data is not serialized into a new buffer because the undo-step can take ownership of it
@@ -80,6 +87,10 @@ struct UndoReader {
   int undo_direction;
 
   bool memchunk_identical;
+
+  /** Decompression statistics when the reader was created, for reporting. */
+  size_t decompress_num_init;
+  double decompress_time_init;
 };
 
 /* Actually only used `writefile.cc`. */
@@ -91,6 +102,42 @@ void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size);
 
+/** Statistics about chunk buffers shared between all undo steps, see #MemFileChunk. */
+struct MemFileChunkStoreStats {
+  /** Chunks of all undo steps, and their total size in bytes. */
+  size_t chunks_num;
+  size_t chunks_size;
+  /** Distinct buffers actually stored for these chunks, and their total size in bytes. */
+  size_t buffers_num;
+  size_t buffers_size;
+  /** Total of chunks found in the storage by content rather than in the previous step. */
+  size_t dedup_num;
+  size_t dedup_size;
+  /** Buffers currently compressed, their uncompressed and compressed size in bytes. */
+  size_t compressed_num;
+  size_t compressed_size;
+  size_t compressed_storage_size;
+  /** Total of buffers decompressed on access, and the time spent on it in seconds. */
+  size_t decompress_num;
+  double decompress_time;
+};
+
+MemFileChunkStoreStats BLO_memfile_chunk_store_stats();
+
+/** Copy `size` bytes of the chunk content from `offset`, decompressing it when needed. */
+void BLO_memfile_chunk_read(const MemFileChunk *chunk, size_t offset, void *r_data, size_t size);
+
+/**
+ * Compress chunk buffers in the background, that were not used by the last `keep_steps` undo
+ * pushes or reads. Does nothing while a previous compression is still running.
+ */
+void BLO_memfile_compress_schedule(int keep_steps);
+/**
+ * Wait until the scheduled compression is done. Must be called from the thread that schedules
+ * compression.
+ */
+void BLO_memfile_compress_wait();
+
 /* exports */
 
 /**
@@ -55,6 +55,7 @@
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
 
@@ -167,6 +168,24 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * When the file is memory-mapped, only read and reconstruct the data blocks of an ID once
+ * they are looked up while reading the ID. Blocks that are never referenced (e.g. data of
+ * removed features, or arrays replaced by versioning) are never copied out of the file.
+ */
+#ifdef USE_BHEAD_READ_ON_DEMAND
+#  define USE_DATAMAP_READ_ON_DEMAND
+#endif
+
+/**
+ * Read the large data blocks of an ID (e.g. geometry arrays) using multiple threads.
+ * Can be disabled at run-time with `--debug-blendfile-no-threads`.
+ */
+#define USE_PARALLEL_DATA_READ
+#ifdef USE_PARALLEL_DATA_READ
+#  define PARALLEL_DATA_READ_MIN_LEN (64 * 1024)
+#endif
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -246,6 +265,11 @@ struct NewAddress {
 
 struct OldNewMap {
   blender::Map<const void *, NewAddress> map;
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+  /** Blocks that are read into #map on their first lookup, see #datamap_lookup_and_inc. */
+  blender::Map<const void *, BHead *> deferred_map;
+  const char *deferred_allocname;
+#endif
 };
 
 static OldNewMap *oldnewmap_new()
@@ -310,6 +334,9 @@ static void oldnewmap_clear(OldNewMap *onm)
     }
   }
   onm->map.clear_and_shrink();
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+  onm->deferred_map.clear_and_shrink();
+#endif
 }
 
 static void oldnewmap_free(OldNewMap *onm)
@@ -869,6 +896,15 @@ static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
   bool success = true;
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
   BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+
+  /* Memory-mapped files can be copied from directly, without seeking back and forth. */
+  if (const void *data = BLI_filereader_memory_data(
+          fd->file, new_bhead->file_offset, size_t(new_bhead->bhead.len)))
+  {
+    memcpy(buf, data, size_t(new_bhead->bhead.len));
+    return BLI_filereader_memory_is_valid(fd->file);
+  }
+
   off64_t offset_backup = fd->file->offset;
   if (UNLIKELY(fd->file->seek(fd->file, new_bhead->file_offset, SEEK_SET) == -1)) {
     success = false;
@@ -902,6 +938,17 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   }
   return &new_bhead_data->bhead;
 }
+
+/**
+ * Get the data of a block that has not been read yet without copying it,
+ * only possible when the file is memory-mapped.
+ */
+static const void *blo_bhead_peek_data(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false);
+  return BLI_filereader_memory_data(fd->file, new_bhead->file_offset, size_t(thisblock->len));
+}
 #endif /* USE_BHEAD_READ_ON_DEMAND */
 
 const char *blo_bhead_id_name(const FileData *fd, const BHead *bhead)
@@ -1428,16 +1475,30 @@ short BLO_version_from_file(const char *filepath)
 /** \name Old/New Pointer Map
  * \{ */
 
+static void *datamap_lookup_and_inc(FileData *fd, const void *adr, bool increase_users)
+{
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+  OldNewMap *onm = fd->datamap;
+  if (!onm->deferred_map.is_empty()) {
+    if (std::optional<BHead *> bhead = onm->deferred_map.pop_try(adr)) {
+      void *data = read_struct(fd, *bhead, onm->deferred_allocname);
+      oldnewmap_insert(onm, adr, data, 0);
+    }
+  }
+#endif
+  return oldnewmap_lookup_and_inc(fd->datamap, adr, increase_users);
+}
+
 /* Only direct data-blocks. */
 static void *newdataadr(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return datamap_lookup_and_inc(fd, adr, true);
 }
 
 /* Only direct data-blocks. */
 static void *newdataadr_no_us(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
+  return datamap_lookup_and_inc(fd, adr, false);
 }
 
 void *blo_read_get_new_globaldata_address(FileData *fd, const void *adr)
@@ -1452,7 +1513,7 @@ static void *newpackedadr(FileData *fd, const void *adr)
     return oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
   }
 
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return datamap_lookup_and_inc(fd, adr, true);
 }
 
 /* only lib data */
@@ -1780,7 +1841,11 @@ static void switch_endian_structs(const SDNA *filesdna, BHead *bhead)
   }
 }
 
-static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+/**
+ * Read the data of a block, \a r_file_ok is cleared when reading the file failed.
+ * Does not modify \a fd, so that it can be used to read different blocks in parallel.
+ */
+static void *read_struct_ex(FileData *fd, BHead *bh, const char *blockname, bool &r_file_ok)
 {
   void *temp = nullptr;
 
@@ -1795,7 +1860,7 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
       if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
         bh = blo_bhead_read_full(fd, bh);
         if (UNLIKELY(bh == nullptr)) {
-          fd->flags &= ~FD_FLAGS_FILE_OK;
+          r_file_ok = false;
           return nullptr;
         }
       }
@@ -1807,9 +1872,19 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
+          /* Reconstruct directly from the mapped file, this avoids a temporary copy of the
+           * whole block (the endian switch above always reads the full block). */
+          if (const void *data = blo_bhead_peek_data(fd, bh)) {
+            temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
+            if (UNLIKELY(!BLI_filereader_memory_is_valid(fd->file))) {
+              r_file_ok = false;
+              MEM_SAFE_FREE(temp);
+            }
+            return temp;
+          }
           bh = blo_bhead_read_full(fd, bh);
           if (UNLIKELY(bh == nullptr)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
+            r_file_ok = false;
             return nullptr;
           }
         }
@@ -1827,7 +1902,7 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
           /* Instead of allocating the bhead, then copying it,
            * read the data from the file directly into the memory. */
           if (UNLIKELY(!blo_bhead_read_data(fd, bh, temp))) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
+            r_file_ok = false;
             MEM_freeN(temp);
             temp = nullptr;
           }
@@ -1848,6 +1923,16 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
   return temp;
 }
 
+static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+{
+  bool file_ok = true;
+  void *temp = read_struct_ex(fd, bh, blockname, file_ok);
+  if (UNLIKELY(!file_ok)) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+  return temp;
+}
+
 /* Like read_struct, but gets a pointer without allocating. Only works for
  * undo since DNA must match. */
 static const void *peek_struct_undo(FileData *fd, BHead *bhead)
@@ -2470,24 +2555,107 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
   return success;
 }
 
+#ifdef USE_PARALLEL_DATA_READ
+/**
+ * Whether the data of the block can be read from any thread, without going through the
+ * (stateful) #FileReader.
+ */
+static bool blo_bhead_data_is_thread_safe(FileData *fd, BHead *bhead)
+{
+#  ifdef USE_BHEAD_READ_ON_DEMAND
+  return BHEADN_FROM_BHEAD(bhead)->has_data || blo_bhead_peek_data(fd, bhead) != nullptr;
+#  else
+  UNUSED_VARS(fd, bhead);
+  return true;
+#  endif
+}
+#endif
+
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+/**
+ * Only defer blocks that can be accessed randomly without any cost,
+ * seeking in compressed files would decompress the same frames over and over.
+ */
+static bool blo_bhead_data_can_defer(FileData *fd, BHead *bhead)
+{
+  return bhead->len && bhead->old && BHEADN_FROM_BHEAD(bhead)->has_data == false &&
+         blo_bhead_peek_data(fd, bhead) != nullptr;
+}
+#endif
+
 /* Read all data associated with a datablock into datamap. */
 static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
 {
-  bhead = blo_bhead_next(fd, bhead);
+  blender::Vector<BHead *, 16> data_bheads;
+  for (bhead = blo_bhead_next(fd, bhead); bhead && bhead->code == BLO_CODE_DATA;
+       bhead = blo_bhead_next(fd, bhead))
+  {
+    data_bheads.append(bhead);
+  }
+
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+  fd->datamap->deferred_allocname = allocname;
+#endif
+
+#ifdef USE_PARALLEL_DATA_READ
+  /* Large blocks (typically geometry arrays) are copied, endian switched and reconstructed in
+   * parallel. Their results are only inserted in the map in file order below, so the map is the
+   * same as when reading serially. Blocks that are deferred stay lazy, they are only read when
+   * they are actually used. */
+  blender::Vector<int64_t> parallel_indices;
+  if ((G.debug & G_DEBUG_BLENDFILE_NO_THREADS) == 0) {
+    for (const int64_t i : data_bheads.index_range()) {
+      BHead *data_bhead = data_bheads[i];
+#  ifdef USE_DATAMAP_READ_ON_DEMAND
+      if (blo_bhead_data_can_defer(fd, data_bhead)) {
+        continue;
+      }
+#  endif
+      if (data_bhead->len >= PARALLEL_DATA_READ_MIN_LEN &&
+          blo_bhead_data_is_thread_safe(fd, data_bhead))
+      {
+        parallel_indices.append(i);
+      }
+    }
+  }
+  blender::Array<void *> parallel_data;
+  blender::Array<bool> is_read_in_parallel;
+  if (parallel_indices.size() > 1) {
+    parallel_data.reinitialize(data_bheads.size());
+    is_read_in_parallel.reinitialize(data_bheads.size());
+    is_read_in_parallel.fill(false);
+    /* Failures are gathered per block, #FileData is only modified from this thread. */
+    blender::Array<bool> parallel_file_ok(parallel_indices.size(), true);
+    blender::threading::parallel_for(
+        parallel_indices.index_range(), 1, [&](const blender::IndexRange range) {
+          for (const int64_t i : range) {
+            const int64_t index = parallel_indices[i];
+            parallel_data[index] = read_struct_ex(
+                fd, data_bheads[index], allocname, parallel_file_ok[i]);
+            is_read_in_parallel[index] = true;
+          }
+        });
+    if (parallel_file_ok.as_span().contains(false)) {
+      fd->flags &= ~FD_FLAGS_FILE_OK;
+    }
+  }
+#endif
+
+  for (const int64_t i : data_bheads.index_range()) {
+    BHead *data_bhead = data_bheads[i];
 
-  while (bhead && bhead->code == BLO_CODE_DATA) {
     /* The code below is useful for debugging leaks in data read from the blend file.
      * Without this the messages only tell us what ID-type the memory came from,
      * eg: `Data from OB len 64`, see #dataname.
      * With the code below we get the struct-name to help tracking down the leak.
      * This is kept disabled as the #malloc for the text always leaks memory. */
 #if 0
-    if (bhead->SDNAnr == 0) {
+    if (data_bhead->SDNAnr == 0) {
       /* The data type here is unclear because #writedata sets SDNAnr to 0. */
       allocname = "likely raw data";
     }
     else {
-      SDNA_Struct *sp = fd->filesdna->structs[bhead->SDNAnr];
+      SDNA_Struct *sp = fd->filesdna->structs[data_bhead->SDNAnr];
       allocname = fd->filesdna->types[sp->type];
       size_t allocname_size = strlen(allocname) + 1;
       char *allocname_buf = static_cast<char *>(malloc(allocname_size));
@@ -2496,12 +2664,26 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
     }
 #endif
 
-    void *data = read_struct(fd, bhead, allocname);
-    if (data) {
-      oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+#ifdef USE_PARALLEL_DATA_READ
+    if (!is_read_in_parallel.is_empty() && is_read_in_parallel[i]) {
+      if (void *data = parallel_data[i]) {
+        oldnewmap_insert(fd->datamap, data_bhead->old, data, 0);
+      }
+      continue;
     }
+#endif
 
-    bhead = blo_bhead_next(fd, bhead);
+#ifdef USE_DATAMAP_READ_ON_DEMAND
+    if (blo_bhead_data_can_defer(fd, data_bhead)) {
+      fd->datamap->deferred_map.add_overwrite(data_bhead->old, data_bhead);
+      continue;
+    }
+#endif
+
+    void *data = read_struct(fd, data_bhead, allocname);
+    if (data) {
+      oldnewmap_insert(fd->datamap, data_bhead->old, data, 0);
+    }
   }
 
   return bhead;
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <mutex>
 
 /* open/close */
 #ifndef _WIN32
@@ -22,10 +23,14 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "CLG_log.h"
+
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_task.h"
+#include "BLI_time.h"
 
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -34,21 +39,368 @@
 #include "BKE_main.hh"
 #include "BKE_undo_system.hh"
 
+#include <xxhash.h>
+#include <zstd.h>
+
 #include "BLI_strict_flags.h" /* Keep last. */
 
+static CLG_LogRef LOG = {"blo.undofile"};
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Buffer Storage
+ *
+ * Chunk buffers are shared by content between all undo steps, not only with the matching chunk
+ * of the previous step. This avoids storing the same data multiple times when toggling between
+ * two states, or when data moves within the file. Buffers are reference counted by the chunks
+ * using them, and freed with the last one.
+ *
+ * Buffers that were not used by recent undo pushes or reads can be compressed in the background,
+ * see #BLO_memfile_compress_schedule. They are decompressed again when accessed. All access to
+ * buffer data goes through the storage mutex, the compression job only holds a user.
+ * \{ */
+
+/* Favor speed, compression happens in the background but decompression blocks undo. */
+#define MEMFILE_COMPRESSION_LEVEL 1
+
+struct MemFileChunkBuffer {
+  uint64_t hash;
+  size_t size;
+  int users;
+  /** False when a different buffer with the same hash was stored first. */
+  bool is_stored;
+  /** Uncompressed data, null while compressed. */
+  char *data;
+  /** Compressed data, null while uncompressed. */
+  void *compressed_data;
+  size_t compressed_size;
+  /** Value of #MemFileChunkStore.clock when this buffer was last used. */
+  uint64_t last_used;
+};
+
+struct MemFileChunkStore {
+  std::mutex mutex;
+  /** Use a raw map, so the static storage is not reported as leaked memory on exit. */
+  blender::RawMap<uint64_t, MemFileChunkBuffer *> buffers;
+  MemFileChunkStoreStats stats = {};
+  /** Incremented on every undo push and read, to find buffers that were not used recently. */
+  uint64_t clock = 0;
+  /** Background compression, see #BLO_memfile_compress_schedule. */
+  TaskPool *compress_pool = nullptr;
+  bool compress_running = false;
+};
+
+static MemFileChunkStore &memfile_chunk_store()
+{
+  static MemFileChunkStore store;
+  return store;
+}
+
+static void memfile_chunk_buffer_unref_locked(MemFileChunkStore &store, MemFileChunkBuffer *buffer)
+{
+  BLI_assert(buffer->users > 0);
+  if (--buffer->users > 0) {
+    return;
+  }
+
+  if (buffer->is_stored) {
+    store.buffers.remove(buffer->hash);
+  }
+  store.stats.buffers_num--;
+  store.stats.buffers_size -= buffer->size;
+  if (buffer->compressed_data) {
+    store.stats.compressed_num--;
+    store.stats.compressed_size -= buffer->size;
+    store.stats.compressed_storage_size -= buffer->compressed_size;
+    MEM_freeN(buffer->compressed_data);
+  }
+  MEM_SAFE_FREE(buffer->data);
+  MEM_freeN(buffer);
+}
+
+/** Get the uncompressed data of the buffer, decompressing it if needed. */
+static const char *memfile_chunk_buffer_data_ensure_locked(MemFileChunkStore &store,
+                                                           MemFileChunkBuffer *buffer)
+{
+  buffer->last_used = store.clock;
+  if (buffer->data != nullptr) {
+    return buffer->data;
+  }
+
+  const double start_time = BLI_time_now_seconds();
+  buffer->data = static_cast<char *>(MEM_mallocN(buffer->size, "Chunk buffer"));
+  const size_t size = ZSTD_decompress(
+      buffer->data, buffer->size, buffer->compressed_data, buffer->compressed_size);
+  BLI_assert(size == buffer->size);
+  UNUSED_VARS_NDEBUG(size);
+
+  store.stats.compressed_num--;
+  store.stats.compressed_size -= buffer->size;
+  store.stats.compressed_storage_size -= buffer->compressed_size;
+  store.stats.decompress_num++;
+  store.stats.decompress_time += BLI_time_now_seconds() - start_time;
+  MEM_freeN(buffer->compressed_data);
+  buffer->compressed_data = nullptr;
+  buffer->compressed_size = 0;
+
+  return buffer->data;
+}
+
+/** Add a user to the buffer of a chunk from a previous step. */
+static MemFileChunkBuffer *memfile_chunk_buffer_share(MemFileChunkBuffer *buffer)
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  buffer->users++;
+  buffer->last_used = store.clock;
+  store.stats.chunks_num++;
+  store.stats.chunks_size += buffer->size;
+  return buffer;
+}
+
+static bool memfile_chunk_buffer_equals(MemFileChunkBuffer *buffer,
+                                        const char *buf,
+                                        const size_t size)
+{
+  if (buffer->size != size) {
+    return false;
+  }
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  return memcmp(memfile_chunk_buffer_data_ensure_locked(store, buffer), buf, size) == 0;
+}
+
+/**
+ * Find a stored buffer with the same content as `buf`, or store a copy of it.
+ * \param r_is_new: Set when a new buffer was allocated.
+ */
+static MemFileChunkBuffer *memfile_chunk_buffer_ensure(const char *buf,
+                                                       const size_t size,
+                                                       bool *r_is_new)
+{
+  const uint64_t hash = XXH3_64bits_withSeed(buf, size, uint64_t(size));
+
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  store.stats.chunks_num++;
+  store.stats.chunks_size += size;
+
+  MemFileChunkBuffer *existing = store.buffers.lookup_default(hash, nullptr);
+  if (existing != nullptr && existing->size == size &&
+      memcmp(memfile_chunk_buffer_data_ensure_locked(store, existing), buf, size) == 0)
+  {
+    existing->users++;
+    store.stats.dedup_num++;
+    store.stats.dedup_size += size;
+    *r_is_new = false;
+    return existing;
+  }
+
+  MemFileChunkBuffer *buffer = MEM_cnew<MemFileChunkBuffer>("MemFileChunkBuffer");
+  buffer->hash = hash;
+  buffer->size = size;
+  buffer->users = 1;
+  buffer->is_stored = (existing == nullptr);
+  buffer->data = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
+  buffer->last_used = store.clock;
+  memcpy(buffer->data, buf, size);
+  if (buffer->is_stored) {
+    store.buffers.add_new(hash, buffer);
+  }
+  store.stats.buffers_num++;
+  store.stats.buffers_size += size;
+
+  *r_is_new = true;
+  return buffer;
+}
+
+static void memfile_chunk_buffer_release(MemFileChunkBuffer *buffer)
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  store.stats.chunks_num--;
+  store.stats.chunks_size -= buffer->size;
+  memfile_chunk_buffer_unref_locked(store, buffer);
+}
+
+void BLO_memfile_chunk_read(const MemFileChunk *chunk, size_t offset, void *r_data, size_t size)
+{
+  BLI_assert(offset + size <= chunk->size);
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  memcpy(r_data, memfile_chunk_buffer_data_ensure_locked(store, chunk->buffer) + offset, size);
+}
+
+MemFileChunkStoreStats BLO_memfile_chunk_store_stats()
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  return store.stats;
+}
+
+/** Buffers to compress, each one holding a user until it is processed. */
+struct MemFileCompressJob {
+  blender::Vector<MemFileChunkBuffer *> buffers;
+  int64_t buffers_done = 0;
+  /** Buffers used since this clock value are kept uncompressed. */
+  uint64_t last_used_limit;
+};
+
+static void memfile_compress_job_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  MemFileCompressJob *job = static_cast<MemFileCompressJob *>(taskdata);
+  MemFileChunkStore &store = memfile_chunk_store();
+  {
+    std::lock_guard lock(store.mutex);
+    /* Release buffers left over when the job was canceled. */
+    for (const int64_t i : job->buffers.index_range().drop_front(job->buffers_done)) {
+      memfile_chunk_buffer_unref_locked(store, job->buffers[i]);
+    }
+    store.compress_running = false;
+  }
+  MEM_delete(job);
+}
+
+static void memfile_compress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  MemFileCompressJob *job = static_cast<MemFileCompressJob *>(taskdata);
+  MemFileChunkStore &store = memfile_chunk_store();
+
+  const double start_time = BLI_time_now_seconds();
+  size_t size_in = 0;
+  size_t size_out = 0;
+
+  for (; job->buffers_done < job->buffers.size(); job->buffers_done++) {
+    if (BLI_task_pool_current_canceled(pool)) {
+      break;
+    }
+    MemFileChunkBuffer *buffer = job->buffers[job->buffers_done];
+
+    /* The uncompressed data is only freed here, or when the last user is gone,
+     * so it can be read without holding the lock. */
+    const size_t bound = ZSTD_compressBound(buffer->size);
+    void *compressed_data = MEM_mallocN(bound, "Chunk buffer compressed");
+    const size_t compressed_size = ZSTD_compress(
+        compressed_data, bound, buffer->data, buffer->size, MEMFILE_COMPRESSION_LEVEL);
+
+    std::lock_guard lock(store.mutex);
+    if (!ZSTD_isError(compressed_size) && compressed_size < buffer->size &&
+        buffer->last_used < job->last_used_limit)
+    {
+      buffer->compressed_data = MEM_reallocN(compressed_data, compressed_size);
+      buffer->compressed_size = compressed_size;
+      MEM_freeN(buffer->data);
+      buffer->data = nullptr;
+      store.stats.compressed_num++;
+      store.stats.compressed_size += buffer->size;
+      store.stats.compressed_storage_size += compressed_size;
+      size_in += buffer->size;
+      size_out += compressed_size;
+    }
+    else {
+      MEM_freeN(compressed_data);
+    }
+    memfile_chunk_buffer_unref_locked(store, buffer);
+  }
+
+  CLOG_INFO(&LOG,
+            1,
+            "Compressed undo buffers: %zu -> %zu bytes in %.3f s",
+            size_in,
+            size_out,
+            BLI_time_now_seconds() - start_time);
+}
+
+void BLO_memfile_compress_schedule(const int keep_steps)
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  TaskPool *pool_done = nullptr;
+  {
+    std::lock_guard lock(store.mutex);
+    if (store.compress_running) {
+      /* Remaining buffers are handled by the next push. */
+      return;
+    }
+    std::swap(pool_done, store.compress_pool);
+  }
+  if (pool_done) {
+    BLI_task_pool_free(pool_done);
+  }
+
+  MemFileCompressJob *job = MEM_new<MemFileCompressJob>(__func__);
+  {
+    std::lock_guard lock(store.mutex);
+    const uint64_t keep = uint64_t(keep_steps);
+    job->last_used_limit = store.clock > keep ? store.clock - keep : 0;
+    for (MemFileChunkBuffer *buffer : store.buffers.values()) {
+      if (buffer->data != nullptr && buffer->last_used < job->last_used_limit) {
+        buffer->users++;
+        job->buffers.append(buffer);
+      }
+    }
+    if (job->buffers.is_empty()) {
+      MEM_delete(job);
+      return;
+    }
+    store.compress_running = true;
+    store.compress_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+    BLI_task_pool_push(
+        store.compress_pool, memfile_compress_task, job, true, memfile_compress_job_free);
+  }
+}
+
+void BLO_memfile_compress_wait()
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  TaskPool *pool = nullptr;
+  {
+    std::lock_guard lock(store.mutex);
+    pool = store.compress_pool;
+  }
+  if (pool) {
+    BLI_task_pool_work_and_wait(pool);
+  }
+}
+
+/** Stop background compression, once no undo step uses the storage anymore. */
+static void memfile_compress_end()
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  TaskPool *pool = nullptr;
+  {
+    std::lock_guard lock(store.mutex);
+    std::swap(pool, store.compress_pool);
+  }
+  if (pool) {
+    BLI_task_pool_cancel(pool);
+    BLI_task_pool_free(pool);
+  }
+}
+
+/** Start a new undo push or read, buffers used from now on count as recently used. */
+static void memfile_chunk_store_tick()
+{
+  MemFileChunkStore &store = memfile_chunk_store();
+  std::lock_guard lock(store.mutex);
+  store.clock++;
+}
+
+/** \} */
+
 /* **************** support for memory-write, for undo buffers *************** */
 
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    memfile_chunk_buffer_release(chunk->buffer);
     MEM_freeN(chunk);
   }
   MEM_delete(memfile->shared_storage);
   memfile->shared_storage = nullptr;
   memfile->size = 0;
+
+  if (BLO_memfile_chunk_store_stats().chunks_num == 0) {
+    memfile_compress_end();
+  }
 }
 
 MemFileSharedStorage::~MemFileSharedStorage()
@@ -59,34 +411,10 @@ MemFileSharedStorage::~MemFileSharedStorage()
   }
 }
 
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile * /*second*/)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  blender::Map<const char *, MemFileChunk *> buffer_to_second_memchunk;
-
-  /* First, detect all memchunks in second memfile that are not owned by it. */
-  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
-    if (sc->is_identical) {
-      buffer_to_second_memchunk.add(sc->buf, sc);
-    }
-  }
-
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
-  LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
-    if (!fc->is_identical) {
-      if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
-    }
-  }
-
+  /* Chunk buffers are reference counted, the ones still used by the second memfile (or any other
+   * one) are kept alive by their other users. */
   BLO_memfile_free(first);
 }
 
@@ -103,6 +431,7 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 {
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
+  memfile_chunk_store_tick();
   mem_data->reference_current_chunk = reference_memfile ? static_cast<MemFileChunk *>(
                                                               reference_memfile->chunks.first) :
                                                           nullptr;
@@ -126,6 +455,24 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
 {
   mem_data->id_session_uid_mapping.clear_and_shrink();
+
+  if (CLOG_CHECK(&LOG, 1)) {
+    const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+    CLOG_INFO(&LOG,
+              1,
+              "Undo push: %zu new bytes. Chunks: %zu (%zu bytes), stored buffers: %zu (%zu "
+              "bytes), deduplicated: %zu (%zu bytes), compressed: %zu (%zu -> %zu bytes)",
+              mem_data->written_memfile->size,
+              stats.chunks_num,
+              stats.chunks_size,
+              stats.buffers_num,
+              stats.buffers_size,
+              stats.dedup_num,
+              stats.dedup_size,
+              stats.compressed_num,
+              stats.compressed_size,
+              stats.compressed_storage_size);
+  }
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -136,7 +483,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   MemFileChunk *curchunk = static_cast<MemFileChunk *>(
       MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk"));
   curchunk->size = size;
-  curchunk->buf = nullptr;
+  curchunk->buffer = nullptr;
   curchunk->is_identical = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
@@ -149,8 +496,8 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   if (*compchunk_step != nullptr) {
     MemFileChunk *compchunk = *compchunk_step;
     if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
+      if (memfile_chunk_buffer_equals(compchunk->buffer, buf, size)) {
+        curchunk->buffer = memfile_chunk_buffer_share(compchunk->buffer);
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
       }
@@ -158,12 +505,13 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
-  /* not equal... */
-  if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+  /* Not equal to the previous step, but the same content may still be stored already. */
+  if (curchunk->buffer == nullptr) {
+    bool is_new;
+    curchunk->buffer = memfile_chunk_buffer_ensure(buf, size, &is_new);
+    if (is_new) {
+      memfile->size += size;
+    }
   }
 }
 
@@ -242,7 +590,7 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      BLO_memfile_chunk_read(chunk, chunkoffset, POINTER_OFFSET(buffer, totread), readsize);
       totread += readsize;
       undo->reader.offset += (off64_t)readsize;
       seek += readsize;
@@ -263,6 +611,17 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
 
 static void undo_close(FileReader *reader)
 {
+  UndoReader *undo = (UndoReader *)reader;
+  if (CLOG_CHECK(&LOG, 1)) {
+    const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+    if (stats.decompress_num != undo->decompress_num_init) {
+      CLOG_INFO(&LOG,
+                1,
+                "Undo read: decompressed %zu buffers in %.3f s",
+                stats.decompress_num - undo->decompress_num_init,
+                stats.decompress_time - undo->decompress_time_init);
+    }
+  }
   MEM_freeN(reader);
 }
 
@@ -273,6 +632,11 @@ FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction)
   undo->memfile = memfile;
   undo->undo_direction = undo_direction;
 
+  memfile_chunk_store_tick();
+  const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+  undo->decompress_num_init = stats.decompress_num;
+  undo->decompress_time_init = stats.decompress_time;
+
   undo->reader.read = undo_read;
   undo->reader.seek = nullptr;
   undo->reader.close = undo_close;
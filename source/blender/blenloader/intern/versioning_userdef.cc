@@ -738,8 +738,9 @@ void blo_do_versions_userdef(UserDef *userdef)
     if (userdef->pixelsize == 0.0f) {
       userdef->pixelsize = 1.0f;
     }
-    /* Clear old userdef flag for "Camera Parent Lock". */
-    userdef->uiflag &= ~USER_UIFLAG_UNUSED_3;
+    /* The bit was used by "Camera Parent Lock" before, clear it so that undo compression, which
+     * reuses the bit, starts disabled. */
+    userdef->uiflag &= ~USER_GLOBALUNDO_COMPRESS;
   }
 
   if (!USER_VERSION_ATLEAST(292, 9)) {
@@ -58,6 +58,7 @@
  *   - #BLENDER_USERPREF_FILE (on UNIX `~/.config/blender/X.X/config/userpref.blend`).
  */
 
+#include <atomic>
 #include <cerrno>
 #include <climits>
 #include <cmath>
@@ -65,6 +66,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <string>
 
 #ifdef WIN32
 #  include "BLI_winstuff.h"
@@ -87,6 +89,7 @@
 #include "DNA_key_types.h"
 #include "DNA_sdna_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -94,9 +97,12 @@
 #include "BLI_implicit_sharing.hh"
 #include "BLI_link_utils.h"
 #include "BLI_linklist.h"
+#include "BLI_map.hh"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -125,6 +131,7 @@
 
 #include "readfile.hh"
 
+#include <xxhash.h>
 #include <zstd.h>
 
 /* Make preferences read-only. */
@@ -141,6 +148,13 @@
 
 #define ZSTD_COMPRESSION_LEVEL 3
 
+/**
+ * When re-saving a compressed file, flush the buffer at the end of every ID that leaves at
+ * least this much data in it, so frame boundaries follow ID boundaries and unchanged IDs
+ * produce identical frames which can be reused, see #ZstdFrameReuseCache.
+ */
+#define ZSTD_ID_FLUSH_MIN_SIZE (1 << 18) /* 256kb */
+
 static CLG_LogRef LOG = {"blo.writefile"};
 
 /** Use if we want to store how many bytes have been written to the file. */
@@ -155,6 +169,8 @@ struct ZstdFrame {
 
   uint32_t compressed_size;
   uint32_t uncompressed_size;
+  /** Hash of the uncompressed content, only computed when reusing frames. */
+  XXH128_hash_t hash;
 };
 
 class WriteWrap {
@@ -165,6 +181,8 @@ class WriteWrap {
 
   /** Buffer output (we only want when output isn't already buffered). */
   bool use_buf = true;
+  /** Flush buffered output at the end of IDs, see #ZSTD_ID_FLUSH_MIN_SIZE. */
+  bool use_id_flush = false;
 };
 
 class RawWriteWrap : public WriteWrap {
@@ -199,6 +217,56 @@ bool RawWriteWrap::write(const void *buf, size_t buf_len)
   return ::write(file_handle, buf, buf_len) == buf_len;
 }
 
+/**
+ * Frames of the last compressed file written in this session.
+ *
+ * Re-saving a large file usually only changes a few IDs. Since IDs that did not change are
+ * written to identical bytes (the same way undo detects unchanged chunks), frames with identical
+ * uncompressed content can be copied from the previous file on disk instead of being compressed
+ * again. The old file still exists while the new one is written to a temporary file.
+ *
+ * Reused frames are always decompressed and compared against the new content, the file size and
+ * modification time only serve to discard the cache early when the file was changed externally.
+ *
+ * Only compressed saves use this. Uncompressed saves and auto-save, which always writes an
+ * uncompressed file, are not covered.
+ */
+struct ZstdFrameReuseCache {
+  struct Key {
+    XXH128_hash_t content_hash;
+    uint32_t uncompressed_size;
+
+    uint64_t hash() const
+    {
+      return content_hash.low64;
+    }
+
+    friend bool operator==(const Key &a, const Key &b)
+    {
+      return XXH128_isEqual(a.content_hash, b.content_hash) &&
+             a.uncompressed_size == b.uncompressed_size;
+    }
+  };
+
+  struct Location {
+    uint64_t offset;
+    uint32_t compressed_size;
+  };
+
+  std::string filepath;
+  int64_t file_size = 0;
+  int64_t file_mtime = 0;
+
+  blender::RawMap<Key, Location> frames;
+};
+
+/** Use a raw map, so the static cache is not reported as leaked memory on exit. */
+static ZstdFrameReuseCache &zstd_frame_reuse_cache()
+{
+  static ZstdFrameReuseCache cache;
+  return cache;
+}
+
 class ZstdWriteWrap : public WriteWrap {
   WriteWrap &base_wrap;
 
@@ -213,24 +281,45 @@ class ZstdWriteWrap : public WriteWrap {
 
   bool write_error = false;
 
+  /** Hash frames so they can be reused by the next save, see #ZstdFrameReuseCache. */
+  bool use_reuse = false;
+  /** The previous version of the file, to copy reused frames from (-1 when unavailable). */
+  int reuse_file_handle = -1;
+  int reused_frames_num = 0;
+  size_t reused_size = 0;
+
  public:
   ZstdWriteWrap(WriteWrap &base_wrap) : base_wrap(base_wrap) {}
+  ~ZstdWriteWrap()
+  {
+    BLI_freelistN(&frames);
+  }
 
   bool open(const char *filepath) override;
   bool close() override;
   bool write(const void *buf, size_t buf_len) override;
 
+  /** Reuse frames from the previous save of `filepath`, call before #open. */
+  void reuse_begin(const char *filepath);
+  /** Store the frames of the file that was just written to `filepath` for the next save. */
+  void reuse_end(const char *filepath, bool success);
+
  private:
   struct ZstdWriteBlockTask;
   void write_task(ZstdWriteBlockTask *task);
   void write_u32_le(uint32_t val);
   void write_seekable_frames();
+  void *reuse_frame_read(const ZstdFrameReuseCache::Key &key, size_t *r_size);
 };
 
 struct ZstdWriteWrap::ZstdWriteBlockTask {
   ZstdWriteBlockTask *next, *prev;
   void *data;
   size_t size;
+  /** Compressed frame copied from the previous file, or null. */
+  void *reuse_data;
+  size_t reuse_size;
+  XXH128_hash_t hash;
   int frame_number;
   ZstdWriteWrap *ww;
 
@@ -244,10 +333,30 @@ struct ZstdWriteWrap::ZstdWriteBlockTask {
 
 void ZstdWriteWrap::write_task(ZstdWriteBlockTask *task)
 {
-  size_t out_buf_len = ZSTD_compressBound(task->size);
-  void *out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
-  size_t out_size = ZSTD_compress(
-      out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+  void *out_buf = nullptr;
+  size_t out_size = 0;
+
+  if (task->reuse_data) {
+    /* Check the reused frame really matches, decompressing is much cheaper than compressing. */
+    void *check_buf = MEM_mallocN(task->size, "Zstd check buffer");
+    const size_t check_size = ZSTD_decompress(
+        check_buf, task->size, task->reuse_data, task->reuse_size);
+    if (check_size == task->size && memcmp(check_buf, task->data, task->size) == 0) {
+      out_buf = task->reuse_data;
+      out_size = task->reuse_size;
+    }
+    else {
+      MEM_freeN(task->reuse_data);
+      task->reuse_data = nullptr;
+    }
+    MEM_freeN(check_buf);
+  }
+
+  if (out_buf == nullptr) {
+    size_t out_buf_len = ZSTD_compressBound(task->size);
+    out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
+    out_size = ZSTD_compress(out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+  }
 
   MEM_freeN(task->data);
 
@@ -266,7 +375,13 @@ void ZstdWriteWrap::write_task(ZstdWriteBlockTask *task)
           MEM_mallocN(sizeof(ZstdFrame), "zstd frameinfo"));
       frameinfo->uncompressed_size = task->size;
       frameinfo->compressed_size = out_size;
+      frameinfo->hash = task->hash;
       BLI_addtail(&frames, frameinfo);
+
+      if (task->reuse_data) {
+        reused_frames_num++;
+        reused_size += task->size;
+      }
     }
     else {
       write_error = true;
@@ -296,6 +411,73 @@ bool ZstdWriteWrap::open(const char *filepath)
   return true;
 }
 
+void ZstdWriteWrap::reuse_begin(const char *filepath)
+{
+  use_reuse = true;
+  use_id_flush = true;
+
+  ZstdFrameReuseCache &cache = zstd_frame_reuse_cache();
+  BLI_stat_t st;
+  if (cache.filepath != filepath || BLI_stat(filepath, &st) != 0 ||
+      int64_t(st.st_size) != cache.file_size || int64_t(st.st_mtime) != cache.file_mtime)
+  {
+    cache.frames.clear();
+    return;
+  }
+
+  reuse_file_handle = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+}
+
+void ZstdWriteWrap::reuse_end(const char *filepath, bool success)
+{
+  ZstdFrameReuseCache &cache = zstd_frame_reuse_cache();
+  cache.frames.clear();
+  cache.filepath.clear();
+
+  BLI_stat_t st;
+  if (!success || write_error || BLI_stat(filepath, &st) != 0) {
+    return;
+  }
+
+  uint64_t offset = 0;
+  LISTBASE_FOREACH (ZstdFrame *, frame, &frames) {
+    cache.frames.add({frame->hash, frame->uncompressed_size}, {offset, frame->compressed_size});
+    offset += frame->compressed_size;
+  }
+  cache.filepath = filepath;
+  cache.file_size = int64_t(st.st_size);
+  cache.file_mtime = int64_t(st.st_mtime);
+
+  CLOG_INFO(&LOG,
+            1,
+            "Reused %d of %d compressed frames (%" PRIu64 " of %" PRIu64 " bytes)",
+            reused_frames_num,
+            BLI_listbase_count(&frames),
+            uint64_t(reused_size),
+            uint64_t(offset));
+}
+
+void *ZstdWriteWrap::reuse_frame_read(const ZstdFrameReuseCache::Key &key, size_t *r_size)
+{
+  const ZstdFrameReuseCache::Location *location =
+      zstd_frame_reuse_cache().frames.lookup_ptr(key);
+  if (location == nullptr) {
+    return nullptr;
+  }
+
+  void *data = MEM_mallocN(location->compressed_size, "Zstd reused frame");
+  if (BLI_lseek(reuse_file_handle, int64_t(location->offset), SEEK_SET) !=
+          int64_t(location->offset) ||
+      ::read(reuse_file_handle, data, location->compressed_size) != location->compressed_size)
+  {
+    MEM_freeN(data);
+    return nullptr;
+  }
+
+  *r_size = location->compressed_size;
+  return data;
+}
+
 void ZstdWriteWrap::write_u32_le(uint32_t val)
 {
 #ifdef __BIG_ENDIAN__
@@ -345,8 +527,12 @@ bool ZstdWriteWrap::close()
   BLI_mutex_end(&mutex);
   BLI_condition_end(&condition);
 
+  if (reuse_file_handle != -1) {
+    ::close(reuse_file_handle);
+    reuse_file_handle = -1;
+  }
+
   write_seekable_frames();
-  BLI_freelistN(&frames);
 
   return base_wrap.close() && !write_error;
 }
@@ -362,6 +548,15 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
   task->data = MEM_mallocN(buf_len, __func__);
   memcpy(task->data, buf, buf_len);
   task->size = buf_len;
+  task->reuse_data = nullptr;
+  task->reuse_size = 0;
+  task->hash = {};
+  if (use_reuse) {
+    task->hash = XXH3_128bits(buf, buf_len);
+    if (reuse_file_handle != -1) {
+      task->reuse_data = reuse_frame_read({task->hash, uint32_t(buf_len)}, &task->reuse_size);
+    }
+  }
   task->frame_number = num_frames++;
   task->ww = this;
 
@@ -388,6 +583,35 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
   return true;
 }
 
+/**
+ * Writes into a growing memory buffer, used to serialize IDs on worker threads before they are
+ * appended to the actual output, see #write_ids_parallel.
+ */
+class MemoryWriteWrap : public WriteWrap {
+ public:
+  blender::Vector<uchar> data;
+
+  MemoryWriteWrap()
+  {
+    /* Data is already gathered in a single buffer. */
+    use_buf = false;
+  }
+
+  bool open(const char * /*filepath*/) override
+  {
+    return true;
+  }
+  bool close() override
+  {
+    return true;
+  }
+  bool write(const void *buf, size_t buf_len) override
+  {
+    data.extend(blender::Span<uchar>(static_cast<const uchar *>(buf), int64_t(buf_len)));
+    return true;
+  }
+};
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -640,7 +864,7 @@ static void mywrite_id_begin(WriteData *wd, ID *id)
 /**
  * Start writing of data related to a single ID.
  *
- * Only does something when storing an undo step.
+ * Only does something when storing an undo step, or when compressed frames are reused.
  */
 static void mywrite_id_end(WriteData *wd, ID * /*id*/)
 {
@@ -650,6 +874,10 @@ static void mywrite_id_end(WriteData *wd, ID * /*id*/)
     mywrite_flush(wd);
     wd->mem.current_id_session_uid = MAIN_ID_SESSION_UID_UNSET;
   }
+  else if (wd->ww->use_id_flush && wd->buffer.used_len >= ZSTD_ID_FLUSH_MIN_SIZE) {
+    /* Keep compressed frames aligned with IDs, so unchanged IDs can reuse them. */
+    mywrite_flush(wd);
+  }
 }
 
 /** \} */
@@ -1195,6 +1423,77 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
   return IDWALK_RET_NOP;
 }
 
+/** Maximum number of IDs serialized at once by #write_ids_parallel, bounds memory usage. */
+#define WRITE_PARALLEL_ID_BATCH_SIZE 64
+/**
+ * Maximum size of the buffered data of a batch in #write_ids_parallel. IDs that are still being
+ * serialized when the budget is reached can exceed it, but no new IDs are started.
+ */
+#define WRITE_PARALLEL_BATCH_MAX_BYTES (256 * 1024 * 1024)
+
+/**
+ * Serialize IDs of a type with #IDTYPE_FLAGS_BLEND_WRITE_THREADSAFE on worker threads, each into
+ * its own memory buffer, then append the buffers in the original order, so the written data is
+ * identical to writing the IDs one after the other.
+ */
+static void write_ids_parallel(WriteData *wd,
+                               const IDTypeInfo *id_type,
+                               const blender::Span<ID *> ids)
+{
+  using namespace blender;
+  BLI_assert(!wd->use_memfile);
+
+  int64_t batch_start = 0;
+  while (batch_start < ids.size()) {
+    const Span<ID *> batch = ids.slice(
+        batch_start, std::min<int64_t>(WRITE_PARALLEL_ID_BATCH_SIZE, ids.size() - batch_start));
+    Array<MemoryWriteWrap> id_buffers(batch.size());
+    Array<bool> id_errors(batch.size(), false);
+    Array<bool> id_is_serialized(batch.size(), false);
+    std::atomic<int64_t> buffered_bytes = 0;
+
+    threading::parallel_for(batch.index_range(), 1, [&](const IndexRange range) {
+      BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+      id_buffer_init_for_id_type(id_buffer, id_type);
+      for (const int64_t i : range) {
+        /* The first ID is always serialized, so that every batch makes progress. */
+        if (i > 0 && buffered_bytes.load(std::memory_order_relaxed) >=
+                         WRITE_PARALLEL_BATCH_MAX_BYTES)
+        {
+          continue;
+        }
+        WriteData *id_wd = writedata_new(&id_buffers[i]);
+        BlendWriter writer = {id_wd};
+        id_buffer_init_from_id(id_buffer, batch[i], false);
+        id_type->blend_write(&writer, id_buffer->temp_id, batch[i]);
+        id_errors[i] = id_wd->error;
+        writedata_free(id_wd);
+        buffered_bytes.fetch_add(id_buffers[i].data.size(), std::memory_order_relaxed);
+        id_is_serialized[i] = true;
+      }
+      BLO_write_destroy_id_buffer(&id_buffer);
+    });
+
+    /* Write IDs in order up to the first one that was skipped because of the memory budget, it is
+     * the start of the next batch. */
+    for (const int64_t i : batch.index_range()) {
+      if (!id_is_serialized[i]) {
+        break;
+      }
+      if (id_errors[i]) {
+        wd->error = true;
+      }
+      mywrite_id_begin(wd, batch[i]);
+      const Vector<uchar> &data = id_buffers[i].data;
+      if (!data.is_empty()) {
+        mywrite(wd, data.data(), size_t(data.size()));
+      }
+      mywrite_id_end(wd, batch[i]);
+      batch_start++;
+    }
+  }
+}
+
 /**
  * When #MemFile arguments are non-null, this is a file-safe to memory.
  *
@@ -1294,6 +1593,12 @@ static bool write_file_handle(Main *mainvar,
       const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
       id_buffer_init_for_id_type(id_buffer, id_type);
 
+      /* IDs that can be serialized on worker threads, written in batches keeping file order. */
+      const bool use_parallel = !wd->use_memfile && id_type->blend_write != nullptr &&
+                                (id_type->flags & IDTYPE_FLAGS_BLEND_WRITE_THREADSAFE) &&
+                                (G.debug & G_DEBUG_BLENDFILE_NO_THREADS) == 0;
+      blender::Vector<ID *> parallel_ids;
+
       for (; id; id = static_cast<ID *>(id->next)) {
         /* We should never attempt to write non-regular IDs
          * (i.e. all kind of temp/runtime ones). */
@@ -1342,6 +1647,13 @@ static bool write_file_handle(Main *mainvar,
               bmain, id, write_id_direct_linked_data_process_cb, nullptr, IDWALK_READONLY);
         }
 
+        if (use_parallel && !do_override) {
+          parallel_ids.append(id);
+          continue;
+        }
+        write_ids_parallel(wd, id_type, parallel_ids);
+        parallel_ids.clear();
+
         if (do_override) {
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
@@ -1361,6 +1673,8 @@ static bool write_file_handle(Main *mainvar,
         mywrite_id_end(wd, id);
       }
 
+      write_ids_parallel(wd, id_type, parallel_ids);
+
       mywrite_flush(wd);
     }
   } while ((bmain != override_storage) && (bmain = override_storage));
@@ -1651,7 +1965,11 @@ bool BLO_write_file(Main *mainvar,
 
   if (write_flags & G_FILE_COMPRESS) {
     ZstdWriteWrap zstd_wrap(raw_wrap);
-    return BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, zstd_wrap);
+    zstd_wrap.reuse_begin(filepath);
+    const bool success = BLO_write_file_impl(
+        mainvar, filepath, write_flags, params, reports, zstd_wrap);
+    zstd_wrap.reuse_end(filepath, success);
+    return success;
   }
 
   return BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, raw_wrap);
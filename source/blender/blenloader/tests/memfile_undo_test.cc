@@ -0,0 +1,132 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLO_undofile.hh"
+
+#include "BKE_lib_id.hh"
+
+namespace blender::blenloader::tests {
+
+static void memfile_write(MemFile *memfile, MemFile *reference, const Span<const char *> chunks)
+{
+  MemFileWriteData mem_data;
+  BLO_memfile_write_init(&mem_data, memfile, reference);
+  mem_data.current_id_session_uid = MAIN_ID_SESSION_UID_UNSET;
+  for (const char *chunk : chunks) {
+    BLO_memfile_chunk_add(&mem_data, chunk, strlen(chunk));
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+static std::string memfile_chunk_content(const MemFileChunk *chunk)
+{
+  std::string content(chunk->size, '\0');
+  BLO_memfile_chunk_read(chunk, 0, content.data(), chunk->size);
+  return content;
+}
+
+static Vector<const MemFileChunk *> memfile_chunks(const MemFile &memfile)
+{
+  Vector<const MemFileChunk *> chunks;
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile.chunks) {
+    chunks.append(chunk);
+  }
+  return chunks;
+}
+
+TEST(memfile_undo, SharedWithPreviousStep)
+{
+  const MemFileChunkStoreStats stats_init = BLO_memfile_chunk_store_stats();
+
+  MemFile step_a = {};
+  MemFile step_b = {};
+  memfile_write(&step_a, nullptr, {"object data", "mesh data"});
+  memfile_write(&step_b, &step_a, {"object data", "changed mesh data"});
+
+  const Vector<const MemFileChunk *> chunks_a = memfile_chunks(step_a);
+  const Vector<const MemFileChunk *> chunks_b = memfile_chunks(step_b);
+  EXPECT_TRUE(chunks_b[0]->is_identical);
+  EXPECT_FALSE(chunks_b[1]->is_identical);
+  EXPECT_EQ(chunks_a[0]->buffer, chunks_b[0]->buffer);
+  EXPECT_EQ(step_b.size, strlen("changed mesh data"));
+
+  /* Freeing the first step keeps buffers still used by the second one. */
+  BLO_memfile_merge(&step_a, &step_b);
+  EXPECT_EQ(memfile_chunk_content(chunks_b[0]), "object data");
+
+  BLO_memfile_free(&step_b);
+  const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+  EXPECT_EQ(stats.chunks_num, stats_init.chunks_num);
+  EXPECT_EQ(stats.buffers_size, stats_init.buffers_size);
+}
+
+TEST(memfile_undo, SharedByContent)
+{
+  const MemFileChunkStoreStats stats_init = BLO_memfile_chunk_store_stats();
+
+  /* Toggling between two states only stores each state once. */
+  MemFile step_a = {};
+  MemFile step_b = {};
+  MemFile step_c = {};
+  memfile_write(&step_a, nullptr, {"first state"});
+  memfile_write(&step_b, &step_a, {"second state"});
+  memfile_write(&step_c, &step_b, {"first state"});
+
+  const Vector<const MemFileChunk *> chunks_a = memfile_chunks(step_a);
+  const Vector<const MemFileChunk *> chunks_c = memfile_chunks(step_c);
+  /* Not identical to the previous step, but sharing the buffer of an older one. */
+  EXPECT_FALSE(chunks_c[0]->is_identical);
+  EXPECT_EQ(chunks_a[0]->buffer, chunks_c[0]->buffer);
+  EXPECT_EQ(step_c.size, 0u);
+
+  const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+  EXPECT_EQ(stats.chunks_num - stats_init.chunks_num, 3u);
+  EXPECT_EQ(stats.buffers_num - stats_init.buffers_num, 2u);
+  EXPECT_EQ(stats.dedup_num - stats_init.dedup_num, 1u);
+
+  BLO_memfile_free(&step_a);
+  BLO_memfile_free(&step_b);
+  EXPECT_EQ(memfile_chunk_content(chunks_c[0]), "first state");
+  BLO_memfile_free(&step_c);
+}
+
+TEST(memfile_undo, CompressUnusedBuffers)
+{
+  const MemFileChunkStoreStats stats_init = BLO_memfile_chunk_store_stats();
+
+  /* Repetitive content, so that it compresses well. */
+  const std::string data_a(4096, 'a');
+  const std::string data_b(4096, 'b');
+  const std::string data_c(4096, 'c');
+
+  MemFile step_a = {};
+  MemFile step_b = {};
+  MemFile step_c = {};
+  memfile_write(&step_a, nullptr, {data_a.c_str()});
+  memfile_write(&step_b, nullptr, {data_b.c_str()});
+  memfile_write(&step_c, nullptr, {data_c.c_str()});
+
+  /* Only the buffer of the oldest step is compressed, the more recent ones are kept. */
+  BLO_memfile_compress_schedule(1);
+  BLO_memfile_compress_wait();
+  const MemFileChunkStoreStats stats_compressed = BLO_memfile_chunk_store_stats();
+  EXPECT_EQ(stats_compressed.compressed_num - stats_init.compressed_num, 1u);
+  EXPECT_EQ(stats_compressed.compressed_size - stats_init.compressed_size, data_a.size());
+  EXPECT_LT(stats_compressed.compressed_storage_size - stats_init.compressed_storage_size,
+            data_a.size());
+
+  /* Reading the chunk decompresses its buffer again. */
+  EXPECT_EQ(memfile_chunk_content(memfile_chunks(step_a)[0]), data_a);
+  const MemFileChunkStoreStats stats = BLO_memfile_chunk_store_stats();
+  EXPECT_EQ(stats.decompress_num - stats_init.decompress_num, 1u);
+  EXPECT_EQ(stats.compressed_num, stats_init.compressed_num);
+
+  BLO_memfile_free(&step_a);
+  BLO_memfile_free(&step_b);
+  BLO_memfile_free(&step_c);
+}
+
+}  // namespace blender::blenloader::tests
@@ -50,6 +50,12 @@ void DEG_debug_stats_gnuplot(const Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/**
+ * Write the trace of the last evaluation in the Chrome trace event JSON format. Only available
+ * when time debugging is enabled (`--debug-depsgraph-time`).
+ */
+void DEG_debug_eval_trace_chrome(const Depsgraph *graph, FILE *fp);
+
 /* ************************************************ */
 
 /** Compare two dependency graphs. */
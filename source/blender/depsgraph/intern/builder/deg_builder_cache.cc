@@ -15,9 +15,14 @@
 #include "BLI_utildefines.h"
 
 #include "BKE_animsys.h"
+#include "BKE_lib_id.hh"
+#include "BKE_lib_query.hh"
 
 #include "RNA_path.hh"
 
+#include "intern/node/deg_node_component.hh"
+#include "intern/node/deg_node_id.hh"
+
 namespace blender::deg {
 
 /* Animated property storage. */
@@ -165,4 +170,79 @@ AnimatedPropertyStorage *DepsgraphBuilderCache::ensureInitializedAnimatedPropert
   return animated_property_storage;
 }
 
+/* Relations cache. */
+
+void DepsgraphRelationsCache::tag_id(const ID *id)
+{
+  tagged_ids.add(id->session_uid);
+}
+
+void DepsgraphRelationsCache::clear()
+{
+  id_relations.clear();
+  tagged_ids.clear();
+}
+
+void DepsgraphRelationsCache::ensure_owners(const Main *bmain,
+                                            const Scene *scene,
+                                            const ViewLayer *view_layer)
+{
+  if (bmain == bmain_ && scene == scene_ && view_layer == view_layer_) {
+    return;
+  }
+  /* Session UIDs of the IDs might be preserved when the database is re-read (on undo for
+   * example), while their content is not. */
+  clear();
+  bmain_ = bmain;
+  scene_ = scene;
+  view_layer_ = view_layer;
+}
+
+namespace {
+
+int id_fingerprint_cb(LibraryIDLinkCallbackData *cb_data)
+{
+  uint64_t *hash = static_cast<uint64_t *>(cb_data->user_data);
+  const ID *id = *cb_data->id_pointer;
+  *hash = get_default_hash(*hash,
+                           id,
+                           (id != nullptr) ? id->session_uid : MAIN_ID_SESSION_UID_UNSET,
+                           cb_data->cb_flag);
+  return IDWALK_RET_NOP;
+}
+
+}  // namespace
+
+uint64_t DepsgraphRelationsCache::id_fingerprint(const ID *id)
+{
+  /* The address of the ID changes when it is re-allocated, references to other IDs change when
+   * they are re-assigned, which does not always come with an update tag of the ID. */
+  uint64_t hash = get_default_hash(id, id->session_uid);
+  BKE_library_foreach_ID_link(
+      nullptr, const_cast<ID *>(id), id_fingerprint_cb, &hash, IDWALK_READONLY);
+  return hash;
+}
+
+DepsgraphRelationsCache::NodeKey DepsgraphRelationsCache::node_key(const Node *node)
+{
+  NodeKey key;
+  if (node->type != NodeType::OPERATION) {
+    BLI_assert(node->type == NodeType::TIMESOURCE);
+    key.id_session_uid = MAIN_ID_SESSION_UID_UNSET;
+    key.component_type = NodeType::TIMESOURCE;
+    key.opcode = OperationCode::OPERATION;
+    key.name_tag = -1;
+    return key;
+  }
+  const OperationNode *operation_node = static_cast<const OperationNode *>(node);
+  const ComponentNode *component_node = operation_node->owner;
+  key.id_session_uid = component_node->owner->id_orig_session_uid;
+  key.component_type = component_node->type;
+  key.component_name = component_node->name;
+  key.opcode = operation_node->opcode;
+  key.name = operation_node->name;
+  key.name_tag = operation_node->name_tag;
+  return key;
+}
+
 }  // namespace blender::deg
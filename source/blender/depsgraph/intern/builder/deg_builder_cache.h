@@ -11,16 +11,22 @@
 #include "MEM_guardedalloc.h"
 
 #include "intern/depsgraph_type.hh"
+#include "intern/node/deg_node.hh"
+#include "intern/node/deg_node_operation.hh"
 
 #include "RNA_access.hh"
 
 struct ID;
+struct Main;
 struct PointerRNA;
 struct PropertyRNA;
+struct Scene;
+struct ViewLayer;
 
 namespace blender::deg {
 
 class DepsgraphBuilderCache;
+struct Relation;
 
 /* Identifier for animated property. */
 class AnimatedPropertyID {
@@ -101,4 +107,80 @@ class DepsgraphBuilderCache {
   MEM_CXX_CLASS_ALLOC_FUNCS("DepsgraphBuilderCache");
 };
 
+/* Relations built for every ID during the previous build of the graph.
+ *
+ * Unlike the #DepsgraphBuilderCache it is owned by the dependency graph and persists across its
+ * rebuilds: the relations builder restores relations of IDs which did not change since the
+ * previous build instead of building them again. See
+ * #DepsgraphRelationBuilder::check_is_built_or_restore. */
+class DepsgraphRelationsCache {
+ public:
+  /* Identifier of a node which stays valid after the graph is rebuilt. */
+  struct NodeKey {
+    /* The time source when `id_session_uid` is #MAIN_ID_SESSION_UID_UNSET. */
+    uint id_session_uid;
+    NodeType component_type;
+    string component_name;
+    OperationCode opcode;
+    string name;
+    int name_tag;
+  };
+
+  struct CachedRelation {
+    NodeKey from;
+    NodeKey to;
+    /* Relation descriptions are static strings. */
+    const char *name;
+    int flag;
+  };
+
+  /* Relations built by the builder of an ID, excluding the ones built by builders of other IDs
+   * it invoked. */
+  struct IDRelations {
+    /* Hash of the ID state relations depend on, see #id_fingerprint. */
+    uint64_t fingerprint = 0;
+    /* False when the builder depends on state which is not tracked by the cache, such as physics
+     * relations or the set of IDs in the graph. */
+    bool is_cacheable = true;
+    Vector<CachedRelation> relations;
+    /* Session UIDs of the IDs whose builder was invoked from the builder of this ID. */
+    Vector<uint> dependencies;
+    /* Custom data masks and special evaluation flags requested for IDs, by session UID. */
+    Vector<std::pair<uint, DEGCustomDataMeshMasks>> customdata_masks;
+    Vector<std::pair<uint, uint32_t>> eval_flags;
+    /* Relations recorded during the current build, converted to #relations by
+     * #DepsgraphRelationBuilder::end_build. */
+    Vector<Relation *> recorded_relations;
+  };
+
+  /* Mark relations of the ID as outdated. Called when the ID is tagged for update. */
+  void tag_id(const ID *id);
+  /* Forget all cached relations, so that all relations are built on the next build. */
+  void clear();
+  /* Make sure the cache is used for the given graph owners, clearing it otherwise. */
+  void ensure_owners(const Main *bmain, const Scene *scene, const ViewLayer *view_layer);
+
+  /* Hash of the original ID and of the IDs it references. IDs are expected to be tagged for
+   * update on all other changes affecting relations. */
+  static uint64_t id_fingerprint(const ID *id);
+
+  static NodeKey node_key(const Node *node);
+
+  /* Indexed by original ID.session_uid. */
+  Map<uint, IDRelations> id_relations;
+  /* IDs tagged for update since the previous build, by session UID. */
+  Set<uint> tagged_ids;
+
+  /* Statistics of the last build, for debug prints. */
+  int restored_ids_num = 0;
+  int built_ids_num = 0;
+
+ private:
+  const Main *bmain_ = nullptr;
+  const Scene *scene_ = nullptr;
+  const ViewLayer *view_layer_ = nullptr;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("DepsgraphRelationsCache");
+};
+
 }  // namespace blender::deg
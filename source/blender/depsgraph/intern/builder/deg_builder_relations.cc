@@ -70,6 +70,7 @@
 #include "BKE_image.h"
 #include "BKE_key.hh"
 #include "BKE_layer.hh"
+#include "BKE_lib_id.hh"
 #include "BKE_lib_query.hh"
 #include "BKE_material.h"
 #include "BKE_mball.hh"
@@ -352,6 +353,11 @@ void DepsgraphRelationBuilder::add_customdata_mask(Object *object,
     }
     else {
       id_node->customdata_masks |= customdata_masks;
+      if (DepsgraphRelationsCache::IDRelations *id_relations = recorded_id_relations(
+              stack_.current_id()))
+      {
+        id_relations->customdata_masks.append({object->id.session_uid, customdata_masks});
+      }
     }
   }
 }
@@ -364,6 +370,11 @@ void DepsgraphRelationBuilder::add_special_eval_flag(ID *id, uint32_t flag)
   }
   else {
     id_node->eval_flags |= flag;
+    if (DepsgraphRelationsCache::IDRelations *id_relations = recorded_id_relations(
+            stack_.current_id()))
+    {
+      id_relations->eval_flags.append({id->session_uid, flag});
+    }
   }
 }
 
@@ -373,7 +384,9 @@ Relation *DepsgraphRelationBuilder::add_time_relation(TimeSourceNode *timesrc,
                                                       int flags)
 {
   if (timesrc && node_to) {
-    return graph_->add_new_relation(timesrc, node_to, description, flags);
+    Relation *relation = graph_->add_new_relation(timesrc, node_to, description, flags);
+    record_relation(relation);
+    return relation;
   }
 
   DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -401,7 +414,9 @@ Relation *DepsgraphRelationBuilder::add_operation_relation(OperationNode *node_f
                                                            int flags)
 {
   if (node_from && node_to) {
-    return graph_->add_new_relation(node_from, node_to, description, flags);
+    Relation *relation = graph_->add_new_relation(node_from, node_to, description, flags);
+    record_relation(relation);
+    return relation;
   }
 
   DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -421,6 +436,7 @@ void DepsgraphRelationBuilder::add_particle_collision_relations(const OperationK
                                                                 Collection *collection,
                                                                 const char *name)
 {
+  mark_id_relations_not_cacheable();
   ListBase *relations = build_collision_relations(graph_, collection, eModifierType_Collision);
 
   LISTBASE_FOREACH (CollisionRelation *, relation, relations) {
@@ -441,6 +457,7 @@ void DepsgraphRelationBuilder::add_particle_forcefield_relations(const Operation
                                                                  bool add_absorption,
                                                                  const char *name)
 {
+  mark_id_relations_not_cacheable();
   ListBase *relations = build_effector_relations(graph_, eff->group);
 
   /* Make sure physics effects like wind are properly re-evaluating the modifier stack. */
@@ -515,6 +532,197 @@ Depsgraph *DepsgraphRelationBuilder::getGraph()
 
 void DepsgraphRelationBuilder::begin_build() {}
 
+void DepsgraphRelationBuilder::end_build()
+{
+  if (relations_cache_ == nullptr) {
+    return;
+  }
+  /* Store keys of recorded relations, which stay valid after the graph is rebuilt. The flags are
+   * read at the end, since some are assigned after the relation was added. */
+  for (const uint id_session_uid : recorded_ids_) {
+    DepsgraphRelationsCache::IDRelations &id_relations = relations_cache_->id_relations.lookup(
+        id_session_uid);
+    id_relations.relations.reserve(id_relations.recorded_relations.size());
+    for (const Relation *relation : id_relations.recorded_relations) {
+      id_relations.relations.append({DepsgraphRelationsCache::node_key(relation->from),
+                                     DepsgraphRelationsCache::node_key(relation->to),
+                                     relation->name,
+                                     relation->flag});
+    }
+    id_relations.recorded_relations.clear_and_shrink();
+  }
+  /* Forget about IDs which are no longer in the graph. */
+  relations_cache_->id_relations.remove_if([&](auto item) {
+    return !recorded_ids_.contains(item.key) && !restored_ids_.contains(item.key);
+  });
+  relations_cache_->tagged_ids.clear();
+  relations_cache_->restored_ids_num = restored_ids_.size();
+  relations_cache_->built_ids_num = recorded_ids_.size();
+}
+
+void DepsgraphRelationBuilder::use_relations_cache(DepsgraphRelationsCache *relations_cache,
+                                                   const bool restore)
+{
+  relations_cache_ = relations_cache;
+  restore_relations_ = restore;
+  for (IDNode *id_node : graph_->id_nodes) {
+    id_nodes_by_session_uid_.add(id_node->id_orig_session_uid, id_node);
+  }
+}
+
+void DepsgraphRelationBuilder::mark_id_relations_not_cacheable()
+{
+  if (DepsgraphRelationsCache::IDRelations *id_relations = recorded_id_relations(
+          stack_.current_id()))
+  {
+    id_relations->is_cacheable = false;
+  }
+}
+
+bool DepsgraphRelationBuilder::check_is_built_or_restore(ID *id)
+{
+  if (relations_cache_ == nullptr) {
+    return built_map_.checkIsBuiltAndTag(id);
+  }
+  /* Relations of the ID which is currently being built can only be restored together with the
+   * relations of the IDs it builds, whether they are already built or not. */
+  record_dependency(id);
+  if (built_map_.checkIsBuiltAndTag(id)) {
+    return true;
+  }
+  const uint id_session_uid = id->session_uid;
+  if (restore_relations_ && can_restore_id_relations(id_session_uid)) {
+    restore_id_relations(id_session_uid);
+    return true;
+  }
+  DepsgraphRelationsCache::IDRelations &id_relations =
+      relations_cache_->id_relations.lookup_or_add_default(id_session_uid);
+  id_relations = {};
+  id_relations.fingerprint = DepsgraphRelationsCache::id_fingerprint(id);
+  recorded_ids_.add(id_session_uid);
+  return false;
+}
+
+DepsgraphRelationsCache::IDRelations *DepsgraphRelationBuilder::recorded_id_relations(
+    const ID *id)
+{
+  if (id == nullptr || !recorded_ids_.contains(id->session_uid)) {
+    return nullptr;
+  }
+  return relations_cache_->id_relations.lookup_ptr(id->session_uid);
+}
+
+void DepsgraphRelationBuilder::record_relation(Relation *relation)
+{
+  if (DepsgraphRelationsCache::IDRelations *id_relations = recorded_id_relations(
+          stack_.current_id()))
+  {
+    id_relations->recorded_relations.append(relation);
+  }
+}
+
+void DepsgraphRelationBuilder::record_dependency(const ID *id)
+{
+  const ID *current_id = stack_.current_id();
+  if (current_id == id) {
+    return;
+  }
+  if (DepsgraphRelationsCache::IDRelations *id_relations = recorded_id_relations(current_id)) {
+    id_relations->dependencies.append(id->session_uid);
+  }
+}
+
+Node *DepsgraphRelationBuilder::find_cached_node(const DepsgraphRelationsCache::NodeKey &key) const
+{
+  if (key.id_session_uid == MAIN_ID_SESSION_UID_UNSET) {
+    return graph_->time_source;
+  }
+  const IDNode *id_node = id_nodes_by_session_uid_.lookup_default(key.id_session_uid, nullptr);
+  if (id_node == nullptr) {
+    return nullptr;
+  }
+  const ComponentNode *component_node = id_node->find_component(key.component_type,
+                                                                key.component_name.c_str());
+  if (component_node == nullptr) {
+    return nullptr;
+  }
+  return component_node->find_operation(key.opcode, key.name.c_str(), key.name_tag);
+}
+
+bool DepsgraphRelationBuilder::can_restore_id_relations(const uint id_session_uid)
+{
+  if (const bool *restorable = restorable_ids_.lookup_ptr(id_session_uid)) {
+    return *restorable;
+  }
+  /* IDs which depend on each other are not restored, which is ensured by considering the ID as
+   * not restorable while its dependencies are checked. */
+  restorable_ids_.add_new(id_session_uid, false);
+
+  const DepsgraphRelationsCache::IDRelations *id_relations =
+      relations_cache_->id_relations.lookup_ptr(id_session_uid);
+  if (id_relations == nullptr || !id_relations->is_cacheable ||
+      relations_cache_->tagged_ids.contains(id_session_uid))
+  {
+    return false;
+  }
+  const IDNode *id_node = id_nodes_by_session_uid_.lookup_default(id_session_uid, nullptr);
+  if (id_node == nullptr ||
+      DepsgraphRelationsCache::id_fingerprint(id_node->id_orig) != id_relations->fingerprint)
+  {
+    return false;
+  }
+  for (const DepsgraphRelationsCache::CachedRelation &relation : id_relations->relations) {
+    if (find_cached_node(relation.from) == nullptr || find_cached_node(relation.to) == nullptr) {
+      return false;
+    }
+  }
+  for (const auto &[target_session_uid, customdata_masks] : id_relations->customdata_masks) {
+    if (!id_nodes_by_session_uid_.contains(target_session_uid)) {
+      return false;
+    }
+  }
+  for (const auto &[target_session_uid, flag] : id_relations->eval_flags) {
+    if (!id_nodes_by_session_uid_.contains(target_session_uid)) {
+      return false;
+    }
+  }
+  for (const uint dependency_session_uid : id_relations->dependencies) {
+    if (!can_restore_id_relations(dependency_session_uid)) {
+      return false;
+    }
+  }
+
+  restorable_ids_.add_overwrite(id_session_uid, true);
+  return true;
+}
+
+void DepsgraphRelationBuilder::restore_id_relations(const uint id_session_uid)
+{
+  const DepsgraphRelationsCache::IDRelations &id_relations = relations_cache_->id_relations.lookup(
+      id_session_uid);
+  for (const DepsgraphRelationsCache::CachedRelation &relation : id_relations.relations) {
+    graph_->add_new_relation(find_cached_node(relation.from),
+                             find_cached_node(relation.to),
+                             relation.name,
+                             relation.flag);
+  }
+  for (const auto &[target_session_uid, customdata_masks] : id_relations.customdata_masks) {
+    id_nodes_by_session_uid_.lookup(target_session_uid)->customdata_masks |= customdata_masks;
+  }
+  for (const auto &[target_session_uid, flag] : id_relations.eval_flags) {
+    id_nodes_by_session_uid_.lookup(target_session_uid)->eval_flags |= flag;
+  }
+  restored_ids_.add(id_session_uid);
+
+  /* Dependencies are known to be restorable. */
+  for (const uint dependency_session_uid : id_relations.dependencies) {
+    IDNode *id_node = id_nodes_by_session_uid_.lookup(dependency_session_uid);
+    if (!built_map_.checkIsBuiltAndTag(id_node->id_orig)) {
+      restore_id_relations(dependency_session_uid);
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
@@ -621,7 +829,7 @@ void DepsgraphRelationBuilder::build_id(ID *id)
 
 void DepsgraphRelationBuilder::build_generic_id(ID *id)
 {
-  if (built_map_.checkIsBuiltAndTag(id)) {
+  if (check_is_built_or_restore(id)) {
     return;
   }
 
@@ -671,7 +879,7 @@ void DepsgraphRelationBuilder::build_collection(LayerCollection *from_layer_coll
     return;
   }
 
-  if (built_map_.checkIsBuiltAndTag(collection)) {
+  if (check_is_built_or_restore(collection)) {
     return;
   }
 
@@ -716,7 +924,7 @@ void DepsgraphRelationBuilder::build_collection(LayerCollection *from_layer_coll
 
 void DepsgraphRelationBuilder::build_object(Object *object)
 {
-  if (built_map_.checkIsBuiltAndTag(object)) {
+  if (check_is_built_or_restore(object)) {
     return;
   }
 
@@ -1637,7 +1845,7 @@ void DepsgraphRelationBuilder::build_animdata_fcurve_target(
     add_relation(adt_key, pose_init_key, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
     return;
   }
-  graph_->add_new_relation(
+  add_operation_relation(
       operation_from, operation_to, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
   /* It is possible that animation is writing to a nested ID data-block,
    * need to make sure animation is evaluated after target ID is copied. */
@@ -1802,7 +2010,7 @@ void DepsgraphRelationBuilder::build_animdata_force(ID *id)
 
 void DepsgraphRelationBuilder::build_action(bAction *action)
 {
-  if (built_map_.checkIsBuiltAndTag(action)) {
+  if (check_is_built_or_restore(action)) {
     return;
   }
 
@@ -1818,7 +2026,7 @@ void DepsgraphRelationBuilder::build_action(bAction *action)
 
 void DepsgraphRelationBuilder::build_animation(Animation *animation)
 {
-  if (built_map_.checkIsBuiltAndTag(animation)) {
+  if (check_is_built_or_restore(animation)) {
     return;
   }
 
@@ -1896,6 +2104,7 @@ void DepsgraphRelationBuilder::build_driver_data(ID *id, FCurve *fcu)
     const bool driver_targets_bbone = STRPREFIX(prop_identifier, "bbone_");
 
     /* Find objects which use this, and make their eval callbacks depend on this. */
+    mark_id_relations_not_cacheable();
     for (IDNode *to_node : graph_->id_nodes) {
       if (GS(to_node->id_orig->name) != ID_OB) {
         continue;
@@ -2216,7 +2425,7 @@ void DepsgraphRelationBuilder::build_dimensions(Object *object)
 
 void DepsgraphRelationBuilder::build_world(World *world)
 {
-  if (built_map_.checkIsBuiltAndTag(world)) {
+  if (check_is_built_or_restore(world)) {
     return;
   }
 
@@ -2449,7 +2658,7 @@ void DepsgraphRelationBuilder::build_particle_systems(Object *object)
 
 void DepsgraphRelationBuilder::build_particle_settings(ParticleSettings *part)
 {
-  if (built_map_.checkIsBuiltAndTag(part)) {
+  if (check_is_built_or_restore(part)) {
     return;
   }
 
@@ -2510,7 +2719,7 @@ void DepsgraphRelationBuilder::build_particle_system_visualization_object(Object
 /* Shapekeys */
 void DepsgraphRelationBuilder::build_shapekeys(Key *key)
 {
-  if (built_map_.checkIsBuiltAndTag(key)) {
+  if (check_is_built_or_restore(key)) {
     return;
   }
 
@@ -2683,7 +2892,7 @@ void DepsgraphRelationBuilder::build_object_data_geometry(Object *object)
 
 void DepsgraphRelationBuilder::build_object_data_geometry_datablock(ID *obdata)
 {
-  if (built_map_.checkIsBuiltAndTag(obdata)) {
+  if (check_is_built_or_restore(obdata)) {
     return;
   }
 
@@ -2852,7 +3061,7 @@ void DepsgraphRelationBuilder::build_object_data_geometry_datablock(ID *obdata)
 
 void DepsgraphRelationBuilder::build_armature(bArmature *armature)
 {
-  if (built_map_.checkIsBuiltAndTag(armature)) {
+  if (check_is_built_or_restore(armature)) {
     return;
   }
 
@@ -2883,7 +3092,7 @@ void DepsgraphRelationBuilder::build_armature_bone_collections(
 
 void DepsgraphRelationBuilder::build_camera(Camera *camera)
 {
-  if (built_map_.checkIsBuiltAndTag(camera)) {
+  if (check_is_built_or_restore(camera)) {
     return;
   }
 
@@ -2910,7 +3119,7 @@ void DepsgraphRelationBuilder::build_camera(Camera *camera)
 /* Lights */
 void DepsgraphRelationBuilder::build_light(Light *lamp)
 {
-  if (built_map_.checkIsBuiltAndTag(lamp)) {
+  if (check_is_built_or_restore(lamp)) {
     return;
   }
 
@@ -2977,7 +3186,7 @@ void DepsgraphRelationBuilder::build_nodetree(bNodeTree *ntree)
   if (ntree == nullptr) {
     return;
   }
-  if (built_map_.checkIsBuiltAndTag(ntree)) {
+  if (check_is_built_or_restore(ntree)) {
     return;
   }
 
@@ -3111,7 +3320,7 @@ void DepsgraphRelationBuilder::build_material(Material *material, ID *owner)
     add_relation(material_key, owner_shading_key, "Material -> Owner Shading");
   }
 
-  if (built_map_.checkIsBuiltAndTag(material)) {
+  if (check_is_built_or_restore(material)) {
     return;
   }
 
@@ -3150,7 +3359,7 @@ void DepsgraphRelationBuilder::build_materials(ID *owner, Material **materials,
 /* Recursively build graph for texture */
 void DepsgraphRelationBuilder::build_texture(Tex *texture)
 {
-  if (built_map_.checkIsBuiltAndTag(texture)) {
+  if (check_is_built_or_restore(texture)) {
     return;
   }
 
@@ -3194,7 +3403,7 @@ void DepsgraphRelationBuilder::build_texture(Tex *texture)
 
 void DepsgraphRelationBuilder::build_image(Image *image)
 {
-  if (built_map_.checkIsBuiltAndTag(image)) {
+  if (check_is_built_or_restore(image)) {
     return;
   }
 
@@ -3206,7 +3415,7 @@ void DepsgraphRelationBuilder::build_image(Image *image)
 
 void DepsgraphRelationBuilder::build_cachefile(CacheFile *cache_file)
 {
-  if (built_map_.checkIsBuiltAndTag(cache_file)) {
+  if (check_is_built_or_restore(cache_file)) {
     return;
   }
 
@@ -3238,7 +3447,7 @@ void DepsgraphRelationBuilder::build_cachefile(CacheFile *cache_file)
 
 void DepsgraphRelationBuilder::build_mask(Mask *mask)
 {
-  if (built_map_.checkIsBuiltAndTag(mask)) {
+  if (check_is_built_or_restore(mask)) {
     return;
   }
 
@@ -3278,7 +3487,7 @@ void DepsgraphRelationBuilder::build_mask(Mask *mask)
 
 void DepsgraphRelationBuilder::build_freestyle_linestyle(FreestyleLineStyle *linestyle)
 {
-  if (built_map_.checkIsBuiltAndTag(linestyle)) {
+  if (check_is_built_or_restore(linestyle)) {
     return;
   }
 
@@ -3293,7 +3502,7 @@ void DepsgraphRelationBuilder::build_freestyle_linestyle(FreestyleLineStyle *lin
 
 void DepsgraphRelationBuilder::build_movieclip(MovieClip *clip)
 {
-  if (built_map_.checkIsBuiltAndTag(clip)) {
+  if (check_is_built_or_restore(clip)) {
     return;
   }
 
@@ -3307,7 +3516,7 @@ void DepsgraphRelationBuilder::build_movieclip(MovieClip *clip)
 
 void DepsgraphRelationBuilder::build_lightprobe(LightProbe *probe)
 {
-  if (built_map_.checkIsBuiltAndTag(probe)) {
+  if (check_is_built_or_restore(probe)) {
     return;
   }
 
@@ -3320,7 +3529,7 @@ void DepsgraphRelationBuilder::build_lightprobe(LightProbe *probe)
 
 void DepsgraphRelationBuilder::build_speaker(Speaker *speaker)
 {
-  if (built_map_.checkIsBuiltAndTag(speaker)) {
+  if (check_is_built_or_restore(speaker)) {
     return;
   }
 
@@ -3339,7 +3548,7 @@ void DepsgraphRelationBuilder::build_speaker(Speaker *speaker)
 
 void DepsgraphRelationBuilder::build_sound(bSound *sound)
 {
-  if (built_map_.checkIsBuiltAndTag(sound)) {
+  if (check_is_built_or_restore(sound)) {
     return;
   }
 
@@ -3446,7 +3655,7 @@ void DepsgraphRelationBuilder::build_scene_speakers(Scene *scene, ViewLayer *vie
 
 void DepsgraphRelationBuilder::build_vfont(VFont *vfont)
 {
-  if (built_map_.checkIsBuiltAndTag(vfont)) {
+  if (check_is_built_or_restore(vfont)) {
     return;
   }
 
@@ -22,6 +22,7 @@
 #include "BLI_utildefines.h"
 
 #include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cache.h"
 #include "intern/builder/deg_builder_key.h"
 #include "intern/builder/deg_builder_map.h"
 #include "intern/builder/deg_builder_rna.h"
@@ -87,6 +88,15 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
 
   void begin_build();
+  void end_build();
+
+  /* Record relations of all built IDs in the given cache. When `restore` is true relations of
+   * IDs which did not change since the cache was filled are restored from it instead of being
+   * built. */
+  void use_relations_cache(DepsgraphRelationsCache *relations_cache, bool restore);
+  /* Relations of the ID which is currently being built depend on state which is not tracked by
+   * the relations cache, they are to be built on every build of the graph. */
+  void mark_id_relations_not_cacheable();
 
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
@@ -303,6 +313,15 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                               const char *description,
                               int flags = 0);
 
+  /* Check whether relations of the given ID were already built, tagging it as built otherwise.
+   * Relations of IDs which did not change since the previous build of the graph are restored
+   * from the relations cache, in which case true is returned as well. */
+  bool check_is_built_or_restore(ID *id);
+  template<typename T> bool check_is_built_or_restore(T *datablock)
+  {
+    return check_is_built_or_restore(&datablock->id);
+  }
+
   /* Add relation which ensures visibility of `id_from` when `id_to` is visible.
    * For the more detailed explanation see comment for `NodeType::VISIBILITY`. */
   void add_visibility_relation(ID *id_from, ID *id_to);
@@ -348,6 +367,24 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   BuilderMap built_map_;
   RNANodeQuery rna_node_query_;
   BuilderStack stack_;
+
+  /* Relations cache state, see #check_is_built_or_restore. */
+  DepsgraphRelationsCache *relations_cache_ = nullptr;
+  bool restore_relations_ = false;
+  /* IDs whose relations are recorded during this build, by session UID. */
+  Set<uint> recorded_ids_;
+  /* IDs whose relations are restored during this build, by session UID. */
+  Set<uint> restored_ids_;
+  /* Whether relations of the ID can be restored, by session UID. */
+  Map<uint, bool> restorable_ids_;
+  Map<uint, IDNode *> id_nodes_by_session_uid_;
+
+  DepsgraphRelationsCache::IDRelations *recorded_id_relations(const ID *id);
+  void record_relation(Relation *relation);
+  void record_dependency(const ID *id);
+  Node *find_cached_node(const DepsgraphRelationsCache::NodeKey &key) const;
+  bool can_restore_id_relations(uint id_session_uid);
+  void restore_id_relations(uint id_session_uid);
 };
 
 struct DepsNodeHandle {
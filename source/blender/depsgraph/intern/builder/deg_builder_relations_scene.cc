@@ -46,6 +46,8 @@ void DepsgraphRelationBuilder::build_scene_camera(Scene *scene)
 
 void DepsgraphRelationBuilder::build_scene_parameters(Scene *scene)
 {
+  /* Scene relations are built on every build of the graph. */
+  mark_id_relations_not_cacheable();
   if (built_map_.checkIsBuiltAndTag(scene, BuilderMap::TAG_PARAMETERS)) {
     return;
   }
@@ -66,6 +68,7 @@ void DepsgraphRelationBuilder::build_scene_parameters(Scene *scene)
 
 void DepsgraphRelationBuilder::build_scene_compositor(Scene *scene)
 {
+  mark_id_relations_not_cacheable();
   if (built_map_.checkIsBuiltAndTag(scene, BuilderMap::TAG_SCENE_COMPOSITOR)) {
     return;
   }
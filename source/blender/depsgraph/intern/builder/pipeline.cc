@@ -4,6 +4,7 @@
 
 #include "pipeline.h"
 
+#include "BLI_set.hh"
 #include "BLI_time.h"
 
 #include "BKE_global.hh"
@@ -15,6 +16,10 @@
 #include "deg_builder_relations.h"
 #include "deg_builder_transitive.h"
 
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
+
 namespace blender::deg {
 
 AbstractBuilderPipeline::AbstractBuilderPipeline(::Depsgraph *graph)
@@ -37,8 +42,20 @@ void AbstractBuilderPipeline::build()
   build_step_relations();
   build_step_finalize();
 
+  const DepsgraphRelationsCache *relations_cache = deg_graph_->relations_cache.get();
+  if (relations_cache && relations_cache->restored_ids_num != 0 &&
+      (G.debug & G_DEBUG_DEPSGRAPH_RELATIONS_CACHE_VALIDATE))
+  {
+    build_step_validate_relations_cache();
+  }
+
   if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
     printf("Depsgraph built in %f seconds.\n", BLI_time_now_seconds() - start_time);
+    if (relations_cache) {
+      printf("Depsgraph relations of %d IDs restored, %d IDs built.\n",
+             relations_cache->restored_ids_num,
+             relations_cache->built_ids_num);
+    }
   }
 }
 
@@ -63,9 +80,20 @@ void AbstractBuilderPipeline::build_step_relations()
   /* Hook up relationships between operations - to determine evaluation order. */
   unique_ptr<DepsgraphRelationBuilder> relation_builder = construct_relation_builder();
   relation_builder->begin_build();
+  if (use_relations_cache()) {
+    if (!deg_graph_->relations_cache) {
+      deg_graph_->relations_cache = std::make_unique<DepsgraphRelationsCache>();
+    }
+    deg_graph_->relations_cache->ensure_owners(bmain_, scene_, view_layer_);
+    relation_builder->use_relations_cache(deg_graph_->relations_cache.get(), restore_relations_);
+  }
+  else {
+    deg_graph_->relations_cache.reset();
+  }
   build_relations(*relation_builder);
   relation_builder->build_copy_on_write_relations();
   relation_builder->build_driver_relations();
+  relation_builder->end_build();
 }
 
 void AbstractBuilderPipeline::build_step_finalize()
@@ -94,6 +122,70 @@ void AbstractBuilderPipeline::build_step_finalize()
   deg_graph_->need_update_relations = false;
 }
 
+namespace {
+
+string relations_cache_node_identifier(const Node *node)
+{
+  if (node->type == NodeType::OPERATION) {
+    return static_cast<const OperationNode *>(node)->full_identifier();
+  }
+  return node->identifier();
+}
+
+/* Description of all relations and of the relation builder side effects on ID nodes, which are
+ * expected to match between a graph with restored relations and a fully built one. */
+Set<string> relations_cache_graph_state(const Depsgraph *graph)
+{
+  Set<string> state;
+  for (const OperationNode *node : graph->operations) {
+    for (const Relation *rel : node->inlinks) {
+      state.add(relations_cache_node_identifier(rel->from) + " -> " +
+                relations_cache_node_identifier(rel->to) + " (" + rel->name + ", flag " +
+                std::to_string(rel->flag & ~RELATION_FLAG_CYCLIC) + ")");
+    }
+  }
+  for (const IDNode *id_node : graph->id_nodes) {
+    const DEGCustomDataMeshMasks &masks = id_node->customdata_masks;
+    state.add(string(id_node->id_orig->name) + " eval flags " +
+              std::to_string(id_node->eval_flags) + ", customdata masks " +
+              std::to_string(masks.vert_mask) + " " + std::to_string(masks.edge_mask) + " " +
+              std::to_string(masks.face_mask) + " " + std::to_string(masks.loop_mask) + " " +
+              std::to_string(masks.poly_mask));
+  }
+  return state;
+}
+
+}  // namespace
+
+void AbstractBuilderPipeline::build_step_validate_relations_cache()
+{
+  const Set<string> restored_state = relations_cache_graph_state(deg_graph_);
+
+  restore_relations_ = false;
+  build_step_nodes();
+  build_step_relations();
+  build_step_finalize();
+  restore_relations_ = true;
+
+  const Set<string> built_state = relations_cache_graph_state(deg_graph_);
+  int errors_num = 0;
+  for (const string &item : built_state) {
+    if (!restored_state.contains(item)) {
+      printf("Relations cache: missing %s\n", item.c_str());
+      errors_num++;
+    }
+  }
+  for (const string &item : restored_state) {
+    if (!built_state.contains(item)) {
+      printf("Relations cache: unexpected %s\n", item.c_str());
+      errors_num++;
+    }
+  }
+  if (errors_num != 0) {
+    printf("Relations cache: %d differences with a full build of the graph.\n", errors_num);
+  }
+}
+
 unique_ptr<DepsgraphNodeBuilder> AbstractBuilderPipeline::construct_node_builder()
 {
   return std::make_unique<DepsgraphNodeBuilder>(bmain_, deg_graph_, &builder_cache_);
@@ -104,4 +196,9 @@ unique_ptr<DepsgraphRelationBuilder> AbstractBuilderPipeline::construct_relation
   return std::make_unique<DepsgraphRelationBuilder>(bmain_, deg_graph_, &builder_cache_);
 }
 
+bool AbstractBuilderPipeline::use_relations_cache() const
+{
+  return false;
+}
+
 }  // namespace blender::deg
@@ -44,14 +44,23 @@ class AbstractBuilderPipeline {
   Scene *scene_;
   ViewLayer *view_layer_;
   DepsgraphBuilderCache builder_cache_;
+  /* Restore relations from the relations cache of the graph, if it is used. */
+  bool restore_relations_ = true;
 
   virtual unique_ptr<DepsgraphNodeBuilder> construct_node_builder();
   virtual unique_ptr<DepsgraphRelationBuilder> construct_relation_builder();
 
+  /* Whether the graph keeps relations of IDs across rebuilds, restoring them for IDs which did
+   * not change instead of building them again. */
+  virtual bool use_relations_cache() const;
+
   virtual void build_step_sanity_check();
   void build_step_nodes();
   void build_step_relations();
   void build_step_finalize();
+  /* Build the graph again without restoring relations from the cache, and report differences
+   * between both graphs. */
+  void build_step_validate_relations_cache();
 
   virtual void build_nodes(DepsgraphNodeBuilder &node_builder) = 0;
   virtual void build_relations(DepsgraphRelationBuilder &relation_builder) = 0;
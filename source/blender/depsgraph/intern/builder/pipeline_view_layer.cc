@@ -4,6 +4,8 @@
 
 #include "pipeline_view_layer.h"
 
+#include "BKE_global.hh"
+
 #include "intern/builder/deg_builder_nodes.h"
 #include "intern/builder/deg_builder_relations.h"
 #include "intern/depsgraph.hh"
@@ -25,4 +27,10 @@ void ViewLayerBuilderPipeline::build_relations(DepsgraphRelationBuilder &relatio
   relation_builder.build_view_layer(scene_, view_layer_, DEG_ID_LINKED_DIRECTLY);
 }
 
+bool ViewLayerBuilderPipeline::use_relations_cache() const
+{
+  return G.debug &
+         (G_DEBUG_DEPSGRAPH_RELATIONS_CACHE | G_DEBUG_DEPSGRAPH_RELATIONS_CACHE_VALIDATE);
+}
+
 }  // namespace blender::deg
@@ -19,6 +19,7 @@ class ViewLayerBuilderPipeline : public AbstractBuilderPipeline {
  protected:
   virtual void build_nodes(DepsgraphNodeBuilder &node_builder) override;
   virtual void build_relations(DepsgraphRelationBuilder &relation_builder) override;
+  virtual bool use_relations_cache() const override;
 };
 
 }  // namespace blender::deg
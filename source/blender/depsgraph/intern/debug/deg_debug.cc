@@ -10,6 +10,7 @@
 
 #include "BLI_console.h"
 #include "BLI_hash.h"
+#include "BLI_math_base.h"
 #include "BLI_string.h"
 #include "BLI_time_utildefines.h"
 #include "BLI_utildefines.h"
@@ -20,6 +21,21 @@
 
 namespace blender::deg {
 
+void DepsgraphEvalTrace::clear()
+{
+  events.clear();
+  start_time = end_time = 0.0;
+  threads_num = 0;
+  busy_time = 0.0;
+  critical_path_time = 0.0;
+  critical_path_num = 0;
+}
+
+double DepsgraphEvalTrace::idle_time() const
+{
+  return max_dd(threads_num * (end_time - start_time) - busy_time, 0.0);
+}
+
 DepsgraphDebug::DepsgraphDebug() : flags(G.debug), graph_evaluation_start_time_(0) {}
 
 bool DepsgraphDebug::do_time_debug() const
@@ -53,6 +69,17 @@ void DepsgraphDebug::end_graph_evaluation()
   else {
     printf("Depsgraph [%s] updated in %f seconds.\n", name.c_str(), graph_eval_time);
   }
+
+  if (!eval_trace.events.is_empty()) {
+    printf(
+        "  Critical path: %f seconds over %d operations, busy: %f seconds, idle: %f seconds "
+        "on %d threads.\n",
+        eval_trace.critical_path_time,
+        eval_trace.critical_path_num,
+        eval_trace.busy_time,
+        eval_trace.idle_time(),
+        eval_trace.threads_num);
+  }
 }
 
 bool terminal_do_color()
@@ -16,6 +16,38 @@
 
 namespace blender::deg {
 
+/* Timing of a single evaluated operation, recorded when time debugging is enabled. */
+struct DepsgraphEvalTraceEvent {
+  /* Full identifier of the operation, see #OperationNode::full_identifier(). */
+  string name;
+  /* Name of the ID owning the operation, without the ID code. */
+  string id_name;
+  double start_time;
+  double end_time;
+  /* Index of the thread which evaluated the operation. */
+  int thread;
+  /* Whether the operation is on the critical path of the evaluation. */
+  bool is_critical;
+};
+
+/* Trace of the last graph evaluation, see #deg_eval_stats_trace(). */
+struct DepsgraphEvalTrace {
+  Vector<DepsgraphEvalTraceEvent> events;
+  double start_time = 0.0;
+  double end_time = 0.0;
+  /* Number of threads available for the evaluation. */
+  int threads_num = 0;
+  /* Sum of the time spent on evaluating operations. */
+  double busy_time = 0.0;
+  /* Longest chain of dependent operations, the evaluation can not be faster than this. */
+  double critical_path_time = 0.0;
+  int critical_path_num = 0;
+
+  void clear();
+  /* Time during which the threads were not evaluating any operation. */
+  double idle_time() const;
+};
+
 class DepsgraphDebug {
  public:
   DepsgraphDebug();
@@ -32,6 +64,9 @@ class DepsgraphDebug {
    * created for different view layer). */
   string name;
 
+  /* Trace of the last evaluation, only filled in when time debugging is enabled. */
+  DepsgraphEvalTrace eval_trace;
+
  protected:
   /* Maximum number of counters used to calculate frame rate of depsgraph update. */
   static const constexpr int MAX_FPS_COUNTERS = 64;
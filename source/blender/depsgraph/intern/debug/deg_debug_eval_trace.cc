@@ -0,0 +1,81 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Export of the evaluation trace in the Chrome trace event format, which can be viewed with
+ * `chrome://tracing` or https://ui.perfetto.dev.
+ */
+
+#include "DEG_depsgraph_debug.hh"
+
+#include "intern/depsgraph.hh"
+
+namespace deg = blender::deg;
+
+namespace blender::deg {
+namespace {
+
+void write_json_string(FILE *fp, const string &str)
+{
+  fputc('"', fp);
+  for (const char ch : str) {
+    if (ELEM(ch, '"', '\\')) {
+      fputc('\\', fp);
+      fputc(ch, fp);
+    }
+    else if (uchar(ch) < 0x20) {
+      fprintf(fp, "\\u%04x", int(ch));
+    }
+    else {
+      fputc(ch, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+void write_trace_event(FILE *fp,
+                       const DepsgraphEvalTrace &trace,
+                       const DepsgraphEvalTraceEvent &event)
+{
+  /* Times are in microseconds, relative to the start of the evaluation. */
+  fprintf(fp, "{\"name\":");
+  write_json_string(fp, event.name);
+  fprintf(fp, ",\"cat\":");
+  write_json_string(fp, event.id_name);
+  fprintf(fp,
+          ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+          "\"args\":{\"critical\":%s}}",
+          event.thread,
+          (event.start_time - trace.start_time) * 1e6,
+          (event.end_time - event.start_time) * 1e6,
+          event.is_critical ? "true" : "false");
+}
+
+}  // namespace
+}  // namespace blender::deg
+
+void DEG_debug_eval_trace_chrome(const Depsgraph *depsgraph, FILE *fp)
+{
+  if (depsgraph == nullptr) {
+    return;
+  }
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(depsgraph);
+  const deg::DepsgraphEvalTrace &trace = deg_graph->debug.eval_trace;
+
+  fprintf(fp, "{\"traceEvents\":[\n");
+  for (const int64_t i : trace.events.index_range()) {
+    deg::write_trace_event(fp, trace, trace.events[i]);
+    fprintf(fp, i + 1 < trace.events.size() ? ",\n" : "\n");
+  }
+  fprintf(fp,
+          "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"critical_path_time\":%f,"
+          "\"critical_path_operations\":%d,\"busy_time\":%f,\"idle_time\":%f,\"threads\":%d}}\n",
+          trace.critical_path_time,
+          trace.critical_path_num,
+          trace.busy_time,
+          trace.idle_time(),
+          trace.threads_num);
+}
@@ -119,6 +119,18 @@ void deg_debug_stats_gnuplot(const DebugContext &ctx)
   if (ctx.label && ctx.label[0]) {
     deg_debug_fprintf(ctx, "set title \"%s\"" NL, ctx.label);
   }
+  /* Summary of the evaluation trace. */
+  const DepsgraphEvalTrace &trace = ctx.graph->debug.eval_trace;
+  if (!trace.events.is_empty()) {
+    deg_debug_fprintf(ctx,
+                      "set label 1 \"Critical path: %.3f ms (%d operations), busy: %.3f ms, "
+                      "idle: %.3f ms on %d threads\" at graph 0.98,0.02 right" NL,
+                      trace.critical_path_time * 1000.0,
+                      trace.critical_path_num,
+                      trace.busy_time * 1000.0,
+                      trace.idle_time() * 1000.0,
+                      trace.threads_num);
+  }
   /* Rest of the commands.
    * TODO(sergey): Need to decide on the resolution somehow. */
   deg_debug_fprintf(ctx, "set terminal pngcairo size 1920,1080" NL);
@@ -26,6 +26,7 @@
 #include "DEG_depsgraph.hh"
 #include "DEG_depsgraph_debug.hh"
 
+#include "intern/builder/deg_builder_cache.h"
 #include "intern/depsgraph_physics.hh"
 #include "intern/depsgraph_registry.hh"
 #include "intern/depsgraph_relation.hh"
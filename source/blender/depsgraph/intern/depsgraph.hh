@@ -37,6 +37,7 @@ struct ViewLayer;
 
 namespace blender::deg {
 
+class DepsgraphRelationsCache;
 struct IDNode;
 struct Node;
 struct OperationNode;
@@ -173,6 +174,10 @@ struct Depsgraph {
 
   light_linking::Cache light_linking_cache;
 
+  /* Relations of IDs from the previous build, restored on rebuild for IDs which did not change.
+   * Only allocated when enabled, see #G_DEBUG_DEPSGRAPH_RELATIONS_CACHE. */
+  unique_ptr<DepsgraphRelationsCache> relations_cache;
+
   /* The number of times this graph has been evaluated. */
   uint64_t update_count;
 
@@ -27,6 +27,7 @@
 #include "DEG_depsgraph_physics.hh"
 #include "DEG_depsgraph_query.hh"
 
+#include "builder/deg_builder_relations.h"
 #include "depsgraph.hh"
 
 namespace deg = blender::deg;
@@ -96,6 +97,8 @@ void DEG_add_collision_relations(DepsNodeHandle *handle,
                                  DEG_CollobjFilterFunction filter_function,
                                  const char *name)
 {
+  /* Physics relations are stored in the graph when its relations are built. */
+  reinterpret_cast<deg::DepsNodeHandle *>(handle)->builder->mark_id_relations_not_cacheable();
   Depsgraph *depsgraph = DEG_get_graph_from_handle(handle);
   deg::Depsgraph *deg_graph = (deg::Depsgraph *)depsgraph;
   ListBase *relations = build_collision_relations(deg_graph, collection, modifier_type);
@@ -120,6 +123,7 @@ void DEG_add_forcefield_relations(DepsNodeHandle *handle,
                                   int skip_forcefield,
                                   const char *name)
 {
+  reinterpret_cast<deg::DepsNodeHandle *>(handle)->builder->mark_id_relations_not_cacheable();
   Depsgraph *depsgraph = DEG_get_graph_from_handle(handle);
   deg::Depsgraph *deg_graph = (deg::Depsgraph *)depsgraph;
   ListBase *relations = build_effector_relations(deg_graph, effector_weights->group);
@@ -42,6 +42,7 @@
 #include "DEG_depsgraph_query.hh"
 
 #include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cache.h"
 #include "intern/depsgraph.hh"
 #include "intern/depsgraph_registry.hh"
 #include "intern/depsgraph_update.hh"
@@ -710,6 +711,9 @@ void graph_id_tag_update(
   IDNode *id_node = (graph != nullptr) ? graph->find_id_node(id) : nullptr;
   if (graph != nullptr) {
     DEG_graph_id_type_tag(reinterpret_cast<::Depsgraph *>(graph), GS(id->name));
+    if (graph->relations_cache) {
+      graph->relations_cache->tag_id(id);
+    }
   }
   if (flags == 0) {
     deg_graph_node_tag_zero(bmain, graph, id_node, update_source);
@@ -10,9 +10,13 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <mutex>
+
 #include "BLI_compiler_attrs.h"
+#include "BLI_enumerable_thread_specific.hh"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
+#include "BLI_heap.h"
 #include "BLI_task.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
@@ -37,6 +41,7 @@
 #include "intern/depsgraph_tag.hh"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_priority.h"
 #include "intern/eval/deg_eval_stats.h"
 #include "intern/eval/deg_eval_visibility.h"
 #include "intern/node/deg_node.hh"
@@ -83,19 +88,31 @@ struct DepsgraphEvalState {
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+  /* Timing of evaluated operations per thread, gathered when `do_stats` is true. */
+  threading::EnumerableThreadSpecific<Vector<EvalTraceRecord>> trace_records;
+  /* Evaluate operations of the longest dependency chains first, see #G_DEBUG_DEPSGRAPH_PRIORITY.
+   * Operations ready for evaluation are then stored in a heap, ordered by their priority. */
+  bool use_priority = false;
+  Heap *ready_heap = nullptr;
+  std::mutex ready_mutex;
 };
 
-void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
+void evaluate_node(DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
   /* Perform operation. */
-  if (state->do_stats) {
+  if (state->do_stats || state->use_priority) {
     const double start_time = BLI_time_now_seconds();
     operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
+    const double end_time = BLI_time_now_seconds();
+    operation_node->eval_time = float(end_time - start_time);
+    if (state->do_stats) {
+      operation_node->stats.current_time += end_time - start_time;
+      state->trace_records.local().append({operation_node, start_time, end_time, 0});
+    }
   }
   else {
     operation_node->evaluate(depsgraph);
@@ -108,19 +125,35 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   operation_node->flag &= ~DEPSOP_FLAG_CLEAR_ON_EVAL;
 }
 
+void deg_task_push(TaskPool *pool, DepsgraphEvalState *state, OperationNode *node)
+{
+  if (state->use_priority) {
+    std::lock_guard lock(state->ready_mutex);
+    BLI_heap_insert(state->ready_heap, -node->priority, node);
+  }
+  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
+}
+
 void deg_task_run_func(TaskPool *pool, void *taskdata)
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
+  /* Evaluate node. With priority scheduling there is one task per ready node, but every task
+   * evaluates the ready node with the highest priority, which is not necessarily its own. */
+  OperationNode *operation_node;
+  if (state->use_priority) {
+    std::lock_guard lock(state->ready_mutex);
+    operation_node = static_cast<OperationNode *>(BLI_heap_pop_min(state->ready_heap));
+  }
+  else {
+    operation_node = reinterpret_cast<OperationNode *>(taskdata);
+  }
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
-  schedule_children(state, operation_node, [&](OperationNode *node) {
-    BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-  });
+  schedule_children(
+      state, operation_node, [&](OperationNode *node) { deg_task_push(pool, state, node); });
 }
 
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
@@ -194,6 +227,11 @@ void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
       node->stats.reset_current();
     }
   }
+  /* Use timing of the previous evaluations to prioritize operations. */
+  if (state->use_priority) {
+    deg_graph_update_operations_priority(graph);
+    state->ready_heap = BLI_heap_new();
+  }
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -317,9 +355,7 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
-  });
+  schedule_graph(state, [&](OperationNode *node) { deg_task_push(task_pool, state, node); });
   BLI_task_pool_work_and_wait(task_pool);
 }
 
@@ -377,6 +413,28 @@ TaskPool *deg_evaluate_task_pool_create(DepsgraphEvalState *state)
   return BLI_task_pool_create_suspended(state, TASK_PRIORITY_HIGH);
 }
 
+/* Gather the timing records of all threads into the graph evaluation trace. */
+void evaluate_graph_trace(DepsgraphEvalState *state, const double start_time)
+{
+  const double end_time = BLI_time_now_seconds();
+  Vector<EvalTraceRecord> records;
+  int thread = 0;
+  for (Vector<EvalTraceRecord> &thread_records : state->trace_records) {
+    if (thread_records.is_empty()) {
+      continue;
+    }
+    for (EvalTraceRecord &record : thread_records) {
+      record.thread = thread;
+    }
+    records.extend(thread_records);
+    thread++;
+  }
+  const int threads_num = (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) ?
+                              1 :
+                              BLI_task_scheduler_num_threads();
+  deg_eval_stats_trace(state->graph, records, start_time, end_time, threads_num);
+}
+
 }  // namespace
 
 void deg_evaluate_on_refresh(Depsgraph *graph)
@@ -402,6 +460,9 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
+  const double start_time = state.do_stats ? BLI_time_now_seconds() : 0.0;
+  state.use_priority = (G.debug & G_DEBUG_DEPSGRAPH_PRIORITY) &&
+                       !(G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS);
 
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
@@ -447,6 +508,9 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   evaluate_graph_threaded_stage(&state, task_pool, EvaluationStage::THREADED_EVALUATION);
 
   BLI_task_pool_free(task_pool);
+  if (state.ready_heap) {
+    BLI_heap_free(state.ready_heap, nullptr);
+  }
 
   evaluate_graph_single_threaded_if_needed(&state);
 
@@ -455,6 +519,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
    * synchronization. */
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
+    evaluate_graph_trace(&state, start_time);
   }
 
   /* Clear any uncleared tags. */
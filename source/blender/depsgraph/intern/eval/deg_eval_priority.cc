@@ -0,0 +1,88 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_priority.h"
+
+#include <algorithm>
+
+#include "BLI_assert.h"
+#include "BLI_stack.h"
+
+#include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node.hh"
+#include "intern/node/deg_node_operation.hh"
+
+namespace blender::deg {
+
+/* Cost of operations which were not evaluated yet. Non-zero, so that the length of dependency
+ * chains is taken into account on the first evaluation of a graph. */
+#define DEG_PRIORITY_UNKNOWN_COST 1e-6f
+
+static float operation_node_cost(const OperationNode *op_node)
+{
+  if (op_node->is_noop()) {
+    return 0.0f;
+  }
+  if (op_node->eval_time > 0.0f) {
+    return op_node->eval_time;
+  }
+  return DEG_PRIORITY_UNKNOWN_COST;
+}
+
+static bool is_priority_relation(const Relation *rel)
+{
+  return rel->to->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0;
+}
+
+void deg_graph_update_operations_priority(Depsgraph *graph)
+{
+  /* Traverse the graph from leaves up to the roots, so that the priority of all the children of
+   * an operation is known by the time it is handled. Pending links are re-calculated by the
+   * evaluation, so they can be used for the traversal. */
+  BLI_Stack *stack = BLI_stack_new(sizeof(OperationNode *), "DEG priority stack");
+
+  for (OperationNode *op_node : graph->operations) {
+    op_node->priority = 0.0f;
+    op_node->num_links_pending = 0;
+    for (Relation *rel : op_node->outlinks) {
+      if (is_priority_relation(rel)) {
+        ++op_node->num_links_pending;
+      }
+    }
+    if (op_node->num_links_pending == 0) {
+      BLI_stack_push(stack, &op_node);
+    }
+  }
+
+  while (!BLI_stack_is_empty(stack)) {
+    OperationNode *op_node;
+    BLI_stack_pop(stack, &op_node);
+
+    for (Relation *rel : op_node->outlinks) {
+      if (is_priority_relation(rel)) {
+        const OperationNode *op_to = reinterpret_cast<const OperationNode *>(rel->to);
+        op_node->priority = std::max(op_node->priority, op_to->priority);
+      }
+    }
+    op_node->priority += operation_node_cost(op_node);
+
+    for (Relation *rel : op_node->inlinks) {
+      if (rel->from->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        OperationNode *op_from = reinterpret_cast<OperationNode *>(rel->from);
+        BLI_assert(op_from->num_links_pending > 0);
+        if (--op_from->num_links_pending == 0) {
+          BLI_stack_push(stack, &op_from);
+        }
+      }
+    }
+  }
+  BLI_stack_free(stack);
+}
+
+}  // namespace blender::deg
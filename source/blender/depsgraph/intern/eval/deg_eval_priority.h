@@ -0,0 +1,21 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+namespace blender::deg {
+
+struct Depsgraph;
+
+/* Update the scheduling priority of all operations: the longest evaluation time of the chains of
+ * operations depending on them, based on timing of previous evaluations. Operations with the
+ * highest priority are evaluated first when priority scheduling is enabled, so that long chains
+ * start as early as possible. */
+void deg_graph_update_operations_priority(Depsgraph *graph);
+
+}  // namespace blender::deg
@@ -8,9 +8,14 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include "BLI_map.hh"
+#include "BLI_set.hh"
 #include "BLI_utildefines.h"
 
+#include "DNA_ID.h"
+
 #include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
 
 #include "intern/node/deg_node.hh"
 #include "intern/node/deg_node_component.hh"
@@ -39,4 +44,116 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+namespace {
+
+struct CriticalPathEntry {
+  /* Longest time of a dependency chain ending with this operation, including it. */
+  double time;
+  /* Previous operation on that chain. */
+  const OperationNode *prev;
+};
+
+bool is_critical_path_relation(const Relation *rel)
+{
+  return rel->from->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0;
+}
+
+/* Compute the longest weighted dependency chain ending at each of the given operations.
+ * Operations which were not evaluated (no-ops, up to date ones) weigh nothing but still connect
+ * their dependencies. Uses an explicit stack, since chains can be very long in rigs. */
+Map<const OperationNode *, CriticalPathEntry> critical_path_compute(
+    const Map<const OperationNode *, double> &durations)
+{
+  Map<const OperationNode *, CriticalPathEntry> entries;
+  Vector<std::pair<const OperationNode *, bool>> stack;
+  for (const OperationNode *node : durations.keys()) {
+    stack.append({node, false});
+  }
+  while (!stack.is_empty()) {
+    const auto [node, inputs_done] = stack.pop_last();
+    if (entries.contains(node)) {
+      continue;
+    }
+    if (!inputs_done) {
+      stack.append({node, true});
+      for (const Relation *rel : node->inlinks) {
+        if (is_critical_path_relation(rel)) {
+          const OperationNode *from = static_cast<const OperationNode *>(rel->from);
+          if (!entries.contains(from)) {
+            stack.append({from, false});
+          }
+        }
+      }
+      continue;
+    }
+    CriticalPathEntry entry = {0.0, nullptr};
+    for (const Relation *rel : node->inlinks) {
+      if (!is_critical_path_relation(rel)) {
+        continue;
+      }
+      const OperationNode *from = static_cast<const OperationNode *>(rel->from);
+      const CriticalPathEntry *from_entry = entries.lookup_ptr(from);
+      if (from_entry && from_entry->time > entry.time) {
+        entry.time = from_entry->time;
+        entry.prev = from;
+      }
+    }
+    entry.time += durations.lookup_default(node, 0.0);
+    entries.add_new(node, entry);
+  }
+  return entries;
+}
+
+}  // namespace
+
+void deg_eval_stats_trace(Depsgraph *graph,
+                          const Span<EvalTraceRecord> records,
+                          const double start_time,
+                          const double end_time,
+                          const int threads_num)
+{
+  DepsgraphEvalTrace &trace = graph->debug.eval_trace;
+  trace.clear();
+  trace.start_time = start_time;
+  trace.end_time = end_time;
+  trace.threads_num = threads_num;
+
+  Map<const OperationNode *, double> durations;
+  for (const EvalTraceRecord &record : records) {
+    const double duration = record.end_time - record.start_time;
+    durations.lookup_or_add(record.node, 0.0) += duration;
+    trace.busy_time += duration;
+  }
+
+  /* Walk back from the operation finishing the longest chain. */
+  const Map<const OperationNode *, CriticalPathEntry> entries = critical_path_compute(durations);
+  const OperationNode *critical_node = nullptr;
+  for (const OperationNode *node : durations.keys()) {
+    const double time = entries.lookup(node).time;
+    if (critical_node == nullptr || time > trace.critical_path_time) {
+      critical_node = node;
+      trace.critical_path_time = time;
+    }
+  }
+  Set<const OperationNode *> critical_nodes;
+  for (const OperationNode *node = critical_node; node; node = entries.lookup(node).prev) {
+    if (durations.contains(node)) {
+      critical_nodes.add(node);
+    }
+  }
+  trace.critical_path_num = critical_nodes.size();
+
+  trace.events.reserve(records.size());
+  for (const EvalTraceRecord &record : records) {
+    DepsgraphEvalTraceEvent event;
+    event.name = record.node->full_identifier();
+    event.id_name = record.node->owner->owner->id_orig->name + 2;
+    event.start_time = record.start_time;
+    event.end_time = record.end_time;
+    event.thread = record.thread;
+    event.is_critical = critical_nodes.contains(record.node);
+    trace.events.append(std::move(event));
+  }
+}
+
 }  // namespace blender::deg
@@ -8,11 +8,30 @@
 
 #pragma once
 
+#include "BLI_span.hh"
+
 namespace blender::deg {
 
 struct Depsgraph;
+struct OperationNode;
+
+/* Timing of an operation evaluation, recorded by the evaluation engine. */
+struct EvalTraceRecord {
+  OperationNode *node;
+  double start_time;
+  double end_time;
+  int thread;
+};
 
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Store the trace of the evaluation in the graph debug data, and find its critical path: the
+ * longest chain of dependent operations, weighted by their evaluation time. */
+void deg_eval_stats_trace(Depsgraph *graph,
+                          Span<EvalTraceRecord> records,
+                          double start_time,
+                          double end_time,
+                          int threads_num);
+
 }  // namespace blender::deg
@@ -281,6 +281,12 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Time spent on the last evaluation of this operation, used for priority scheduling. */
+  float eval_time = 0.0f;
+  /* Longest evaluation time of the chains of operations depending on this one, including it.
+   * See #deg_graph_update_operations_priority. */
+  float priority = 0.0f;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
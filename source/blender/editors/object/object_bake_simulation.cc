@@ -10,6 +10,9 @@
 #include "BLI_path_util.h"
 #include "BLI_serialize.hh"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_time.h"
 #include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
@@ -220,15 +223,128 @@ struct NodeBakeRequest {
   bake::BakePath path;
   int frame_start;
   int frame_end;
+  bool use_compression = false;
   std::unique_ptr<bake::BlobWriteSharing> blob_sharing;
 };
 
+/** Throughput of a bake, reported when it is done. */
+struct BakeStatistics {
+  int frames_num = 0;
+  int64_t written_size = 0;
+  double duration = 0.0;
+};
+
 struct BakeGeometryNodesJob {
   wmWindowManager *wm;
   Main *bmain;
   Depsgraph *depsgraph;
   Scene *scene;
   Vector<NodeBakeRequest> bake_requests;
+  BakeStatistics statistics;
+};
+
+/**
+ * Writes baked frames to disk on a background thread, so that the evaluation of the next frame
+ * does not have to wait for the disk. Frames are written in the order in which they are added,
+ * one after the other, so the #bake::BlobWriteSharing of a request is never used concurrently.
+ *
+ * The written state is not copied. It is owned by the node cache which keeps all baked frames
+ * until the bake is done, and its geometry is implicitly shared with the evaluated geometry of
+ * later frames.
+ */
+class BakeFrameWriter : NonCopyable, NonMovable {
+ private:
+  /** Adding a frame blocks while this many frames are waiting to be written. */
+  static constexpr int max_queued_frames_num = 4;
+
+  struct WriteTask {
+    NodeBakeRequest *request;
+    const bake::BakeState *state;
+    std::string frame_file_name;
+  };
+
+  TaskPool *task_pool_;
+  ThreadMutex mutex_;
+  ThreadCondition condition_;
+  int queued_frames_num_ = 0;
+  /** Only accessed from the writing thread until #finish is called. */
+  int64_t written_size_ = 0;
+
+ public:
+  BakeFrameWriter()
+  {
+    BLI_mutex_init(&mutex_);
+    BLI_condition_init(&condition_);
+    task_pool_ = BLI_task_pool_create_background_serial(this, TASK_PRIORITY_HIGH);
+  }
+
+  ~BakeFrameWriter()
+  {
+    this->finish();
+    BLI_task_pool_free(task_pool_);
+    BLI_condition_end(&condition_);
+    BLI_mutex_end(&mutex_);
+  }
+
+  void add(NodeBakeRequest &request,
+           const bake::BakeState &state,
+           const std::string &frame_file_name)
+  {
+    BLI_mutex_lock(&mutex_);
+    while (queued_frames_num_ >= max_queued_frames_num) {
+      BLI_condition_wait(&condition_, &mutex_);
+    }
+    queued_frames_num_++;
+    BLI_mutex_unlock(&mutex_);
+
+    WriteTask *task = MEM_new<WriteTask>(__func__);
+    task->request = &request;
+    task->state = &state;
+    task->frame_file_name = frame_file_name;
+    BLI_task_pool_push(task_pool_, write_task_run, task, true, write_task_free);
+  }
+
+  /** Wait until all frames are written. */
+  void finish()
+  {
+    BLI_task_pool_work_and_wait(task_pool_);
+  }
+
+  int64_t written_size() const
+  {
+    return written_size_;
+  }
+
+ private:
+  static void write_task_run(TaskPool *__restrict pool, void *taskdata)
+  {
+    BakeFrameWriter &writer = *static_cast<BakeFrameWriter *>(BLI_task_pool_user_data(pool));
+    const WriteTask &task = *static_cast<const WriteTask *>(taskdata);
+    const NodeBakeRequest &request = *task.request;
+    const bake::BakePath &path = request.path;
+
+    char meta_path[FILE_MAX];
+    BLI_path_join(meta_path,
+                  sizeof(meta_path),
+                  path.meta_dir.c_str(),
+                  (task.frame_file_name + ".json").c_str());
+    BLI_file_ensure_parent_dir_exists(meta_path);
+    bake::DiskBlobWriter blob_writer{
+        path.blobs_dir, task.frame_file_name, request.use_compression};
+    fstream meta_file{meta_path, std::ios::out};
+    bake::serialize_bake(*task.state, blob_writer, *request.blob_sharing, meta_file);
+    writer.written_size_ += blob_writer.written_size() + int64_t(meta_file.tellp());
+
+    BLI_mutex_lock(&writer.mutex_);
+    writer.queued_frames_num_--;
+    BLI_condition_notify_all(&writer.condition_);
+    BLI_mutex_unlock(&writer.mutex_);
+  }
+
+  static void write_task_free(TaskPool *__restrict /*pool*/, void *taskdata)
+  {
+    MEM_delete(static_cast<WriteTask *>(taskdata));
+  }
 };
 
 static void request_bakes_in_modifier_cache(BakeGeometryNodesJob &job)
@@ -271,6 +387,8 @@ static void bake_geometry_nodes_startjob(void *customdata, wmJobWorkerStatus *wo
   const float frame_step_size = 1.0f;
   const float progress_per_frame = frame_step_size / frames_to_bake;
   const int old_frame = job.scene->r.cfra;
+  const double start_time = BLI_time_now_seconds();
+  BakeFrameWriter frame_writer;
 
   for (float frame_f = global_bake_start_frame; frame_f <= global_bake_end_frame;
        frame_f += frame_step_size)
@@ -307,23 +425,18 @@ static void bake_geometry_nodes_startjob(void *customdata, wmJobWorkerStatus *wo
         continue;
       }
 
-      const bake::BakePath path = request.path;
-
-      char meta_path[FILE_MAX];
-      BLI_path_join(meta_path,
-                    sizeof(meta_path),
-                    path.meta_dir.c_str(),
-                    (frame_file_name + ".json").c_str());
-      BLI_file_ensure_parent_dir_exists(meta_path);
-      bake::DiskBlobWriter blob_writer{path.blobs_dir, frame_file_name};
-      fstream meta_file{meta_path, std::ios::out};
-      bake::serialize_bake(frame_cache.state, blob_writer, *request.blob_sharing, meta_file);
+      frame_writer.add(request, frame_cache.state, frame_file_name);
     }
 
+    job.statistics.frames_num++;
     worker_status->progress += progress_per_frame;
     worker_status->do_update = true;
   }
 
+  frame_writer.finish();
+  job.statistics.written_size = frame_writer.written_size();
+  job.statistics.duration = BLI_time_now_seconds() - start_time;
+
   /* Tag simulations as being baked. */
   for (NodeBakeRequest &request : job.bake_requests) {
     if (request.node_type != GEO_NODE_SIMULATION_OUTPUT) {
@@ -353,6 +466,15 @@ static void bake_geometry_nodes_endjob(void *customdata)
   BakeGeometryNodesJob &job = *static_cast<BakeGeometryNodesJob *>(customdata);
   WM_set_locked_interface(job.wm, false);
   G.is_rendering = false;
+  const BakeStatistics &statistics = job.statistics;
+  if (statistics.frames_num > 0 && statistics.duration > 0.0) {
+    WM_reportf(RPT_INFO,
+               "Baked %d frames in %.2f s (%.1f frames/s, %.1f MB/s)",
+               statistics.frames_num,
+               statistics.duration,
+               statistics.frames_num / statistics.duration,
+               statistics.written_size / statistics.duration / (1024.0 * 1024.0));
+  }
   WM_main_add_notifier(NC_OBJECT | ND_MODIFIER, nullptr);
   WM_main_add_notifier(NC_NODE | ND_DISPLAY, nullptr);
   WM_main_add_notifier(NC_SPACE | ND_SPACE_VIEW3D | NS_VIEW3D_SHADING, nullptr);
@@ -481,6 +603,9 @@ static Vector<NodeBakeRequest> collect_simulations_to_bake(Main &bmain,
         request.path = std::move(*path);
         request.frame_start = frame_range->first();
         request.frame_end = frame_range->last();
+        if (const NodesModifierBake *bake = nmd->find_bake(id)) {
+          request.use_compression = bake->flag & NODES_MODIFIER_BAKE_COMPRESS;
+        }
 
         requests.append(std::move(request));
       }
@@ -838,6 +963,7 @@ static Vector<NodeBakeRequest> bake_single_node_gather_bake_request(bContext *C,
     return {};
   }
   request.path = std::move(*bake_path);
+  request.use_compression = bake->flag & NODES_MODIFIER_BAKE_COMPRESS;
 
   if (node->type == GEO_NODE_BAKE && bake->bake_mode == NODES_MODIFIER_BAKE_MODE_STILL) {
     const int current_frame = scene->r.cfra;
@@ -2443,20 +2443,22 @@ static void node_add_error_message_button(const TreeDrawContext &tree_draw_ctx,
   UI_block_emboss_set(&block, UI_EMBOSS);
 }
 
+static geo_log::GeoTreeLog *geo_node_get_tree_log(const TreeDrawContext &tree_draw_ctx,
+                                                  const SpaceNode &snode,
+                                                  const bNode &node)
+{
+  const bNodeTreeZones *zones = snode.edittree->zones();
+  if (!zones) {
+    return nullptr;
+  }
+  const bNodeTreeZone *zone = zones->get_zone_by_node(node.identifier);
+  return tree_draw_ctx.geo_log_by_zone.lookup_default(zone, nullptr);
+}
+
 static std::optional<std::chrono::nanoseconds> geo_node_get_execution_time(
     const TreeDrawContext &tree_draw_ctx, const SpaceNode &snode, const bNode &node)
 {
-  const bNodeTree &ntree = *snode.edittree;
-
-  geo_log::GeoTreeLog *tree_log = [&]() -> geo_log::GeoTreeLog * {
-    const bNodeTreeZones *zones = ntree.zones();
-    if (!zones) {
-      return nullptr;
-    }
-    const bNodeTreeZone *zone = zones->get_zone_by_node(node.identifier);
-    return tree_draw_ctx.geo_log_by_zone.lookup_default(zone, nullptr);
-  }();
-
+  geo_log::GeoTreeLog *tree_log = geo_node_get_tree_log(tree_draw_ctx, snode, node);
   if (tree_log == nullptr) {
     return std::nullopt;
   }
@@ -2496,6 +2498,30 @@ static std::optional<std::chrono::nanoseconds> geo_node_get_execution_time(
   return std::nullopt;
 }
 
+/**
+ * Get how often the outputs of the node have been found in the output cache of the modifier,
+ * and how often they had to be computed.
+ */
+static std::optional<std::pair<int, int>> geo_node_get_output_cache_usage(
+    const TreeDrawContext &tree_draw_ctx, const SpaceNode &snode, const bNode &node)
+{
+  geo_log::GeoTreeLog *tree_log = geo_node_get_tree_log(tree_draw_ctx, snode, node);
+  if (tree_log == nullptr) {
+    return std::nullopt;
+  }
+  std::pair<int, int> usage;
+  if (node.type == NODE_GROUP_OUTPUT) {
+    usage = {tree_log->output_cache_hits_sum, tree_log->output_cache_misses_sum};
+  }
+  else if (const geo_log::GeoNodeLog *node_log = tree_log->nodes.lookup_ptr(node.identifier)) {
+    usage = {node_log->output_cache_hits, node_log->output_cache_misses};
+  }
+  if (usage.first == 0 && usage.second == 0) {
+    return std::nullopt;
+  }
+  return usage;
+}
+
 /* Create node key instance, assuming the node comes from the currently edited node tree. */
 static bNodeInstanceKey current_node_instance_key(const SpaceNode &snode, const bNode &node)
 {
@@ -2571,19 +2597,10 @@ static std::optional<std::chrono::nanoseconds> node_get_execution_time(
   return std::nullopt;
 }
 
-static std::string node_get_execution_time_label(TreeDrawContext &tree_draw_ctx,
-                                                 const SpaceNode &snode,
-                                                 const bNode &node)
+static std::string node_get_execution_time_str(const std::chrono::nanoseconds exec_time)
 {
-  const std::optional<std::chrono::nanoseconds> exec_time = node_get_execution_time(
-      tree_draw_ctx, snode, node);
-
-  if (!exec_time.has_value()) {
-    return std::string("");
-  }
-
   const uint64_t exec_time_us =
-      std::chrono::duration_cast<std::chrono::microseconds>(*exec_time).count();
+      std::chrono::duration_cast<std::chrono::microseconds>(exec_time).count();
 
   /* Don't show time if execution time is 0 microseconds. */
   if (exec_time_us == 0) {
@@ -2607,6 +2624,31 @@ static std::string node_get_execution_time_label(TreeDrawContext &tree_draw_ctx,
   return stream.str() + " ms";
 }
 
+static std::string node_get_execution_time_label(TreeDrawContext &tree_draw_ctx,
+                                                 const SpaceNode &snode,
+                                                 const bNode &node)
+{
+  const std::optional<std::chrono::nanoseconds> exec_time = node_get_execution_time(
+      tree_draw_ctx, snode, node);
+
+  if (!exec_time.has_value()) {
+    return std::string("");
+  }
+
+  std::string label = node_get_execution_time_str(*exec_time);
+  if (snode.edittree->type == NTREE_GEOMETRY) {
+    /* Show how often the outputs were taken from the output cache. */
+    if (const std::optional<std::pair<int, int>> cache_usage = geo_node_get_output_cache_usage(
+            tree_draw_ctx, snode, node))
+    {
+      const int hits = cache_usage->first;
+      const int total = hits + cache_usage->second;
+      label += fmt::format(" ({}/{} {})", hits, total, IFACE_("cached"));
+    }
+  }
+  return label;
+}
+
 struct NamedAttributeTooltipArg {
   Map<StringRefNull, geo_log::NamedAttributeUsage> usage_by_attribute;
 };
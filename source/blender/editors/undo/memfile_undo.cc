@@ -49,6 +49,9 @@
 /** \name Implements ED Undo System
  * \{ */
 
+/** Number of most recent undo pushes and reads whose data is kept uncompressed. */
+#define MEMFILE_UNDO_UNCOMPRESSED_STEPS 2
+
 struct MemFileUndoStep {
   UndoStep step;
   MemFileUndoData *data;
@@ -87,6 +90,10 @@ static bool memfile_undosys_step_encode(bContext * /*C*/, Main *bmain, UndoStep
   us->data = BKE_memfile_undo_encode(bmain, us_prev ? us_prev->data : nullptr);
   us->step.data_size = us->data->undo_size;
 
+  if (U.uiflag & USER_GLOBALUNDO_COMPRESS) {
+    BLO_memfile_compress_schedule(MEMFILE_UNDO_UNCOMPRESSED_STEPS);
+  }
+
   /* Store the fact that we should not re-use old data with that undo step, and reset the Main
    * flag. */
   us->step.use_old_bmain_data = !bmain->use_memfile_full_barrier;
@@ -492,6 +492,14 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
                                 const FieldContext &context,
                                 Span<GVMutableArray> dst_varrays = {});
 
+/**
+ * Fusing chains of element-wise operations (see #mf::FusedFunction) is enabled by default.
+ * Disabling it is meant for debugging, e.g. to find out whether a regression is caused by fusion.
+ * Geometry nodes evaluation sets it from the `--debug-field-no-fusion` command line option.
+ */
+void set_field_operation_fusion_enabled(bool enabled);
+bool field_operation_fusion_enabled();
+
 /* -------------------------------------------------------------------- */
 /** \name Utility functions for simple field creation and evaluation
  * \{ */
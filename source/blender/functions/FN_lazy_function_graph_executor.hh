@@ -11,6 +11,9 @@
  * another #Graph again).
  */
 
+#include <atomic>
+
+#include "BLI_array.hh"
 #include "BLI_vector.hh"
 #include "BLI_vector_set.hh"
 
@@ -105,6 +108,17 @@ class GraphExecutor : public LazyFunction {
    * Optional wrapper for node execution functions.
    */
   const NodeExecuteWrapper *node_execute_wrapper_;
+  /**
+   * Estimated execution time of every node in seconds, indexed by #Node::index_in_graph. The
+   * estimates are updated after every evaluation of the graph and are used to start nodes on the
+   * most expensive paths through the graph first in later evaluations.
+   */
+  mutable Array<std::atomic<float>> node_costs_;
+  /**
+   * True when some node has been found to be expensive. Otherwise, the overhead of taking the
+   * costs into account during scheduling is avoided.
+   */
+  mutable std::atomic<bool> has_expensive_nodes_ = false;
 
   /**
    * When a graph is executed, various things have to be allocated (e.g. the state of all nodes).
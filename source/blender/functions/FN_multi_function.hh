@@ -119,6 +119,12 @@ class MultiFunction : NonCopyable, NonMovable {
      * educated guess about a good grain size.
      */
     bool uniform_execution_time = true;
+    /**
+     * The function is a cheap element-wise computation without any setup cost per call. Such
+     * functions can be fused with others (see #FusedFunction) and be called on small chunks of
+     * the data, so that intermediate values stay in the CPU cache.
+     */
+    bool is_fusable = false;
   };
 
   ExecutionHints execution_hints() const;
@@ -508,10 +508,14 @@ template<typename CallFn, typename... ParamTags> class CustomMF : public MultiFu
  private:
   Signature signature_;
   CallFn call_fn_;
+  bool is_fusable_;
 
  public:
-  CustomMF(const char *name, CallFn call_fn, TypeSequence<ParamTags...> /*param_tags*/)
-      : call_fn_(std::move(call_fn))
+  CustomMF(const char *name,
+           CallFn call_fn,
+           TypeSequence<ParamTags...> /*param_tags*/,
+           const bool is_fusable = false)
+      : call_fn_(std::move(call_fn)), is_fusable_(is_fusable)
   {
     SignatureBuilder builder{name, signature_};
     /* Loop over all parameter types and add an entry for each in the signature. */
@@ -523,6 +527,14 @@ template<typename CallFn, typename... ParamTags> class CustomMF : public MultiFu
   {
     call_fn_(mask, params);
   }
+
+ private:
+  ExecutionHints get_execution_hints() const override
+  {
+    ExecutionHints hints;
+    hints.is_fusable = is_fusable_;
+    return hints;
+  }
 };
 
 template<typename Out, typename... In, typename ElementFn, typename ExecPreset>
@@ -537,7 +549,9 @@ inline auto build_multi_function_with_n_inputs_one_output(const char *name,
       [element_fn](const In &...in, Out &out) { new (&out) Out(element_fn(in...)); },
       exec_preset,
       param_tags);
-  return CustomMF(name, call_fn, param_tags);
+  /* Devirtualized presets are meant for small functions, those benefit from being fused. More
+   * expensive functions are not bound by memory bandwidth, so fusing them gains nothing. */
+  return CustomMF(name, call_fn, param_tags, ExecPreset::use_devirtualization);
 }
 
 }  // namespace detail
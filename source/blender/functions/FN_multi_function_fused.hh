@@ -0,0 +1,69 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup fn
+ *
+ * A #FusedFunction evaluates a chain of fusable multi-functions (see
+ * #MultiFunction::ExecutionHints::is_fusable) in a single pass over the data. Instead of calling
+ * every function for all indices and storing intermediate values in arrays as large as the mask,
+ * the functions are called one after the other on small chunks of the data. The intermediate
+ * values of a chunk stay in the CPU cache, which makes evaluating long chains of simple math
+ * operations much less bound by memory bandwidth.
+ *
+ * The fused functions are always called with a contiguous index range and with spans or single
+ * values as inputs, so that their devirtualized code paths are used.
+ */
+
+#include "FN_multi_function.hh"
+
+namespace blender::fn::multi_function {
+
+class FusedFunction : public MultiFunction {
+ public:
+  /** A call of one of the fused functions. */
+  struct Call {
+    const MultiFunction *fn;
+    /**
+     * Value index for every parameter of the function. Values of input parameters have to be
+     * inputs of the fused function or outputs of a previous call. Output parameters have to use
+     * values that are not used as output by another call.
+     */
+    Vector<int> values;
+  };
+
+  /** Number of elements that are processed at once. */
+  static constexpr int64_t chunk_size = 4096;
+
+ private:
+  Signature signature_;
+  Vector<Call> calls_;
+  Vector<const CPPType *> value_types_;
+  int inputs_num_;
+  Vector<int> output_values_;
+  /** Chunk buffer used by every value that is computed by a call. */
+  Vector<int> value_buffers_;
+  Vector<const CPPType *> buffer_types_;
+  /** Computed values that are not used anymore after each call. */
+  Vector<Vector<int>> values_to_destruct_;
+  /** Index of the output parameter for every value, or -1 if it is not an output. */
+  Vector<int> output_param_by_value_;
+
+ public:
+  /**
+   * \param input_types: Types of the inputs of the fused function, which are the first values.
+   * \param output_values: Values that are outputs of the fused function.
+   */
+  FusedFunction(Span<const CPPType *> input_types, Vector<Call> calls, Span<int> output_values);
+
+  void call(const IndexMask &mask, Params params, Context context) const override;
+  std::string debug_name() const override;
+
+ private:
+  void assign_buffers();
+};
+
+}  // namespace blender::fn::multi_function
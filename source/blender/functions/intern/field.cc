@@ -2,6 +2,8 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <atomic>
+
 #include "BLI_array_utils.hh"
 #include "BLI_map.hh"
 #include "BLI_multi_value_map.hh"
@@ -11,6 +13,7 @@
 
 #include "FN_field.hh"
 #include "FN_multi_function_builder.hh"
+#include "FN_multi_function_fused.hh"
 #include "FN_multi_function_procedure.hh"
 #include "FN_multi_function_procedure_builder.hh"
 #include "FN_multi_function_procedure_executor.hh"
@@ -140,13 +143,239 @@ static Set<GFieldRef> find_varying_fields(const FieldTreeInfo &field_tree_info,
   return found_fields;
 }
 
+/**
+ * Operations that are evaluated together by a single #mf::FusedFunction.
+ */
+struct FusedOperationGroup {
+  /** Operations in the order in which they are evaluated. */
+  Vector<const FieldOperation *> operations;
+  /** Fields computed outside of the group that are used by its operations. */
+  VectorSet<GFieldRef> inputs;
+  /** Fields computed by the group that are used outside of it. */
+  VectorSet<GFieldRef> outputs;
+};
+
+struct FusedOperationGroups {
+  Vector<std::unique_ptr<FusedOperationGroup>> groups;
+  Map<const FieldNode *, const FusedOperationGroup *> group_by_operation;
+};
+
+static int operation_outputs_num(const FieldOperation &operation)
+{
+  const mf::MultiFunction &fn = operation.multi_function();
+  int outputs_num = 0;
+  for (const int param_index : fn.param_indices()) {
+    if (fn.param_type(param_index).interface_type() == mf::ParamType::Output) {
+      outputs_num++;
+    }
+  }
+  return outputs_num;
+}
+
+static std::atomic<bool> use_field_operation_fusion = true;
+
+void set_field_operation_fusion_enabled(const bool enabled)
+{
+  use_field_operation_fusion = enabled;
+}
+
+bool field_operation_fusion_enabled()
+{
+  return use_field_operation_fusion;
+}
+
+static bool is_fusable_operation(const FieldOperation &operation)
+{
+  const mf::MultiFunction &fn = operation.multi_function();
+  if (!fn.execution_hints().is_fusable) {
+    return false;
+  }
+  for (const int param_index : fn.param_indices()) {
+    if (!ELEM(fn.param_type(param_index).category(),
+              mf::ParamCategory::SingleInput,
+              mf::ParamCategory::SingleOutput))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Find groups of fusable operations that can be evaluated in one pass. An operation is added to
+ * the group of its users when all of them are in the same group. This way, only the last
+ * operation of a group can be used outside of it (besides requested outputs), so replacing the
+ * group with a single function never creates a cycle.
+ */
+static FusedOperationGroups find_fused_operation_groups(const FieldTreeInfo &field_tree_info,
+                                                        Span<GFieldRef> output_fields)
+{
+  /* Find all operations in an order where every operation comes after its inputs. */
+  Vector<const FieldOperation *> sorted_operations;
+  Set<const FieldNode *> handled_nodes;
+  struct NodeWithIndex {
+    const FieldNode *node;
+    int current_input_index = 0;
+  };
+  for (const GFieldRef &field : output_fields) {
+    Stack<NodeWithIndex> nodes_to_check;
+    if (handled_nodes.add(&field.node())) {
+      nodes_to_check.push({&field.node()});
+    }
+    while (!nodes_to_check.is_empty()) {
+      NodeWithIndex &node_with_index = nodes_to_check.peek();
+      if (node_with_index.node->node_type() != FieldNodeType::Operation) {
+        nodes_to_check.pop();
+        continue;
+      }
+      const FieldOperation &operation = *static_cast<const FieldOperation *>(
+          node_with_index.node);
+      const Span<GField> inputs = operation.inputs();
+      if (node_with_index.current_input_index < inputs.size()) {
+        const FieldNode &input_node = inputs[node_with_index.current_input_index].node();
+        node_with_index.current_input_index++;
+        if (handled_nodes.add(&input_node)) {
+          nodes_to_check.push({&input_node});
+        }
+      }
+      else {
+        sorted_operations.append(&operation);
+        nodes_to_check.pop();
+      }
+    }
+  }
+
+  FusedOperationGroups fused_groups;
+  Map<const FieldNode *, FusedOperationGroup *> group_by_operation;
+  /* Iterate over operations from their users to their inputs. */
+  for (int64_t i = sorted_operations.size() - 1; i >= 0; i--) {
+    const FieldOperation *operation = sorted_operations[i];
+    if (!is_fusable_operation(*operation)) {
+      continue;
+    }
+    /* Find the group that all users of the operation are in. */
+    FusedOperationGroup *group = nullptr;
+    bool has_users = false;
+    bool users_in_same_group = true;
+    for (const int output_index : IndexRange(operation_outputs_num(*operation))) {
+      for (const GFieldRef &user : field_tree_info.field_users.lookup({*operation, output_index}))
+      {
+        FusedOperationGroup *user_group = group_by_operation.lookup_default(&user.node(),
+                                                                            nullptr);
+        if (user_group == nullptr || (has_users && user_group != group)) {
+          users_in_same_group = false;
+        }
+        group = user_group;
+        has_users = true;
+      }
+    }
+    if (!has_users || !users_in_same_group) {
+      fused_groups.groups.append(std::make_unique<FusedOperationGroup>());
+      group = fused_groups.groups.last().get();
+    }
+    group->operations.append(operation);
+    group_by_operation.add_new(operation, group);
+  }
+
+  for (std::unique_ptr<FusedOperationGroup> &group : fused_groups.groups) {
+    if (group->operations.size() < 2) {
+      /* Evaluating a single operation with a fused function has no benefit. */
+      continue;
+    }
+    std::reverse(group->operations.begin(), group->operations.end());
+    for (const FieldOperation *operation : group->operations) {
+      for (const GField &input : operation->inputs()) {
+        if (group_by_operation.lookup_default(&input.node(), nullptr) != group.get()) {
+          group->inputs.add(input);
+        }
+      }
+      for (const int output_index : IndexRange(operation_outputs_num(*operation))) {
+        const GFieldRef output{*operation, output_index};
+        if (output_fields.contains(output)) {
+          group->outputs.add(output);
+          continue;
+        }
+        for (const GFieldRef &user : field_tree_info.field_users.lookup(output)) {
+          if (group_by_operation.lookup_default(&user.node(), nullptr) != group.get()) {
+            group->outputs.add(output);
+          }
+        }
+      }
+    }
+    for (const FieldOperation *operation : group->operations) {
+      fused_groups.group_by_operation.add_new(operation, group.get());
+    }
+  }
+  return fused_groups;
+}
+
+/**
+ * Add a call to a #mf::FusedFunction that evaluates all operations of the group.
+ */
+static void build_fused_operation_group_call(mf::Procedure &procedure,
+                                             mf::ProcedureBuilder &builder,
+                                             const FusedOperationGroup &group,
+                                             Map<GFieldRef, mf::Variable *> &variable_by_field)
+{
+  Map<GFieldRef, int> value_by_field;
+  Vector<const CPPType *> input_types;
+  for (const GFieldRef &input : group.inputs) {
+    value_by_field.add_new(input, input_types.append_and_get_index(&input.cpp_type()));
+  }
+  int values_num = input_types.size();
+
+  Vector<mf::FusedFunction::Call> calls;
+  for (const FieldOperation *operation : group.operations) {
+    const mf::MultiFunction &fn = operation->multi_function();
+    mf::FusedFunction::Call call{&fn, Vector<int>(fn.param_amount())};
+    int param_input_index = 0;
+    int param_output_index = 0;
+    for (const int param_index : fn.param_indices()) {
+      if (fn.param_type(param_index).interface_type() == mf::ParamType::Input) {
+        call.values[param_index] = value_by_field.lookup(
+            operation->inputs()[param_input_index]);
+        param_input_index++;
+      }
+      else {
+        call.values[param_index] = values_num;
+        value_by_field.add_new({*operation, param_output_index}, values_num);
+        values_num++;
+        param_output_index++;
+      }
+    }
+    calls.append(std::move(call));
+  }
+
+  Vector<int> output_values;
+  for (const GFieldRef &output : group.outputs) {
+    output_values.append(value_by_field.lookup(output));
+  }
+
+  const mf::MultiFunction &fused_fn = procedure.construct_function<mf::FusedFunction>(
+      input_types, std::move(calls), output_values);
+  Vector<mf::Variable *> variables;
+  for (const GFieldRef &input : group.inputs) {
+    variables.append(variable_by_field.lookup(input));
+  }
+  for (const GFieldRef &output : group.outputs) {
+    mf::Variable &variable = procedure.new_variable(mf::DataType::ForSingle(output.cpp_type()));
+    variables.append(&variable);
+    variable_by_field.add_new(output, &variable);
+  }
+  builder.add_call_with_all_variables(fused_fn, variables);
+}
+
 /**
  * Builds the #procedure so that it computes the fields.
+ *
+ * \param fused_groups: Operations that are evaluated together, or null if every operation should
+ * be called separately.
  */
 static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
                                                       ResourceScope &scope,
                                                       const FieldTreeInfo &field_tree_info,
-                                                      Span<GFieldRef> output_fields)
+                                                      Span<GFieldRef> output_fields,
+                                                      const FusedOperationGroups *fused_groups)
 {
   mf::ProcedureBuilder builder{procedure};
   /* Every input, intermediate and output field corresponds to a variable in the procedure. */
@@ -188,6 +417,22 @@ static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
           const FieldOperation &operation_node = static_cast<const FieldOperation &>(field.node());
           const Span<GField> operation_inputs = operation_node.inputs();
 
+          const FusedOperationGroup *fused_group =
+              fused_groups ? fused_groups->group_by_operation.lookup_default(&operation_node,
+                                                                             nullptr) :
+                             nullptr;
+          if (fused_group != nullptr) {
+            if (field_with_index.current_input_index < fused_group->inputs.size()) {
+              fields_to_check.push({fused_group->inputs[field_with_index.current_input_index]});
+              field_with_index.current_input_index++;
+            }
+            else {
+              build_fused_operation_group_call(
+                  procedure, builder, *fused_group, variable_by_field);
+            }
+            break;
+          }
+
           if (field_with_index.current_input_index < operation_inputs.size()) {
             /* Not all inputs are handled yet. Push the next input field to the stack and increment
              * the input index. */
@@ -369,8 +614,12 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   if (!varying_fields_to_evaluate.is_empty()) {
     /* Build the procedure for those fields. */
     mf::Procedure procedure;
+    FusedOperationGroups fused_groups;
+    if (field_operation_fusion_enabled()) {
+      fused_groups = find_fused_operation_groups(field_tree_info, varying_fields_to_evaluate);
+    }
     build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, varying_fields_to_evaluate);
+        procedure, scope, field_tree_info, varying_fields_to_evaluate, &fused_groups);
     mf::ProcedureExecutor procedure_executor{procedure};
 
     mf::ParamsBuilder mf_params{procedure_executor, &mask};
@@ -422,7 +671,7 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
     /* Build the procedure for those fields. */
     mf::Procedure procedure;
     build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, constant_fields_to_evaluate);
+        procedure, scope, field_tree_info, constant_fields_to_evaluate, nullptr);
     mf::ProcedureExecutor procedure_executor{procedure};
     const IndexMask mask(1);
     mf::ParamsBuilder mf_params{procedure_executor, &mask};
@@ -39,8 +39,17 @@
  * When all tasks are completed, the executor gives back control to the caller which may later
  * provide new inputs to the graph which in turn leads to new nodes being scheduled and the process
  * starts again.
+ *
+ * The time it takes to execute every node is measured and remembered in the #GraphExecutor. When
+ * the same graph is evaluated again, the nodes on the most expensive path through the graph (the
+ * critical path) are started first. Otherwise, an expensive node might only be started when all
+ * other work is done already, leaving all but one thread idle. When an expensive node starts, the
+ * other scheduled nodes are made available to other threads, so that they don't have to wait
+ * until the expensive node is done. Cheap nodes are still executed in the order in which they are
+ * scheduled, so that nodes usually run on the thread that computed their inputs.
  */
 
+#include <algorithm>
 #include <mutex>
 #include <sstream>
 
@@ -184,8 +193,25 @@ struct NodeState {
    * Custom storage of the node.
    */
   void *storage = nullptr;
+  /**
+   * Time spent executing the node in seconds. Access does not require holding the node lock,
+   * because it is only changed while the node is running.
+   */
+  double execution_time = 0.0;
+  /**
+   * Estimated time of the most expensive path from this node to the outputs of the graph,
+   * including the node itself. It's only computed when the graph contains expensive nodes.
+   */
+  float critical_path_cost = 0.0f;
 };
 
+/**
+ * Nodes that take longer than this (in seconds) are considered to be expensive. Cheaper nodes are
+ * not prioritized, because the overhead is not worth it and it would destroy the locality of the
+ * execution order.
+ */
+static constexpr float expensive_node_cost = 0.0005f;
+
 /**
  * Utility class that wraps a node whose state is locked. Having this is a separate class is useful
  * because it allows methods to communicate that they expect the node to be locked.
@@ -220,16 +246,38 @@ class GraphExecutorLFParams;
  */
 struct ScheduledNodes {
  private:
+  struct CostlyNode {
+    float cost;
+    const FunctionNode *node;
+
+    friend bool operator<(const CostlyNode &a, const CostlyNode &b)
+    {
+      return a.cost < b.cost;
+    }
+  };
+
   /** Use two stacks of scheduled nodes for different priorities. */
   Vector<const FunctionNode *> priority_;
   Vector<const FunctionNode *> normal_;
+  /**
+   * Nodes on expensive paths through the graph. This is a max-heap, so that the node with the
+   * most expensive path is executed first.
+   */
+  Vector<CostlyNode> costly_;
 
  public:
-  void schedule(const FunctionNode &node, const bool is_priority)
+  /**
+   * \param critical_path_cost: See #NodeState::critical_path_cost.
+   */
+  void schedule(const FunctionNode &node, const bool is_priority, const float critical_path_cost)
   {
     if (is_priority) {
       this->priority_.append(&node);
     }
+    else if (critical_path_cost >= expensive_node_cost) {
+      this->costly_.append({critical_path_cost, &node});
+      std::push_heap(this->costly_.begin(), this->costly_.end());
+    }
     else {
       this->normal_.append(&node);
     }
@@ -240,6 +288,10 @@ struct ScheduledNodes {
     if (!this->priority_.is_empty()) {
       return this->priority_.pop_last();
     }
+    if (!this->costly_.is_empty()) {
+      std::pop_heap(this->costly_.begin(), this->costly_.end());
+      return this->costly_.pop_last().node;
+    }
     if (!this->normal_.is_empty()) {
       return this->normal_.pop_last();
     }
@@ -248,12 +300,12 @@ struct ScheduledNodes {
 
   bool is_empty() const
   {
-    return this->priority_.is_empty() && this->normal_.is_empty();
+    return this->priority_.is_empty() && this->costly_.is_empty() && this->normal_.is_empty();
   }
 
   int64_t nodes_num() const
   {
-    return priority_.size() + normal_.size();
+    return priority_.size() + costly_.size() + normal_.size();
   }
 
   /**
@@ -268,6 +320,15 @@ struct ScheduledNodes {
     other.normal_.extend(normal_.as_span().drop_front(normal_split));
     priority_.resize(priority_split);
     normal_.resize(normal_split);
+
+    /* Distribute the costly nodes alternately, so that both groups get some expensive ones. */
+    std::sort_heap(costly_.begin(), costly_.end());
+    Vector<CostlyNode> costly = std::move(costly_);
+    for (const int64_t i : costly.index_range()) {
+      (i % 2 == 0 ? other.costly_ : costly_).append(costly[i]);
+    }
+    std::make_heap(costly_.begin(), costly_.end());
+    std::make_heap(other.costly_.begin(), other.costly_.end());
   }
 };
 
@@ -357,6 +418,7 @@ class Executor {
       for (const int node_index : range) {
         const Node &node = *self_.graph_.nodes()[node_index];
         NodeState &node_state = *node_states_[node_index];
+        this->update_node_cost_estimate(node, node_state);
         this->destruct_node_state(node, node_state);
       }
     });
@@ -391,6 +453,9 @@ class Executor {
       char *buffer = static_cast<char *>(
           local_data.allocator->allocate(self_.init_buffer_info_.total_size, alignof(void *)));
       this->initialize_node_states(buffer);
+      if (self_.has_expensive_nodes_.load(std::memory_order_relaxed)) {
+        this->initialize_critical_path_costs();
+      }
 
       loaded_inputs_ = MutableSpan{
           reinterpret_cast<std::atomic<uint8_t> *>(
@@ -461,6 +526,87 @@ class Executor {
     });
   }
 
+  /**
+   * Compute #NodeState::critical_path_cost for every node based on the cost estimates from
+   * previous evaluations. Links that are part of a cycle are ignored.
+   */
+  void initialize_critical_path_costs()
+  {
+    const Span<const Node *> nodes = self_.graph_.nodes();
+
+    const auto compute_cost = [&](const Node &node) {
+      float max_target_cost = 0.0f;
+      for (const OutputSocket *output_socket : node.outputs()) {
+        for (const InputSocket *target_socket : output_socket->targets()) {
+          const NodeState &target_state = *node_states_[target_socket->node().index_in_graph()];
+          max_target_cost = std::max(max_target_cost, target_state.critical_path_cost);
+        }
+      }
+      const int node_index = node.index_in_graph();
+      node_states_[node_index]->critical_path_cost =
+          self_.node_costs_[node_index].load(std::memory_order_relaxed) + max_target_cost;
+    };
+
+    /* Traverse the graph from the outputs to the inputs, so that the costs of all linked target
+     * nodes are known when the cost of a node is computed. */
+    Array<int> remaining_targets_num(nodes.size(), 0);
+    Vector<const Node *> nodes_to_check;
+    for (const int node_index : nodes.index_range()) {
+      const Node &node = *nodes[node_index];
+      for (const OutputSocket *output_socket : node.outputs()) {
+        remaining_targets_num[node_index] += output_socket->targets().size();
+      }
+      if (remaining_targets_num[node_index] == 0) {
+        nodes_to_check.append(&node);
+      }
+    }
+    while (!nodes_to_check.is_empty()) {
+      const Node &node = *nodes_to_check.pop_last();
+      compute_cost(node);
+      for (const InputSocket *input_socket : node.inputs()) {
+        if (const OutputSocket *origin = input_socket->origin()) {
+          const Node &origin_node = origin->node();
+          if (--remaining_targets_num[origin_node.index_in_graph()] == 0) {
+            nodes_to_check.append(&origin_node);
+          }
+        }
+      }
+    }
+    /* Nodes in cycles are never reached above. */
+    for (const int node_index : nodes.index_range()) {
+      if (remaining_targets_num[node_index] > 0) {
+        compute_cost(*nodes[node_index]);
+      }
+    }
+  }
+
+  /**
+   * Remember how long the node took, so that it can be prioritized in later evaluations.
+   */
+  void update_node_cost_estimate(const Node &node, const NodeState &node_state)
+  {
+    if (node_state.execution_time == 0.0) {
+      /* The node has not been executed, keep the previous estimate. */
+      return;
+    }
+    std::atomic<float> &cost = self_.node_costs_[node.index_in_graph()];
+    const float new_cost = float(node_state.execution_time);
+    const float old_cost = cost.load(std::memory_order_relaxed);
+    /* Smooth out outliers while still adapting to changes quickly. Concurrent evaluations of the
+     * same graph may overwrite each other's estimates here, which is fine. */
+    const float estimate = old_cost == 0.0f ? new_cost : (old_cost + new_cost) * 0.5f;
+    cost.store(estimate, std::memory_order_relaxed);
+    if (estimate >= expensive_node_cost) {
+      self_.has_expensive_nodes_.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  bool is_expensive_node(const FunctionNode &node) const
+  {
+    return self_.node_costs_[node.index_in_graph()].load(std::memory_order_relaxed) >=
+           expensive_node_cost;
+  }
+
   void destruct_node_state(const Node &node, NodeState &node_state)
   {
     if (node.is_function()) {
@@ -742,12 +888,13 @@ class Executor {
       case NodeScheduleState::NotScheduled: {
         locked_node.node_state.schedule_state = NodeScheduleState::Scheduled;
         const FunctionNode &node = static_cast<const FunctionNode &>(locked_node.node);
+        const float cost = locked_node.node_state.critical_path_cost;
         if (this->use_multi_threading()) {
           std::lock_guard lock{current_task.mutex};
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, cost);
         }
         else {
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, cost);
         }
         current_task.has_scheduled_nodes.store(true, std::memory_order_relaxed);
         break;
@@ -812,6 +959,14 @@ class Executor {
       if (current_task.scheduled_nodes.is_empty()) {
         current_task.has_scheduled_nodes.store(false, std::memory_order_relaxed);
       }
+      else if (this->is_expensive_node(*node)) {
+        /* Let other threads work on the remaining nodes while the expensive node is running. This
+         * is also done when the node sends a blocking hint, but many single-threaded nodes don't
+         * do that. Nodes scheduled by the expensive node still stay on this thread. */
+        if (this->try_enable_multi_threading()) {
+          this->push_all_scheduled_nodes_to_task_pool(current_task);
+        }
+      }
       this->run_node_task(*node, current_task, local_data);
 
       /* If there are many nodes scheduled at the same time, it's beneficial to let multiple
@@ -1299,6 +1454,9 @@ class Executor {
       return {&main_allocator_, context_->local_user_data};
     }
     ThreadLocalStorage &local_storage = thread_locals_->local();
+    if (context_->user_data == nullptr) {
+      return {&local_storage.allocator, nullptr};
+    }
     if (!local_storage.local_user_data.has_value()) {
       local_storage.local_user_data = context_->user_data->get_local(local_storage.allocator);
     }
@@ -1448,12 +1606,15 @@ inline void Executor::execute_node(const FunctionNode &node,
   };
 
   lazy_threading::HintReceiver blocking_hint_receiver{blocking_hint_fn};
+  const timeit::TimePoint start_time = timeit::Clock::now();
   if (self_.node_execute_wrapper_) {
     self_.node_execute_wrapper_->execute_node(node, node_params, fn_context);
   }
   else {
     fn.execute(node_params, fn_context);
   }
+  const timeit::TimePoint end_time = timeit::Clock::now();
+  node_state.execution_time += std::chrono::duration<double>(end_time - start_time).count();
 
   if (self_.logger_ != nullptr) {
     self_.logger_->log_after_node_execute(node, node_params, fn_context);
@@ -1473,8 +1634,13 @@ GraphExecutor::GraphExecutor(const Graph &graph,
       graph_output_index_by_socket_index_(graph.graph_outputs().size(), -1),
       logger_(logger),
       side_effect_provider_(side_effect_provider),
-      node_execute_wrapper_(node_execute_wrapper)
+      node_execute_wrapper_(node_execute_wrapper),
+      node_costs_(graph.nodes().size())
 {
+  for (std::atomic<float> &cost : node_costs_) {
+    cost.store(0.0f, std::memory_order_relaxed);
+  }
+
   /* The graph executor can handle partial execution when there are still missing inputs. */
   allow_missing_requested_inputs_ = true;
 
@@ -0,0 +1,226 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "BLI_array.hh"
+#include "BLI_linear_allocator.hh"
+
+#include "FN_multi_function_fused.hh"
+
+namespace blender::fn::multi_function {
+
+FusedFunction::FusedFunction(Span<const CPPType *> input_types,
+                             Vector<Call> calls,
+                             Span<int> output_values)
+    : calls_(std::move(calls)), inputs_num_(input_types.size()), output_values_(output_values)
+{
+  value_types_.extend(input_types);
+  for (const Call &call : calls_) {
+    BLI_assert(call.values.size() == call.fn->param_amount());
+    for (const int param_index : call.fn->param_indices()) {
+      const ParamType param_type = call.fn->param_type(param_index);
+      BLI_assert(ELEM(param_type.category(),
+                      ParamCategory::SingleInput,
+                      ParamCategory::SingleOutput));
+      const int value = call.values[param_index];
+      if (param_type.interface_type() == ParamType::Output) {
+        /* New values are numbered in the order in which they are computed. */
+        BLI_assert(value == value_types_.size());
+        value_types_.append(&param_type.data_type().single_type());
+      }
+      else {
+        BLI_assert(value < value_types_.size());
+        UNUSED_VARS_NDEBUG(value);
+      }
+    }
+  }
+
+  output_param_by_value_.resize(value_types_.size(), -1);
+  SignatureBuilder builder{"Fused", signature_};
+  for (const CPPType *type : input_types) {
+    builder.single_input("Input", *type);
+  }
+  for (const int i : output_values_.index_range()) {
+    const int value = output_values_[i];
+    BLI_assert(value >= inputs_num_);
+    BLI_assert(output_param_by_value_[value] == -1);
+    output_param_by_value_[value] = inputs_num_ + i;
+    builder.single_output("Output", *value_types_[value]);
+  }
+  this->set_signature(&signature_);
+
+  this->assign_buffers();
+}
+
+void FusedFunction::assign_buffers()
+{
+  Array<int> last_use(value_types_.size(), -1);
+  for (const int call_i : calls_.index_range()) {
+    const Call &call = calls_[call_i];
+    for (const int param_index : call.fn->param_indices()) {
+      if (call.fn->param_type(param_index).interface_type() == ParamType::Input) {
+        last_use[call.values[param_index]] = call_i;
+      }
+    }
+  }
+
+  /* Values with disjoint lifetimes share the same chunk buffer, to keep the memory that is used
+   * for intermediate values as small as possible. */
+  value_buffers_.resize(value_types_.size(), -1);
+  values_to_destruct_.resize(calls_.size());
+  Vector<int> free_buffers;
+  for (const int call_i : calls_.index_range()) {
+    const Call &call = calls_[call_i];
+    for (const int param_index : call.fn->param_indices()) {
+      if (call.fn->param_type(param_index).interface_type() != ParamType::Output) {
+        continue;
+      }
+      const int value = call.values[param_index];
+      const CPPType *type = value_types_[value];
+      int free_i = -1;
+      for (const int i : free_buffers.index_range()) {
+        if (buffer_types_[free_buffers[i]] == type) {
+          free_i = i;
+          break;
+        }
+      }
+      if (free_i == -1) {
+        value_buffers_[value] = buffer_types_.append_and_get_index(type);
+      }
+      else {
+        value_buffers_[value] = free_buffers[free_i];
+        free_buffers.remove_and_reorder(free_i);
+      }
+    }
+    for (const int value : call.values) {
+      if (value < inputs_num_ || output_param_by_value_[value] != -1) {
+        /* Inputs are not owned and outputs are passed to the caller. */
+        continue;
+      }
+      /* Values that are never used are destructed right after they are computed. */
+      if (!ELEM(last_use[value], call_i, -1)) {
+        continue;
+      }
+      if (values_to_destruct_[call_i].contains(value)) {
+        continue;
+      }
+      values_to_destruct_[call_i].append(value);
+      free_buffers.append(value_buffers_[value]);
+    }
+  }
+}
+
+void FusedFunction::call(const IndexMask &mask, Params params, Context context) const
+{
+  if (mask.is_empty()) {
+    return;
+  }
+  const int64_t max_chunk_size = std::min(mask.size(), chunk_size);
+
+  LinearAllocator<> allocator;
+  Array<void *> buffers(buffer_types_.size());
+  for (const int i : buffer_types_.index_range()) {
+    const CPPType &type = *buffer_types_[i];
+    buffers[i] = allocator.allocate(type.size() * max_chunk_size, type.alignment());
+  }
+
+  /* Inputs that are not single values have to be copied into a compressed buffer when the
+   * indices of a chunk are not contiguous. */
+  Array<GVArray> inputs(inputs_num_);
+  Array<void *> input_buffers(inputs_num_, nullptr);
+  for (const int i : IndexRange(inputs_num_)) {
+    inputs[i] = params.readonly_single_input(i);
+    if (!inputs[i].is_single()) {
+      const CPPType &type = *value_types_[i];
+      input_buffers[i] = allocator.allocate(type.size() * max_chunk_size, type.alignment());
+    }
+  }
+
+  Array<GVArray> chunk_inputs(inputs_num_);
+  Array<void *> value_data(value_types_.size(), nullptr);
+  for (int64_t chunk_start = 0; chunk_start < mask.size(); chunk_start += chunk_size) {
+    const IndexMask chunk_mask = mask.slice(chunk_start,
+                                            std::min(chunk_size, mask.size() - chunk_start));
+    const int64_t size = chunk_mask.size();
+    const std::optional<IndexRange> chunk_range = chunk_mask.to_range();
+    /* The fused functions always process a contiguous range of indices. */
+    const IndexMask chunk_indices(size);
+
+    for (const int i : IndexRange(inputs_num_)) {
+      const GVArray &varray = inputs[i];
+      if (chunk_range.has_value()) {
+        chunk_inputs[i] = varray.slice(*chunk_range);
+      }
+      else if (varray.is_single()) {
+        chunk_inputs[i] = varray.slice(IndexRange(size));
+      }
+      else {
+        varray.materialize_compressed_to_uninitialized(chunk_mask, input_buffers[i]);
+        chunk_inputs[i] = GVArray::ForSpan({varray.type(), input_buffers[i], size});
+      }
+    }
+    for (const int value : value_types_.index_range().drop_front(inputs_num_)) {
+      const int output_param = output_param_by_value_[value];
+      if (output_param != -1 && chunk_range.has_value()) {
+        /* Write directly into the output array. */
+        const GMutableSpan output = params.uninitialized_single_output(output_param);
+        value_data[value] = output.slice(*chunk_range).data();
+      }
+      else {
+        value_data[value] = buffers[value_buffers_[value]];
+      }
+    }
+
+    for (const int call_i : calls_.index_range()) {
+      const Call &call = calls_[call_i];
+      ParamsBuilder call_params{*call.fn, &chunk_indices};
+      for (const int param_index : call.fn->param_indices()) {
+        const int value = call.values[param_index];
+        const CPPType &type = *value_types_[value];
+        if (call.fn->param_type(param_index).interface_type() == ParamType::Output) {
+          call_params.add_uninitialized_single_output({type, value_data[value], size});
+        }
+        else if (value < inputs_num_) {
+          call_params.add_readonly_single_input(chunk_inputs[value]);
+        }
+        else {
+          call_params.add_readonly_single_input(GSpan(type, value_data[value], size));
+        }
+      }
+      call.fn->call(chunk_indices, call_params, context);
+
+      for (const int value : values_to_destruct_[call_i]) {
+        value_types_[value]->destruct_n(value_data[value], size);
+      }
+    }
+
+    if (!chunk_range.has_value()) {
+      /* Move the computed values to their indices in the output arrays. */
+      for (const int value : output_values_) {
+        const CPPType &type = *value_types_[value];
+        const GMutableSpan output = params.uninitialized_single_output(
+            output_param_by_value_[value]);
+        void *src = value_data[value];
+        chunk_mask.foreach_index([&](const int64_t i, const int64_t pos) {
+          type.relocate_construct(POINTER_OFFSET(src, type.size() * pos), output[i]);
+        });
+      }
+      for (const int i : IndexRange(inputs_num_)) {
+        if (input_buffers[i] != nullptr) {
+          value_types_[i]->destruct_n(input_buffers[i], size);
+        }
+      }
+    }
+  }
+}
+
+std::string FusedFunction::debug_name() const
+{
+  std::string name = "Fused";
+  for (const Call &call : calls_) {
+    name += (&call == calls_.begin() ? ": " : ", ") + call.fn->debug_name();
+  }
+  return name;
+}
+
+}  // namespace blender::fn::multi_function
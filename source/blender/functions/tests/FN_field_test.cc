@@ -281,4 +281,120 @@ TEST(field, IgnoredOutput)
   EXPECT_EQ(results.get(3), 5);
 }
 
+TEST(field, FusedFunctions)
+{
+  GField index_field{std::make_shared<IndexFieldInput>()};
+
+  /* Only functions with devirtualized presets are fused. */
+  auto add_fn = mf::build::SI2_SO<int, int, int>(
+      "add", [](int a, int b) { return a + b; }, mf::build::exec_presets::AllSpanOrSingle());
+  auto mul_3_fn = mf::build::SI1_SO<int, int>(
+      "mul_3", [](int a) { return a * 3; }, mf::build::exec_presets::AllSpanOrSingle());
+  auto add_10_fn = mf::build::SI1_SO<int, int>(
+      "add_10", [](int a) { return a + 10; }, mf::build::exec_presets::AllSpanOrSingle());
+
+  /* The intermediate value is used by two operations of the same chain. */
+  GField add_field{FieldOperation::Create(add_fn, {index_field, index_field}), 0};
+  GField mul_field{FieldOperation::Create(mul_3_fn, {add_field}), 0};
+  GField sum_field{FieldOperation::Create(add_fn, {mul_field, add_field}), 0};
+  GField result_field_1{FieldOperation::Create(add_10_fn, {sum_field}), 0};
+  /* An intermediate value of the chain is also requested as output. */
+  GField result_field_2 = mul_field;
+
+  IndexMaskMemory memory;
+  for (const IndexMask &mask : {IndexMask(5000), IndexMask::from_every_nth(3, 2000, 1, memory)}) {
+    Array<int> result_1(mask.min_array_size());
+    Array<int> result_2(mask.min_array_size());
+
+    FieldContext context;
+    FieldEvaluator evaluator{context, &mask};
+    evaluator.add_with_destination(result_field_1, result_1.as_mutable_span());
+    evaluator.add_with_destination(result_field_2, result_2.as_mutable_span());
+    evaluator.evaluate();
+    mask.foreach_index([&](const int64_t i) {
+      EXPECT_EQ(result_1[i], i * 8 + 10);
+      EXPECT_EQ(result_2[i], i * 6);
+    });
+  }
+}
+
+TEST(field, FusedFunctionsWithUnfusableFunction)
+{
+  GField index_field{std::make_shared<IndexFieldInput>()};
+
+  auto add_10_fn = mf::build::SI1_SO<int, int>(
+      "add_10", [](int a) { return a + 10; }, mf::build::exec_presets::AllSpanOrSingle());
+  auto sub_fn = mf::build::SI2_SO<int, int, int>(
+      "sub", [](int a, int b) { return a - b; }, mf::build::exec_presets::AllSpanOrSingle());
+
+  /* The operation after the function with two outputs uses values from before it, so the
+   * operations before and after it can't be fused together. */
+  GField add_10_field{FieldOperation::Create(add_10_fn, {index_field}), 0};
+  std::shared_ptr<FieldOperation> two_outputs_fn = FieldOperation::Create(
+      std::make_unique<TwoOutputFunction>(), {add_10_field, index_field});
+  GField sub_field{FieldOperation::Create(sub_fn, {GField(two_outputs_fn, 1), add_10_field}), 0};
+  GField result_field{FieldOperation::Create(add_10_fn, {sub_field}), 0};
+
+  const IndexMask mask(3000);
+  Array<int> result(mask.size());
+  FieldContext context;
+  FieldEvaluator evaluator{context, &mask};
+  evaluator.add_with_destination(result_field, result.as_mutable_span());
+  evaluator.evaluate();
+  EXPECT_EQ(result[0], 20);
+  EXPECT_EQ(result[1], 21);
+  EXPECT_EQ(result[2999], 3019);
+}
+
+TEST(field, FusedFunctionsMatchUnfused)
+{
+  class PositionFieldInput final : public FieldInput {
+   public:
+    PositionFieldInput() : FieldInput(CPPType::get<float>(), "Position") {}
+
+    GVArray get_varray_for_context(const FieldContext & /*context*/,
+                                   const IndexMask &mask,
+                                   ResourceScope &scope) const final
+    {
+      Array<float> &values = scope.construct<Array<float>>(mask.min_array_size());
+      for (const int64_t i : values.index_range()) {
+        values[i] = float(i % 1000) * 0.001f;
+      }
+      return VArray<float>::ForSpan(values);
+    }
+  };
+
+  auto mul_add_fn = mf::build::SI1_SO<float, float>(
+      "mul_add",
+      [](float a) { return a * 1.01f + 0.5f; },
+      mf::build::exec_presets::AllSpanOrSingle());
+  auto abs_fn = mf::build::SI1_SO<float, float>(
+      "abs",
+      [](float a) { return std::abs(a - 1.0f); },
+      mf::build::exec_presets::AllSpanOrSingle());
+
+  /* A long chain over more elements than a single chunk of the fused function. */
+  Field<float> field{std::make_shared<PositionFieldInput>()};
+  for ([[maybe_unused]] const int64_t _ : IndexRange(40)) {
+    field = Field<float>(FieldOperation::Create(mul_add_fn, {field}));
+    field = Field<float>(FieldOperation::Create(abs_fn, {field}));
+  }
+
+  const int64_t size = 100'000;
+  Array<float> result_fused(size);
+  Array<float> result_unfused(size);
+  for (const bool use_fusion : {true, false}) {
+    set_field_operation_fusion_enabled(use_fusion);
+    FieldContext context;
+    FieldEvaluator evaluator{context, size};
+    evaluator.add_with_destination(
+        field, use_fusion ? result_fused.as_mutable_span() : result_unfused.as_mutable_span());
+    evaluator.evaluate();
+  }
+  set_field_operation_fusion_enabled(true);
+
+  /* The same operations are done for every element, so the results are exactly the same. */
+  EXPECT_EQ_ARRAY(result_fused.data(), result_unfused.data(), size);
+}
+
 }  // namespace blender::fn::tests
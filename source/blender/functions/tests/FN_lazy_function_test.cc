@@ -4,6 +4,9 @@
 
 #include "testing/testing.h"
 
+#include <mutex>
+#include <thread>
+
 #include "FN_lazy_function_execute.hh"
 #include "FN_lazy_function_graph.hh"
 #include "FN_lazy_function_graph_executor.hh"
@@ -179,4 +182,104 @@ TEST(lazy_function, GraphWithCycle)
   EXPECT_EQ(result, 10 * 2 * 5);
 }
 
+class SlowPassThroughFunction : public LazyFunction {
+ public:
+  SlowPassThroughFunction()
+  {
+    debug_name_ = "Slow Pass Through";
+    inputs_.append({"Value", CPPType::get<int>()});
+    outputs_.append({"Value", CPPType::get<int>()});
+  }
+
+  void execute_impl(Params &params, const Context & /*context*/) const override
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    params.set_output(0, params.get_input<int>(0));
+  }
+};
+
+/**
+ * Remembers the order in which nodes are started and the thread they are executed on. Nodes may be
+ * executed on multiple threads at the same time.
+ */
+class RecordExecutionOrderWrapper : public GraphExecutor::NodeExecuteWrapper {
+ public:
+  struct ExecutedNode {
+    const FunctionNode *node;
+    std::thread::id thread_id;
+  };
+
+  mutable std::mutex mutex;
+  mutable Vector<ExecutedNode> executed_nodes;
+
+  void execute_node(const FunctionNode &node,
+                    Params &params,
+                    const Context &context) const override
+  {
+    {
+      std::lock_guard lock{mutex};
+      executed_nodes.append({&node, std::this_thread::get_id()});
+    }
+    node.function().execute(params, context);
+  }
+};
+
+TEST(lazy_function, RepeatedExecutionWithExpensiveNode)
+{
+  BLI_task_scheduler_init();
+  const AddLazyFunction add_fn;
+  const SlowPassThroughFunction slow_fn;
+
+  Graph graph;
+  FunctionNode &slow_node = graph.add_function(slow_fn);
+  FunctionNode &add_node_1 = graph.add_function(add_fn);
+  FunctionNode &add_node_2 = graph.add_function(add_fn);
+  GraphInputSocket &input_socket = graph.add_input(CPPType::get<int>());
+  GraphOutputSocket &output_socket = graph.add_output(CPPType::get<int>());
+
+  graph.add_link(input_socket, slow_node.input(0));
+  graph.add_link(input_socket, add_node_1.input(0));
+  graph.add_link(slow_node.output(0), add_node_2.input(0));
+  graph.add_link(add_node_1.output(0), add_node_2.input(1));
+  graph.add_link(add_node_2.output(0), output_socket);
+
+  const int value_3 = 3;
+  add_node_1.input(1).set_default_value(&value_3);
+
+  graph.update_node_indices();
+
+  /* Later evaluations take the execution times of previous ones into account. The evaluation may
+   * use multiple threads, so only the order on the calling thread is deterministic. */
+  RecordExecutionOrderWrapper execution_order;
+  GraphExecutor executor_fn{
+      graph, {&input_socket}, {&output_socket}, nullptr, nullptr, &execution_order};
+  const std::thread::id calling_thread_id = std::this_thread::get_id();
+  for (const int i : IndexRange(3)) {
+    execution_order.executed_nodes.clear();
+    int result = 0;
+    execute_lazy_function_eagerly(
+        executor_fn, nullptr, nullptr, std::make_tuple(i), std::make_tuple(&result));
+    EXPECT_EQ(result, i + i + 3);
+    const Span<RecordExecutionOrderWrapper::ExecutedNode> executed_nodes =
+        execution_order.executed_nodes;
+    ASSERT_EQ(executed_nodes.size(), 3);
+    /* The last node depends on both others, so it can only start once they are done. */
+    EXPECT_EQ(executed_nodes[2].node, &add_node_2);
+    EXPECT_NE(executed_nodes[0].node, executed_nodes[1].node);
+    if (i > 0) {
+      /* The slow node is on the critical path, so the calling thread has to start it before the
+       * cheap node that can run in parallel to it. The cheap node may be started on another
+       * thread in the meantime. */
+      const RecordExecutionOrderWrapper::ExecutedNode *first_on_calling_thread =
+          std::find_if(executed_nodes.begin(),
+                       executed_nodes.end(),
+                       [&](const RecordExecutionOrderWrapper::ExecutedNode &executed_node) {
+                         return executed_node.thread_id == calling_thread_id;
+                       });
+      ASSERT_NE(first_on_calling_thread, executed_nodes.end());
+      EXPECT_EQ(first_on_calling_thread->node, &slow_node);
+    }
+  }
+}
+
 }  // namespace blender::fn::lazy_function::tests
@@ -0,0 +1,66 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_timeit.hh"
+
+#include "FN_field.hh"
+#include "FN_multi_function_builder.hh"
+
+namespace blender::fn::tests {
+
+class PositionFieldInput final : public FieldInput {
+ public:
+  PositionFieldInput() : FieldInput(CPPType::get<float>(), "Position") {}
+
+  GVArray get_varray_for_context(const FieldContext & /*context*/,
+                                 const IndexMask &mask,
+                                 ResourceScope &scope) const final
+  {
+    Array<float> &values = scope.construct<Array<float>>(mask.min_array_size());
+    for (const int64_t i : values.index_range()) {
+      values[i] = float(i % 1000) * 0.001f;
+    }
+    return VArray<float>::ForSpan(values);
+  }
+};
+
+/**
+ * Evaluate a chain of 80 small element-wise operations, like a long chain of math nodes, with
+ * the fused evaluation and with the evaluation of every operation on its own.
+ */
+TEST(field_performance, FusedFunctions)
+{
+  auto mul_add_fn = mf::build::SI1_SO<float, float>(
+      "mul_add",
+      [](float a) { return a * 1.01f + 0.5f; },
+      mf::build::exec_presets::AllSpanOrSingle());
+  auto abs_fn = mf::build::SI1_SO<float, float>(
+      "abs",
+      [](float a) { return std::abs(a - 1.0f); },
+      mf::build::exec_presets::AllSpanOrSingle());
+
+  Field<float> field{std::make_shared<PositionFieldInput>()};
+  for ([[maybe_unused]] const int64_t _ : IndexRange(40)) {
+    field = Field<float>(FieldOperation::Create(mul_add_fn, {field}));
+    field = Field<float>(FieldOperation::Create(abs_fn, {field}));
+  }
+
+  const int64_t size = 10'000'000;
+  Array<float> result(size);
+  for (const bool use_fusion : {false, true}) {
+    set_field_operation_fusion_enabled(use_fusion);
+    FieldContext context;
+    FieldEvaluator evaluator{context, size};
+    evaluator.add_with_destination(field, result.as_mutable_span());
+
+    SCOPED_TIMER(use_fusion ? "fused" : "not fused");
+    evaluator.evaluate();
+  }
+  set_field_operation_fusion_enabled(true);
+}
+
+}  // namespace blender::fn::tests
@@ -259,6 +259,13 @@ struct GatherTasksInfo {
    */
   Vector<std::unique_ptr<GArray<>>> &r_temporary_arrays;
 
+  /**
+   * Only compute the offsets and keep the first task of every type. That is enough to allocate
+   * the realized geometry before the tasks are gathered again chunk by chunk, see
+   * #realize_instances_in_chunks.
+   */
+  bool only_count = false;
+
   /** All gathered tasks. */
   GatherTasks r_tasks;
   /** Current offsets while gathering tasks. */
@@ -286,22 +293,107 @@ struct InstanceContext {
   }
 };
 
-static int64_t get_final_points_num(const GatherTasks &tasks)
+/**
+ * Tasks gathered for a contiguous range of instances on a separate thread. The offsets of the
+ * tasks are relative to the start of the chunk, unless the chunk start was known in advance.
+ */
+struct GatherTasksChunk {
+  GatherTasks tasks;
+  /** Offsets after the last task of the chunk. */
+  GatherOffsets offsets;
+  Vector<std::unique_ptr<GArray<>>> temporary_arrays;
+};
+
+/**
+ * Number of instances that are gathered by one thread. The order of the tasks depends on the
+ * instance order, so the instances are split into fixed size chunks that are joined afterwards.
+ */
+static constexpr int64_t gather_chunk_size = 4096;
+
+/** Above this number of top-level instances, the realized geometry is filled chunk by chunk. */
+static constexpr int64_t realize_in_chunks_min_instances = 16 * gather_chunk_size;
+
+static int64_t get_final_points_num(const GatherOffsets &offsets)
 {
-  int64_t points_num = 0;
-  if (!tasks.pointcloud_tasks.is_empty()) {
-    const RealizePointCloudTask &task = tasks.pointcloud_tasks.last();
-    points_num += task.start_index + task.pointcloud_info->pointcloud->totpoint;
+  return int64_t(offsets.pointcloud_offset) + offsets.mesh_offsets.vertex +
+         offsets.curves_offsets.point;
+}
+
+static GatherTasksInfo chunk_gather_info(const GatherTasksInfo &gather_info,
+                                         Vector<std::unique_ptr<GArray<>>> &r_temporary_arrays)
+{
+  return {gather_info.pointclouds,
+          gather_info.meshes,
+          gather_info.curves,
+          gather_info.create_id_attribute_on_any_component,
+          r_temporary_arrays,
+          gather_info.only_count};
+}
+
+static void add_offsets(GatherOffsets &offsets, const GatherOffsets &other)
+{
+  offsets.pointcloud_offset += other.pointcloud_offset;
+  offsets.mesh_offsets.vertex += other.mesh_offsets.vertex;
+  offsets.mesh_offsets.edge += other.mesh_offsets.edge;
+  offsets.mesh_offsets.face += other.mesh_offsets.face;
+  offsets.mesh_offsets.loop += other.mesh_offsets.loop;
+  offsets.curves_offsets.point += other.curves_offsets.point;
+  offsets.curves_offsets.curve += other.curves_offsets.curve;
+}
+
+/** Append tasks that were gathered separately, starting at the current offsets. */
+static void append_gathered_chunk(GatherTasksInfo &gather_info, GatherTasksChunk &&chunk)
+{
+  const GatherOffsets &start = gather_info.r_offsets;
+  GatherTasks &r_tasks = gather_info.r_tasks;
+  for (RealizePointCloudTask &task : chunk.tasks.pointcloud_tasks) {
+    if (gather_info.only_count && !r_tasks.pointcloud_tasks.is_empty()) {
+      break;
+    }
+    task.start_index += start.pointcloud_offset;
+    r_tasks.pointcloud_tasks.append(std::move(task));
   }
-  if (!tasks.mesh_tasks.is_empty()) {
-    const RealizeMeshTask &task = tasks.mesh_tasks.last();
-    points_num += task.start_indices.vertex + task.mesh_info->mesh->verts_num;
+  for (RealizeMeshTask &task : chunk.tasks.mesh_tasks) {
+    if (gather_info.only_count && !r_tasks.mesh_tasks.is_empty()) {
+      break;
+    }
+    task.start_indices.vertex += start.mesh_offsets.vertex;
+    task.start_indices.edge += start.mesh_offsets.edge;
+    task.start_indices.face += start.mesh_offsets.face;
+    task.start_indices.loop += start.mesh_offsets.loop;
+    r_tasks.mesh_tasks.append(std::move(task));
+  }
+  for (RealizeCurveTask &task : chunk.tasks.curve_tasks) {
+    if (gather_info.only_count && !r_tasks.curve_tasks.is_empty()) {
+      break;
+    }
+    task.start_indices.point += start.curves_offsets.point;
+    task.start_indices.curve += start.curves_offsets.curve;
+    r_tasks.curve_tasks.append(std::move(task));
   }
-  if (!tasks.curve_tasks.is_empty()) {
-    const RealizeCurveTask &task = tasks.curve_tasks.last();
-    points_num += task.start_indices.point + task.curve_info->curves->geometry.point_num;
+  if (!r_tasks.first_volume) {
+    r_tasks.first_volume = std::move(chunk.tasks.first_volume);
   }
-  return points_num;
+  if (!r_tasks.first_edit_data) {
+    r_tasks.first_edit_data = std::move(chunk.tasks.first_edit_data);
+  }
+  for (std::unique_ptr<GArray<>> &array : chunk.temporary_arrays) {
+    gather_info.r_temporary_arrays.append(std::move(array));
+  }
+  add_offsets(gather_info.r_offsets, chunk.offsets);
+}
+
+/** Call the function for every chunk of instances in parallel. */
+template<typename Fn>
+static void foreach_instances_chunk(const int64_t instances_num, const Fn &fn)
+{
+  const int64_t chunks_num = (instances_num + gather_chunk_size - 1) / gather_chunk_size;
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange chunks) {
+    for (const int64_t chunk_i : chunks) {
+      const int64_t start = chunk_i * gather_chunk_size;
+      fn(chunk_i, IndexRange(start, std::min(gather_chunk_size, instances_num - start)));
+    }
+  });
 }
 
 static void copy_transformed_positions(const Span<float3> src,
@@ -507,56 +599,72 @@ static void foreach_geometry_in_reference(
   }
 }
 
-static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
-                                               const Instances &instances,
-                                               const float4x4 &base_transform,
-                                               const InstanceContext &base_instance_context)
-{
-  const Span<InstanceReference> references = instances.references();
-  const Span<int> handles = instances.reference_handles();
-  const Span<float4x4> transforms = instances.transforms();
-
+/** Data of an #Instances that is used when gathering tasks for any of its instances. */
+struct InstancesGatherData {
+  const Instances *instances;
   Span<int> stored_instance_ids;
+  Vector<std::pair<int, GSpan>> pointcloud_attributes_to_override;
+  Vector<std::pair<int, GSpan>> mesh_attributes_to_override;
+  Vector<std::pair<int, GSpan>> curve_attributes_to_override;
+};
+
+static InstancesGatherData prepare_instances_gather_data(GatherTasksInfo &gather_info,
+                                                          const Instances &instances)
+{
+  InstancesGatherData data;
+  data.instances = &instances;
   if (gather_info.create_id_attribute_on_any_component) {
     bke::AttributeReader ids = instances.attributes().lookup<int>("id");
     if (ids) {
-      stored_instance_ids = ids.varray.get_internal_span();
+      data.stored_instance_ids = ids.varray.get_internal_span();
     }
   }
 
   /* Prepare attribute fallbacks. */
-  InstanceContext instance_context = base_instance_context;
-  Vector<std::pair<int, GSpan>> pointcloud_attributes_to_override = prepare_attribute_fallbacks(
+  data.pointcloud_attributes_to_override = prepare_attribute_fallbacks(
       gather_info, instances, gather_info.pointclouds.attributes);
-  Vector<std::pair<int, GSpan>> mesh_attributes_to_override = prepare_attribute_fallbacks(
+  data.mesh_attributes_to_override = prepare_attribute_fallbacks(
       gather_info, instances, gather_info.meshes.attributes);
-  Vector<std::pair<int, GSpan>> curve_attributes_to_override = prepare_attribute_fallbacks(
+  data.curve_attributes_to_override = prepare_attribute_fallbacks(
       gather_info, instances, gather_info.curves.attributes);
+  return data;
+}
+
+static void gather_realize_tasks_for_instance_range(GatherTasksInfo &gather_info,
+                                                    const InstancesGatherData &data,
+                                                    const IndexRange range,
+                                                    const float4x4 &base_transform,
+                                                    const InstanceContext &base_instance_context)
+{
+  const Span<InstanceReference> references = data.instances->references();
+  const Span<int> handles = data.instances->reference_handles();
+  const Span<float4x4> transforms = data.instances->transforms();
 
-  for (const int i : transforms.index_range()) {
+  InstanceContext instance_context = base_instance_context;
+  for (const int i : range) {
     const int handle = handles[i];
     const float4x4 &transform = transforms[i];
     const InstanceReference &reference = references[handle];
     const float4x4 new_base_transform = base_transform * transform;
 
     /* Update attribute fallbacks for the current instance. */
-    for (const std::pair<int, GSpan> &pair : pointcloud_attributes_to_override) {
+    for (const std::pair<int, GSpan> &pair : data.pointcloud_attributes_to_override) {
       instance_context.pointclouds.array[pair.first] = pair.second[i];
     }
-    for (const std::pair<int, GSpan> &pair : mesh_attributes_to_override) {
+    for (const std::pair<int, GSpan> &pair : data.mesh_attributes_to_override) {
       instance_context.meshes.array[pair.first] = pair.second[i];
     }
-    for (const std::pair<int, GSpan> &pair : curve_attributes_to_override) {
+    for (const std::pair<int, GSpan> &pair : data.curve_attributes_to_override) {
       instance_context.curves.array[pair.first] = pair.second[i];
     }
 
     uint32_t local_instance_id = 0;
     if (gather_info.create_id_attribute_on_any_component) {
-      if (stored_instance_ids.is_empty()) {
+      if (data.stored_instance_ids.is_empty()) {
         local_instance_id = uint32_t(i);
       }
       else {
-        local_instance_id = uint32_t(stored_instance_ids[i]);
+        local_instance_id = uint32_t(data.stored_instance_ids[i]);
       }
     }
     const uint32_t instance_id = noise::hash(base_instance_context.id, local_instance_id);
@@ -578,104 +686,153 @@ static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
 }
 
 /**
- * Gather tasks for all geometries in the #geometry_set.
+ * Gather the tasks of all instances. With many instances, chunks of instances are gathered in
+ * parallel and joined in order afterwards, which gives the same tasks as gathering serially.
  */
-static void gather_realize_tasks_recursive(GatherTasksInfo &gather_info,
-                                           const bke::GeometrySet &geometry_set,
-                                           const float4x4 &base_transform,
-                                           const InstanceContext &base_instance_context)
+static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
+                                               const Instances &instances,
+                                               const float4x4 &base_transform,
+                                               const InstanceContext &base_instance_context)
 {
-  for (const bke::GeometryComponent *component : geometry_set.get_components()) {
-    const bke::GeometryComponent::Type type = component->type();
-    switch (type) {
-      case bke::GeometryComponent::Type::Mesh: {
-        const bke::MeshComponent &mesh_component = *static_cast<const bke::MeshComponent *>(
-            component);
-        const Mesh *mesh = mesh_component.get();
-        if (mesh != nullptr && mesh->verts_num > 0) {
-          const int mesh_index = gather_info.meshes.order.index_of(mesh);
-          const MeshRealizeInfo &mesh_info = gather_info.meshes.realize_info[mesh_index];
+  const InstancesGatherData data = prepare_instances_gather_data(gather_info, instances);
+  const int64_t instances_num = instances.instances_num();
+  if (instances_num <= gather_chunk_size) {
+    gather_realize_tasks_for_instance_range(
+        gather_info, data, IndexRange(instances_num), base_transform, base_instance_context);
+    return;
+  }
+
+  Array<GatherTasksChunk> chunks((instances_num + gather_chunk_size - 1) / gather_chunk_size);
+  foreach_instances_chunk(instances_num, [&](const int64_t chunk_i, const IndexRange range) {
+    GatherTasksChunk &chunk = chunks[chunk_i];
+    GatherTasksInfo chunk_info = chunk_gather_info(gather_info, chunk.temporary_arrays);
+    gather_realize_tasks_for_instance_range(
+        chunk_info, data, range, base_transform, base_instance_context);
+    chunk.tasks = std::move(chunk_info.r_tasks);
+    chunk.offsets = chunk_info.r_offsets;
+  });
+  for (GatherTasksChunk &chunk : chunks) {
+    append_gathered_chunk(gather_info, std::move(chunk));
+  }
+}
+
+/**
+ * Gather tasks for a single geometry component. When only counting, just the first task of every
+ * type is kept.
+ */
+static void gather_realize_tasks_for_component(GatherTasksInfo &gather_info,
+                                               const bke::GeometryComponent *component,
+                                               const float4x4 &base_transform,
+                                               const InstanceContext &base_instance_context)
+{
+  const bool add_task_always = !gather_info.only_count;
+  const bke::GeometryComponent::Type type = component->type();
+  switch (type) {
+    case bke::GeometryComponent::Type::Mesh: {
+      const bke::MeshComponent &mesh_component = *static_cast<const bke::MeshComponent *>(
+          component);
+      const Mesh *mesh = mesh_component.get();
+      if (mesh != nullptr && mesh->verts_num > 0) {
+        const int mesh_index = gather_info.meshes.order.index_of(mesh);
+        const MeshRealizeInfo &mesh_info = gather_info.meshes.realize_info[mesh_index];
+        if (add_task_always || gather_info.r_tasks.mesh_tasks.is_empty()) {
           gather_info.r_tasks.mesh_tasks.append({gather_info.r_offsets.mesh_offsets,
                                                  &mesh_info,
                                                  base_transform,
                                                  base_instance_context.meshes,
                                                  base_instance_context.id});
-          gather_info.r_offsets.mesh_offsets.vertex += mesh->verts_num;
-          gather_info.r_offsets.mesh_offsets.edge += mesh->edges_num;
-          gather_info.r_offsets.mesh_offsets.loop += mesh->corners_num;
-          gather_info.r_offsets.mesh_offsets.face += mesh->faces_num;
         }
-        break;
+        gather_info.r_offsets.mesh_offsets.vertex += mesh->verts_num;
+        gather_info.r_offsets.mesh_offsets.edge += mesh->edges_num;
+        gather_info.r_offsets.mesh_offsets.loop += mesh->corners_num;
+        gather_info.r_offsets.mesh_offsets.face += mesh->faces_num;
       }
-      case bke::GeometryComponent::Type::PointCloud: {
-        const auto &pointcloud_component = *static_cast<const bke::PointCloudComponent *>(
-            component);
-        const PointCloud *pointcloud = pointcloud_component.get();
-        if (pointcloud != nullptr && pointcloud->totpoint > 0) {
-          const int pointcloud_index = gather_info.pointclouds.order.index_of(pointcloud);
-          const PointCloudRealizeInfo &pointcloud_info =
-              gather_info.pointclouds.realize_info[pointcloud_index];
+      break;
+    }
+    case bke::GeometryComponent::Type::PointCloud: {
+      const auto &pointcloud_component = *static_cast<const bke::PointCloudComponent *>(component);
+      const PointCloud *pointcloud = pointcloud_component.get();
+      if (pointcloud != nullptr && pointcloud->totpoint > 0) {
+        const int pointcloud_index = gather_info.pointclouds.order.index_of(pointcloud);
+        const PointCloudRealizeInfo &pointcloud_info =
+            gather_info.pointclouds.realize_info[pointcloud_index];
+        if (add_task_always || gather_info.r_tasks.pointcloud_tasks.is_empty()) {
           gather_info.r_tasks.pointcloud_tasks.append({gather_info.r_offsets.pointcloud_offset,
                                                        &pointcloud_info,
                                                        base_transform,
                                                        base_instance_context.pointclouds,
                                                        base_instance_context.id});
-          gather_info.r_offsets.pointcloud_offset += pointcloud->totpoint;
         }
-        break;
+        gather_info.r_offsets.pointcloud_offset += pointcloud->totpoint;
       }
-      case bke::GeometryComponent::Type::Curve: {
-        const auto &curve_component = *static_cast<const bke::CurveComponent *>(component);
-        const Curves *curves = curve_component.get();
-        if (curves != nullptr && curves->geometry.curve_num > 0) {
-          const int curve_index = gather_info.curves.order.index_of(curves);
-          const RealizeCurveInfo &curve_info = gather_info.curves.realize_info[curve_index];
+      break;
+    }
+    case bke::GeometryComponent::Type::Curve: {
+      const auto &curve_component = *static_cast<const bke::CurveComponent *>(component);
+      const Curves *curves = curve_component.get();
+      if (curves != nullptr && curves->geometry.curve_num > 0) {
+        const int curve_index = gather_info.curves.order.index_of(curves);
+        const RealizeCurveInfo &curve_info = gather_info.curves.realize_info[curve_index];
+        if (add_task_always || gather_info.r_tasks.curve_tasks.is_empty()) {
           gather_info.r_tasks.curve_tasks.append({gather_info.r_offsets.curves_offsets,
                                                   &curve_info,
                                                   base_transform,
                                                   base_instance_context.curves,
                                                   base_instance_context.id});
-          gather_info.r_offsets.curves_offsets.point += curves->geometry.point_num;
-          gather_info.r_offsets.curves_offsets.curve += curves->geometry.curve_num;
-        }
-        break;
-      }
-      case bke::GeometryComponent::Type::Instance: {
-        const auto &instances_component = *static_cast<const bke::InstancesComponent *>(component);
-        const Instances *instances = instances_component.get();
-        if (instances != nullptr && instances->instances_num() > 0) {
-          gather_realize_tasks_for_instances(
-              gather_info, *instances, base_transform, base_instance_context);
         }
-        break;
+        gather_info.r_offsets.curves_offsets.point += curves->geometry.point_num;
+        gather_info.r_offsets.curves_offsets.curve += curves->geometry.curve_num;
       }
-      case bke::GeometryComponent::Type::Volume: {
-        const auto *volume_component = static_cast<const bke::VolumeComponent *>(component);
-        if (!gather_info.r_tasks.first_volume) {
-          volume_component->add_user();
-          gather_info.r_tasks.first_volume = ImplicitSharingPtr<const bke::VolumeComponent>(
-              volume_component);
-        }
-        break;
+      break;
+    }
+    case bke::GeometryComponent::Type::Instance: {
+      const auto &instances_component = *static_cast<const bke::InstancesComponent *>(component);
+      const Instances *instances = instances_component.get();
+      if (instances != nullptr && instances->instances_num() > 0) {
+        gather_realize_tasks_for_instances(
+            gather_info, *instances, base_transform, base_instance_context);
       }
-      case bke::GeometryComponent::Type::Edit: {
-        const auto *edit_component = static_cast<const bke::GeometryComponentEditData *>(
-            component);
-        if (!gather_info.r_tasks.first_edit_data) {
-          edit_component->add_user();
-          gather_info.r_tasks.first_edit_data =
-              ImplicitSharingPtr<const bke::GeometryComponentEditData>(edit_component);
-        }
-        break;
+      break;
+    }
+    case bke::GeometryComponent::Type::Volume: {
+      const auto *volume_component = static_cast<const bke::VolumeComponent *>(component);
+      if (!gather_info.r_tasks.first_volume) {
+        volume_component->add_user();
+        gather_info.r_tasks.first_volume = ImplicitSharingPtr<const bke::VolumeComponent>(
+            volume_component);
       }
-      case bke::GeometryComponent::Type::GreasePencil: {
-        /* TODO. Do nothing for now. */
-        break;
+      break;
+    }
+    case bke::GeometryComponent::Type::Edit: {
+      const auto *edit_component = static_cast<const bke::GeometryComponentEditData *>(component);
+      if (!gather_info.r_tasks.first_edit_data) {
+        edit_component->add_user();
+        gather_info.r_tasks.first_edit_data =
+            ImplicitSharingPtr<const bke::GeometryComponentEditData>(edit_component);
       }
+      break;
+    }
+    case bke::GeometryComponent::Type::GreasePencil: {
+      /* TODO. Do nothing for now. */
+      break;
     }
   }
 }
 
+/**
+ * Gather tasks for all geometries in the #geometry_set.
+ */
+static void gather_realize_tasks_recursive(GatherTasksInfo &gather_info,
+                                           const bke::GeometrySet &geometry_set,
+                                           const float4x4 &base_transform,
+                                           const InstanceContext &base_instance_context)
+{
+  for (const bke::GeometryComponent *component : geometry_set.get_components()) {
+    gather_realize_tasks_for_component(
+        gather_info, component, base_transform, base_instance_context);
+  }
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -806,75 +963,80 @@ static void execute_realize_pointcloud_task(
       dst_attribute_writers);
 }
 
-static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &options,
-                                             const AllPointCloudsInfo &all_pointclouds_info,
-                                             const Span<RealizePointCloudTask> tasks,
-                                             const OrderedAttributes &ordered_attributes,
-                                             bke::GeometrySet &r_realized_geometry)
-{
-  if (tasks.is_empty()) {
-    return;
-  }
-
-  const RealizePointCloudTask &last_task = tasks.last();
-  const PointCloud &last_pointcloud = *last_task.pointcloud_info->pointcloud;
-  const int tot_points = last_task.start_index + last_pointcloud.totpoint;
+/** Attributes of the realized point cloud that the tasks write to. */
+struct RealizePointCloudOutput {
+  SpanAttributeWriter<float3> positions;
+  SpanAttributeWriter<int> point_ids;
+  SpanAttributeWriter<float> point_radii;
+  Vector<GSpanAttributeWriter> dst_attribute_writers;
+};
 
+static void prepare_realize_pointcloud_output(const AllPointCloudsInfo &all_pointclouds_info,
+                                              const RealizePointCloudTask &first_task,
+                                              const int tot_points,
+                                              const OrderedAttributes &ordered_attributes,
+                                              bke::GeometrySet &r_realized_geometry,
+                                              RealizePointCloudOutput &r_output)
+{
   /* Allocate new point cloud. */
   PointCloud *dst_pointcloud = BKE_pointcloud_new_nomain(tot_points);
   r_realized_geometry.replace_pointcloud(dst_pointcloud);
   bke::MutableAttributeAccessor dst_attributes = dst_pointcloud->attributes_for_write();
 
-  const RealizePointCloudTask &first_task = tasks.first();
   const PointCloud &first_pointcloud = *first_task.pointcloud_info->pointcloud;
   dst_pointcloud->mat = static_cast<Material **>(MEM_dupallocN(first_pointcloud.mat));
   dst_pointcloud->totcol = first_pointcloud.totcol;
 
-  SpanAttributeWriter<float3> positions = dst_attributes.lookup_or_add_for_write_only_span<float3>(
+  r_output.positions = dst_attributes.lookup_or_add_for_write_only_span<float3>(
       "position", bke::AttrDomain::Point);
 
   /* Prepare id attribute. */
-  SpanAttributeWriter<int> point_ids;
   if (all_pointclouds_info.create_id_attribute) {
-    point_ids = dst_attributes.lookup_or_add_for_write_only_span<int>("id",
-                                                                      bke::AttrDomain::Point);
+    r_output.point_ids = dst_attributes.lookup_or_add_for_write_only_span<int>(
+        "id", bke::AttrDomain::Point);
   }
-  SpanAttributeWriter<float> point_radii;
   if (all_pointclouds_info.create_radius_attribute) {
-    point_radii = dst_attributes.lookup_or_add_for_write_only_span<float>("radius",
-                                                                          bke::AttrDomain::Point);
+    r_output.point_radii = dst_attributes.lookup_or_add_for_write_only_span<float>(
+        "radius", bke::AttrDomain::Point);
   }
 
   /* Prepare generic output attributes. */
-  Vector<GSpanAttributeWriter> dst_attribute_writers;
   for (const int attribute_index : ordered_attributes.index_range()) {
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
-    dst_attribute_writers.append(dst_attributes.lookup_or_add_for_write_only_span(
+    r_output.dst_attribute_writers.append(dst_attributes.lookup_or_add_for_write_only_span(
         attribute_id, bke::AttrDomain::Point, data_type));
   }
+}
 
-  /* Actually execute all tasks. */
+static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &options,
+                                             const Span<RealizePointCloudTask> tasks,
+                                             const OrderedAttributes &ordered_attributes,
+                                             RealizePointCloudOutput &output)
+{
   threading::parallel_for(tasks.index_range(), 100, [&](const IndexRange task_range) {
     for (const int task_index : task_range) {
       const RealizePointCloudTask &task = tasks[task_index];
       execute_realize_pointcloud_task(options,
                                       task,
                                       ordered_attributes,
-                                      dst_attribute_writers,
-                                      point_radii.span,
-                                      point_ids.span,
-                                      positions.span);
+                                      output.dst_attribute_writers,
+                                      output.point_radii.span,
+                                      output.point_ids.span,
+                                      output.positions.span);
     }
   });
+}
 
+static void finish_realize_pointcloud_output(RealizePointCloudOutput &output)
+{
   /* Tag modified attributes. */
-  for (GSpanAttributeWriter &dst_attribute : dst_attribute_writers) {
+  for (GSpanAttributeWriter &dst_attribute : output.dst_attribute_writers) {
     dst_attribute.finish();
   }
-  positions.finish();
-  point_radii.finish();
-  point_ids.finish();
+  output.positions.finish();
+  output.point_radii.finish();
+  output.point_ids.finish();
 }
 
 /** \} */
@@ -1125,35 +1287,39 @@ static void execute_realize_mesh_task(const RealizeInstancesOptions &options,
       dst_attribute_writers);
 }
 
-static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
-                                       const AllMeshesInfo &all_meshes_info,
-                                       const Span<RealizeMeshTask> tasks,
-                                       const OrderedAttributes &ordered_attributes,
-                                       const VectorSet<Material *> &ordered_materials,
-                                       bke::GeometrySet &r_realized_geometry)
-{
-  if (tasks.is_empty()) {
-    return;
-  }
-
-  const RealizeMeshTask &last_task = tasks.last();
-  const Mesh &last_mesh = *last_task.mesh_info->mesh;
-  const int tot_vertices = last_task.start_indices.vertex + last_mesh.verts_num;
-  const int tot_edges = last_task.start_indices.edge + last_mesh.edges_num;
-  const int tot_loops = last_task.start_indices.loop + last_mesh.corners_num;
-  const int tot_faces = last_task.start_indices.face + last_mesh.faces_num;
+/** Data of the realized mesh that the tasks write to. */
+struct RealizeMeshOutput {
+  Mesh *mesh = nullptr;
+  MutableSpan<float3> positions;
+  MutableSpan<int2> edges;
+  MutableSpan<int> face_offsets;
+  MutableSpan<int> corner_verts;
+  MutableSpan<int> corner_edges;
+  SpanAttributeWriter<int> vertex_ids;
+  SpanAttributeWriter<int> material_indices;
+  Vector<GSpanAttributeWriter> dst_attribute_writers;
+};
 
-  Mesh *dst_mesh = BKE_mesh_new_nomain(tot_vertices, tot_edges, tot_faces, tot_loops);
+static void prepare_realize_mesh_output(const AllMeshesInfo &all_meshes_info,
+                                        const RealizeMeshTask &first_task,
+                                        const MeshElementStartIndices &tot_elements,
+                                        const OrderedAttributes &ordered_attributes,
+                                        const VectorSet<Material *> &ordered_materials,
+                                        bke::GeometrySet &r_realized_geometry,
+                                        RealizeMeshOutput &r_output)
+{
+  Mesh *dst_mesh = BKE_mesh_new_nomain(
+      tot_elements.vertex, tot_elements.edge, tot_elements.face, tot_elements.loop);
   r_realized_geometry.replace_mesh(dst_mesh);
+  r_output.mesh = dst_mesh;
   bke::MutableAttributeAccessor dst_attributes = dst_mesh->attributes_for_write();
-  MutableSpan<float3> dst_positions = dst_mesh->vert_positions_for_write();
-  MutableSpan<int2> dst_edges = dst_mesh->edges_for_write();
-  MutableSpan<int> dst_face_offsets = dst_mesh->face_offsets_for_write();
-  MutableSpan<int> dst_corner_verts = dst_mesh->corner_verts_for_write();
-  MutableSpan<int> dst_corner_edges = dst_mesh->corner_edges_for_write();
+  r_output.positions = dst_mesh->vert_positions_for_write();
+  r_output.edges = dst_mesh->edges_for_write();
+  r_output.face_offsets = dst_mesh->face_offsets_for_write();
+  r_output.corner_verts = dst_mesh->corner_verts_for_write();
+  r_output.corner_edges = dst_mesh->corner_edges_for_write();
 
   /* Copy settings from the first input geometry set with a mesh. */
-  const RealizeMeshTask &first_task = tasks.first();
   const Mesh &first_mesh = *first_task.mesh_info->mesh;
   BKE_mesh_copy_parameters_for_eval(dst_mesh, &first_mesh);
   /* The above line also copies vertex group names. We don't want that here because the new
@@ -1167,25 +1333,22 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
   }
 
   /* Prepare id attribute. */
-  SpanAttributeWriter<int> vertex_ids;
   if (all_meshes_info.create_id_attribute) {
-    vertex_ids = dst_attributes.lookup_or_add_for_write_only_span<int>("id",
-                                                                       bke::AttrDomain::Point);
+    r_output.vertex_ids = dst_attributes.lookup_or_add_for_write_only_span<int>(
+        "id", bke::AttrDomain::Point);
   }
   /* Prepare material indices. */
-  SpanAttributeWriter<int> material_indices;
   if (all_meshes_info.create_material_index_attribute) {
-    material_indices = dst_attributes.lookup_or_add_for_write_only_span<int>(
+    r_output.material_indices = dst_attributes.lookup_or_add_for_write_only_span<int>(
         "material_index", bke::AttrDomain::Face);
   }
 
   /* Prepare generic output attributes. */
-  Vector<GSpanAttributeWriter> dst_attribute_writers;
   for (const int attribute_index : ordered_attributes.index_range()) {
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
-    dst_attribute_writers.append(
+    r_output.dst_attribute_writers.append(
         dst_attributes.lookup_or_add_for_write_only_span(attribute_id, domain, data_type));
   }
   const char *active_layer = CustomData_get_active_layer_name(&first_mesh.corner_data,
@@ -1204,39 +1367,49 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
       CustomData_set_layer_render(&dst_mesh->corner_data, CD_PROP_FLOAT2, id);
     }
   }
-  /* Actually execute all tasks. */
+}
+
+static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
+                                       const Span<RealizeMeshTask> tasks,
+                                       const OrderedAttributes &ordered_attributes,
+                                       RealizeMeshOutput &output)
+{
   threading::parallel_for(tasks.index_range(), 100, [&](const IndexRange task_range) {
     for (const int task_index : task_range) {
       const RealizeMeshTask &task = tasks[task_index];
       execute_realize_mesh_task(options,
                                 task,
                                 ordered_attributes,
-                                dst_attribute_writers,
-                                dst_positions,
-                                dst_edges,
-                                dst_face_offsets,
-                                dst_corner_verts,
-                                dst_corner_edges,
-                                vertex_ids.span,
-                                material_indices.span);
+                                output.dst_attribute_writers,
+                                output.positions,
+                                output.edges,
+                                output.face_offsets,
+                                output.corner_verts,
+                                output.corner_edges,
+                                output.vertex_ids.span,
+                                output.material_indices.span);
     }
   });
+}
 
+static void finish_realize_mesh_output(const AllMeshesInfo &all_meshes_info,
+                                       RealizeMeshOutput &output)
+{
   /* Tag modified attributes. */
-  for (GSpanAttributeWriter &dst_attribute : dst_attribute_writers) {
+  for (GSpanAttributeWriter &dst_attribute : output.dst_attribute_writers) {
     dst_attribute.finish();
   }
-  vertex_ids.finish();
-  material_indices.finish();
+  output.vertex_ids.finish();
+  output.material_indices.finish();
 
   if (all_meshes_info.no_loose_edges_hint) {
-    dst_mesh->tag_loose_edges_none();
+    output.mesh->tag_loose_edges_none();
   }
   if (all_meshes_info.no_loose_verts_hint) {
-    dst_mesh->tag_loose_verts_none();
+    output.mesh->tag_loose_verts_none();
   }
   if (all_meshes_info.no_overlapping_hint) {
-    dst_mesh->tag_overlapping_none();
+    output.mesh->tag_overlapping_none();
   }
 }
 
@@ -1462,82 +1635,98 @@ static void execute_realize_curve_task(const RealizeInstancesOptions &options,
       dst_attribute_writers);
 }
 
-static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
-                                        const AllCurvesInfo &all_curves_info,
-                                        const Span<RealizeCurveTask> tasks,
-                                        const OrderedAttributes &ordered_attributes,
-                                        bke::GeometrySet &r_realized_geometry)
-{
-  if (tasks.is_empty()) {
-    return;
-  }
+/** Data of the realized curves that the tasks write to. */
+struct RealizeCurveOutput {
+  bke::CurvesGeometry *curves = nullptr;
+  SpanAttributeWriter<int> point_ids;
+  Vector<GSpanAttributeWriter> dst_attribute_writers;
+  SpanAttributeWriter<float3> handle_left;
+  SpanAttributeWriter<float3> handle_right;
+  SpanAttributeWriter<float> radius;
+  SpanAttributeWriter<float> nurbs_weight;
+  SpanAttributeWriter<int> resolution;
+  SpanAttributeWriter<float3> custom_normal;
 
-  const RealizeCurveTask &last_task = tasks.last();
-  const Curves &last_curves = *last_task.curve_info->curves;
-  const int points_num = last_task.start_indices.point + last_curves.geometry.point_num;
-  const int curves_num = last_task.start_indices.curve + last_curves.geometry.curve_num;
+  /** Tasks can be executed in multiple batches at the same time, see #realize_instances. */
+  std::mutex type_counts_mutex;
+};
+
+static void prepare_realize_curve_output(const AllCurvesInfo &all_curves_info,
+                                         const RealizeCurveTask &first_task,
+                                         const CurvesElementStartIndices &tot_elements,
+                                         const OrderedAttributes &ordered_attributes,
+                                         bke::GeometrySet &r_realized_geometry,
+                                         RealizeCurveOutput &r_output)
+{
+  const int points_num = tot_elements.point;
+  const int curves_num = tot_elements.curve;
 
   /* Allocate new curves data-block. */
   Curves *dst_curves_id = bke::curves_new_nomain(points_num, curves_num);
   bke::CurvesGeometry &dst_curves = dst_curves_id->geometry.wrap();
   dst_curves.offsets_for_write().last() = points_num;
   r_realized_geometry.replace_curves(dst_curves_id);
+  r_output.curves = &dst_curves;
   bke::MutableAttributeAccessor dst_attributes = dst_curves.attributes_for_write();
 
   /* Copy settings from the first input geometry set with curves. */
-  const RealizeCurveTask &first_task = tasks.first();
   const Curves &first_curves_id = *first_task.curve_info->curves;
   bke::curves_copy_parameters(first_curves_id, *dst_curves_id);
 
   /* Prepare id attribute. */
-  SpanAttributeWriter<int> point_ids;
   if (all_curves_info.create_id_attribute) {
-    point_ids = dst_attributes.lookup_or_add_for_write_only_span<int>("id",
-                                                                      bke::AttrDomain::Point);
+    r_output.point_ids = dst_attributes.lookup_or_add_for_write_only_span<int>(
+        "id", bke::AttrDomain::Point);
   }
 
   /* Prepare generic output attributes. */
-  Vector<GSpanAttributeWriter> dst_attribute_writers;
   for (const int attribute_index : ordered_attributes.index_range()) {
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
-    dst_attribute_writers.append(
+    r_output.dst_attribute_writers.append(
         dst_attributes.lookup_or_add_for_write_only_span(attribute_id, domain, data_type));
   }
 
   /* Prepare handle position attributes if necessary. */
-  SpanAttributeWriter<float3> handle_left;
-  SpanAttributeWriter<float3> handle_right;
   if (all_curves_info.create_handle_postion_attributes) {
-    handle_left = dst_attributes.lookup_or_add_for_write_only_span<float3>("handle_left",
-                                                                           bke::AttrDomain::Point);
-    handle_right = dst_attributes.lookup_or_add_for_write_only_span<float3>(
+    r_output.handle_left = dst_attributes.lookup_or_add_for_write_only_span<float3>(
+        "handle_left", bke::AttrDomain::Point);
+    r_output.handle_right = dst_attributes.lookup_or_add_for_write_only_span<float3>(
         "handle_right", bke::AttrDomain::Point);
   }
 
-  SpanAttributeWriter<float> radius;
   if (all_curves_info.create_radius_attribute) {
-    radius = dst_attributes.lookup_or_add_for_write_only_span<float>("radius",
-                                                                     bke::AttrDomain::Point);
+    r_output.radius = dst_attributes.lookup_or_add_for_write_only_span<float>(
+        "radius", bke::AttrDomain::Point);
   }
-  SpanAttributeWriter<float> nurbs_weight;
   if (all_curves_info.create_nurbs_weight_attribute) {
-    nurbs_weight = dst_attributes.lookup_or_add_for_write_only_span<float>("nurbs_weight",
-                                                                           bke::AttrDomain::Point);
+    r_output.nurbs_weight = dst_attributes.lookup_or_add_for_write_only_span<float>(
+        "nurbs_weight", bke::AttrDomain::Point);
   }
-  SpanAttributeWriter<int> resolution;
   if (all_curves_info.create_resolution_attribute) {
-    resolution = dst_attributes.lookup_or_add_for_write_only_span<int>("resolution",
-                                                                       bke::AttrDomain::Curve);
+    r_output.resolution = dst_attributes.lookup_or_add_for_write_only_span<int>(
+        "resolution", bke::AttrDomain::Curve);
   }
-  SpanAttributeWriter<float3> custom_normal;
   if (all_curves_info.create_custom_normal_attribute) {
-    custom_normal = dst_attributes.lookup_or_add_for_write_only_span<float3>(
+    r_output.custom_normal = dst_attributes.lookup_or_add_for_write_only_span<float3>(
         "custom_normal", bke::AttrDomain::Point);
   }
 
-  /* Actually execute all tasks. */
+  /* Type counts have to be updated eagerly, they are accumulated while executing the tasks. */
+  dst_curves.runtime->type_counts.fill(0);
+}
+
+static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
+                                        const AllCurvesInfo &all_curves_info,
+                                        const Span<RealizeCurveTask> tasks,
+                                        const OrderedAttributes &ordered_attributes,
+                                        RealizeCurveOutput &output)
+{
+  if (tasks.is_empty()) {
+    return;
+  }
+
   threading::parallel_for(tasks.index_range(), 100, [&](const IndexRange task_range) {
     for (const int task_index : task_range) {
       const RealizeCurveTask &task = tasks[task_index];
@@ -1545,38 +1734,43 @@ static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
                                  all_curves_info,
                                  task,
                                  ordered_attributes,
-                                 dst_curves,
-                                 dst_attribute_writers,
-                                 point_ids.span,
-                                 handle_left.span,
-                                 handle_right.span,
-                                 radius.span,
-                                 nurbs_weight.span,
-                                 resolution.span,
-                                 custom_normal.span);
+                                 *output.curves,
+                                 output.dst_attribute_writers,
+                                 output.point_ids.span,
+                                 output.handle_left.span,
+                                 output.handle_right.span,
+                                 output.radius.span,
+                                 output.nurbs_weight.span,
+                                 output.resolution.span,
+                                 output.custom_normal.span);
     }
   });
 
-  /* Type counts have to be updated eagerly. */
-  dst_curves.runtime->type_counts.fill(0);
+  std::array<int, CURVE_TYPES_NUM> type_counts{};
   for (const RealizeCurveTask &task : tasks) {
     for (const int i : IndexRange(CURVE_TYPES_NUM)) {
-      dst_curves.runtime->type_counts[i] +=
-          task.curve_info->curves->geometry.runtime->type_counts[i];
+      type_counts[i] += task.curve_info->curves->geometry.runtime->type_counts[i];
     }
   }
+  std::lock_guard lock{output.type_counts_mutex};
+  for (const int i : IndexRange(CURVE_TYPES_NUM)) {
+    output.curves->runtime->type_counts[i] += type_counts[i];
+  }
+}
 
+static void finish_realize_curve_output(RealizeCurveOutput &output)
+{
   /* Tag modified attributes. */
-  for (GSpanAttributeWriter &dst_attribute : dst_attribute_writers) {
+  for (GSpanAttributeWriter &dst_attribute : output.dst_attribute_writers) {
     dst_attribute.finish();
   }
-  point_ids.finish();
-  radius.finish();
-  resolution.finish();
-  nurbs_weight.finish();
-  handle_left.finish();
-  handle_right.finish();
-  custom_normal.finish();
+  output.point_ids.finish();
+  output.radius.finish();
+  output.resolution.finish();
+  output.nurbs_weight.finish();
+  output.handle_left.finish();
+  output.handle_right.finish();
+  output.custom_normal.finish();
 }
 
 /** \} */
@@ -1594,14 +1788,158 @@ static void remove_id_attribute_from_instances(bke::GeometrySet &geometry_set)
   });
 }
 
+/** The realized geometry of every type, only allocated when there are tasks of that type. */
+struct RealizeOutputs {
+  RealizePointCloudOutput pointcloud;
+  RealizeMeshOutput mesh;
+  RealizeCurveOutput curves;
+};
+
+/** Allocate the realized geometry based on the gathered offsets and the first tasks. */
+static void prepare_realize_outputs(const GatherTasksInfo &gather_info,
+                                    bke::GeometrySet &r_realized_geometry,
+                                    RealizeOutputs &r_outputs)
+{
+  const GatherTasks &tasks = gather_info.r_tasks;
+  const GatherOffsets &offsets = gather_info.r_offsets;
+  if (!tasks.pointcloud_tasks.is_empty()) {
+    prepare_realize_pointcloud_output(gather_info.pointclouds,
+                                      tasks.pointcloud_tasks.first(),
+                                      offsets.pointcloud_offset,
+                                      gather_info.pointclouds.attributes,
+                                      r_realized_geometry,
+                                      r_outputs.pointcloud);
+  }
+  if (!tasks.mesh_tasks.is_empty()) {
+    prepare_realize_mesh_output(gather_info.meshes,
+                                tasks.mesh_tasks.first(),
+                                offsets.mesh_offsets,
+                                gather_info.meshes.attributes,
+                                gather_info.meshes.materials,
+                                r_realized_geometry,
+                                r_outputs.mesh);
+  }
+  if (!tasks.curve_tasks.is_empty()) {
+    prepare_realize_curve_output(gather_info.curves,
+                                 tasks.curve_tasks.first(),
+                                 offsets.curves_offsets,
+                                 gather_info.curves.attributes,
+                                 r_realized_geometry,
+                                 r_outputs.curves);
+  }
+}
+
+static void execute_realize_tasks(const RealizeInstancesOptions &options,
+                                  const GatherTasksInfo &gather_info,
+                                  const GatherTasks &tasks,
+                                  RealizeOutputs &outputs)
+{
+  execute_realize_pointcloud_tasks(
+      options, tasks.pointcloud_tasks, gather_info.pointclouds.attributes, outputs.pointcloud);
+  execute_realize_mesh_tasks(
+      options, tasks.mesh_tasks, gather_info.meshes.attributes, outputs.mesh);
+  execute_realize_curve_tasks(options,
+                              gather_info.curves,
+                              tasks.curve_tasks,
+                              gather_info.curves.attributes,
+                              outputs.curves);
+}
+
+static void finish_realize_outputs(const GatherTasksInfo &gather_info, RealizeOutputs &outputs)
+{
+  finish_realize_pointcloud_output(outputs.pointcloud);
+  if (outputs.mesh.mesh) {
+    finish_realize_mesh_output(gather_info.meshes, outputs.mesh);
+  }
+  finish_realize_curve_output(outputs.curves);
+}
+
+/**
+ * Realize a geometry with very many top-level instances without storing the tasks of all of them
+ * at the same time. The instances are only counted first, which is enough to allocate the
+ * realized geometry. Afterwards the tasks are gathered again for every chunk of instances and
+ * executed right away. Otherwise the memory used by the tasks can be similar to the size of the
+ * realized geometry, e.g. when instancing a small mesh millions of times.
+ */
+static void realize_instances_in_chunks(const RealizeInstancesOptions &options,
+                                        const bke::GeometrySet &geometry_set,
+                                        GatherTasksInfo &gather_info,
+                                        const InstanceContext &base_instance_context,
+                                        bke::GeometrySet &r_realized_geometry,
+                                        RealizeOutputs &r_outputs)
+{
+  const float4x4 transform = float4x4::identity();
+  const Instances &instances = *geometry_set.get_instances();
+  const int64_t instances_num = instances.instances_num();
+  const int64_t chunks_num = (instances_num + gather_chunk_size - 1) / gather_chunk_size;
+
+  /* Count the elements of all tasks and remember where the elements of every chunk start. */
+  gather_info.only_count = true;
+  std::optional<InstancesGatherData> instances_data;
+  Array<GatherOffsets> chunk_starts(chunks_num);
+  GatherOffsets offsets_after_instances;
+  for (const bke::GeometryComponent *component : geometry_set.get_components()) {
+    if (component->type() != bke::GeometryComponent::Type::Instance) {
+      gather_realize_tasks_for_component(
+          gather_info, component, transform, base_instance_context);
+      continue;
+    }
+    instances_data.emplace(prepare_instances_gather_data(gather_info, instances));
+    Array<GatherTasksChunk> chunks(chunks_num);
+    foreach_instances_chunk(instances_num, [&](const int64_t chunk_i, const IndexRange range) {
+      GatherTasksChunk &chunk = chunks[chunk_i];
+      GatherTasksInfo chunk_info = chunk_gather_info(gather_info, chunk.temporary_arrays);
+      gather_realize_tasks_for_instance_range(
+          chunk_info, *instances_data, range, transform, base_instance_context);
+      chunk.tasks = std::move(chunk_info.r_tasks);
+      chunk.offsets = chunk_info.r_offsets;
+    });
+    for (const int64_t chunk_i : chunks.index_range()) {
+      chunk_starts[chunk_i] = gather_info.r_offsets;
+      append_gathered_chunk(gather_info, std::move(chunks[chunk_i]));
+    }
+    offsets_after_instances = gather_info.r_offsets;
+  }
+
+  prepare_realize_outputs(gather_info, r_realized_geometry, r_outputs);
+
+  /* Gather the tasks again and execute them directly, chunk by chunk. */
+  Vector<std::unique_ptr<GArray<>>> temporary_arrays;
+  GatherTasksInfo direct_info = chunk_gather_info(gather_info, temporary_arrays);
+  direct_info.only_count = false;
+  const int64_t approximate_used_bytes_num = get_final_points_num(gather_info.r_offsets) * 32;
+  threading::memory_bandwidth_bound_task(approximate_used_bytes_num, [&]() {
+    for (const bke::GeometryComponent *component : geometry_set.get_components()) {
+      if (component->type() != bke::GeometryComponent::Type::Instance) {
+        gather_realize_tasks_for_component(
+            direct_info, component, transform, base_instance_context);
+        continue;
+      }
+      foreach_instances_chunk(instances_num, [&](const int64_t chunk_i, const IndexRange range) {
+        Vector<std::unique_ptr<GArray<>>> chunk_temporary_arrays;
+        GatherTasksInfo chunk_info = chunk_gather_info(direct_info, chunk_temporary_arrays);
+        chunk_info.r_offsets = chunk_starts[chunk_i];
+        gather_realize_tasks_for_instance_range(
+            chunk_info, *instances_data, range, transform, base_instance_context);
+        execute_realize_tasks(options, chunk_info, chunk_info.r_tasks, r_outputs);
+      });
+      direct_info.r_offsets = offsets_after_instances;
+    }
+    execute_realize_tasks(options, direct_info, direct_info.r_tasks, r_outputs);
+  });
+}
+
 bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
                                    const RealizeInstancesOptions &options)
 {
   /* The algorithm works in three steps:
    * 1. Preprocess each unique geometry that is instanced (e.g. each `Mesh`).
    * 2. Gather "tasks" that need to be executed to realize the instances. Each task corresponds to
-   *    instances of the previously preprocessed geometry.
+   *    instances of the previously preprocessed geometry. Large numbers of instances are gathered
+   *    in parallel.
    * 3. Execute all tasks in parallel.
+   * With very many instances, the last two steps are done for one chunk of instances at a time,
+   * see #realize_instances_in_chunks.
    */
 
   if (!geometry_set.has_instances()) {
@@ -1627,32 +1965,28 @@ bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
                                  temporary_arrays};
   const float4x4 transform = float4x4::identity();
   InstanceContext attribute_fallbacks(gather_info);
-  gather_realize_tasks_recursive(gather_info, geometry_set, transform, attribute_fallbacks);
 
   bke::GeometrySet new_geometry_set;
+  RealizeOutputs outputs;
 
-  const int64_t total_points_num = get_final_points_num(gather_info.r_tasks);
-  /* This doesn't have to be exact at all, it's just a rough estimate ot make decisions about
-   * multi-threading (overhead). */
-  const int64_t approximate_used_bytes_num = total_points_num * 32;
-  threading::memory_bandwidth_bound_task(approximate_used_bytes_num, [&]() {
-    execute_realize_pointcloud_tasks(options,
-                                     all_pointclouds_info,
-                                     gather_info.r_tasks.pointcloud_tasks,
-                                     all_pointclouds_info.attributes,
-                                     new_geometry_set);
-    execute_realize_mesh_tasks(options,
-                               all_meshes_info,
-                               gather_info.r_tasks.mesh_tasks,
-                               all_meshes_info.attributes,
-                               all_meshes_info.materials,
-                               new_geometry_set);
-    execute_realize_curve_tasks(options,
-                                all_curves_info,
-                                gather_info.r_tasks.curve_tasks,
-                                all_curves_info.attributes,
-                                new_geometry_set);
-  });
+  if (geometry_set.get_instances()->instances_num() >= realize_in_chunks_min_instances) {
+    realize_instances_in_chunks(
+        options, geometry_set, gather_info, attribute_fallbacks, new_geometry_set, outputs);
+  }
+  else {
+    gather_realize_tasks_recursive(gather_info, geometry_set, transform, attribute_fallbacks);
+    prepare_realize_outputs(gather_info, new_geometry_set, outputs);
+
+    const int64_t total_points_num = get_final_points_num(gather_info.r_offsets);
+    /* This doesn't have to be exact at all, it's just a rough estimate ot make decisions about
+     * multi-threading (overhead). */
+    const int64_t approximate_used_bytes_num = total_points_num * 32;
+    threading::memory_bandwidth_bound_task(approximate_used_bytes_num, [&]() {
+      execute_realize_tasks(options, gather_info, gather_info.r_tasks, outputs);
+    });
+  }
+
+  finish_realize_outputs(gather_info, outputs);
 
   if (gather_info.r_tasks.first_volume) {
     new_geometry_set.add(*gather_info.r_tasks.first_volume);
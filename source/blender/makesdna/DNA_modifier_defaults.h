@@ -561,7 +561,9 @@
   }
 
 #define _DNA_DEFAULT_NodesModifierData \
-  { 0 }
+  { \
+    .output_cache_memory_limit = 256, \
+  }
 
 #define _DNA_DEFAULT_SkinModifierData \
   { \
@@ -2440,6 +2440,7 @@ typedef enum NodesModifierPanelFlag {
 typedef enum NodesModifierBakeFlag {
   NODES_MODIFIER_BAKE_CUSTOM_SIMULATION_FRAME_RANGE = 1 << 0,
   NODES_MODIFIER_BAKE_CUSTOM_PATH = 1 << 1,
+  NODES_MODIFIER_BAKE_COMPRESS = 1 << 2,
 } NodesModifierBakeFlag;
 
 typedef enum NodesModifierBakeMode {
@@ -2462,7 +2463,8 @@ typedef struct NodesModifierData {
   int bakes_num;
   NodesModifierBake *bakes;
 
-  char _pad2[4];
+  /** Memory limit of the output cache in megabytes, see #NODES_MODIFIER_CACHE_OUTPUTS. */
+  int output_cache_memory_limit;
   int panels_num;
   NodesModifierPanel *panels;
 
@@ -2476,6 +2478,8 @@ typedef struct NodesModifierData {
 
 typedef enum NodesModifierFlag {
   NODES_MODIFIER_HIDE_DATABLOCK_SELECTOR = (1 << 0),
+  /** Reuse outputs of expensive nodes whose inputs did not change since the last evaluation. */
+  NODES_MODIFIER_CACHE_OUTPUTS = (1 << 1),
 } NodesModifierFlag;
 
 typedef struct MeshToVolumeModifierData {
@@ -5440,6 +5440,13 @@ static void rna_def_userdef_edit(BlenderRNA *brna)
       "Global undo works by keeping a full copy of the file itself in memory, "
       "so takes extra memory");
 
+  prop = RNA_def_property(srna, "use_global_undo_compression", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "uiflag", USER_GLOBALUNDO_COMPRESS);
+  RNA_def_property_ui_text(prop,
+                           "Compress Global Undo",
+                           "Compress global undo data that was not used recently in the "
+                           "background, using less memory but making undo to older steps slower");
+
   /* auto keyframing */
   prop = RNA_def_property(srna, "use_auto_keying", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, nullptr, "autokey_mode", AUTOKEY_ON);
@@ -92,6 +92,7 @@
 #include "NOD_geometry.hh"
 #include "NOD_geometry_nodes_execute.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_output_cache.hh"
 #include "NOD_node_declaration.hh"
 
 #include "FN_field.hh"
@@ -114,6 +115,7 @@ static void init_data(ModifierData *md)
   MEMCPY_STRUCT_AFTER(nmd, DNA_struct_default_get(NodesModifierData), modifier);
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->output_cache = std::make_shared<nodes::NodeOutputCache>();
 }
 
 static void find_used_ids_from_settings(const NodesModifierSettings &settings, Set<ID *> &ids)
@@ -926,27 +928,6 @@ static BakeFrameIndices get_bake_frame_indices(
   return frame_indices;
 }
 
-static void ensure_bake_loaded(bake::NodeBakeCache &bake_cache, bake::FrameCache &frame_cache)
-{
-  if (!frame_cache.state.items_by_id.is_empty()) {
-    return;
-  }
-  if (!bake_cache.blobs_dir) {
-    return;
-  }
-  if (!frame_cache.meta_path) {
-    return;
-  }
-  bke::bake::DiskBlobReader blob_reader{*bake_cache.blobs_dir};
-  fstream meta_file{*frame_cache.meta_path};
-  std::optional<bke::bake::BakeState> bake_state = bke::bake::deserialize_bake(
-      meta_file, blob_reader, *bake_cache.blob_sharing);
-  if (!bake_state.has_value()) {
-    return;
-  }
-  frame_cache.state = std::move(*bake_state);
-}
-
 static bool try_find_baked_data(bake::NodeBakeCache &bake,
                                 const Main &bmain,
                                 const Object &object,
@@ -1280,8 +1261,8 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
                    bake::SimulationNodeCache &node_cache,
                    nodes::SimulationZoneBehavior &zone_behavior) const
   {
+    node_cache.bake.ensure_frame_loaded(frame_index);
     bake::FrameCache &frame_cache = *node_cache.bake.frames[frame_index];
-    ensure_bake_loaded(node_cache.bake, frame_cache);
     auto &read_single_info = zone_behavior.output.emplace<sim_output::ReadSingle>();
     read_single_info.state = frame_cache.state;
   }
@@ -1291,10 +1272,10 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
                          bake::SimulationNodeCache &node_cache,
                          nodes::SimulationZoneBehavior &zone_behavior) const
   {
+    node_cache.bake.ensure_frame_loaded(prev_frame_index);
+    node_cache.bake.ensure_frame_loaded(next_frame_index);
     bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[prev_frame_index];
     bake::FrameCache &next_frame_cache = *node_cache.bake.frames[next_frame_index];
-    ensure_bake_loaded(node_cache.bake, prev_frame_cache);
-    ensure_bake_loaded(node_cache.bake, next_frame_cache);
     auto &read_interpolated_info = zone_behavior.output.emplace<sim_output::ReadInterpolated>();
     read_interpolated_info.mix_factor = (float(current_frame_) - float(prev_frame_cache.frame)) /
                                         (float(next_frame_cache.frame) -
@@ -1423,8 +1404,8 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
                    bake::BakeNodeCache &node_cache,
                    nodes::BakeNodeBehavior &behavior) const
   {
+    node_cache.bake.ensure_frame_loaded(frame_index);
     bake::FrameCache &frame_cache = *node_cache.bake.frames[frame_index];
-    ensure_bake_loaded(node_cache.bake, frame_cache);
     if (this->check_read_error(frame_cache, behavior)) {
       return;
     }
@@ -1437,10 +1418,10 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
                          bake::BakeNodeCache &node_cache,
                          nodes::BakeNodeBehavior &behavior) const
   {
+    node_cache.bake.ensure_frame_loaded(prev_frame_index);
+    node_cache.bake.ensure_frame_loaded(next_frame_index);
     bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[prev_frame_index];
     bake::FrameCache &next_frame_cache = *node_cache.bake.frames[next_frame_index];
-    ensure_bake_loaded(node_cache.bake, prev_frame_cache);
-    ensure_bake_loaded(node_cache.bake, next_frame_cache);
     if (this->check_read_error(prev_frame_cache, behavior) ||
         this->check_read_error(next_frame_cache, behavior))
     {
@@ -1690,6 +1671,16 @@ static void modifyGeometry(ModifierData *md,
   auto eval_log = std::make_unique<geo_log::GeoModifierLog>();
   call_data.modifier_data = &modifier_eval_data;
 
+  if (nodes::NodeOutputCache *output_cache = nmd->runtime->output_cache.get()) {
+    if (nmd->flag & NODES_MODIFIER_CACHE_OUTPUTS) {
+      output_cache->set_memory_limit(int64_t(nmd->output_cache_memory_limit) * 1024 * 1024);
+      modifier_eval_data.output_cache = output_cache;
+    }
+    else {
+      output_cache->clear();
+    }
+  }
+
   NodesModifierSimulationParams simulation_params(*nmd, *ctx);
   call_data.simulation_params = &simulation_params;
   NodesModifierBakeParams bake_params{*nmd, *ctx};
@@ -1707,6 +1698,11 @@ static void modifyGeometry(ModifierData *md,
   find_side_effect_nodes(*nmd, *ctx, side_effect_nodes);
   call_data.side_effect_nodes = &side_effect_nodes;
 
+  std::optional<nodes::GeoNodesExecutionTrace> execution_trace;
+  if (G.debug & G_DEBUG_GEOMETRY_NODES_TRACE) {
+    call_data.execution_trace = &execution_trace.emplace();
+  }
+
   bke::ModifierComputeContext modifier_compute_context{nullptr, nmd->modifier.name};
 
   geometry_set = nodes::execute_geometry_nodes_on_geometry(tree,
@@ -1719,6 +1715,15 @@ static void modifyGeometry(ModifierData *md,
     nmd_orig->runtime->eval_log = std::move(eval_log);
   }
 
+  if (execution_trace) {
+    /* Print everything at once, so that traces of modifiers evaluated in parallel don't mix. */
+    std::stringstream ss;
+    ss << "Geometry nodes trace of modifier \"" << nmd->modifier.name << "\" on object \""
+       << ctx->object->id.name + 2 << "\":\n";
+    execution_trace->print(ss);
+    std::cout << ss.str();
+  }
+
   if (DEG_is_active(ctx->depsgraph)) {
     add_data_block_items_writeback(*ctx, *nmd, *nmd_orig, simulation_params, bake_params);
   }
@@ -2252,6 +2257,32 @@ static void draw_named_attributes_panel(uiLayout *layout, NodesModifierData &nmd
   }
 }
 
+static void draw_output_cache_panel(uiLayout *layout,
+                                    PointerRNA *modifier_ptr,
+                                    const NodesModifierData &nmd)
+{
+  uiLayout *col = uiLayoutColumn(layout, false);
+  uiLayoutSetPropSep(col, true);
+  uiLayoutSetPropDecorate(col, false);
+  uiItemR(col, modifier_ptr, "use_output_cache", UI_ITEM_NONE, nullptr, ICON_NONE);
+  uiLayout *sub = uiLayoutColumn(col, false);
+  uiLayoutSetActive(sub, nmd.flag & NODES_MODIFIER_CACHE_OUTPUTS);
+  uiItemR(sub, modifier_ptr, "output_cache_memory_limit", UI_ITEM_NONE, nullptr, ICON_NONE);
+
+  if (!(nmd.flag & NODES_MODIFIER_CACHE_OUTPUTS) || !nmd.runtime->output_cache) {
+    return;
+  }
+  const nodes::NodeOutputCache::Stats stats = nmd.runtime->output_cache->stats();
+  char memory_str[BLI_STR_FORMAT_INT64_BYTE_UNIT_SIZE];
+  BLI_str_format_byte_unit(memory_str, stats.memory, true);
+  uiItemL(col,
+          fmt::format(RPT_("{} hits, {} misses"), stats.hits, stats.misses).c_str(),
+          ICON_INFO);
+  uiItemL(col,
+          fmt::format(RPT_("{} cached nodes, {}"), stats.entries_num, memory_str).c_str(),
+          ICON_BLANK1);
+}
+
 static void draw_manage_panel(const bContext *C,
                               uiLayout *layout,
                               PointerRNA *modifier_ptr,
@@ -2267,6 +2298,11 @@ static void draw_manage_panel(const bContext *C,
   {
     draw_named_attributes_panel(panel_layout, nmd);
   }
+  if (uiLayout *panel_layout = uiLayoutPanelProp(
+          C, layout, modifier_ptr, "open_output_cache_panel", IFACE_("Output Cache")))
+  {
+    draw_output_cache_panel(panel_layout, modifier_ptr, nmd);
+  }
 }
 
 static void panel_draw(const bContext *C, Panel *panel)
@@ -2408,6 +2444,7 @@ static void blend_read(BlendDataReader *reader, ModifierData *md)
 
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->output_cache = std::make_shared<nodes::NodeOutputCache>();
 }
 
 static void copy_data(const ModifierData *md, ModifierData *target, const int flag)
@@ -2448,11 +2485,13 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   if (flag & LIB_ID_COPY_SET_COPIED_ON_WRITE) {
     /* Share the simulation cache between the original and evaluated modifier. */
     tnmd->runtime->cache = nmd->runtime->cache;
+    tnmd->runtime->output_cache = nmd->runtime->output_cache;
     /* Keep bake path in the evaluated modifier. */
     tnmd->bake_directory = nmd->bake_directory ? BLI_strdup(nmd->bake_directory) : nullptr;
   }
   else {
     tnmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+    tnmd->runtime->output_cache = std::make_shared<nodes::NodeOutputCache>();
     /* Clear the bake path when duplicating. */
     tnmd->bake_directory = nullptr;
   }
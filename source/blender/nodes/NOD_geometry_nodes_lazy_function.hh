@@ -29,6 +29,7 @@
 #include "NOD_multi_function.hh"
 
 #include "BLI_compute_context.hh"
+#include "BLI_enumerable_thread_specific.hh"
 
 #include "BKE_bake_items.hh"
 #include "BKE_node_tree_zones.hh"
@@ -42,6 +43,8 @@ namespace blender::nodes {
 using lf::LazyFunction;
 using mf::MultiFunction;
 
+class NodeOutputCache;
+
 /** The structs in here describe the different possible behaviors of a simulation input node. */
 namespace sim_input {
 
@@ -154,6 +157,40 @@ struct GeoNodesSideEffectNodes {
   MultiValueMap<std::pair<ComputeContextHash, int32_t>, int> iterations_by_repeat_zone;
 };
 
+/**
+ * Records when and on which thread the nodes of the lazy-function graphs are executed. The
+ * resulting timeline helps finding out why an evaluation does not make use of all threads.
+ */
+class GeoNodesExecutionTrace {
+ public:
+  struct Event {
+    std::string name;
+    geo_eval_log::TimePoint start;
+    geo_eval_log::TimePoint end;
+    /** Number of nodes that were still running on the same thread when this one started. */
+    int depth;
+  };
+
+ private:
+  struct ThreadEvents {
+    Vector<Event> events;
+    /** Indices of the events of the nodes that are currently running on this thread. */
+    Vector<int> running;
+  };
+
+  geo_eval_log::TimePoint start_time_;
+  threading::EnumerableThreadSpecific<ThreadEvents> events_by_thread_;
+
+ public:
+  GeoNodesExecutionTrace();
+
+  void node_execution_begin(const lf::FunctionNode &node);
+  void node_execution_end();
+
+  /** Print the events of every thread ordered by their start time. */
+  void print(std::ostream &stream);
+};
+
 /**
  * Data that is passed into geometry nodes evaluation from the modifier.
  */
@@ -162,6 +199,11 @@ struct GeoNodesModifierData {
   const Object *self_object = nullptr;
   /** Depsgraph that is evaluating the modifier. */
   Depsgraph *depsgraph = nullptr;
+  /**
+   * Optional cache for the outputs of expensive nodes that persists between evaluations of the
+   * modifier.
+   */
+  NodeOutputCache *output_cache = nullptr;
 };
 
 struct GeoNodesOperatorData {
@@ -204,6 +246,10 @@ struct GeoNodesCallData {
    * If this is null, all socket values will be logged.
    */
   const Set<ComputeContextHash> *socket_log_contexts = nullptr;
+  /**
+   * Optional trace of the execution of all nodes, used for debugging performance issues.
+   */
+  GeoNodesExecutionTrace *execution_trace = nullptr;
 
   /**
    * Data from the modifier that is being evaluated.
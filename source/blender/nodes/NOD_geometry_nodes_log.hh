@@ -168,6 +168,14 @@ class ViewerNodeLog {
 using Clock = std::chrono::steady_clock;
 using TimePoint = Clock::time_point;
 
+/** Whether the outputs of a node have been taken from the output cache of the modifier. */
+enum class NodeOutputCacheUsage : int8_t {
+  /** The node does not support caching or its inputs could not be compared. */
+  None,
+  Hit,
+  Miss,
+};
+
 /**
  * Logs all data for a specific geometry node tree in a specific context. When the same node group
  * is used in multiple times each instantiation will have a separate logger.
@@ -193,6 +201,7 @@ class GeoTreeLogger {
     int32_t node_id;
     TimePoint start;
     TimePoint end;
+    NodeOutputCacheUsage cache_usage = NodeOutputCacheUsage::None;
   };
   struct ViewerNodeLogWithNode {
     int32_t node_id;
@@ -240,6 +249,12 @@ class GeoNodeLog {
    * inside.
    */
   std::chrono::nanoseconds run_time{0};
+  /**
+   * Number of times the outputs of the node have been found or not found in the output cache. For
+   * node groups these are the sums of the nodes inside.
+   */
+  int output_cache_hits = 0;
+  int output_cache_misses = 0;
   /** Maps from socket indices to their values. */
   Map<int, ValueLog *> input_values_;
   Map<int, ValueLog *> output_values_;
@@ -279,6 +294,8 @@ class GeoTreeLog {
   Map<int32_t, ViewerNodeLog *, 0> viewer_node_logs;
   Vector<NodeWarning> all_warnings;
   std::chrono::nanoseconds run_time_sum{0};
+  int output_cache_hits_sum = 0;
+  int output_cache_misses_sum = 0;
   Vector<const GeometryAttributeInfo *> existing_attributes;
   Map<StringRefNull, NamedAttributeUsage> used_named_attributes;
 
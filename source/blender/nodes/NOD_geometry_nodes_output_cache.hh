@@ -0,0 +1,152 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup nodes
+ *
+ * The output cache of a Geometry Nodes modifier remembers the outputs of expensive nodes from
+ * previous evaluations. When such a node is evaluated again with the same inputs, e.g. because
+ * only a node further downstream changed, the cached outputs are used instead of executing the
+ * node again.
+ *
+ * Inputs are compared by identity instead of by value where possible, because comparing large
+ * geometries would be almost as expensive as executing the node. A geometry is identified by the
+ * implicitly shared arrays it consists of, together with the version of their sharing info which
+ * changes whenever the data is modified. Fields are compared structurally, which makes common
+ * inputs like the position or index fields comparable between evaluations.
+ */
+
+#include <mutex>
+
+#include "BLI_compute_context.hh"
+#include "BLI_function_ref.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_implicit_sharing.hh"
+#include "BLI_map.hh"
+
+#include "FN_field.hh"
+
+#include "NOD_geometry_nodes_log.hh"
+
+struct bNode;
+
+namespace blender::nodes {
+
+/**
+ * Only nodes whose outputs depend on nothing but their inputs and settings can be cached. Also,
+ * caching is only worth it for nodes that are expensive compared to building the cache key.
+ */
+bool node_supports_output_cache(const bNode &node);
+
+/**
+ * Identifies the evaluation of a node in a specific compute context with specific inputs.
+ */
+class NodeOutputCacheKey {
+ private:
+  /** Describes the node and all inputs that can be compared byte-wise. */
+  std::string data_;
+  /** Fields passed into the node, they are compared with #fn::FieldNode::is_equal_to. */
+  Vector<fn::GField> fields_;
+  /**
+   * Sharing infos whose addresses are part of #data_. The cache keeps a weak user of every
+   * sharing info, so that the address can't be reused for other data.
+   */
+  Vector<const ImplicitSharingInfo *> sharing_infos_;
+  uint64_t hash_ = 0;
+
+  friend class NodeOutputCache;
+
+ public:
+  /**
+   * \param inputs: Values of all inputs of the node's lazy-function.
+   * \param used_outputs: Whether each output of the lazy-function is used.
+   * \return None if some input can't be compared between evaluations.
+   */
+  static std::optional<NodeOutputCacheKey> build(const bNode &node,
+                                                 const ComputeContextHash &context_hash,
+                                                 Span<GPointer> inputs,
+                                                 Span<bool> used_outputs);
+
+  uint64_t hash() const
+  {
+    return hash_;
+  }
+
+  friend bool operator==(const NodeOutputCacheKey &a, const NodeOutputCacheKey &b)
+  {
+    return a.hash_ == b.hash_ && a.data_ == b.data_ && a.fields_ == b.fields_;
+  }
+
+  /**
+   * True when some data the key refers to has been freed. The same inputs can't be passed into
+   * the node anymore then, so a corresponding cache entry will never be used again.
+   */
+  bool is_expired() const;
+};
+
+/**
+ * Cache for the outputs of nodes that is shared between the original and evaluated modifier, so
+ * that it persists between evaluations. All methods are thread-safe.
+ */
+class NodeOutputCache : NonCopyable, NonMovable {
+ public:
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t entries_num = 0;
+    /** Approximate amount of memory used by the cached geometries in bytes. */
+    int64_t memory = 0;
+  };
+
+ private:
+  struct Entry;
+
+  mutable std::mutex mutex_;
+  Map<NodeOutputCacheKey, std::unique_ptr<Entry>> entries_;
+  /** Used to find the least recently used entries when the cache is too large. */
+  uint64_t usage_clock_ = 0;
+  int64_t memory_limit_ = 0;
+  int64_t memory_ = 0;
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+
+ public:
+  NodeOutputCache();
+  ~NodeOutputCache();
+
+  /**
+   * Look up the outputs of the node evaluation identified by the key. On a hit, the callback is
+   * called for every cached output and the warnings of the node are appended to the given vector.
+   *
+   * \param r_warnings: If not null, the warnings the node generated are required, so entries
+   * that have been added without warnings are ignored.
+   */
+  bool lookup(const NodeOutputCacheKey &key,
+              FunctionRef<void(int index, GPointer value)> fn,
+              Vector<geo_eval_log::NodeWarning> *r_warnings);
+
+  /**
+   * Store copies of the given outputs.
+   *
+   * \param warnings: Warnings generated by the node, or none if they were not logged.
+   */
+  void add(NodeOutputCacheKey key,
+           Span<int> output_indices,
+           Span<GPointer> output_values,
+           std::optional<Vector<geo_eval_log::NodeWarning>> warnings);
+
+  /** Remove least recently used entries until the memory usage is below the limit. */
+  void set_memory_limit(int64_t limit);
+
+  void clear();
+
+  Stats stats() const;
+
+ private:
+  void remove_entries_to_fit(int64_t limit);
+};
+
+}  // namespace blender::nodes
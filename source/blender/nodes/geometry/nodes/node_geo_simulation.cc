@@ -864,6 +864,7 @@ static void node_layout_ex(uiLayout *layout, bContext *C, PointerRNA *ptr)
       uiLayoutSetActive(subcol, bake->flag & NODES_MODIFIER_BAKE_CUSTOM_PATH);
       uiItemR(subcol, &bake_rna, "directory", UI_ITEM_NONE, "Path", ICON_NONE);
     }
+    uiItemR(settings_col, &bake_rna, "use_compression", UI_ITEM_NONE, nullptr, ICON_NONE);
     {
       uiLayout *col = uiLayoutColumn(settings_col, true);
       uiItemR(col,
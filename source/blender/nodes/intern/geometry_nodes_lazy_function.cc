@@ -22,6 +22,7 @@
 
 #include "NOD_geometry_exec.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_output_cache.hh"
 #include "NOD_multi_function.hh"
 #include "NOD_node_declaration.hh"
 
@@ -162,6 +163,8 @@ class LazyFunctionForGeometryNode : public LazyFunction {
    * does not have to execute.
    */
   Vector<bool> is_attribute_output_bsocket_;
+  /** Whether the outputs may be stored in the #NodeOutputCache of the modifier. */
+  bool use_output_cache_;
 
   struct OutputAttributeID {
     int bsocket_index;
@@ -177,7 +180,8 @@ class LazyFunctionForGeometryNode : public LazyFunction {
                               GeometryNodesLazyFunctionGraphInfo &own_lf_graph_info)
       : node_(node),
         own_lf_graph_info_(own_lf_graph_info),
-        is_attribute_output_bsocket_(node.output_sockets().size(), false)
+        is_attribute_output_bsocket_(node.output_sockets().size(), false),
+        use_output_cache_(node_supports_output_cache(node))
   {
     BLI_assert(node.typeinfo->geometry_node_execute != nullptr);
     debug_name_ = node.name;
@@ -316,6 +320,17 @@ class LazyFunctionForGeometryNode : public LazyFunction {
       return;
     }
 
+    geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(*user_data);
+    if (NodeOutputCache *output_cache = this->get_output_cache(*user_data)) {
+      if (std::optional<NodeOutputCacheKey> key = this->build_output_cache_key(params,
+                                                                               *user_data))
+      {
+        this->execute_with_output_cache(
+            params, context, *output_cache, std::move(*key), tree_logger, get_output_attribute_id);
+        return;
+      }
+    }
+
     GeoNodeExecParams geo_params{
         node_,
         params,
@@ -328,13 +343,153 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     node_.typeinfo->geometry_node_execute(geo_params);
     geo_eval_log::TimePoint end_time = geo_eval_log::Clock::now();
 
-    if (geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(*user_data))
-    {
+    if (tree_logger) {
       tree_logger->node_execution_times.append(*tree_logger->allocator,
                                                {node_.identifier, start_time, end_time});
     }
   }
 
+  NodeOutputCache *get_output_cache(const GeoNodesLFUserData &user_data) const
+  {
+    if (!use_output_cache_ || user_data.call_data->modifier_data == nullptr) {
+      return nullptr;
+    }
+    return user_data.call_data->modifier_data->output_cache;
+  }
+
+  std::optional<NodeOutputCacheKey> build_output_cache_key(
+      const lf::Params &params, const GeoNodesLFUserData &user_data) const
+  {
+    Array<GPointer> inputs(inputs_.size());
+    for (const int i : inputs_.index_range()) {
+      inputs[i] = {*inputs_[i].type, params.try_get_input_data_ptr(i)};
+    }
+    Array<bool> used_outputs(outputs_.size());
+    for (const int i : outputs_.index_range()) {
+      used_outputs[i] = params.get_output_usage(i) != lf::ValueUsage::Unused;
+    }
+    return NodeOutputCacheKey::build(
+        node_, user_data.compute_context->hash(), inputs, used_outputs);
+  }
+
+  /**
+   * Use the cached outputs if the node has been evaluated with the same inputs before. Otherwise
+   * the node is executed with separate #lf::Params, so that the outputs can be copied into the
+   * cache before they are passed on.
+   */
+  void execute_with_output_cache(lf::Params &params,
+                                 const lf::Context &context,
+                                 NodeOutputCache &output_cache,
+                                 NodeOutputCacheKey key,
+                                 geo_eval_log::GeoTreeLogger *tree_logger,
+                                 FunctionRef<AnonymousAttributeIDPtr(int)> get_output_attribute_id)
+      const
+  {
+    const geo_eval_log::TimePoint start_time = geo_eval_log::Clock::now();
+    LinearAllocator<> allocator;
+    Array<GMutablePointer> outputs(outputs_.size());
+
+    /* The cached values are copied while the cache is locked and are only passed on afterwards,
+     * because setting an output may trigger the evaluation of other nodes. */
+    Vector<geo_eval_log::NodeWarning> cached_warnings;
+    const bool is_hit = output_cache.lookup(
+        key,
+        [&](const int index, const GPointer value) {
+          const CPPType &type = *value.type();
+          void *buffer = allocator.allocate(type.size(), type.alignment());
+          type.copy_construct(value.get(), buffer);
+          outputs[index] = {type, buffer};
+        },
+        tree_logger ? &cached_warnings : nullptr);
+
+    if (is_hit) {
+      if (tree_logger) {
+        for (const geo_eval_log::NodeWarning &warning : cached_warnings) {
+          tree_logger->node_warnings.append(
+              *tree_logger->allocator,
+              {node_.identifier,
+               {warning.type, tree_logger->allocator->copy_string(warning.message)}});
+        }
+      }
+    }
+    else {
+      Array<GMutablePointer> inputs(inputs_.size());
+      for (const int i : inputs_.index_range()) {
+        inputs[i] = {*inputs_[i].type, params.try_get_input_data_ptr(i)};
+      }
+      Array<std::optional<lf::ValueUsage>> input_usages(inputs_.size());
+      Array<lf::ValueUsage> output_usages(outputs_.size());
+      Array<bool> set_outputs(outputs_.size());
+      for (const int i : outputs_.index_range()) {
+        const CPPType &type = *outputs_[i].type;
+        outputs[i] = {type, allocator.allocate(type.size(), type.alignment())};
+        output_usages[i] = params.get_output_usage(i);
+        set_outputs[i] = params.output_was_set(i);
+      }
+      const Array<bool> previously_set_outputs = set_outputs;
+
+      lf::BasicParams node_params{
+          *this, inputs, outputs, input_usages, output_usages, set_outputs};
+      GeoNodeExecParams geo_params{
+          node_,
+          node_params,
+          context,
+          own_lf_graph_info_.mapping.lf_input_index_for_output_bsocket_usage,
+          own_lf_graph_info_.mapping.lf_input_index_for_attribute_propagation_to_output,
+          get_output_attribute_id};
+      node_.typeinfo->geometry_node_execute(geo_params);
+
+      Vector<int> computed_indices;
+      Vector<GPointer> computed_values;
+      for (const int i : outputs_.index_range()) {
+        if (set_outputs[i] && !previously_set_outputs[i]) {
+          computed_indices.append(i);
+          computed_values.append(outputs[i]);
+        }
+        else {
+          outputs[i] = {};
+        }
+      }
+      std::optional<Vector<geo_eval_log::NodeWarning>> warnings;
+      if (tree_logger) {
+        warnings.emplace();
+        for (const geo_eval_log::GeoTreeLogger::WarningWithNode &warning :
+             tree_logger->node_warnings)
+        {
+          if (warning.node_id == node_.identifier) {
+            warnings->append(warning.warning);
+          }
+        }
+      }
+      output_cache.add(std::move(key), computed_indices, computed_values, std::move(warnings));
+    }
+
+    for (const int i : outputs_.index_range()) {
+      GMutablePointer value = outputs[i];
+      if (value.get() == nullptr) {
+        continue;
+      }
+      if (params.output_was_set(i)) {
+        value.destruct();
+        continue;
+      }
+      value.type()->move_construct(value.get(), params.get_output_data_ptr(i));
+      value.destruct();
+      params.output_set(i);
+    }
+
+    const geo_eval_log::TimePoint end_time = geo_eval_log::Clock::now();
+    if (tree_logger) {
+      tree_logger->node_execution_times.append(
+          *tree_logger->allocator,
+          {node_.identifier,
+           start_time,
+           end_time,
+           is_hit ? geo_eval_log::NodeOutputCacheUsage::Hit :
+                    geo_eval_log::NodeOutputCacheUsage::Miss});
+    }
+  }
+
   /**
    * Output the given anonymous attribute id as a field.
    */
@@ -1980,6 +2135,20 @@ class GeometryNodesLazyFunctionLogger : public lf::GraphExecutor::Logger {
     if constexpr (false) {
       this->add_thread_id_debug_message(node, context);
     }
+    const auto &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    if (GeoNodesExecutionTrace *trace = user_data.call_data->execution_trace) {
+      trace->node_execution_begin(node);
+    }
+  }
+
+  void log_after_node_execute(const lf::FunctionNode & /*node*/,
+                              const lf::Params & /*params*/,
+                              const lf::Context &context) const override
+  {
+    const auto &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    if (GeoNodesExecutionTrace *trace = user_data.call_data->execution_trace) {
+      trace->node_execution_end();
+    }
   }
 
   void add_thread_id_debug_message(const lf::FunctionNode &node, const lf::Context &context) const
@@ -4323,6 +4492,59 @@ std::optional<FoundNestedNodeID> find_nested_node_id(const GeoNodesLFUserData &u
   return found;
 }
 
+GeoNodesExecutionTrace::GeoNodesExecutionTrace() : start_time_(geo_eval_log::Clock::now()) {}
+
+void GeoNodesExecutionTrace::node_execution_begin(const lf::FunctionNode &node)
+{
+  ThreadEvents &thread_events = events_by_thread_.local();
+  const int depth = thread_events.running.size();
+  thread_events.running.append(thread_events.events.size());
+  thread_events.events.append({node.name(), geo_eval_log::Clock::now(), {}, depth});
+}
+
+void GeoNodesExecutionTrace::node_execution_end()
+{
+  ThreadEvents &thread_events = events_by_thread_.local();
+  const int event_index = thread_events.running.pop_last();
+  thread_events.events[event_index].end = geo_eval_log::Clock::now();
+}
+
+void GeoNodesExecutionTrace::print(std::ostream &stream)
+{
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  const auto to_ms = [&](const geo_eval_log::TimePoint time) {
+    return Milliseconds(time - start_time_).count();
+  };
+  int thread_index = 0;
+  for (const ThreadEvents &thread_events : events_by_thread_) {
+    if (thread_events.events.is_empty()) {
+      continue;
+    }
+    /* Nodes that run on the same thread at the same time are nested in each other, e.g. nodes in
+     * a node group, so only the outermost ones count towards the busy time. Events are already
+     * sorted by their start time, because they are added when the node starts. */
+    double busy_time = 0.0;
+    for (const Event &event : thread_events.events) {
+      if (event.depth == 0) {
+        busy_time += Milliseconds(event.end - event.start).count();
+      }
+    }
+    stream << fmt::format("Thread {}: {} nodes, busy for {:.3f} ms\n",
+                          thread_index,
+                          thread_events.events.size(),
+                          busy_time);
+    for (const Event &event : thread_events.events) {
+      stream << fmt::format("  {:10.3f} - {:10.3f} ms  {:{}}{}\n",
+                            to_ms(event.start),
+                            to_ms(event.end),
+                            "",
+                            event.depth * 2,
+                            event.name);
+    }
+    thread_index++;
+  }
+}
+
 const Object *GeoNodesCallData::self_object() const
 {
   if (this->modifier_data) {
@@ -263,8 +263,17 @@ void GeoTreeLog::ensure_node_run_time()
   for (GeoTreeLogger *tree_logger : tree_loggers_) {
     for (const GeoTreeLogger::NodeExecutionTime &timings : tree_logger->node_execution_times) {
       const std::chrono::nanoseconds duration = timings.end - timings.start;
-      this->nodes.lookup_or_add_default_as(timings.node_id).run_time += duration;
+      GeoNodeLog &node_log = this->nodes.lookup_or_add_default_as(timings.node_id);
+      node_log.run_time += duration;
       this->run_time_sum += duration;
+      if (timings.cache_usage == NodeOutputCacheUsage::Hit) {
+        node_log.output_cache_hits++;
+        this->output_cache_hits_sum++;
+      }
+      else if (timings.cache_usage == NodeOutputCacheUsage::Miss) {
+        node_log.output_cache_misses++;
+        this->output_cache_misses_sum++;
+      }
     }
   }
   for (const ComputeContextHash &child_hash : children_hashes_) {
@@ -275,9 +284,14 @@ void GeoTreeLog::ensure_node_run_time()
     child_log.ensure_node_run_time();
     const std::optional<int32_t> &group_node_id = child_log.tree_loggers_[0]->group_node_id;
     if (group_node_id.has_value()) {
-      this->nodes.lookup_or_add_default(*group_node_id).run_time += child_log.run_time_sum;
+      GeoNodeLog &node_log = this->nodes.lookup_or_add_default(*group_node_id);
+      node_log.run_time += child_log.run_time_sum;
+      node_log.output_cache_hits += child_log.output_cache_hits_sum;
+      node_log.output_cache_misses += child_log.output_cache_misses_sum;
     }
     this->run_time_sum += child_log.run_time_sum;
+    this->output_cache_hits_sum += child_log.output_cache_hits_sum;
+    this->output_cache_misses_sum += child_log.output_cache_misses_sum;
   }
   reduced_node_run_times_ = true;
 }
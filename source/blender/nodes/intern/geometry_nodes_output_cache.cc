@@ -0,0 +1,563 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_set.hh"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_anonymous_attribute_id.hh"
+#include "BKE_curves.hh"
+#include "BKE_customdata.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_instances.hh"
+#include "BKE_mesh_types.hh"
+#include "BKE_node.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "NOD_geometry_nodes_output_cache.hh"
+
+namespace blender::nodes {
+
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+bool node_supports_output_cache(const bNode &node)
+{
+  switch (node.type) {
+    case GEO_NODE_CONVEX_HULL:
+    case GEO_NODE_CURVE_TO_MESH:
+    case GEO_NODE_DISTRIBUTE_POINTS_ON_FACES:
+    case GEO_NODE_DUAL_MESH:
+    case GEO_NODE_EXTRUDE_MESH:
+    case GEO_NODE_FILL_CURVE:
+    case GEO_NODE_INSTANCE_ON_POINTS:
+    case GEO_NODE_MERGE_BY_DISTANCE:
+    case GEO_NODE_MESH_BOOLEAN:
+    case GEO_NODE_MESH_TO_POINTS:
+    case GEO_NODE_REALIZE_INSTANCES:
+    case GEO_NODE_RESAMPLE_CURVE:
+    case GEO_NODE_SUBDIVIDE_MESH:
+    case GEO_NODE_SUBDIVISION_SURFACE:
+    case GEO_NODE_TRIANGULATE:
+      return true;
+  }
+  return false;
+}
+
+namespace {
+
+class KeyBuilder {
+ public:
+  std::string data;
+  Vector<fn::GField> fields;
+  Vector<const ImplicitSharingInfo *> sharing_infos;
+
+  template<typename T> void add(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void add_string(const StringRef str)
+  {
+    this->add(str.size());
+    data.append(str.data(), str.size());
+  }
+
+  /**
+   * Shared data is identified by its sharing info instead of by its content. The version of the
+   * sharing info changes when the data is modified in place.
+   */
+  bool add_shared_data(const ImplicitSharingInfo *sharing_info, const void *shared_data)
+  {
+    this->add(shared_data);
+    if (shared_data == nullptr) {
+      return true;
+    }
+    if (sharing_info == nullptr) {
+      return false;
+    }
+    this->add(sharing_info);
+    this->add(sharing_info->version());
+    sharing_infos.append(sharing_info);
+    return true;
+  }
+
+  bool add_custom_data(const CustomData &custom_data, const int elems_num)
+  {
+    this->add(elems_num);
+    this->add(custom_data.totlayer);
+    for (const CustomDataLayer &layer : Span(custom_data.layers, custom_data.totlayer)) {
+      this->add(layer.type);
+      this->add(layer.flag);
+      this->add(layer.active);
+      this->add(layer.active_rnd);
+      this->add_string(layer.name);
+      if (!this->add_shared_data(layer.sharing_info, layer.data)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void add_materials(const Span<const Material *> materials)
+  {
+    this->add(materials.size());
+    for (const Material *material : materials) {
+      this->add(material);
+    }
+  }
+
+  void add_vertex_group_names(const ListBase &vertex_group_names)
+  {
+    this->add(BLI_listbase_count(&vertex_group_names));
+    LISTBASE_FOREACH (const bDeformGroup *, group, &vertex_group_names) {
+      this->add_string(group->name);
+    }
+  }
+
+  bool add_mesh(const Mesh &mesh)
+  {
+    if (mesh.runtime->wrapper_type != ME_WRAPPER_TYPE_MDATA) {
+      return false;
+    }
+    this->add(mesh.faces_num);
+    if (!this->add_shared_data(mesh.runtime->face_offsets_sharing_info, mesh.face_offset_indices))
+    {
+      return false;
+    }
+    if (!this->add_custom_data(mesh.vert_data, mesh.verts_num) ||
+        !this->add_custom_data(mesh.edge_data, mesh.edges_num) ||
+        !this->add_custom_data(mesh.face_data, mesh.faces_num) ||
+        !this->add_custom_data(mesh.corner_data, mesh.corners_num))
+    {
+      return false;
+    }
+    this->add_materials({mesh.mat, mesh.totcol});
+    this->add_vertex_group_names(mesh.vertex_group_names);
+    this->add_string(mesh.active_color_attribute ? mesh.active_color_attribute : "");
+    this->add_string(mesh.default_color_attribute ? mesh.default_color_attribute : "");
+    return true;
+  }
+
+  bool add_curves(const Curves &curves_id)
+  {
+    const bke::CurvesGeometry &curves = curves_id.geometry.wrap();
+    this->add(curves.curve_num);
+    if (!this->add_shared_data(curves.runtime->curve_offsets_sharing_info,
+                               curves.curve_offsets))
+    {
+      return false;
+    }
+    if (!this->add_custom_data(curves.point_data, curves.point_num) ||
+        !this->add_custom_data(curves.curve_data, curves.curve_num))
+    {
+      return false;
+    }
+    this->add_vertex_group_names(curves.vertex_group_names);
+    this->add_materials({curves_id.mat, curves_id.totcol});
+    this->add(curves_id.surface);
+    return true;
+  }
+
+  bool add_pointcloud(const PointCloud &pointcloud)
+  {
+    if (!this->add_custom_data(pointcloud.pdata, pointcloud.totpoint)) {
+      return false;
+    }
+    this->add_materials({pointcloud.mat, pointcloud.totcol});
+    return true;
+  }
+
+  bool add_instances(const bke::Instances &instances)
+  {
+    if (!this->add_custom_data(instances.custom_data_attributes(), instances.instances_num())) {
+      return false;
+    }
+    this->add(instances.references_num());
+    for (const bke::InstanceReference &reference : instances.references()) {
+      this->add(reference.type());
+      switch (reference.type()) {
+        case bke::InstanceReference::Type::None:
+          break;
+        case bke::InstanceReference::Type::Object:
+        case bke::InstanceReference::Type::Collection:
+          /* The referenced data-blocks can change without the reference changing. */
+          return false;
+        case bke::InstanceReference::Type::GeometrySet:
+          if (!this->add_geometry(reference.geometry_set())) {
+            return false;
+          }
+          break;
+      }
+    }
+    return true;
+  }
+
+  bool add_geometry(const GeometrySet &geometry)
+  {
+    if (geometry.has_volume() || geometry.has_grease_pencil() ||
+        geometry.has<bke::GeometryComponentEditData>())
+    {
+      return false;
+    }
+    const Mesh *mesh = geometry.get_mesh();
+    this->add(mesh != nullptr);
+    if (mesh && !this->add_mesh(*mesh)) {
+      return false;
+    }
+    const Curves *curves = geometry.get_curves();
+    this->add(curves != nullptr);
+    if (curves && !this->add_curves(*curves)) {
+      return false;
+    }
+    const PointCloud *pointcloud = geometry.get_pointcloud();
+    this->add(pointcloud != nullptr);
+    if (pointcloud && !this->add_pointcloud(*pointcloud)) {
+      return false;
+    }
+    const bke::Instances *instances = geometry.get_instances();
+    this->add(instances != nullptr);
+    if (instances && !this->add_instances(*instances)) {
+      return false;
+    }
+    return true;
+  }
+
+  bool add_socket_value(const SocketValueVariant &value)
+  {
+    if (value.is_context_dependent_field()) {
+      this->add(fields.size());
+      fields.append(value.get<fn::GField>());
+      return true;
+    }
+    SocketValueVariant single_value = value;
+    single_value.convert_to_single();
+    const GPointer ptr = single_value.get_single_ptr();
+    const CPPType &type = *ptr.type();
+    this->add(&type);
+    if (type.is<std::string>()) {
+      this->add_string(*static_cast<const std::string *>(ptr.get()));
+      return true;
+    }
+    if (!type.is_trivial()) {
+      return false;
+    }
+    data.append(static_cast<const char *>(ptr.get()), type.size());
+    return true;
+  }
+
+  void add_attribute_set(const bke::AnonymousAttributeSet &set)
+  {
+    if (!set.names) {
+      this->add(-1);
+      return;
+    }
+    Vector<StringRef> names(set.names->begin(), set.names->end());
+    std::sort(names.begin(), names.end());
+    this->add(int(names.size()));
+    for (const StringRef name : names) {
+      this->add_string(name);
+    }
+  }
+
+  bool add_value(const GPointer value)
+  {
+    const CPPType &type = *value.type();
+    if (type.is<bool>()) {
+      this->add(*static_cast<const bool *>(value.get()));
+      return true;
+    }
+    if (type.is<SocketValueVariant>()) {
+      return this->add_socket_value(*static_cast<const SocketValueVariant *>(value.get()));
+    }
+    if (type.is<GeometrySet>()) {
+      return this->add_geometry(*static_cast<const GeometrySet *>(value.get()));
+    }
+    if (type.is<bke::AnonymousAttributeSet>()) {
+      this->add_attribute_set(*static_cast<const bke::AnonymousAttributeSet *>(value.get()));
+      return true;
+    }
+    /* Multi-input sockets. */
+    if (type.is<Vector<GeometrySet>>()) {
+      const Vector<GeometrySet> &geometries = *static_cast<const Vector<GeometrySet> *>(
+          value.get());
+      this->add(geometries.size());
+      for (const GeometrySet &geometry : geometries) {
+        if (!this->add_geometry(geometry)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (type.is<Vector<SocketValueVariant>>()) {
+      const Vector<SocketValueVariant> &values = *static_cast<const Vector<SocketValueVariant> *>(
+          value.get());
+      this->add(values.size());
+      for (const SocketValueVariant &value : values) {
+        if (!this->add_socket_value(value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    /* Data-block pointers are not supported, because the data-blocks may have changed. */
+    return false;
+  }
+
+  void add_node_settings(const bNode &node)
+  {
+    this->add_string(node.idname);
+    this->add(node.custom1);
+    this->add(node.custom2);
+    this->add(node.custom3);
+    this->add(node.custom4);
+    if (node.storage) {
+      const size_t storage_size = MEM_allocN_len(node.storage);
+      this->add(storage_size);
+      data.append(static_cast<const char *>(node.storage), storage_size);
+    }
+  }
+};
+
+}  // namespace
+
+std::optional<NodeOutputCacheKey> NodeOutputCacheKey::build(const bNode &node,
+                                                            const ComputeContextHash &context_hash,
+                                                            const Span<GPointer> inputs,
+                                                            const Span<bool> used_outputs)
+{
+  KeyBuilder builder;
+  builder.add(context_hash);
+  builder.add(node.identifier);
+  builder.add_node_settings(node);
+  for (const GPointer input : inputs) {
+    if (!builder.add_value(input)) {
+      return std::nullopt;
+    }
+  }
+  for (const bool used : used_outputs) {
+    builder.add(used);
+  }
+
+  NodeOutputCacheKey key;
+  key.data_ = std::move(builder.data);
+  key.fields_ = std::move(builder.fields);
+  key.sharing_infos_ = std::move(builder.sharing_infos);
+  key.hash_ = get_default_hash(StringRef(key.data_));
+  for (const fn::GField &field : key.fields_) {
+    key.hash_ = get_default_hash(key.hash_, field.hash());
+  }
+  return key;
+}
+
+bool NodeOutputCacheKey::is_expired() const
+{
+  for (const ImplicitSharingInfo *sharing_info : sharing_infos_) {
+    if (sharing_info->is_expired()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void count_custom_data_memory(const CustomData &custom_data,
+                                     const int elems_num,
+                                     Set<const void *> &counted_data,
+                                     int64_t &r_memory)
+{
+  for (const CustomDataLayer &layer : Span(custom_data.layers, custom_data.totlayer)) {
+    if (layer.data && counted_data.add(layer.data)) {
+      r_memory += int64_t(CustomData_get_elem_size(&layer)) * elems_num;
+    }
+  }
+}
+
+/**
+ * Arrays that are shared between multiple geometries are only counted once, but the same array
+ * may still be counted for multiple cache entries.
+ */
+static void count_geometry_memory(const GeometrySet &geometry,
+                                  Set<const void *> &counted_data,
+                                  int64_t &r_memory)
+{
+  if (const Mesh *mesh = geometry.get_mesh()) {
+    if (mesh->face_offset_indices && counted_data.add(mesh->face_offset_indices)) {
+      r_memory += int64_t(mesh->faces_num + 1) * sizeof(int);
+    }
+    count_custom_data_memory(mesh->vert_data, mesh->verts_num, counted_data, r_memory);
+    count_custom_data_memory(mesh->edge_data, mesh->edges_num, counted_data, r_memory);
+    count_custom_data_memory(mesh->face_data, mesh->faces_num, counted_data, r_memory);
+    count_custom_data_memory(mesh->corner_data, mesh->corners_num, counted_data, r_memory);
+  }
+  if (const Curves *curves_id = geometry.get_curves()) {
+    const bke::CurvesGeometry &curves = curves_id->geometry.wrap();
+    if (curves.curve_offsets && counted_data.add(curves.curve_offsets)) {
+      r_memory += int64_t(curves.curve_num + 1) * sizeof(int);
+    }
+    count_custom_data_memory(curves.point_data, curves.point_num, counted_data, r_memory);
+    count_custom_data_memory(curves.curve_data, curves.curve_num, counted_data, r_memory);
+  }
+  if (const PointCloud *pointcloud = geometry.get_pointcloud()) {
+    count_custom_data_memory(pointcloud->pdata, pointcloud->totpoint, counted_data, r_memory);
+  }
+  if (const bke::Instances *instances = geometry.get_instances()) {
+    count_custom_data_memory(
+        instances->custom_data_attributes(), instances->instances_num(), counted_data, r_memory);
+    instances->foreach_referenced_geometry([&](const GeometrySet &instance_geometry) {
+      count_geometry_memory(instance_geometry, counted_data, r_memory);
+    });
+  }
+}
+
+struct NodeOutputCache::Entry {
+  Vector<int> output_indices;
+  Vector<GMutablePointer> output_values;
+  std::optional<Vector<geo_eval_log::NodeWarning>> warnings;
+  /** The entry is a weak user of the sharing infos referenced by its key. */
+  Vector<const ImplicitSharingInfo *> sharing_infos;
+  int64_t memory = 0;
+  uint64_t last_used = 0;
+
+  ~Entry()
+  {
+    for (GMutablePointer value : output_values) {
+      value.destruct();
+      MEM_freeN(value.get());
+    }
+    for (const ImplicitSharingInfo *sharing_info : sharing_infos) {
+      sharing_info->remove_weak_user_and_delete_if_last();
+    }
+  }
+};
+
+NodeOutputCache::NodeOutputCache() = default;
+
+NodeOutputCache::~NodeOutputCache() = default;
+
+bool NodeOutputCache::lookup(const NodeOutputCacheKey &key,
+                             const FunctionRef<void(int index, GPointer value)> fn,
+                             Vector<geo_eval_log::NodeWarning> *r_warnings)
+{
+  std::lock_guard lock{mutex_};
+  std::unique_ptr<Entry> *entry_ptr = entries_.lookup_ptr(key);
+  if (entry_ptr == nullptr || (r_warnings && !(*entry_ptr)->warnings.has_value())) {
+    misses_++;
+    return false;
+  }
+  Entry &entry = **entry_ptr;
+  entry.last_used = ++usage_clock_;
+  for (const int i : entry.output_indices.index_range()) {
+    fn(entry.output_indices[i], entry.output_values[i]);
+  }
+  if (r_warnings) {
+    r_warnings->extend(*entry.warnings);
+  }
+  hits_++;
+  return true;
+}
+
+void NodeOutputCache::add(NodeOutputCacheKey key,
+                          const Span<int> output_indices,
+                          const Span<GPointer> output_values,
+                          std::optional<Vector<geo_eval_log::NodeWarning>> warnings)
+{
+  auto entry = std::make_unique<Entry>();
+  entry->output_indices = output_indices;
+  Set<const void *> counted_data;
+  for (const GPointer value : output_values) {
+    const CPPType &type = *value.type();
+    void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+    type.copy_construct(value.get(), buffer);
+    entry->output_values.append({type, buffer});
+    if (type.is<GeometrySet>()) {
+      const GeometrySet &geometry = *static_cast<const GeometrySet *>(buffer);
+      count_geometry_memory(geometry, counted_data, entry->memory);
+    }
+  }
+  entry->warnings = std::move(warnings);
+  for (const ImplicitSharingInfo *sharing_info : key.sharing_infos_) {
+    sharing_info->add_weak_user();
+  }
+  entry->sharing_infos = key.sharing_infos_;
+
+  std::lock_guard lock{mutex_};
+  if (entry->memory > memory_limit_) {
+    return;
+  }
+  /* Entries for inputs that don't exist anymore can't be used again. */
+  entries_.remove_if([&](const auto &item) {
+    if (item.key.is_expired()) {
+      memory_ -= item.value->memory;
+      return true;
+    }
+    return false;
+  });
+  this->remove_entries_to_fit(memory_limit_ - entry->memory);
+
+  entry->last_used = ++usage_clock_;
+  /* An existing entry may not have the warnings that are required now. */
+  if (const std::unique_ptr<Entry> *old_entry = entries_.lookup_ptr(key)) {
+    memory_ -= (*old_entry)->memory;
+  }
+  memory_ += entry->memory;
+  entries_.add_overwrite(std::move(key), std::move(entry));
+}
+
+void NodeOutputCache::remove_entries_to_fit(const int64_t limit)
+{
+  if (memory_ <= limit) {
+    return;
+  }
+  Vector<std::pair<uint64_t, int64_t>> usage_and_memory;
+  for (const std::unique_ptr<Entry> &entry : entries_.values()) {
+    usage_and_memory.append({entry->last_used, entry->memory});
+  }
+  std::sort(usage_and_memory.begin(), usage_and_memory.end());
+  uint64_t last_used_threshold = 0;
+  for (const auto &[last_used, memory] : usage_and_memory) {
+    if (memory_ <= limit) {
+      break;
+    }
+    memory_ -= memory;
+    last_used_threshold = last_used;
+  }
+  entries_.remove_if(
+      [&](const auto &item) { return item.value->last_used <= last_used_threshold; });
+}
+
+void NodeOutputCache::set_memory_limit(const int64_t limit)
+{
+  std::lock_guard lock{mutex_};
+  memory_limit_ = limit;
+  this->remove_entries_to_fit(limit);
+}
+
+void NodeOutputCache::clear()
+{
+  std::lock_guard lock{mutex_};
+  entries_.clear();
+  memory_ = 0;
+  hits_ = 0;
+  misses_ = 0;
+}
+
+NodeOutputCache::Stats NodeOutputCache::stats() const
+{
+  std::lock_guard lock{mutex_};
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.entries_num = entries_.size();
+  stats.memory = memory_;
+  return stats;
+}
+
+}  // namespace blender::nodes
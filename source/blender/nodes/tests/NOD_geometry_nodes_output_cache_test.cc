@@ -0,0 +1,227 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <array>
+
+#include "BLI_math_vector_types.hh"
+#include "BLI_string.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_node_types.h"
+
+#include "BKE_cpp_types.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_mesh.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "CLG_log.h"
+
+#include "NOD_geometry_nodes_output_cache.hh"
+
+namespace blender::nodes::tests {
+
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+class NodeOutputCacheTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_cpp_types_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+};
+
+/**
+ * Mimics the inputs of a mesh node: a geometry, a float that depends on the current frame (e.g.
+ * the output of a Scene Time node) and a boolean.
+ */
+struct NodeInputs {
+  GeometrySet geometry;
+  SocketValueVariant frame;
+  bool selection = true;
+
+  NodeInputs(GeometrySet geometry_value, const float frame_value)
+      : geometry(std::move(geometry_value)), frame(frame_value)
+  {
+  }
+
+  Array<GPointer> pointers() const
+  {
+    return {GPointer(&geometry), GPointer(&frame), GPointer(&selection)};
+  }
+};
+
+static bNode create_node(const int identifier)
+{
+  bNode node{};
+  STRNCPY(node.idname, "GeometryNodeSubdivideMesh");
+  node.identifier = identifier;
+  return node;
+}
+
+static GeometrySet create_mesh_geometry()
+{
+  Mesh *mesh = BKE_mesh_new_nomain(4, 0, 0, 0);
+  mesh->vert_positions_for_write().fill(float3(0.0f));
+  return GeometrySet::from_mesh(mesh);
+}
+
+static NodeOutputCacheKey build_key(const bNode &node,
+                                    const ComputeContextHash &context_hash,
+                                    const NodeInputs &inputs)
+{
+  const std::array<bool, 1> used_outputs = {true};
+  std::optional<NodeOutputCacheKey> key = NodeOutputCacheKey::build(
+      node, context_hash, inputs.pointers(), used_outputs);
+  EXPECT_TRUE(key.has_value());
+  return std::move(*key);
+}
+
+/** Caches a single integer output for the key. */
+static void add_to_cache(NodeOutputCache &cache, NodeOutputCacheKey key, const int value)
+{
+  const SocketValueVariant output(value);
+  const std::array<int, 1> output_indices = {0};
+  const std::array<GPointer, 1> output_values = {GPointer(&output)};
+  cache.add(std::move(key), output_indices, output_values, std::nullopt);
+}
+
+/** \return The cached integer output for the key, or -1 if there is no cache entry. */
+static int lookup_in_cache(NodeOutputCache &cache, const NodeOutputCacheKey &key)
+{
+  int result = -1;
+  cache.lookup(
+      key,
+      [&](const int /*index*/, const GPointer value) {
+        result = static_cast<const SocketValueVariant *>(value.get())->get<int>();
+      },
+      nullptr);
+  return result;
+}
+
+TEST_F(NodeOutputCacheTest, HitWithUnchangedInputs)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+  const bNode node = create_node(1);
+  const ComputeContextHash context_hash{1, 2};
+  const NodeInputs inputs(create_mesh_geometry(), 1.0f);
+
+  add_to_cache(cache, build_key(node, context_hash, inputs), 42);
+
+  /* A second evaluation with the same data builds an equal key. */
+  const NodeInputs same_inputs(inputs.geometry, 1.0f);
+  const NodeOutputCacheKey key = build_key(node, context_hash, same_inputs);
+  EXPECT_EQ(lookup_in_cache(cache, key), 42);
+  EXPECT_EQ(lookup_in_cache(cache, key), 42);
+
+  const NodeOutputCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 2);
+  EXPECT_EQ(stats.misses, 0);
+  EXPECT_EQ(stats.entries_num, 1);
+}
+
+TEST_F(NodeOutputCacheTest, MissWithChangedInput)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+  const bNode node = create_node(1);
+  const ComputeContextHash context_hash{1, 2};
+  NodeInputs inputs(create_mesh_geometry(), 1.0f);
+  add_to_cache(cache, build_key(node, context_hash, inputs), 42);
+
+  /* The same arrays, but modified in place. */
+  Mesh *mesh = inputs.geometry.get_mesh_for_write();
+  const float3 *positions_data = mesh->vert_positions().data();
+  mesh->vert_positions_for_write().fill(float3(1.0f));
+  EXPECT_EQ(mesh->vert_positions().data(), positions_data);
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, inputs)), -1);
+
+  /* A geometry with the same content but different arrays. */
+  const NodeInputs other_geometry(create_mesh_geometry(), 1.0f);
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, other_geometry)), -1);
+
+  /* Different single value. */
+  NodeInputs changed_selection(other_geometry.geometry, 1.0f);
+  add_to_cache(cache, build_key(node, context_hash, changed_selection), 43);
+  changed_selection.selection = false;
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, changed_selection)), -1);
+
+  EXPECT_EQ(cache.stats().hits, 0);
+  EXPECT_EQ(cache.stats().misses, 3);
+}
+
+TEST_F(NodeOutputCacheTest, MissWithChangedNodeTree)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+  const bNode node = create_node(1);
+  const ComputeContextHash context_hash{1, 2};
+  const NodeInputs inputs(create_mesh_geometry(), 1.0f);
+  add_to_cache(cache, build_key(node, context_hash, inputs), 42);
+
+  /* Changed node setting. */
+  bNode changed_node = create_node(1);
+  changed_node.custom1 = 1;
+  EXPECT_EQ(lookup_in_cache(cache, build_key(changed_node, context_hash, inputs)), -1);
+
+  /* Another node in the same tree. */
+  const bNode other_node = create_node(2);
+  EXPECT_EQ(lookup_in_cache(cache, build_key(other_node, context_hash, inputs)), -1);
+
+  /* The same node in another node group or zone. */
+  const ComputeContextHash other_context_hash{3, 4};
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, other_context_hash, inputs)), -1);
+
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, inputs)), 42);
+}
+
+TEST_F(NodeOutputCacheTest, MissWithChangedFrame)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+  const bNode node = create_node(1);
+  const ComputeContextHash context_hash{1, 2};
+  const GeometrySet geometry = create_mesh_geometry();
+  add_to_cache(cache, build_key(node, context_hash, NodeInputs(geometry, 1.0f)), 1);
+
+  /* The frame only reaches the node through its inputs. */
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, NodeInputs(geometry, 2.0f))),
+            -1);
+  add_to_cache(cache, build_key(node, context_hash, NodeInputs(geometry, 2.0f)), 2);
+
+  /* Going back to a previous frame uses the entry of that frame. */
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, NodeInputs(geometry, 1.0f))), 1);
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, NodeInputs(geometry, 2.0f))), 2);
+  EXPECT_EQ(cache.stats().entries_num, 2);
+}
+
+TEST_F(NodeOutputCacheTest, ExpiredEntriesAreRemoved)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+  const bNode node = create_node(1);
+  const ComputeContextHash context_hash{1, 2};
+  {
+    const NodeInputs inputs(create_mesh_geometry(), 1.0f);
+    add_to_cache(cache, build_key(node, context_hash, inputs), 1);
+  }
+  /* The geometry of the first entry has been freed, so it can't be looked up anymore. */
+  const NodeInputs inputs(create_mesh_geometry(), 1.0f);
+  add_to_cache(cache, build_key(node, context_hash, inputs), 2);
+  EXPECT_EQ(cache.stats().entries_num, 1);
+  EXPECT_EQ(lookup_in_cache(cache, build_key(node, context_hash, inputs)), 2);
+}
+
+}  // namespace blender::nodes::tests
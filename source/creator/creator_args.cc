@@ -738,9 +738,14 @@ static void print_help(bArgs *ba, bool all)
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-build");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-tag");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-no-threads");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-priority");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-relations-cache");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-relations-cache-validate");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uid");
+  BLI_args_print_arg_doc(ba, "--debug-geometry-nodes-trace");
+  BLI_args_print_arg_doc(ba, "--debug-field-no-fusion");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
   BLI_args_print_arg_doc(ba, "--debug-wintab");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
@@ -756,6 +761,7 @@ static void print_help(bArgs *ba, bool all)
   }
   BLI_args_print_arg_doc(ba, "--debug-all");
   BLI_args_print_arg_doc(ba, "--debug-io");
+  BLI_args_print_arg_doc(ba, "--debug-blendfile-no-threads");
 
   PRINT("\n");
   BLI_args_print_arg_doc(ba, "--debug-fpe");
@@ -1253,19 +1259,44 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_tag[] =
     "Enable debug messages from dependency graph related on tagging.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_time[] =
     "\n\t"
-    "Enable debug messages from dependency graph related on timing.";
+    "Enable debug messages from dependency graph related on timing.\n"
+    "\tAlso records evaluation traces with the critical path, see "
+    "'Depsgraph.debug_eval_trace_chrome'.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_eval[] =
     "\n\t"
     "Enable debug messages from dependency graph related on evaluation.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_no_threads[] =
     "\n\t"
     "Switch dependency graph to a single threaded evaluation.";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_priority[] =
+    "\n\t"
+    "Evaluate dependency graph operations of the longest dependency chains first,\n"
+    "\tbased on timing of previous evaluations (debug only, not used by default).";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_relations_cache[] =
+    "\n\t"
+    "Keep dependency graph relations of unchanged data-blocks across rebuilds of the graph\n"
+    "\t(debug only, not used by default).";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_relations_cache_validate[] =
+    "\n\t"
+    "Keep dependency graph relations across rebuilds, and compare the graph with a full build\n"
+    "\tafter every rebuild which restored relations.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_pretty[] =
     "\n\t"
     "Enable colors for dependency graph debug messages.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_uid[] =
     "\n\t"
     "Verify validness of session-wide identifiers assigned to ID data-blocks.";
+static const char arg_handle_debug_mode_generic_set_doc_geometry_nodes_trace[] =
+    "\n\t"
+    "Print a timeline of the nodes executed on every thread after each evaluation\n"
+    "\tof a geometry nodes modifier.";
+static const char arg_handle_debug_mode_generic_set_doc_field_no_fusion[] =
+    "\n\t"
+    "Evaluate every field operation separately, without fusing chains of element-wise\n"
+    "\toperations.";
+static const char arg_handle_debug_mode_generic_set_doc_blendfile_no_threads[] =
+    "\n\t"
+    "Switch blend-file reading and writing to a single threaded handling of data-blocks.";
 static const char arg_handle_debug_mode_generic_set_doc_gpu_force_workarounds[] =
     "\n\t"
     "Enable workarounds for typical GPU issues and disable all GPU extensions.";
@@ -2632,6 +2663,21 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
                "--debug-depsgraph-no-threads",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads),
                (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-depsgraph-priority",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_priority),
+               (void *)G_DEBUG_DEPSGRAPH_PRIORITY);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-depsgraph-relations-cache",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_relations_cache),
+               (void *)G_DEBUG_DEPSGRAPH_RELATIONS_CACHE);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-depsgraph-relations-cache-validate",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_relations_cache_validate),
+               (void *)G_DEBUG_DEPSGRAPH_RELATIONS_CACHE_VALIDATE);
   BLI_args_add(ba,
                nullptr,
                "--debug-depsgraph-pretty",
@@ -2642,6 +2688,21 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
                "--debug-depsgraph-uid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_uid),
                (void *)G_DEBUG_DEPSGRAPH_UID);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-geometry-nodes-trace",
+               CB_EX(arg_handle_debug_mode_generic_set, geometry_nodes_trace),
+               (void *)G_DEBUG_GEOMETRY_NODES_TRACE);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-field-no-fusion",
+               CB_EX(arg_handle_debug_mode_generic_set, field_no_fusion),
+               (void *)G_DEBUG_FIELD_NO_FUSION);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-blendfile-no-threads",
+               CB_EX(arg_handle_debug_mode_generic_set, blendfile_no_threads),
+               (void *)G_DEBUG_BLENDFILE_NO_THREADS);
   BLI_args_add(ba,
                nullptr,
                "--debug-gpu-force-workarounds",
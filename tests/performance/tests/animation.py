@@ -9,6 +9,8 @@ def _run(args):
     import bpy
     import time
 
+    bpy.app.debug_depsgraph_priority = args['priority']
+
     start_time = time.time()
     elapsed_time = 0.0
     num_frames = 0
@@ -28,21 +30,27 @@ def _run(args):
 
 
 class AnimationTest(api.Test):
-    def __init__(self, filepath):
+    def __init__(self, filepath, priority=False):
         self.filepath = filepath
+        self.priority = priority
 
     def name(self):
+        # Critical path priority scheduling of depsgraph operations.
+        if self.priority:
+            return self.filepath.stem + " priority"
         return self.filepath.stem
 
     def category(self):
         return "animation"
 
     def run(self, env, device_id):
-        args = {}
+        args = {'priority': self.priority}
         result, _ = env.run_in_blender(_run, args, [self.filepath])
         return result
 
 
 def generate(env):
     filepaths = env.find_blend_files('animation/*')
-    return [AnimationTest(filepath) for filepath in filepaths]
+    return [AnimationTest(filepath, priority)
+            for filepath in filepaths
+            for priority in (False, True)]
@@ -5,20 +5,36 @@
 import api
 
 
+def _memory_usage():
+    # Resident set size of the current process in bytes, when available.
+    import os
+    try:
+        with open("/proc/self/statm", "r") as f:
+            return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+    except (OSError, ValueError):
+        return None
+
+
 def _run(filepath):
     import bpy
     import time
 
-    # Load once to ensure it's cached by OS
+    # First load, files may or may not be cached by the OS at this point.
+    start_time = time.time()
     bpy.ops.wm.open_mainfile(filepath=filepath)
+    cold_time = time.time() - start_time
     bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
 
-    # Measure loading the second time
+    # Measure loading the second time, now the file is cached by the OS.
+    memory_before = _memory_usage()
     start_time = time.time()
     bpy.ops.wm.open_mainfile(filepath=filepath)
     elapsed_time = time.time() - start_time
+    memory_after = _memory_usage()
 
-    result = {'time': elapsed_time}
+    result = {'time': elapsed_time, 'time_cold': cold_time}
+    if memory_before is not None and memory_after is not None:
+        result['memory'] = float(max(memory_after - memory_before, 0))
     return result
 
 
@@ -0,0 +1,54 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(filepath):
+    import bpy
+    import os
+    import tempfile
+    import time
+
+    bpy.ops.wm.open_mainfile(filepath=filepath)
+
+    with tempfile.TemporaryDirectory() as tempdir:
+        save_filepath = os.path.join(tempdir, "save.blend")
+
+        # First save, everything has to be compressed.
+        start_time = time.time()
+        bpy.ops.wm.save_as_mainfile(filepath=save_filepath, compress=True, copy=True)
+        full_time = time.time() - start_time
+
+        # Change a small part of the file, as typical between two saves while working.
+        objects = list(bpy.data.objects)
+        for ob in objects[:max(1, len(objects) // 100)]:
+            ob.location.x += 1.0
+
+        # Save again, unchanged data can be reused from the previous save.
+        start_time = time.time()
+        bpy.ops.wm.save_as_mainfile(filepath=save_filepath, compress=True, copy=True)
+        elapsed_time = time.time() - start_time
+
+    return {'time': elapsed_time, 'time_full': full_time}
+
+
+class BlendSaveTest(api.Test):
+    def __init__(self, filepath):
+        self.filepath = filepath
+
+    def name(self):
+        return self.filepath.stem
+
+    def category(self):
+        return "blend_save"
+
+    def run(self, env, device_id):
+        result, _ = env.run_in_blender(_run, str(self.filepath))
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('*/*')
+    return [BlendSaveTest(filepath) for filepath in filepaths]
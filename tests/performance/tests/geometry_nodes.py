@@ -42,6 +42,37 @@ def _run(args):
     return result
 
 
+def _run_realize_instances(args):
+    import bpy
+
+    # Build a node tree that instances a small mesh on every point of a grid and realizes the
+    # instances, so that the test does not depend on a file from the benchmarks library.
+    tree = bpy.data.node_groups.new("Realize Instances", 'GeometryNodeTree')
+    tree.interface.new_socket("Geometry", in_out='OUTPUT', socket_type='NodeSocketGeometry')
+
+    grid = tree.nodes.new('GeometryNodeMeshGrid')
+    grid.inputs["Vertices X"].default_value = args['grid_resolution']
+    grid.inputs["Vertices Y"].default_value = args['grid_resolution']
+    cube = tree.nodes.new('GeometryNodeMeshCube')
+    cube.inputs["Size"].default_value = (0.01, 0.01, 0.01)
+    instance = tree.nodes.new('GeometryNodeInstanceOnPoints')
+    realize = tree.nodes.new('GeometryNodeRealizeInstances')
+    output = tree.nodes.new('NodeGroupOutput')
+
+    tree.links.new(grid.outputs["Mesh"], instance.inputs["Points"])
+    tree.links.new(cube.outputs["Mesh"], instance.inputs["Instance"])
+    tree.links.new(instance.outputs["Instances"], realize.inputs["Geometry"])
+    tree.links.new(realize.outputs["Geometry"], output.inputs["Geometry"])
+
+    mesh = bpy.data.meshes.new("Realize Instances")
+    ob = bpy.data.objects.new("Realize Instances", mesh)
+    bpy.context.scene.collection.objects.link(ob)
+    modifier = ob.modifiers.new("Realize Instances", 'NODES')
+    modifier.node_group = tree
+
+    return _run(args)
+
+
 class GeometryNodesTest(api.Test):
     def __init__(self, filepath):
         self.filepath = filepath
@@ -60,6 +91,28 @@ class GeometryNodesTest(api.Test):
         return result
 
 
+class GeometryNodesRealizeInstancesTest(api.Test):
+    def __init__(self, instances_num):
+        self.instances_num = instances_num
+
+    def name(self):
+        return f"realize_instances_{self.instances_num}"
+
+    def category(self):
+        return "geometry_nodes"
+
+    def run(self, env, device_id):
+        args = {'grid_resolution': round(self.instances_num ** 0.5)}
+
+        result, _ = env.run_in_blender(_run_realize_instances, args)
+
+        return result
+
+
 def generate(env):
     filepaths = env.find_blend_files('geometry_nodes/*')
-    return [GeometryNodesTest(filepath) for filepath in filepaths]
+    tests = [GeometryNodesTest(filepath) for filepath in filepaths]
+    # Both below and above the number of instances that is realized chunk by chunk.
+    tests += [GeometryNodesRealizeInstancesTest(instances_num)
+              for instances_num in (10_000, 1_000_000, 5_000_000)]
+    return tests